@@ -319,6 +319,34 @@ enum {
     /* Restrict the supplied bbox to that actually used by the underlying device.
      * Used to restrict alphabits drawing to the area defined by compositors etc.*/
     gxdso_restrict_bbox,
+    /* gxdso_JPEG_passthrough_query:
+     *     data = NULL
+     *     size = 0
+     * Sent by the DCTDecode filter when it is created. Returns +ve value
+     * if the device may want the compressed data of the filter, to write
+     * it unchanged for the image that the filter is the source of.
+     */
+    gxdso_JPEG_passthrough_query,
+    /* gxdso_JPEG_passthrough_begin:
+     *     data = NULL
+     *     size = 0
+     * Sent by the DCTDecode filter before the first compressed data is
+     * read. Returns +ve value if the device takes the data, 0 if not, in
+     * which case the filter doesn't send anything more.
+     */
+    gxdso_JPEG_passthrough_begin,
+    /* gxdso_JPEG_passthrough_data:
+     *     data = pointer to compressed data
+     *     size = number of bytes
+     * Sent as the DCTDecode filter consumes its compressed data.
+     */
+    gxdso_JPEG_passthrough_data,
+    /* gxdso_JPEG_passthrough_end:
+     *     data = NULL
+     *     size = 0
+     * Sent when the DCTDecode filter has consumed all its data.
+     */
+    gxdso_JPEG_passthrough_end,
     /* Add new gxdso_ keys above this. */
     gxdso_pattern__LAST
 };
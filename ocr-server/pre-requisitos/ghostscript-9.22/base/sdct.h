@@ -82,6 +82,18 @@ extern_st(st_jpeg_compress_data);
   gs_public_st_ptrs1(st_jpeg_compress_data, jpeg_compress_data,\
     "JPEG compress data", jpeg_compress_data_enum_ptrs, jpeg_compress_data_reloc_ptrs, dummy)
 
+/*
+ * The DCTDecode filter can hand its compressed data, as it consumes it, to
+ * a client that wants to write it out unchanged (see zfdctd.c).
+ */
+typedef enum {
+    jpeg_passthrough_begin,	/* returns > 0 if the client takes the data */
+    jpeg_passthrough_data,
+    jpeg_passthrough_end
+} jpeg_passthrough_op;
+typedef int (*jpeg_passthrough_proc)(void *client, jpeg_passthrough_op op,
+                                     const byte *data, uint size);
+
 typedef struct jpeg_decompress_data_s {
     jpeg_stream_data_common;
     /* dinfo must immediately follow the common fields, */
@@ -93,6 +105,13 @@ typedef struct jpeg_decompress_data_s {
     bool faked_eoi;		/* true when fill_input_buffer inserted EOI */
     byte *scanline_buffer;	/* buffer for oversize scanline, or NULL */
     uint bytes_in_scanline;	/* # of bytes remaining to output from same */
+    /* The following are set before initialization. */
+    /* The client is not traced, it must outlive the filter. */
+    jpeg_passthrough_proc PassThroughfn;	/* NULL if no passthrough */
+    void *PassThroughClient;
+    /* The following are updated dynamically. */
+    int PassThrough;		/* 0 = not started, 1 = passing, -1 = stopped */
+    const byte *passed_ptr;	/* input data up to here has been passed */
 } jpeg_decompress_data;
 
 #define private_st_jpeg_decompress_data()	/* in zfdctd.c */\
@@ -99,6 +99,7 @@ s_DCTD_init(stream_state * st)
     ss->data.decompress->skip = 0;
     ss->data.decompress->input_eod = false;
     ss->data.decompress->faked_eoi = false;
+    ss->data.decompress->PassThrough = 0;
     ss->phase = 0;
     return 0;
 }
@@ -164,10 +165,32 @@ update_jpeg_header_height(JOCTET *d, size_t len, int height)
     }
 }
 
-/* Process a buffer */
+/*
+ * Pass the input data consumed since the last call on to the passthrough
+ * client, asking it first whether it takes the data at all.
+ */
+static void
+dctd_pass_through(jpeg_decompress_data *jddp, const stream_cursor_read *pr)
+{
+    if (jddp->PassThroughfn != NULL && jddp->PassThrough >= 0 &&
+        pr->ptr > jddp->passed_ptr) {
+        if (jddp->PassThrough == 0)
+            jddp->PassThrough =
+                ((*jddp->PassThroughfn)(jddp->PassThroughClient,
+                                        jpeg_passthrough_begin, NULL, 0) > 0 ?
+                 1 : -1);
+        if (jddp->PassThrough > 0)
+            (*jddp->PassThroughfn)(jddp->PassThroughClient,
+                                   jpeg_passthrough_data, jddp->passed_ptr + 1,
+                                   pr->ptr - jddp->passed_ptr);
+    }
+    jddp->passed_ptr = pr->ptr;
+}
+
+/* Decode a buffer */
 static int
-s_DCTD_process(stream_state * st, stream_cursor_read * pr,
-               stream_cursor_write * pw, bool last)
+s_DCTD_decode(stream_state * st, stream_cursor_read * pr,
+              stream_cursor_write * pw, bool last)
 {
     stream_DCT_state *const ss = (stream_DCT_state *) st;
     jpeg_decompress_data *jddp = ss->data.decompress;
@@ -201,6 +224,7 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
              */
             while (pr->ptr < pr->limit && pr->ptr[1] != 0xff)
                 pr->ptr++;
+            jddp->passed_ptr = pr->ptr;	/* don't pass the garbage on */
             if (pr->ptr == pr->limit)
                 return 0;
             src->next_input_byte = pr->ptr + 1;
@@ -342,9 +366,14 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
                      * a local buffer and copy the data into it. The local
                      * buffer can be grown as required. */
                     if ((src->next_input_byte-1 == pr->ptr) &&
-                        (pr->limit - pr->ptr >= ss->templat->min_in_size) &&
-                        (compact_jpeg_buffer(pr) == 0))
-                        return ERRC;
+                        (pr->limit - pr->ptr >= ss->templat->min_in_size)) {
+                        /* Compaction drops fill bytes from the data not */
+                        /* yet consumed, pass on what has been first. */
+                        dctd_pass_through(jddp, pr);
+                        if (compact_jpeg_buffer(pr) == 0)
+                            return ERRC;
+                        jddp->passed_ptr = pr->ptr;
+                    }
                     return 0;	/* need more data */
                 }
                 if (jddp->scanline_buffer != NULL) {
@@ -371,6 +400,29 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
     return ERRC;
 }
 
+/* Process a buffer */
+static int
+s_DCTD_process(stream_state * st, stream_cursor_read * pr,
+               stream_cursor_write * pw, bool last)
+{
+    stream_DCT_state *const ss = (stream_DCT_state *) st;
+    jpeg_decompress_data *jddp = ss->data.decompress;
+    int status;
+
+    if (jddp->PassThroughfn == NULL || jddp->PassThrough < 0)
+        return s_DCTD_decode(st, pr, pw, last);
+    jddp->passed_ptr = pr->ptr;
+    status = s_DCTD_decode(st, pr, pw, last);
+    dctd_pass_through(jddp, pr);
+    if (status == EOFC || status == ERRC) {
+        if (jddp->PassThrough > 0)
+            (*jddp->PassThroughfn)(jddp->PassThroughClient,
+                                   jpeg_passthrough_end, NULL, 0);
+        jddp->PassThrough = -1;
+    }
+    return status;
+}
+
 /* Stream template */
 const stream_template s_DCTD_template =
 {&st_DCT_state, s_DCTD_init, s_DCTD_process, 2000, 4000, NULL,
@@ -41,8 +41,10 @@ s_zlib_set_defaults(stream_state * st)
     /* DEF_MEM_LEVEL should be in zlib.h or zconf.h, but it isn't. */
     ss->memLevel = min(MAX_MEM_LEVEL, 8);
     ss->strategy = Z_DEFAULT_STRATEGY;
+    ss->threads = 0;
     /* Clear pointers */
     ss->dynamic = 0;
+    ss->workers = 0;
 }
 
 /* Allocate the dynamic state. */
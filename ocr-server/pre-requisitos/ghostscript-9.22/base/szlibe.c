@@ -15,10 +15,427 @@
 
 
 /* zlib encoding (compression) filter stream */
+#include "memory_.h"
 #include "std.h"
+#include "gserrors.h"
+#include "gsmemory.h"
+#include "gxsync.h"
 #include "strimpl.h"
 #include "szlibxx.h"
 
+/* ------ Multi-threaded encoding ------ */
+
+/*
+ * If the client sets threads > 1, the data are cut into blocks of a fixed
+ * size, and each block is deflated on its own by one of that many worker
+ * threads, primed with the last 32K of the block before it, and ended with
+ * a sync flush so the compressed blocks simply follow each other.  The main
+ * thread only copies data in and out, and computes the Adler-32 checksum.
+ *
+ * Compressed blocks are delivered in order, and only once all the workers
+ * are busy or the input has ended, so the output doesn't depend on the
+ * timing of the threads, nor (the block size being fixed) on their number.
+ * Nothing below allocates memory or touches GC memory on a worker thread.
+ *
+ * The first block goes through the ordinary encoder, which also writes the
+ * zlib header.  Only if the data go on past it are the workers set up, the
+ * ordinary encoder sync flushed, and its Adler-32 taken over, so that the
+ * many small streams of a PDF cost no more than without threads, and come
+ * out the same.  The end of the first block, which primes the second, is
+ * kept as it goes through.
+ */
+#define ZLIB_BLOCK_SIZE 131072
+#define ZLIB_DICT_SIZE 32768
+
+typedef struct zlib_worker_s {
+    zlib_workers_t *workers;
+    z_stream zstate;
+    bool zstate_ok;
+    byte *buf;			/* dictionary, then block data */
+    uint dict_size;
+    uint in_size;
+    byte *out;
+    uint out_size;		/* allocated */
+    uint out_count;		/* produced */
+    bool final;
+    int status;			/* 0 or ERRC */
+    gx_semaphore_t *start;
+    gx_semaphore_t *done;
+    gp_thread_id thread;
+} zlib_worker_t;
+
+/*typedef*/ struct zlib_workers_s {
+    gs_memory_t *memory;	/* non-GC */
+    int count;
+    zlib_worker_t *worker;
+    bool threads_started;
+    bool no_threads;		/* couldn't start threads, work in line */
+    bool quit;
+    int first;			/* oldest block in flight */
+    int in_flight;
+    bool finished;		/* the last block has been handed out */
+    bool handover;		/* the ordinary encoder is being flushed */
+    byte dict[ZLIB_DICT_SIZE];	/* end of the last block handed out */
+    uint dict_size;
+    uLong adler;
+    byte wrapper[4];		/* zlib trailer */
+    const byte *out_ptr;	/* output not yet delivered */
+    const byte *out_limit;
+    bool trailer_done;
+} /*zlib_workers_t*/;
+
+static void *
+zlib_workers_alloc(void *mem, uint items, uint size)
+{
+    return gs_alloc_byte_array((gs_memory_t *)mem, items, size,
+                               "zlib_workers_alloc");
+}
+
+static void
+zlib_workers_free(void *mem, void *address)
+{
+    gs_free_object((gs_memory_t *)mem, address, "zlib_workers_free");
+}
+
+/* Compress one block. */
+static void
+zlib_worker_deflate(zlib_worker_t *zw)
+{
+    z_stream *zs = &zw->zstate;
+    int status;
+
+    zw->status = ERRC;
+    zw->out_count = 0;
+    if (deflateReset(zs) != Z_OK)
+        return;
+    if (zw->dict_size > 0 &&
+        deflateSetDictionary(zs, zw->buf + ZLIB_DICT_SIZE - zw->dict_size,
+                             zw->dict_size) != Z_OK)
+        return;
+    zs->next_in = zw->buf + ZLIB_DICT_SIZE;
+    zs->avail_in = zw->in_size;
+    zs->next_out = zw->out;
+    zs->avail_out = zw->out_size;
+    status = deflate(zs, (zw->final ? Z_FINISH : Z_SYNC_FLUSH));
+    if (zs->avail_in != 0 ||
+        status != (zw->final ? Z_STREAM_END : Z_OK))
+        return;
+    zw->out_count = zw->out_size - zs->avail_out;
+    zw->status = 0;
+}
+
+static void
+zlib_worker_thread(void *arg)
+{
+    zlib_worker_t *zw = (zlib_worker_t *)arg;
+
+    for (;;) {
+        gx_semaphore_wait(zw->start);
+        if (zw->workers->quit)
+            break;
+        zlib_worker_deflate(zw);
+        gx_semaphore_signal(zw->done);
+    }
+}
+
+static void
+zlib_workers_start_threads(zlib_workers_t *zws)
+{
+    int i;
+
+    for (i = 0; i < zws->count; i++) {
+        zlib_worker_t *zw = &zws->worker[i];
+
+        zw->start = gx_semaphore_label(gx_semaphore_alloc(zws->memory),
+                                       "zlib_worker start");
+        zw->done = gx_semaphore_label(gx_semaphore_alloc(zws->memory),
+                                      "zlib_worker done");
+        if (zw->start == NULL || zw->done == NULL ||
+            gp_thread_start(zlib_worker_thread, zw, &zw->thread) < 0)
+            break;
+        gp_thread_label(zw->thread, "zlib worker");
+    }
+    if (i < zws->count) {
+        /* Stop the threads we have, and carry on without any. */
+        zws->quit = true;
+        while (--i >= 0) {
+            gx_semaphore_signal(zws->worker[i].start);
+            gp_thread_finish(zws->worker[i].thread);
+            zws->worker[i].thread = NULL;
+        }
+        for (i = 0; i < zws->count; i++) {
+            if (zws->worker[i].start)
+                gx_semaphore_free(zws->worker[i].start);
+            if (zws->worker[i].done)
+                gx_semaphore_free(zws->worker[i].done);
+            zws->worker[i].start = zws->worker[i].done = NULL;
+        }
+        zws->quit = false;
+        zws->no_threads = true;
+        return;
+    }
+    zws->threads_started = true;
+}
+
+/* Wait for the oldest block in flight, and set it up for delivery. */
+static int
+zlib_workers_collect(zlib_workers_t *zws)
+{
+    zlib_worker_t *zw = &zws->worker[zws->first];
+
+    if (zws->threads_started)
+        gx_semaphore_wait(zw->done);
+    zws->first = (zws->first + 1) % zws->count;
+    zws->in_flight--;
+    zw->in_size = 0;		/* free for the next block */
+    if (zw->status < 0)
+        return ERRC;
+    zws->out_ptr = zw->out;
+    zws->out_limit = zw->out + zw->out_count;
+    return 0;
+}
+
+/* Hand out the block being filled. */
+static void
+zlib_workers_submit(zlib_workers_t *zws, bool final)
+{
+    zlib_worker_t *zw =
+        &zws->worker[(zws->first + zws->in_flight) % zws->count];
+
+    zw->final = final;
+    if (!final) {
+        memcpy(zws->dict,
+               zw->buf + ZLIB_DICT_SIZE + zw->in_size - ZLIB_DICT_SIZE,
+               ZLIB_DICT_SIZE);
+        zws->dict_size = ZLIB_DICT_SIZE;
+        if (!zws->threads_started && !zws->no_threads)
+            zlib_workers_start_threads(zws);
+    } else
+        zws->finished = true;
+    zws->in_flight++;
+    if (zws->threads_started)
+        gx_semaphore_signal(zw->start);
+    else
+        zlib_worker_deflate(zw);
+}
+
+static void
+zlib_workers_put_wrapper(zlib_workers_t *zws, uLong value, int size)
+{
+    int i;
+
+    for (i = size; --i >= 0; value >>= 8)
+        zws->wrapper[i] = (byte)value;
+    zws->out_ptr = zws->wrapper;
+    zws->out_limit = zws->wrapper + size;
+}
+
+/* Wait for any blocks in flight, stop the threads and free everything. */
+static void
+zlib_workers_release(stream_zlib_state *ss)
+{
+    zlib_workers_t *zws = ss->workers;
+    gs_memory_t *mem;
+    int i;
+
+    if (zws == NULL)
+        return;
+    mem = zws->memory;
+    if (zws->threads_started) {
+        for (; zws->in_flight > 0; zws->in_flight--) {
+            gx_semaphore_wait(zws->worker[zws->first].done);
+            zws->first = (zws->first + 1) % zws->count;
+        }
+        zws->quit = true;
+        for (i = 0; i < zws->count; i++) {
+            gx_semaphore_signal(zws->worker[i].start);
+            gp_thread_finish(zws->worker[i].thread);
+            gx_semaphore_free(zws->worker[i].start);
+            gx_semaphore_free(zws->worker[i].done);
+        }
+    }
+    for (i = 0; i < zws->count; i++) {
+        zlib_worker_t *zw = &zws->worker[i];
+
+        if (zw->zstate_ok)
+            deflateEnd(&zw->zstate);
+        gs_free_object(mem, zw->buf, "zlib_workers_release(buf)");
+        gs_free_object(mem, zw->out, "zlib_workers_release(out)");
+    }
+    gs_free_object(mem, zws->worker, "zlib_workers_release(worker)");
+    gs_free_object(mem, zws, "zlib_workers_release");
+    ss->workers = NULL;
+}
+
+/*
+ * Allocate the shared state, when the ordinary encoder reaches the end of
+ * the first block that primes the next one.
+ */
+static int
+zlib_workers_create(stream_zlib_state *ss)
+{
+    gs_memory_t *mem = ss->memory->non_gc_memory;
+    zlib_workers_t *zws;
+
+    zws = (zlib_workers_t *)gs_alloc_bytes(mem, sizeof(zlib_workers_t),
+                                           "zlib_workers_create");
+    if (zws == NULL)
+        return_error(gs_error_VMerror);
+    memset(zws, 0, sizeof(*zws));
+    zws->memory = mem;
+    ss->workers = zws;
+    return 0;
+}
+
+/* Keep the input of the ordinary encoder that will prime the next block. */
+static void
+zlib_workers_keep_dict(zlib_workers_t *zws, uLong pos, const byte *p,
+                       uint count)
+{
+    memcpy(zws->dict + pos - (ZLIB_BLOCK_SIZE - ZLIB_DICT_SIZE), p, count);
+}
+
+/*
+ * Set up the workers, when the ordinary encoder has taken the whole first
+ * block and there is more to come.  Threads are started with the first
+ * block that fills up.  In case of error, the caller frees what was done.
+ */
+static int
+zlib_workers_setup(stream_zlib_state *ss)
+{
+    zlib_workers_t *zws = ss->workers;
+    gs_memory_t *mem = zws->memory;
+    int i;
+
+    zws->worker = (zlib_worker_t *)
+        gs_alloc_byte_array(mem, ss->threads, sizeof(zlib_worker_t),
+                            "zlib_workers_setup(worker)");
+    if (zws->worker == NULL)
+        return_error(gs_error_VMerror);
+    memset(zws->worker, 0, ss->threads * sizeof(zlib_worker_t));
+    zws->count = ss->threads;
+    for (i = 0; i < zws->count; i++) {
+        zlib_worker_t *zw = &zws->worker[i];
+        z_stream *zs = &zw->zstate;
+
+        zw->workers = zws;
+        zs->zalloc = zlib_workers_alloc;
+        zs->zfree = zlib_workers_free;
+        zs->opaque = (voidpf)mem;
+        if (deflateInit2(zs, ss->level, ss->method, -ss->windowBits,
+                         ss->memLevel, ss->strategy) != Z_OK)
+            return_error(gs_error_VMerror);
+        zw->zstate_ok = true;
+        /* Leave room for the empty stored block of the sync flush. */
+        zw->out_size = deflateBound(zs, ZLIB_BLOCK_SIZE) + 16;
+        zw->buf = gs_alloc_bytes(mem, ZLIB_DICT_SIZE + ZLIB_BLOCK_SIZE,
+                                 "zlib_workers_setup(buf)");
+        zw->out = gs_alloc_bytes(mem, zw->out_size,
+                                 "zlib_workers_setup(out)");
+        if (zw->buf == NULL || zw->out == NULL)
+            return_error(gs_error_VMerror);
+    }
+    zws->first = zws->in_flight = 0;
+    zws->finished = false;
+    zws->dict_size = ZLIB_DICT_SIZE;
+    zws->adler = ss->dynamic->zstate.adler;
+    zws->out_ptr = zws->out_limit = zws->wrapper;
+    zws->trailer_done = ss->no_wrapper;
+    zws->handover = true;
+    return 0;
+}
+
+/* Flush the ordinary encoder, so the workers' blocks can follow. */
+static int
+zlib_workers_handover(stream_zlib_state *ss, stream_cursor_write * pw)
+{
+    z_stream *zs = &ss->dynamic->zstate;
+    int status;
+
+    if (pw->ptr == pw->limit)
+        return 1;
+    zs->next_in = Z_NULL;
+    zs->avail_in = 0;
+    zs->next_out = pw->ptr + 1;
+    zs->avail_out = pw->limit - pw->ptr;
+    status = deflate(zs, Z_SYNC_FLUSH);
+    pw->ptr = zs->next_out - 1;
+    /* Z_BUF_ERROR means the flush was already complete. */
+    if (status != Z_OK && status != Z_BUF_ERROR)
+        return ERRC;
+    if (zs->avail_out == 0)
+        return 1;
+    ss->workers->handover = false;
+    return 0;
+}
+
+/* Process a buffer with the workers. */
+static int
+s_zlibE_process_threads(stream_zlib_state *ss, stream_cursor_read * pr,
+                        stream_cursor_write * pw, bool last)
+{
+    zlib_workers_t *zws = ss->workers;
+
+    if (zws->handover) {
+        int status = zlib_workers_handover(ss, pw);
+
+        if (status != 0)
+            return status;
+    }
+    for (;;) {
+        zlib_worker_t *zw;
+        uint count;
+
+        /* Deliver what we have first. */
+        if (zws->out_ptr < zws->out_limit) {
+            count = min(zws->out_limit - zws->out_ptr, pw->limit - pw->ptr);
+            memcpy(pw->ptr + 1, zws->out_ptr, count);
+            zws->out_ptr += count;
+            pw->ptr += count;
+            if (zws->out_ptr < zws->out_limit)
+                return 1;
+        }
+        if (zws->in_flight == zws->count ||
+            (zws->finished && zws->in_flight > 0)) {
+            if (zlib_workers_collect(zws) < 0)
+                return ERRC;
+            continue;
+        }
+        if (zws->finished) {
+            if (!zws->trailer_done) {
+                zws->trailer_done = true;
+                zlib_workers_put_wrapper(zws, zws->adler, 4);
+                continue;
+            }
+            return 0;
+        }
+        /* Fill the next block. */
+        zw = &zws->worker[(zws->first + zws->in_flight) % zws->count];
+        if (zw->in_size == 0) {
+            zw->dict_size = zws->dict_size;
+            memcpy(zw->buf + ZLIB_DICT_SIZE - zws->dict_size,
+                   zws->dict + ZLIB_DICT_SIZE - zws->dict_size,
+                   zws->dict_size);
+        }
+        count = min(pr->limit - pr->ptr, ZLIB_BLOCK_SIZE - zw->in_size);
+        if (count > 0) {
+            memcpy(zw->buf + ZLIB_DICT_SIZE + zw->in_size, pr->ptr + 1, count);
+            zws->adler = adler32(zws->adler, pr->ptr + 1, count);
+            zw->in_size += count;
+            pr->ptr += count;
+        }
+        if (last && pr->ptr == pr->limit) {
+            zlib_workers_submit(zws, true);
+            continue;
+        }
+        if (zw->in_size < ZLIB_BLOCK_SIZE)
+            return 0;
+        zlib_workers_submit(zws, false);
+    }
+}
+
+/* ------ Single-threaded encoding ------ */
+
 /* Initialize the filter. */
 static int
 s_zlibE_init(stream_state * st)
@@ -32,6 +449,7 @@ s_zlibE_init(stream_state * st)
                      (ss->no_wrapper ? -ss->windowBits : ss->windowBits),
                      ss->memLevel, ss->strategy) != Z_OK)
         return ERRC;	/****** WRONG ******/
+    ss->workers = 0;
     return 0;
 }
 
@@ -41,6 +459,7 @@ s_zlibE_reset(stream_state * st)
 {
     stream_zlib_state *const ss = (stream_zlib_state *)st;
 
+    zlib_workers_release(ss);
     if (deflateReset(&ss->dynamic->zstate) != Z_OK)
         return ERRC;	/****** WRONG ******/
     return 0;
@@ -53,29 +472,67 @@ s_zlibE_process(stream_state * st, stream_cursor_read * pr,
 {
     stream_zlib_state *const ss = (stream_zlib_state *)st;
     z_stream *zs = &ss->dynamic->zstate;
-    const byte *p = pr->ptr;
-    int status;
 
-    /* Detect no input or full output so that we don't get */
-    /* a Z_BUF_ERROR return. */
-    if (pw->ptr == pw->limit)
-        return 1;
-    if (p == pr->limit && !last)
-        return 0;
-    zs->next_in = (Bytef *)p + 1;
-    zs->avail_in = pr->limit - p;
-    zs->next_out = pw->ptr + 1;
-    zs->avail_out = pw->limit - pw->ptr;
-    status = deflate(zs, (last ? Z_FINISH : Z_NO_FLUSH));
-    pr->ptr = zs->next_in - 1;
-    pw->ptr = zs->next_out - 1;
-    switch (status) {
-        case Z_OK:
-            return (pw->ptr == pw->limit ? 1 : pr->ptr > p && !last ? 0 : 1);
-        case Z_STREAM_END:
-            return (last && pr->ptr == pr->limit ? 0 : ERRC);
-        default:
-            return ERRC;
+    for (;;) {
+        const byte *p = pr->ptr;
+        const byte *limit = pr->limit;
+        bool flush = last;
+        uLong pos = zs->total_in;
+        int status;
+
+        if (ss->workers && ss->workers->count > 0)
+            return s_zlibE_process_threads(ss, pr, pw, last);
+        if (ss->threads > 1 && p < limit) {
+            /* Stop at the end of the first block, and the part before. */
+            uLong stop = ZLIB_BLOCK_SIZE - ZLIB_DICT_SIZE;
+            int code = 0;
+
+            if (pos >= stop) {
+                stop = ZLIB_BLOCK_SIZE;
+                if (ss->workers == NULL)
+                    code = zlib_workers_create(ss);
+                if (code >= 0 && pos == stop) {
+                    code = zlib_workers_setup(ss);
+                    if (code >= 0)
+                        continue;
+                }
+            }
+            if (code < 0) {
+                /* Just work in line. */
+                zlib_workers_release(ss);
+                ss->threads = 0;
+            } else if (limit - p > stop - pos) {
+                limit = p + (stop - pos);
+                flush = false;
+            }
+        }
+        /* Detect no input or full output so that we don't get */
+        /* a Z_BUF_ERROR return. */
+        if (pw->ptr == pw->limit)
+            return 1;
+        if (p == limit && !flush)
+            return 0;
+        zs->next_in = (Bytef *)p + 1;
+        zs->avail_in = limit - p;
+        zs->next_out = pw->ptr + 1;
+        zs->avail_out = pw->limit - pw->ptr;
+        status = deflate(zs, (flush ? Z_FINISH : Z_NO_FLUSH));
+        pr->ptr = zs->next_in - 1;
+        pw->ptr = zs->next_out - 1;
+        if (ss->workers && pr->ptr > p)
+            zlib_workers_keep_dict(ss->workers, pos, p + 1, pr->ptr - p);
+        switch (status) {
+            case Z_OK:
+                if (limit < pr->limit && pr->ptr == limit &&
+                    pw->ptr < pw->limit)
+                    continue;	/* on to the next stop */
+                return (pw->ptr == pw->limit ? 1 :
+                        pr->ptr > p && !flush ? 0 : 1);
+            case Z_STREAM_END:
+                return (last && pr->ptr == pr->limit ? 0 : ERRC);
+            default:
+                return ERRC;
+        }
     }
 }
 
@@ -85,6 +542,7 @@ s_zlibE_release(stream_state * st)
 {
     stream_zlib_state *const ss = (stream_zlib_state *)st;
 
+    zlib_workers_release(ss);
     deflateEnd(&ss->dynamic->zstate);
     s_zlib_free_dynamic_state(ss);
 }
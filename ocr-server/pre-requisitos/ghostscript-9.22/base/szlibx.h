@@ -22,6 +22,9 @@
 /* Define an opaque type for the dynamic part of the state. */
 typedef struct zlib_dynamic_state_s zlib_dynamic_state_t;
 
+/* Define an opaque type for the worker threads of an encoder (szlibe.c). */
+typedef struct zlib_workers_s zlib_workers_t;
+
 /* Define the stream state structure. */
 typedef struct stream_zlib_state_s {
     stream_state_common;
@@ -33,8 +36,10 @@ typedef struct stream_zlib_state_s {
     int method;
     int memLevel;
     int strategy;
+    int threads;		/* if > 1, compress on this many threads */
     /* Dynamic state */
     zlib_dynamic_state_t *dynamic;
+    zlib_workers_t *workers;	/* not in GC memory, NULL if no threads */
 } stream_zlib_state;
 
 /*
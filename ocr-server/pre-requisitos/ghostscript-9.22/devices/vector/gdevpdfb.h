@@ -269,6 +269,7 @@ const gx_device_pdf PDF_DEVICE_IDENT =
  true,				/* PreserveDeviceN */
  0,				/* PDFACompatibilityPolicy */
  true,				/* DetectDuplicateImages */
+ true,				/* DetectDuplicateFonts */
  false,				/* AllowIncrementalCFF */
  !PDF_FOR_OPDFREAD,		/* WantsToUnicode */
  !PDF_FOR_OPDFREAD,		/* WantsPageLabels */
@@ -284,5 +285,12 @@ const gx_device_pdf PDF_DEVICE_IDENT =
  false,                 /* FlattenFonts, writes text as outlines instead of fonts */
  -1,                    /* Last Form ID, start with -1 which means 'none' */
  0,                     /* ExtensionMetadata */
- 0                      /* PDFFormName */
+ 0,                     /* PDFFormName */
+ true,                  /* PassThroughJPEGImages */
+ false,                 /* JPEG_PassThrough */
+ 0,                     /* PassThroughWriter */
+ false,                 /* PassThroughBegun */
+ {0, 0},                /* PassThroughLast */
+ {0},                   /* DuplicateCount */
+ {0}                    /* DuplicateBytes */
 };
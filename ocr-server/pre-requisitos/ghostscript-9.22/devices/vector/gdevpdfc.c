@@ -1000,6 +1000,9 @@ pdf_color_space_named(gx_device_pdf *pdev, const gs_gstate * pgs,
         sclose(&s);
         pres = pdf_find_cspace_resource(pdev, serialized, serialized_size);
         if (pres != NULL) {
+            pdf_note_duplicate(pdev, resourceColorSpace,
+                (csi == gs_color_space_index_ICC && pcs->cmm_icc_profile_data != NULL ?
+                 pcs->cmm_icc_profile_data->buffer_size : 0));
             if (serialized != serialized0)
                 gs_free_object(pdev->pdf_memory, serialized, "pdf_color_space");
             serialized = NULL;
@@ -38,6 +38,8 @@
 #include "gsicc_manage.h"
 #include "gsform1.h"
 #include "gxpath.h"
+#include "strimpl.h"
+#include "szlibx.h"
 
 /* Forward references */
 static image_enum_proc_plane_data(pdf_image_plane_data);
@@ -79,6 +81,7 @@ typedef struct pdf_image_enum_s {
     pdf_image_writer writer;
     gs_matrix mat;
     gs_color_space_index initial_colorspace;
+    bool passthrough;		/* the DCTDecode source writes the data */
 } pdf_image_enum;
 gs_private_st_composite(st_pdf_image_enum, pdf_image_enum, "pdf_image_enum",
   pdf_image_enum_enum_ptrs, pdf_image_enum_reloc_ptrs);
@@ -983,6 +986,10 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
     gs_color_space *pcs_device = NULL;
     cos_value_t cs_value;
     const gs_range_t *pranges = 0;
+    bool jpeg_offered = pdev->JPEG_PassThrough;
+
+    /* An offer of compressed data only holds for the image begun next. */
+    pdev->JPEG_PassThrough = false;
 
     image = (image_union_t *)gs_malloc(mem->non_gc_memory, 4,
                        sizeof(image_union_t), "pdf_begin_typed_image(image)");
@@ -1385,8 +1392,20 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
      * image.
      * For colour conversion we will place an additional filter in front of all
      * the streams which does the conversion.
+     * If the data come from a DCTDecode filter which has offered its
+     * compressed data, and we would neither convert, downsample nor
+     * compress the image losslessly, we write the compressed data instead
+     * of the samples, with no filters at all.
      */
-    if (in_line) {
+    pie->passthrough = jpeg_offered && pdev->PassThroughJPEGImages &&
+        context == PDF_IMAGE_DEFAULT && pic->type->index == 1 && !is_mask &&
+        !in_line && !force_lossless && !convert_to_process_colors &&
+        pdev->binary_ok && !pdev->ForOPDFRead &&
+        psdf_image_can_pass_through((gx_device_psdf *)pdev, &image[0].pixel,
+                                    pmat);
+    if (pie->passthrough)
+        pie->writer.alt_writer_count = 1;
+    else if (in_line) {
         code = new_setup_lossless_filters((gx_device_psdf *) pdev,
                                              &pie->writer.binary[0],
                                              &image[0].pixel, in_line, convert_to_process_colors, (gs_matrix *)pmat, (gs_gstate *)pgs);
@@ -1524,6 +1543,16 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
         if (code < 0)
             goto fail_and_fallback;
     }
+    if (pie->passthrough) {
+        code = cos_dict_put_c_strings(cos_stream_dict(pie->writer.data),
+                                      pie->writer.pin->filter_names.Filter,
+                                      pie->writer.pin->filter_names.DCTDecode);
+        if (code < 0)
+            goto fail_and_fallback;
+        pdev->PassThroughWriter = pie->writer.binary[0].strm;
+        pdev->PassThroughBegun = false;
+        pdev->PassThroughLast[0] = pdev->PassThroughLast[1] = 0;
+    }
     if (pie->writer.alt_writer_count == 2) {
         psdf_setup_compression_chooser(&pie->writer.binary[2],
              (gx_device_psdf *)pdev, pim->Width, pim->Height,
@@ -1586,6 +1615,37 @@ gdev_pdf_begin_typed_image(gx_device * dev, const gs_gstate * pgs,
 
 /* ---------------- All images ---------------- */
 
+/*
+ * Compress the samples of an image with FlateEncode after all, if it was set
+ * up to be written from the compressed data of its DCTDecode source and the
+ * data turn out to come from somewhere else.
+ */
+static int
+pdf_image_fall_back_from_pass_through(gx_device_pdf *pdev, pdf_image_enum *pie)
+{
+    psdf_binary_writer *pbw = &pie->writer.binary[0];
+    stream_state *st;
+    int code;
+
+    pie->passthrough = false;
+    pdev->PassThroughWriter = NULL;
+    st = s_alloc_state(pbw->memory, s_zlibE_template.stype,
+                       "pdf_image_fall_back_from_pass_through");
+    if (st == 0)
+        return_error(gs_error_VMerror);
+    st->templat = &s_zlibE_template;
+    if (s_zlibE_template.set_defaults)
+        (*s_zlibE_template.set_defaults) (st);
+    code = psdf_encode_binary(pbw, &s_zlibE_template, st);
+    if (code < 0) {
+        gs_free_object(pbw->memory, st, "pdf_image_fall_back_from_pass_through");
+        return code;
+    }
+    return cos_dict_put_c_strings(cos_stream_dict(pie->writer.data),
+                                  pie->writer.pin->filter_names.Filter,
+                                  pie->writer.pin->filter_names.FlateDecode);
+}
+
 /* Process the next piece of an image. */
 static int
 pdf_image_plane_data_alt(gx_image_enum_common_t * info,
@@ -1673,6 +1733,20 @@ pdf_image_plane_data(gx_image_enum_common_t * info,
     pdf_image_enum *pie = (pdf_image_enum *) info;
     int i;
 
+    if (pie->passthrough) {
+        gx_device_pdf *pdev = (gx_device_pdf *)info->dev;
+
+        if (pdev->PassThroughBegun) {
+            /* The compressed data have been written already. */
+            *rows_used = min(height, pie->rows_left);
+            pie->rows_left -= *rows_used;
+            return !pie->rows_left;
+        }
+        /* The data didn't come from the DCTDecode filter after all. */
+        i = pdf_image_fall_back_from_pass_through(pdev, pie);
+        if (i < 0)
+            return i;
+    }
     for (i = 0; i < pie->writer.alt_writer_count; i++) {
         int code = pdf_image_plane_data_alt(info, planes, height, rows_used, i);
         if (code)
@@ -1825,6 +1899,21 @@ pdf_image_end_image_data(gx_image_enum_common_t * info, bool draw_last,
     int data_height = height - pie->rows_left;
     int code = 0;
 
+    if (pie->passthrough) {
+        /* Add an EOI marker if the filter stopped reading short of it. */
+        static const byte EOI[2] = {0xff, 0xd9};
+        uint ignore;
+
+        pdev->PassThroughWriter = NULL;
+        if (!pdev->PassThroughBegun)
+            data_height = 0;
+        else if (memcmp(pdev->PassThroughLast, EOI, 2) &&
+                 sputs(pie->writer.binary[0].strm, EOI, 2, &ignore) < 0)
+            return_error(gs_error_ioerror);
+        else if (data_height > 0)
+            /* The compressed data always hold the full height. */
+            data_height = height;
+    }
     if (pie->writer.pres)
         ((pdf_x_object_t *)pie->writer.pres)->data_height = data_height;
     else if (data_height > 0)
@@ -2353,6 +2442,8 @@ gdev_pdf_dev_spec_op(gx_device *pdev1, int dev_spec_op, void *data, int size)
                 if (code < 0)
                     return code;
                 if (code > 0) {
+                    pdf_note_duplicate(pdev, resourceXObject,
+                                       cos_stream_length((const cos_stream_t *)pres1->object));
                     code = pdf_cancel_resource(pdev, pres1, resourceXObject);
                     if (code < 0)
                         return code;
@@ -2476,6 +2567,9 @@ gdev_pdf_dev_spec_op(gx_device *pdev1, int dev_spec_op, void *data, int size)
             if (code > 0) {
                 pdf_pattern_t *ppat = (pdf_pattern_t *)pres1;
 
+                pdf_note_duplicate(pdev, resourcePattern,
+                    (cos_type(pres1->object) == cos_type_stream ?
+                     cos_stream_length((const cos_stream_t *)pres1->object) : 0));
                 code = pdf_cancel_resource(pdev, pres1, resourcePattern);
                 if (code < 0)
                     return code;
@@ -2530,6 +2624,39 @@ gdev_pdf_dev_spec_op(gx_device *pdev1, int dev_spec_op, void *data, int size)
                 if (code != gs_error_undefined)
                     return code;
             }
+            break;
+        case gxdso_JPEG_passthrough_query:
+            /* A DCTDecode filter offers its compressed data to the next image. */
+            if (!pdev->PassThroughJPEGImages || pdev->PassThroughWriter != NULL)
+                return 0;
+            pdev->JPEG_PassThrough = true;
+            return 1;
+        case gxdso_JPEG_passthrough_begin:
+            /* Only take the data while an image waits for them. */
+            if (pdev->PassThroughWriter == NULL || pdev->PassThroughBegun) {
+                pdev->JPEG_PassThrough = false;
+                return 0;
+            }
+            pdev->PassThroughBegun = true;
+            return 1;
+        case gxdso_JPEG_passthrough_data:
+            if (pdev->PassThroughWriter != NULL && pdev->PassThroughBegun &&
+                size > 0) {
+                uint ignore;
+
+                if (size >= 2)
+                    memcpy(pdev->PassThroughLast, (byte *)data + size - 2, 2);
+                else {
+                    pdev->PassThroughLast[0] = pdev->PassThroughLast[1];
+                    pdev->PassThroughLast[1] = *(byte *)data;
+                }
+                if (sputs(pdev->PassThroughWriter, (const byte *)data, size,
+                          &ignore) < 0)
+                    return_error(gs_error_ioerror);
+            }
+            return 0;
+        case gxdso_JPEG_passthrough_end:
+            return 0;
     }
     return gx_default_dev_spec_op(pdev1, dev_spec_op, data, size);
 }
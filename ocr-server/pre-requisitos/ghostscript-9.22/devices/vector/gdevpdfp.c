@@ -117,12 +117,14 @@ static const gs_param_item_t pdf_param_items[] = {
     pi("PreserveDeviceN", gs_param_type_bool, PreserveDeviceN),
     pi("PDFACompatibilityPolicy", gs_param_type_int, PDFACompatibilityPolicy),
     pi("DetectDuplicateImages", gs_param_type_bool, DetectDuplicateImages),
+    pi("DetectDuplicateFonts", gs_param_type_bool, DetectDuplicateFonts),
     pi("AllowIncrementalCFF", gs_param_type_bool, AllowIncrementalCFF),
     pi("WantsToUnicode", gs_param_type_bool, WantsToUnicode),
     pi("AllowPSRepeatFunctions", gs_param_type_bool, AllowPSRepeatFunctions),
     pi("IsDistiller", gs_param_type_bool, IsDistiller),
     pi("PreserveSMask", gs_param_type_bool, PreserveSMask),
     pi("PreserveTrMode", gs_param_type_bool, PreserveTrMode),
+    pi("PassThroughJPEGImages", gs_param_type_bool, PassThroughJPEGImages),
     pi("NoT3CCITT", gs_param_type_bool, NoT3CCITT),
     pi("FastWebView", gs_param_type_bool, Linearise),
     pi("NoOutputFonts", gs_param_type_bool, FlattenFonts),
@@ -1246,6 +1246,9 @@ pdf_substitute_resource(gx_device_pdf *pdev, pdf_resource_t **ppres,
     if (code < 0)
         return code;
     if (code != 0) {
+        pdf_note_duplicate(pdev, rtype,
+            (cos_type(pres1->object) == cos_type_stream ?
+             cos_stream_length((const cos_stream_t *)pres1->object) : 0));
         code = pdf_cancel_resource(pdev, (pdf_resource_t *)pres1, rtype);
         if (code < 0)
             return code;
@@ -1440,6 +1443,41 @@ pdf_print_resource_statistics(gx_device_pdf * pdev)
     }
 }
 
+/* Print the duplicate statistics, once the fonts have been written. */
+void
+pdf_print_duplicate_statistics(gx_device_pdf * pdev)
+{
+    int rtype;
+    gs_offset_t total = 0;
+
+    for (rtype = 0; rtype < NUM_RESOURCE_TYPES; rtype++) {
+        const char *name = pdf_resource_type_names[rtype];
+
+        if (pdev->DuplicateCount[rtype] == 0)
+            continue;
+        dmprintf3(pdev->pdf_memory, "Resource type %d (%s) had %d duplicates", rtype,
+                (name ? name : ""), pdev->DuplicateCount[rtype]);
+        if (pdev->DuplicateBytes[rtype] != 0)
+            dmprintf1(pdev->pdf_memory, ", %"PRId64" bytes not written",
+                      (int64_t)pdev->DuplicateBytes[rtype]);
+        dmprintf(pdev->pdf_memory, ".\n");
+        total += pdev->DuplicateBytes[rtype];
+    }
+    if (total != 0)
+        dmprintf1(pdev->pdf_memory, "Duplicate resources saved %"PRId64" bytes.\n",
+                  (int64_t)total);
+}
+
+/* Count a duplicate resource for the statistics. */
+void
+pdf_note_duplicate(gx_device_pdf * pdev, pdf_resource_type_t rtype, gs_offset_t size)
+{
+    if (rtype >= NUM_RESOURCE_TYPES)
+        rtype = resourceOther;
+    pdev->DuplicateCount[rtype]++;
+    pdev->DuplicateBytes[rtype] += size;
+}
+
 /* Begin an object logically separate from the contents. */
 long
 pdf_open_separate(gx_device_pdf * pdev, long id, pdf_resource_type_t type)
@@ -848,6 +848,10 @@ struct gx_device_pdf_s {
     bool PreserveDeviceN;
     int PDFACompatibilityPolicy;
     bool DetectDuplicateImages;
+    bool DetectDuplicateFonts;      /* If true, fonts from different font objects (or input
+                                     * files) share a font resource when their glyphs are
+                                     * the same.
+                                     */
     bool AllowIncrementalCFF;
     bool WantsToUnicode;
     bool WantsPageLabels;
@@ -889,6 +893,23 @@ struct gx_device_pdf_s {
                                      * after the form is processed. The name will be used to create a
                                      * local named object which pdfmark can reference.
                                      */
+    bool PassThroughJPEGImages;     /* If true, the compressed data of a DCTDecode image are
+                                     * copied to the output unchanged, when the image would
+                                     * not be downsampled or converted and may use DCTEncode.
+                                     */
+    bool JPEG_PassThrough;          /* A DCTDecode filter has offered its compressed data
+                                     * (gxdso_JPEG_passthrough_query) and no image has
+                                     * begun since.
+                                     */
+    stream *PassThroughWriter;      /* While an image is written with the compressed data of
+                                     * its DCTDecode source, the stream of the image, else NULL.
+                                     */
+    bool PassThroughBegun;          /* The filter has begun sending data to PassThroughWriter. */
+    byte PassThroughLast[2];        /* The last 2 bytes sent, to check for an EOI marker. */
+    int DuplicateCount[NUM_RESOURCE_TYPES];
+                                    /* Resources found to be the same as earlier ones, and */
+    gs_offset_t DuplicateBytes[NUM_RESOURCE_TYPES];
+                                    /* the stream data they didn't write (PrintStatistics). */
 };
 
 #define is_in_page(pdev)\
@@ -922,8 +943,9 @@ struct gx_device_pdf_s {
  m(38, outline_levels)
  m(39, gx_device_pdf, EmbeddedFiles);
  m(40, gx_device_pdf, pdf_font_dir);
- m(41, gx_device_pdf, Extension_Metadata);*/
-#define gx_device_pdf_num_ptrs 42
+ m(41, gx_device_pdf, Extension_Metadata);
+ m(42, gx_device_pdf, PassThroughWriter);*/
+#define gx_device_pdf_num_ptrs 43
 #define gx_device_pdf_do_param_strings(m)\
     m(0, OwnerPassword) m(1, UserPassword) m(2, NoEncrypt)\
     m(3, DocumentUUID) m(4, InstanceUUID)
@@ -1093,6 +1115,14 @@ void pdf_drop_resources(gx_device_pdf * pdev, pdf_resource_type_t rtype,
 /* Print resource statistics. */
 void pdf_print_resource_statistics(gx_device_pdf * pdev);
 
+/* Print the duplicate resources and the bytes they saved. */
+void pdf_print_duplicate_statistics(gx_device_pdf * pdev);
+
+/* Count a resource which was found to be the same as an earlier one, */
+/* and the data (if known) that wasn't written, for the statistics. */
+void pdf_note_duplicate(gx_device_pdf * pdev, pdf_resource_type_t rtype,
+        gs_offset_t size);
+
 /* Cancel a resource (do not write it into PDF). */
 int pdf_cancel_resource(gx_device_pdf * pdev, pdf_resource_t *pres,
         pdf_resource_type_t rtype);
@@ -737,6 +737,9 @@ pdf_write_FontDescriptor(gx_device_pdf *pdev, pdf_resource_t *pres)
             code = COS_WRITE_OBJECT(pco, pdev, resourceFontFile);
             if (code < 0)
                 return code;
+            if (pfd->duplicates > 0 && cos_type(pco) == cos_type_stream)
+                pdev->DuplicateBytes[pfd->duplicate_type] += (gs_offset_t)
+                    pfd->duplicates * cos_stream_length((const cos_stream_t *)pco);
         }
     }
     return 0;
@@ -82,6 +82,12 @@ struct pdf_font_descriptor_s {
     pdf_base_font_t *base_font;
     font_type FontType;		/* (copied from base_font) */
     bool embed;
+    /*
+     * Fonts that were merged into this one, and the type of their resources,
+     * for the statistics: their size is known once the FontFile is written.
+     */
+    int duplicates;
+    pdf_resource_type_t duplicate_type;
     struct cid_ {		/* (CIDFonts only) */
         cos_dict_t *Style;
         char Lang[3];		/* 2 chars + \0 */
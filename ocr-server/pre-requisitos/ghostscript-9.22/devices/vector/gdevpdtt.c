@@ -1154,6 +1154,7 @@ pdf_find_font_resource(gx_device_pdf *pdev, gs_font *font,
             pdf_font_resource_t *pdfont = (pdf_font_resource_t *)pres;
             const gs_font_base *cfont;
             gs_font *ofont = font;
+            bool same_XUID = true;
             int code;
 
             cfont = (gs_font_base *)font;
@@ -1161,8 +1162,16 @@ pdf_find_font_resource(gx_device_pdf *pdev, gs_font *font,
                 int size = uid_XUID_size(&cfont->UID);
                 long *xvalues = uid_XUID_values(&cfont->UID);
                 if (xvalues && size >= 2 && xvalues[0] == 1000000) {
-                    if (xvalues[size - 1] != pdfont->XUID)
-                        continue;
+                    /*
+                     * A different XUID means a different font object (or
+                     * input file).  Its glyphs may still be the same, which
+                     * gs_copied_can_copy_glyphs below checks glyph by glyph.
+                     */
+                    if (xvalues[size - 1] != pdfont->XUID) {
+                        if (!pdev->DetectDuplicateFonts)
+                            continue;
+                        same_XUID = false;
+                    }
                 }
             }
 
@@ -1190,6 +1199,18 @@ pdf_find_font_resource(gx_device_pdf *pdev, gs_font *font,
             if (code == gs_error_unregistered) /* Debug purpose only. */
                 return code;
             if(code > 0) {
+                if (!same_XUID) {
+                    pdf_font_descriptor_t *pfd = (pdfont->FontType == ft_composite
+                            ? pdfont->u.type0.DescendantFont->FontDescriptor
+                            : pdfont->FontDescriptor);
+
+                    /* The size is added when the shared font is written. */
+                    pdf_note_duplicate(pdev, type, 0);
+                    if (pfd != NULL) {
+                        pfd->duplicates++;
+                        pfd->duplicate_type = type;
+                    }
+                }
                 *ppdfont = pdfont;
                 return 1;
             }
@@ -288,6 +288,7 @@ typedef enum {
         bool HaveTrueTypes;\
         bool HaveCIDSystem;\
         double ParamCompatibilityLevel;\
+        int NumRenderingThreads;	/* for Flate compression, 0 = none */\
         psdf_distiller_params params
 
 typedef struct gx_device_psdf_s {
@@ -302,6 +303,7 @@ typedef struct gx_device_psdf_s {
         true,\
         false,\
         1.3,\
+        0,\
          { psdf_general_param_defaults(ascii),\
            psdf_color_image_param_defaults,\
            psdf_gray_image_param_defaults,\
@@ -430,6 +432,12 @@ int new_setup_image_filters(gx_device_psdf *pdev, psdf_binary_writer *pbw,
                              const gs_gstate * pgs, bool lossless,
                              bool in_line, bool colour_conversion);
 
+/* Decide whether the compressed data of a DCTDecode image can be written */
+/* unchanged, i.e. without downsampling and with DCTEncode allowed. */
+bool psdf_image_can_pass_through(const gx_device_psdf *pdev,
+                                 const gs_pixel_image_t *pim,
+                                 const gs_matrix *pctm);
+
 /* Set up compression filters for a lossless image, with no downsampling, */
 /* no color space conversion, and only lossless filters. */
 /* Note that this may modify the image parameters. */
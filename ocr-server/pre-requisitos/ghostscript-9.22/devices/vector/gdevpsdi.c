@@ -301,6 +301,8 @@ setup_image_compression(psdf_binary_writer *pbw, const psdf_image_params *pdip,
 
     if (templat->set_defaults)
         (*templat->set_defaults) (st);
+    if (templat == &s_zlibE_template)
+        ((stream_zlib_state *)st)->threads = pdev->NumRenderingThreads;
     if (templat == &s_CFE_template) {
         stream_CFE_state *const ss = (stream_CFE_state *) st;
 
@@ -876,6 +878,71 @@ psdf_setup_image_colors_filter(psdf_binary_writer *pbw,
     return 0;
 }
 
+/*
+ * Compute the resolution of an image in device space, the lower of the
+ * resolutions along its width and height, or -1 if pctm is NULL.
+ */
+static int
+image_resolution(const gx_device_psdf *pdev, const gs_pixel_image_t *pim,
+                 const gs_matrix *pctm, double *presolution)
+{
+    double resolution, resolutiony;
+    gs_point pt;
+    int code;
+
+    if (pctm == 0) {
+        *presolution = -1;
+        return 0;
+    }
+    /* We could do both X and Y, but why bother? */
+    code = gs_distance_transform_inverse(1.0, 0.0, &pim->ImageMatrix, &pt);
+    if (code < 0)
+        return code;
+    gs_distance_transform(pt.x, pt.y, pctm, &pt);
+    resolution = 1.0 / hypot(pt.x / pdev->HWResolution[0],
+                             pt.y / pdev->HWResolution[1]);
+
+    /* Actually we must do both X and Y, in case the image is ananmorphically scaled
+     * and one axis is not high enough resolution to be downsampled.
+     * Bug #696152
+     */
+    code = gs_distance_transform_inverse(0.0, 1.0, &pim->ImageMatrix, &pt);
+    if (code < 0)
+        return code;
+    gs_distance_transform(pt.x, pt.y, pctm, &pt);
+    resolutiony = 1.0 / hypot(pt.x / pdev->HWResolution[0],
+                              pt.y / pdev->HWResolution[1]);
+    *presolution = min(resolution, resolutiony);
+    return 0;
+}
+
+/*
+ * Decide whether the compressed data of an 8-bit DCTDecode image can be
+ * written unchanged: new_setup_image_filters must not downsample it, and
+ * the image parameters must allow DCTEncode for it.
+ */
+bool
+psdf_image_can_pass_through(const gx_device_psdf * pdev,
+                            const gs_pixel_image_t * pim,
+                            const gs_matrix * pctm)
+{
+    const psdf_image_params *pdip;
+    double resolution;
+    int ncomp;
+
+    if (pim->ColorSpace == NULL || pim->BitsPerComponent != 8 ||
+        pim->ColorSpace->type->index == gs_color_space_index_Indexed)
+        return false;
+    ncomp = gs_color_space_num_components(pim->ColorSpace);
+    pdip = (ncomp == 1 ? &pdev->params.GrayImage : &pdev->params.ColorImage);
+    if (!pdip->Encode ||
+        !(pdip->AutoFilter || pdip->filter_template == &s_DCTE_template))
+        return false;
+    if (image_resolution(pdev, pim, pctm, &resolution) < 0)
+        return false;
+    return !do_downsample(pdip, pim, resolution);
+}
+
 /* Set up compression and downsampling filters for an image. */
 /* Note that this may modify the image parameters. */
 int
@@ -897,7 +964,7 @@ new_setup_image_filters(gx_device_psdf * pdev, psdf_binary_writer * pbw,
     int bpc = pim->BitsPerComponent;
     int bpc_out = pim->BitsPerComponent = min(bpc, 8);
     int ncomp;
-    double resolution, resolutiony;
+    double resolution;
 
     /*
      * The Adobe documentation doesn't say this, but mask images are
@@ -936,32 +1003,9 @@ new_setup_image_filters(gx_device_psdf * pdev, psdf_binary_writer * pbw,
      *    W / (W * ImageMatrix^-1 * CTM / HWResolution).
      * We can replace W by 1 to simplify the computation.
      */
-    if (pctm == 0)
-        resolution = -1;
-    else {
-        gs_point pt;
-
-        /* We could do both X and Y, but why bother? */
-        code = gs_distance_transform_inverse(1.0, 0.0, &pim->ImageMatrix, &pt);
-        if (code < 0)
-            return code;
-        gs_distance_transform(pt.x, pt.y, pctm, &pt);
-        resolution = 1.0 / hypot(pt.x / pdev->HWResolution[0],
-                                 pt.y / pdev->HWResolution[1]);
-
-        /* Actually we must do both X and Y, in case the image is ananmorphically scaled
-         * and one axis is not high enough resolution to be downsampled.
-         * Bug #696152
-         */
-        code = gs_distance_transform_inverse(0.0, 1.0, &pim->ImageMatrix, &pt);
-        if (code < 0)
-            return code;
-        gs_distance_transform(pt.x, pt.y, pctm, &pt);
-        resolutiony = 1.0 / hypot(pt.x / pdev->HWResolution[0],
-                                 pt.y / pdev->HWResolution[1]);
-        if (resolutiony < resolution)
-            resolution = resolutiony;
-    }
+    code = image_resolution(pdev, pim, pctm, &resolution);
+    if (code < 0)
+        return code;
     if (ncomp == 1 && pim->ColorSpace && pim->ColorSpace->type->index != gs_color_space_index_Indexed) {
         /* Monochrome, gray, or mask */
         /* Check for downsampling. */
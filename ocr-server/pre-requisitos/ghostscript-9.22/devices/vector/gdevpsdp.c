@@ -475,6 +475,10 @@ gdev_psdf_get_param(gx_device *dev, char *Param, void *list)
     if (code != gs_error_undefined)
         return code;
 
+    if (strcmp(Param, "NumRenderingThreads") == 0) {
+        return(param_write_int(plist, "NumRenderingThreads",
+                               &pdev->NumRenderingThreads));
+    }
     if (strcmp(Param, "AutoRotatePages") == 0) {
         return(psdf_write_name(plist, "AutoRotatePages",
                 AutoRotatePages_names[(int)pdev->params.AutoRotatePages]));
@@ -540,6 +544,11 @@ gdev_psdf_get_params(gx_device * dev, gs_param_list * plist)
     if (code < 0)
         return code;
 
+    code = param_write_int(plist, "NumRenderingThreads",
+                           &pdev->NumRenderingThreads);
+    if (code < 0)
+        return code;
+
     /* General parameters */
 
     code = psdf_write_name(plist, "AutoRotatePages",
@@ -1046,6 +1055,7 @@ gdev_psdf_put_params(gx_device * dev, gs_param_list * plist)
         (pdev->v_memory ? pdev->v_memory : dev->memory);
     int ecode, code = 0;
     psdf_distiller_params params;
+    int NumRenderingThreads = pdev->NumRenderingThreads;
 
     params = pdev->params;
 
@@ -1140,6 +1150,21 @@ gdev_psdf_put_params(gx_device * dev, gs_param_list * plist)
         psdf_put_enum(plist, "CannotEmbedFontPolicy",
                       (int)params.CannotEmbedFontPolicy,
                       CannotEmbedFontPolicy_names, &ecode);
+
+    /* Threads for Flate compression, not a distiller parameter. */
+
+    switch (code = param_read_int(plist, "NumRenderingThreads",
+                                  &NumRenderingThreads)) {
+        case 0:
+            if (NumRenderingThreads >= 0)
+                break;
+            code = gs_error_rangecheck;
+        default:
+            ecode = code;
+            param_signal_error(plist, "NumRenderingThreads", ecode);
+        case 1:
+            break;
+    }
     if (ecode < 0) {
         code = ecode;
         goto exit;
@@ -1156,6 +1181,8 @@ gdev_psdf_put_params(gx_device * dev, gs_param_list * plist)
         goto exit;
 
     code = gdev_vector_put_params(dev, plist);
+    if (code >= 0)
+        pdev->NumRenderingThreads = NumRenderingThreads;
 
 exit:
     if (!(pdev->params.LockDistillerParams && params.LockDistillerParams)) {
@@ -0,0 +1,530 @@
+/* Copyright (C) 2001-2017 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  7 Mt. Lassen Drive - Suite A-134, San Rafael,
+   CA  94903, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* gsserve.c */
+/*
+ * Conversion service front end for the Ghostscript interpreter library.
+ *
+ * One interpreter is initialised through the gsapi with the options
+ * common to every job, so Resource/Init, the font maps and the ICC
+ * manager are set up once.  Each job is then run in a child forked from
+ * that interpreter: the job starts from the same freshly initialised
+ * state, none of its state survives it, and a job that crashes only
+ * takes its own process down.
+ *
+ *    gsserve -S socket [-j running] [-n jobs] [-t seconds] [--] options...
+ *
+ * options are ordinary Ghostscript switches (no file names).  A client
+ * connects to the Unix domain socket and sends a list of NUL terminated
+ * strings, ended by an empty string:
+ *
+ *    working-directory output-file input-file...
+ *
+ * The job sets OutputFile and runs the input files in order, exactly as
+ * "gs options -sOutputFile=output-file input-file..." would.  Everything
+ * it writes to stdout and stderr is sent back over the connection,
+ * followed by a NUL byte, the exit status as decimal text and a newline.
+ * The status is the one gs would have exited with, or 128 plus the
+ * signal number if the job was killed (-t sets SIGALRM as a time limit).
+ *
+ * Up to -j jobs (default 1) run at the same time; further connections
+ * wait in the listen queue.  Each job is watched by a small process of
+ * its own that reports its status, so the interpreter process only has
+ * to reap them.  After -n jobs (default 1000) the interpreter is shut
+ * down once its running jobs are done, and a new one initialised, so
+ * changes to fonts and resources on disk are picked up; the same happens
+ * if it dies for any reason.  The listening socket stays open across the
+ * restart, so clients only ever see a delay.  The socket is created
+ * accessible to its owner only.
+ *
+ * With -dSAFER the interpreter is initialised as with -dDELAYSAFER, and
+ * each job runs .setsafe once it has set its OutputFile.
+ */
+
+#include "malloc_.h"
+#include "memory_.h"
+#include "string_.h"
+#include "unistd_.h"
+#include "fcntl_.h"
+#include "stat_.h"
+#include "errno_.h"
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "ghost.h"
+#include "ierrors.h"
+#include "iapi.h"
+#include "imain.h"
+#include "iminst.h"
+#include "icstate.h"
+#include "gsdevice.h"
+#include "gxdevcli.h"
+#include "gslibctx.h"
+#include "gssprintf.h"
+
+#define GSSERVE_MAX_REQUEST (1024 * 1024)
+
+/* Exit status of an interpreter process that could not initialise. */
+#define GSSERVE_INIT_FAILED 2
+
+static volatile sig_atomic_t terminating = 0;
+
+static char null_output[] = "-sOutputFile=/dev/null";
+static char delay_safer[] = "-dDELAYSAFER";
+
+static void
+terminate_handler(int sig)
+{
+    terminating = 1;
+}
+
+static int
+write_all(int fd, const char *buf, int len)
+{
+    while (len > 0) {
+        int count = write(fd, buf, len);
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += count;
+        len -= count;
+    }
+    return 0;
+}
+
+/* Messages go straight to file descriptor 2; jobs get their own. */
+static void
+report(const char *format, ...)
+{
+    char buf[300];
+    va_list args;
+
+    va_start(args, format);
+    memcpy(buf, "gsserve: ", 9);
+    gs_vsnprintf(buf + 9, sizeof(buf) - 10, format, args);
+    va_end(args);
+    strcat(buf, "\n");
+    write_all(2, buf, strlen(buf));
+}
+
+/* Map an interpreter return code to a gs exit status, as gs.c does. */
+static int
+exit_status(int code)
+{
+    switch (code) {
+        case 0:
+        case gs_error_Info:
+        case gs_error_Quit:
+            return 0;
+        case gs_error_Fatal:
+            return 1;
+        default:
+            return 255;
+    }
+}
+
+/*
+ * Read a request: NUL terminated strings up to and including an empty
+ * one.  Return the number of strings before the empty one and point
+ * strv at them, or -1 if the request is malformed or the client went
+ * away.
+ */
+static int
+read_request(int fd, char **pbuf, char ***pstrv)
+{
+    int size = 4096, len = 0, count = 0, i;
+    char *buf = malloc(size), *p;
+    char **strv;
+
+    if (buf == NULL)
+        return -1;
+    for (;;) {
+        int n;
+
+        /* Done when the buffer ends in an empty string. */
+        if ((len == 1 && buf[0] == 0) ||
+            (len >= 2 && buf[len - 1] == 0 && buf[len - 2] == 0))
+            break;
+        if (len == size) {
+            char *nbuf;
+
+            if (size >= GSSERVE_MAX_REQUEST)
+                goto fail;
+            size *= 2;
+            nbuf = realloc(buf, size);
+            if (nbuf == NULL)
+                goto fail;
+            buf = nbuf;
+        }
+        n = read(fd, buf + len, size - len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            goto fail;
+        len += n;
+    }
+    for (p = buf; *p; p += strlen(p) + 1)
+        count++;
+    strv = malloc((count + 1) * sizeof(char *));
+    if (strv == NULL)
+        goto fail;
+    for (p = buf, i = 0; i < count; p += strlen(p) + 1)
+        strv[i++] = p;
+    strv[count] = NULL;
+    *pbuf = buf;
+    *pstrv = strv;
+    return count;
+fail:
+    free(buf);
+    return -1;
+}
+
+/* Run a string of PostScript with arg appended as a hex string. */
+static int
+run_with_arg(void *instance, const char *pre, const char *arg,
+             const char *post)
+{
+    static const char *const hex = "0123456789abcdef";
+    int len = strlen(pre) + strlen(arg) * 2 + 2 + strlen(post) + 1;
+    char *line = malloc(len), *d;
+    const unsigned char *p;
+    int code, exit_code;
+
+    if (line == NULL)
+        return gs_error_VMerror;
+    strcpy(line, pre);
+    d = line + strlen(line);
+    *d++ = '<';
+    for (p = (const unsigned char *)arg; *p; p++) {
+        *d++ = hex[*p >> 4];
+        *d++ = hex[*p & 0xf];
+    }
+    *d++ = '>';
+    strcpy(d, post);
+    code = gsapi_run_string(instance, line, 0, &exit_code);
+    free(line);
+    return code;
+}
+
+static gs_main_instance *
+main_instance(void *instance)
+{
+    return get_minst_from_memory(((gs_lib_ctx_t *)instance)->memory);
+}
+
+/*
+ * Close the output device the interpreter opened during initialisation.
+ * Its output and scratch files would otherwise be shared by every forked
+ * job; this way each job opens the device afresh when it sets its own
+ * OutputFile.
+ */
+static int
+close_initial_device(void *instance)
+{
+    gs_main_instance *minst = main_instance(instance);
+    gx_device *dev = gs_currentdevice(minst->i_ctx_p->pgs);
+
+    if (dev->LockSafetyParams) {
+        /* setpagedevice would silently keep the old OutputFile. */
+        report("the output file cannot be changed once LockSafetyParams is set");
+        return gs_error_invalidaccess;
+    }
+    return gs_closedevice(dev);
+}
+
+/* Run one job on the connection fd.  This is the forked child. */
+static int
+run_job(void *instance, int fd, int timeout, int safer)
+{
+    char *buf;
+    char **strv;
+    gs_main_instance *minst = main_instance(instance);
+    int count = read_request(fd, &buf, &strv);
+    int code = 0, code1, i;
+
+    if (count < 2) {
+        dup2(fd, 2);
+        report("malformed request");
+        return 255;
+    }
+    dup2(fd, 1);
+    dup2(fd, 2);
+    if (chdir(strv[0]) < 0) {
+        report("cannot change to %s: %s", strv[0], strerror(errno));
+        return 255;
+    }
+    if (timeout > 0)
+        alarm(timeout);
+    code = run_with_arg(instance, "<< /OutputFile ", strv[1],
+                        safer ? " >> setpagedevice .setsafe" :
+                                " >> setpagedevice");
+    for (i = 2; i < count && code == 0; i++) {
+        /* Let relative names resolve against the working directory
+         * before the library path, as for files on the gs command line.
+         */
+        minst->i_ctx_p->starting_arg_file = true;
+        code = run_with_arg(instance, "", strv[i], " .runfile");
+        minst->i_ctx_p->starting_arg_file = false;
+    }
+    /* Closing the device writes the output file. */
+    code1 = gsapi_exit(instance);
+    if (code == 0 || code == gs_error_Quit)
+        code = code1;
+    return exit_status(code);
+}
+
+/* Send the status trailer that ends a reply. */
+static void
+send_status(int fd, int status)
+{
+    char trailer[16];
+    int len;
+
+    trailer[0] = 0;
+    len = 1 + gs_snprintf(trailer + 1, sizeof(trailer) - 1, "%d\n", status);
+    write_all(fd, trailer, len);
+}
+
+/*
+ * Run a job in a child and report how it ended.  This is the process
+ * forked for each connection; it stays small, as it only waits.
+ */
+static int
+watch_job(void *instance, int fd, int timeout, int safer)
+{
+    int status;
+    pid_t pid = fork();
+
+    if (pid == 0)
+        _exit(run_job(instance, fd, timeout, safer));
+    if (pid < 0) {
+        report("fork: %s", strerror(errno));
+        status = 255;
+    } else {
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        if (WIFSIGNALED(status)) {
+            report("job %d killed by signal %d", (int)pid,
+                   WTERMSIG(status));
+            status = 128 + WTERMSIG(status);
+        } else
+            status = WEXITSTATUS(status);
+    }
+    send_status(fd, status);
+    return 0;
+}
+
+/*
+ * Reap finished jobs and return how many are still running.  If block
+ * is set, wait until at least one has finished.
+ */
+static int
+reap_jobs(int running, int block)
+{
+    while (running > 0) {
+        pid_t pid = waitpid(-1, NULL, block ? 0 : WNOHANG);
+
+        if (pid < 0 && errno == EINTR)
+            continue;
+        if (pid <= 0)
+            break;
+        running--;
+        block = 0;
+    }
+    return running;
+}
+
+/*
+ * Initialise an interpreter and serve up to max_jobs jobs from it, at
+ * most max_running at a time.  Return 0 after max_jobs jobs,
+ * GSSERVE_INIT_FAILED if the interpreter cannot be initialised.
+ */
+static int
+serve(int listen_fd, int argc, char *argv[], int max_running, int max_jobs,
+      int timeout, int safer)
+{
+    void *instance;
+    int code, jobs, running = 0;
+
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    if (gsapi_new_instance(&instance, NULL) < 0)
+        return GSSERVE_INIT_FAILED;
+    code = gsapi_init_with_args(instance, argc, argv);
+    if (code >= 0)
+        code = close_initial_device(instance);
+    if (code < 0) {
+        gsapi_exit(instance);
+        gsapi_delete_instance(instance);
+        return GSSERVE_INIT_FAILED;
+    }
+    for (jobs = 0; jobs < max_jobs;) {
+        int fd;
+        pid_t pid;
+
+        running = reap_jobs(running, running >= max_running);
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            report("accept: %s", strerror(errno));
+            break;
+        }
+        jobs++;
+        pid = fork();
+        if (pid == 0) {
+            close(listen_fd);
+            _exit(watch_job(instance, fd, timeout, safer));
+        }
+        if (pid < 0) {
+            report("fork: %s", strerror(errno));
+            send_status(fd, 255);
+        } else
+            running++;
+        close(fd);
+    }
+    while (running > 0)
+        running = reap_jobs(running, 1);
+    gsapi_exit(instance);
+    gsapi_delete_instance(instance);
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    int max_running = 1, max_jobs = 1000, timeout = 0, safer = 0;
+    int listen_fd, fd, i, starts;
+    mode_t mask;
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    char **gsargv;
+    int gsargc;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--")) {
+            i++;
+            break;
+        } else if (!strcmp(argv[i], "-S") && i + 1 < argc)
+            path = argv[++i];
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            max_running = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            max_jobs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            timeout = atoi(argv[++i]);
+        else
+            break;
+    }
+    if (path == NULL || max_running <= 0 || max_jobs <= 0 || timeout < 0 ||
+        strlen(path) >= sizeof(addr.sun_path)) {
+        report("usage: gsserve -S socket [-j running] [-n jobs] [-t seconds] [--] options...");
+        return 1;
+    }
+
+    /* The interpreter sees "gsserve -sOutputFile=/dev/null options...";
+     * pdfwrite and friends need an OutputFile to open the initial device,
+     * and each job replaces it.
+     */
+    gsargc = argc - i + 2;
+    gsargv = malloc((gsargc + 1) * sizeof(char *));
+    if (gsargv == NULL)
+        return 1;
+    gsargv[0] = argv[0];
+    gsargv[1] = null_output;
+    memcpy(gsargv + 2, argv + i, (argc - i) * sizeof(char *));
+    gsargv[gsargc] = NULL;
+    for (i = 2; i < gsargc; i++) {
+        /* Jobs lock down once their OutputFile is set. */
+        if (!strcmp(gsargv[i], "-dSAFER") ||
+            !strcmp(gsargv[i], "-dPARANOIDSAFER")) {
+            gsargv[i] = delay_safer;
+            safer = 1;
+        }
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        report("socket: %s", strerror(errno));
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    mask = umask(0177);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 64) < 0) {
+        report("%s: %s", path, strerror(errno));
+        return 1;
+    }
+    umask(mask);
+    fcntl(listen_fd, F_SETFD, FD_CLOEXEC);
+    fd = open("/dev/null", O_RDONLY);
+    if (fd >= 0) {
+        dup2(fd, 0);
+        close(fd);
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = terminate_handler;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Supervisor: keep an interpreter process running. */
+    for (starts = 0; !terminating; starts++) {
+        int status;
+        pid_t pid = fork();
+
+        if (pid == 0)
+            _exit(serve(listen_fd, gsargc, gsargv, max_running, max_jobs,
+                        timeout, safer));
+        if (pid < 0) {
+            report("fork: %s", strerror(errno));
+            sleep(1);
+            continue;
+        }
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR)
+                break;
+            if (terminating)
+                kill(pid, SIGTERM);
+        }
+        if (terminating)
+            break;
+        if (WIFEXITED(status) &&
+            WEXITSTATUS(status) == GSSERVE_INIT_FAILED) {
+            report("cannot initialise the interpreter");
+            if (starts == 0)
+                break;
+            /* Don't spin if the set-up on disk is broken. */
+            sleep(1);
+        } else if (WIFSIGNALED(status)) {
+            report("interpreter killed by signal %d, restarting",
+                   WTERMSIG(status));
+            sleep(1);
+        }
+    }
+    unlink(path);
+    close(listen_fd);
+    return terminating ? 0 : 1;
+}
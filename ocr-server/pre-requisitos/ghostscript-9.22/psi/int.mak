@@ -1602,7 +1602,7 @@ $(PSD)dctd.dev : $(ECHOGS_XE) $(GLD)sdctd.dev $(GLD)sddparam.dev\
 $(PSOBJ)zfdctd.$(OBJ) : $(PSSRC)zfdctd.c $(OP)\
  $(memory__h) $(stdio__h) $(jpeglib__h) $(gsmemory_h)\
  $(ialloc_h) $(ifilter_h) $(iparam_h) $(sdct_h) $(sjpeg_h)\
- $(strimpl_h) $(INT_MAK) $(MAKEDIRS)
+ $(strimpl_h) $(gxdevice_h) $(gxdevsop_h) $(igstate_h) $(INT_MAK) $(MAKEDIRS)
 	$(PSCC) $(PSO_)zfdctd.$(OBJ) $(C_) $(PSSRC)zfdctd.c
 
 # ================ Display PostScript ================ #
@@ -1928,6 +1928,12 @@ $(PSOBJ)apitest.$(OBJ) : $(PSSRC)apitest.c $(GH)\
  $(locale__h) $(gp_h) $(INT_MAK) $(MAKEDIRS)
 	$(PSCC) $(PSO_)apitest.$(OBJ) $(C_) $(PSSRC)apitest.c
 
+$(PSOBJ)gsserve.$(OBJ) : $(PSSRC)gsserve.c $(GH)\
+ $(malloc__h) $(memory__h) $(string__h) $(unistd__h) $(fcntl__h) $(stat__h)\
+ $(errno__h) $(ierrors_h) $(iapi_h) $(imain_h) $(iminst_h) $(icstate_h)\
+ $(gsdevice_h) $(gxdevcli_h) $(gslibctx_h) $(gssprintf_h) $(INT_MAK) $(MAKEDIRS)
+	$(PSCC) $(PSO_)gsserve.$(OBJ) $(C_) $(PSSRC)gsserve.c
+
 $(PSOBJ)iapi.$(OBJ) : $(PSSRC)iapi.c $(AK)\
  $(string__h) $(ierrors_h) $(gscdefs_h) $(gstypes_h) $(iapi_h)\
  $(iref_h) $(imain_h) $(imainarg_h) $(iminst_h) $(gslibctx_h)\
@@ -21,12 +21,15 @@
 #include "ghost.h"
 #include "oper.h"
 #include "gsmemory.h"
+#include "gxdevice.h"
+#include "gxdevsop.h"		/* for gxdso_* enums */
 #include "strimpl.h"
 #include "sdct.h"
 #include "sjpeg.h"
 #include "ialloc.h"
 #include "ifilter.h"
 #include "iparam.h"
+#include "igstate.h"
 
 private_st_jpeg_decompress_data();
 
@@ -48,6 +51,28 @@ find_stream_memory(i_ctx_t *i_ctx_p, int npop, uint *space)
     return idmemory->spaces_indexed[*space >> r_space_shift];
 }
 
+/* Hand the compressed data of the filter on to the device. */
+static int
+zDCTD_pass_through(void *client, jpeg_passthrough_op op, const byte *data,
+                   uint size)
+{
+    gx_device *dev = (gx_device *)client;
+    int dso;
+
+    switch (op) {
+        case jpeg_passthrough_begin:
+            dso = gxdso_JPEG_passthrough_begin;
+            break;
+        case jpeg_passthrough_data:
+            dso = gxdso_JPEG_passthrough_data;
+            break;
+        default:
+            dso = gxdso_JPEG_passthrough_end;
+            break;
+    }
+    return dev_proc(dev, dev_spec_op)(dev, dso, (void *)data, size);
+}
+
 /* <source> <dict> DCTDecode/filter <file> */
 /* <source> DCTDecode/filter <file> */
 static int
@@ -78,6 +103,7 @@ zDCTD(i_ctx_t *i_ctx_p)
     state.data.decompress = jddp;
     jddp->memory = state.jpeg_memory = mem;	/* set now for allocation */
     jddp->scanline_buffer = NULL;	/* set this early for safe error exit */
+    jddp->PassThroughfn = NULL;
     state.report_error = filter_report_error;	/* in case create fails */
     if ((code = gs_jpeg_create_decompress(&state)) < 0)
         goto fail;		/* correct to do jpeg_destroy here */
@@ -86,6 +112,20 @@ zDCTD(i_ctx_t *i_ctx_p)
         goto fail;
     if ((code = s_DCTD_put_params((gs_param_list *) & list, &state)) < 0)
         goto rel;
+    /*
+     * Offer the compressed data to the device, which may write it out in
+     * place of the decoded image. An explicit ColorTransform would be lost
+     * in the copy, so the data are only offered without one.
+     */
+    if (state.ColorTransform == -1) {
+        gx_device *dev = gs_currentdevice(igs);
+
+        if (dev_proc(dev, dev_spec_op)(dev, gxdso_JPEG_passthrough_query,
+                                       NULL, 0) > 0) {
+            jddp->PassThroughfn = zDCTD_pass_through;
+            jddp->PassThroughClient = dev;
+        }
+    }
     /* Create the filter. */
     jddp->templat = s_DCTD_template;
     code = filter_read(i_ctx_p, 0, &jddp->templat,
@@ -0,0 +1,153 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ * colorclass.c
+ *
+ *   Reduces a scanned image to the smallest depth that represents it.
+ *
+ *   Syntax: colorclass filein [fileout]
+ *
+ *   pixColorClass() decides whether the image really needs color.
+ *   If not, it is converted to 8 bpp luminance, and if the page is
+ *   also black and white, it is thresholded to 1 bpp.  The result is
+ *   written to @fileout, or back to @filein if @fileout is omitted.
+ *   A color image is left alone when written in place.
+ *
+ *   The output keeps the input format, with these exceptions:
+ *      - tiff is written with zip compression for 8 bpp and with
+ *        g4 compression for 1 bpp
+ *      - a 1 bpp image can't be written as jpeg or webp, so it is
+ *        written as png, with the filename extension changed to 'png';
+ *        when converting in place, @filein is then removed
+ *      - an 8 bpp image is written as jpeg with quality 95, so that
+ *        recompressing the scan doesn't visibly add to its artifacts,
+ *        and as lossless webp
+ *      - only the first image of a multipage file is read and written
+ *
+ *   One line is printed to stdout:
+ *         <color|gray|bitonal> <colorfract> <midfract> <fileout>
+ *
+ *   Color is tested on the average of blocks about 1/300 of the
+ *   largest image dimension in size, which is about 1 mm on a page.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+static const char  *classname[] = {"", "color", "gray", "bitonal"};
+
+int main(int    argc,
+         char **argv)
+{
+char        *filein, *fileout, *base;
+l_int32      w, h, d, factor, format, class, thresh, ret;
+l_float32    colorfract, midfract;
+PIX         *pixs, *pixg, *pixd;
+static char  mainName[] = "colorclass";
+
+    if (argc != 2 && argc != 3)
+        return ERROR_INT(" Syntax: colorclass filein [fileout]", mainName, 1);
+
+    filein = argv[1];
+    fileout = (argc == 3) ? argv[2] : argv[1];
+    if ((pixs = pixRead(filein)) == NULL) {
+        L_ERROR("read fail for %s\n", mainName, filein);
+        return 1;
+    }
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    factor = L_MAX(1, L_MAX(w, h) / 300);
+    if (pixColorClass(pixs, factor, -1, -1.0, -1.0, &class, &thresh,
+                      &colorfract, &midfract)) {
+        pixDestroy(&pixs);
+        return ERROR_INT("pixColorClass failed", mainName, 1);
+    }
+
+        /* Reduce the depth */
+    pixg = NULL;
+    if (class == L_CLASS_COLOR || (class == L_CLASS_GRAY && d <= 8) ||
+        d == 1) {
+        pixd = pixClone(pixs);
+    } else {
+        pixg = pixConvertTo8(pixs, FALSE);
+        if (class == L_CLASS_GRAY)
+            pixd = pixClone(pixg);
+        else
+            pixd = pixThresholdToBinary(pixg, thresh);
+    }
+
+        /* Choose the output format */
+    format = pixGetInputFormat(pixs);
+    d = pixGetDepth(pixd);
+    switch (format) {
+    case IFF_TIFF:
+    case IFF_TIFF_PACKBITS:
+    case IFF_TIFF_RLE:
+    case IFF_TIFF_G3:
+    case IFF_TIFF_G4:
+    case IFF_TIFF_LZW:
+    case IFF_TIFF_ZIP:
+        format = (d == 1) ? IFF_TIFF_G4 : IFF_TIFF_ZIP;
+        break;
+    case IFF_JFIF_JPEG:
+    case IFF_WEBP:
+        if (d == 1) format = IFF_PNG;
+        break;
+    case IFF_UNKNOWN:
+        format = pixChooseOutputFormat(pixd);
+        break;
+    default:
+        break;
+    }
+    if (format == IFF_PNG && pixGetInputFormat(pixs) != IFF_PNG) {
+        splitPathAtExtension(fileout, &base, NULL);
+        fileout = stringJoin(base, ".png");
+        lept_free(base);
+    }
+
+    if (pixd != pixs || argc == 3) {
+        if (format == IFF_JFIF_JPEG)
+            ret = pixWriteJpeg(fileout, pixd, 95, 0);
+        else if (format == IFF_WEBP)
+            ret = pixWriteWebP(fileout, pixd, 100, 1);
+        else
+            ret = pixWrite(fileout, pixd, format);
+        if (ret) {
+            L_ERROR("write fail for %s\n", mainName, fileout);
+            return 1;
+        }
+        if (argc == 2 && strcmp(fileout, filein))
+            lept_rmfile(filein);
+    }
+    fprintf(stdout, "%s %6.4f %6.4f %s\n", classname[class], colorfract,
+            midfract, fileout);
+
+    pixDestroy(&pixs);
+    pixDestroy(&pixg);
+    pixDestroy(&pixd);
+    return 0;
+}
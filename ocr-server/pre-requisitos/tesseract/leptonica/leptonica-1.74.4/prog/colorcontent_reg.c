@@ -28,17 +28,21 @@
  *  colorcontent_reg.c
  *
  *   This tests various color content functions, including a simple
- *   color quantization method.
+ *   color quantization method, and the classification of scanned
+ *   pages as color, gray or bitonal.
  */
 
 #include "string.h"
 #include "allheaders.h"
 
+static PIX *ScanPage(PIX *pixs);
+static l_int32 ClassifyPage(PIX *pixs);
+
 l_int32 main(int    argc,
              char **argv)
 {
 l_uint32     *colors;
-l_int32       ncolors;
+l_int32       ncolors, class;
 l_float32     fcolor;
 PIX          *pix1, *pix2, *pix3;
 PIXA         *pixadb;
@@ -102,5 +106,62 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix3);
     pixaDestroy(&pixadb);
 
+        /* Classify scanned pages.  A text page goes bitonal, even with
+         * jpeg noise; the same page with a small color stamp stays
+         * color; a blank page stays gray, as it has no contrast. */
+    pix1 = pixRead("patent.png");
+    pix2 = ScanPage(pix1);
+    class = ClassifyPage(pix2);
+    regTestCompareValues(rp, L_CLASS_BITONAL, class, 0.0);  /* 10 */
+    pix3 = pixRead("feynman-stamp.jpg");
+    pixRasterop(pix2, 1800, 200, pixGetWidth(pix3), pixGetHeight(pix3),
+                PIX_SRC, pix3, 0, 0);
+    pixDestroy(&pix1);
+    pix1 = ScanPage(pix2);
+    class = ClassifyPage(pix1);
+    regTestCompareValues(rp, L_CLASS_COLOR, class, 0.0);  /* 11 */
+    class = ClassifyPage(pix3);
+    regTestCompareValues(rp, L_CLASS_COLOR, class, 0.0);  /* 12 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pix1 = pixCreate(2320, 3408, 32);
+    pixSetAllArbitrary(pix1, 0xf4f0e800);  /* slightly yellow paper */
+    pix3 = pixAddGaussianNoise(pix1, 4.0);
+    pix2 = ScanPage(pix3);
+    pixDestroy(&pix3);
+    class = ClassifyPage(pix2);
+    regTestCompareValues(rp, L_CLASS_GRAY, class, 0.0);  /* 13 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
     return regTestCleanup(rp);
 }
+
+    /* Returns a 32 bpp version of pixs with the artifacts of a jpeg scan */
+static PIX *
+ScanPage(PIX  *pixs)
+{
+l_uint8  *data;
+size_t    size;
+PIX      *pix1, *pixd;
+
+    pix1 = pixConvertTo32(pixs);
+    pixWriteMemJpeg(&data, &size, pix1, 75, 0);
+    pixd = pixReadMemJpeg(data, size, 0, 1, NULL, 0);
+    lept_free(data);
+    pixDestroy(&pix1);
+    return pixd;
+}
+
+    /* Classifies pixs with the block size colorclass uses */
+static l_int32
+ClassifyPage(PIX  *pixs)
+{
+l_int32  class, factor;
+
+    factor = L_MAX(1, L_MAX(pixGetWidth(pixs), pixGetHeight(pixs)) / 300);
+    class = 0;
+    pixColorClass(pixs, factor, -1, -1.0, -1.0, &class, NULL, NULL, NULL);
+    return class;
+}
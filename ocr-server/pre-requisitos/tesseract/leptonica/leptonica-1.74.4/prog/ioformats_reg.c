@@ -45,7 +45,8 @@
  *
  *    Section 4. Test read/write to memory with other compression formats.
  *
- *    Section 5. Test multippage tiff read/write to file and memory.
+ *    Section 5. Test multippage tiff read/write to file and memory,
+ *    and reading tiff images in many strips into a reused pix.
  *
  *    Section 6. Test writing 24 bpp (not 32 bpp) pix
  *
@@ -85,6 +86,8 @@ static l_int32 testcomp(const char *filename, PIX *pix, l_int32 comptype);
 static l_int32 testcomp_mem(PIX *pixs, PIX **ppixt, l_int32 index,
                             l_int32 format);
 static l_int32 test_writemem(PIX *pixs, l_int32 format, char *psfile);
+static l_int32 test_strips(L_REGPARAMS *rp, PIX *pixs, l_int32 comptype,
+                           l_int32 rowsperstrip, PIX **ppixd);
 static PIX *make_24_bpp_pix(PIX *pixs);
 static l_int32 get_header_data(const char *filename, l_int32 true_format);
 static void get_tiff_compression_name(char *buf, l_int32 format);
@@ -100,6 +103,7 @@ l_uint8      *data;
 l_int32       i, d, n, success, failure, same;
 l_int32       w, h, bps, spp;
 size_t        size, nbytes;
+BOX          *box;
 PIX          *pix1, *pix2, *pix4, *pix8, *pix16, *pix32;
 PIX          *pix, *pixt, *pixd;
 PIXA         *pixa;
@@ -360,6 +364,34 @@ L_REGPARAMS  *rp;
         }
         pixDestroy(&pix);
     }
+
+#if  HAVE_LIBPNG
+        /* A truncated png is not read, either into a new pix or into
+         * pixd, and pixd is left to the caller to reuse */
+    fprintf(stderr, "Truncated png\n");
+    pix = pixRead(FILE_8BPP_1);
+    pixWriteMemPng(&data, &size, pix, 0.0);
+    if ((pixt = pixReadMemPng(data, size / 2)) != NULL) {
+        fprintf(stderr, "Read truncated png\n");
+        success = FALSE;
+        pixDestroy(&pixt);
+    }
+    pixd = pixCreate(8, 8, 8);
+    if (pixReadMemPngToPix(pixd, data, size / 2) != NULL) {
+        fprintf(stderr, "Read truncated png into pixd\n");
+        success = FALSE;
+    }
+    pixt = pixReadMemPngToPix(pixd, data, size);
+    pixEqual(pix, pixd, &same);
+    if (pixt != pixd || !same) {
+        fprintf(stderr, "Failed to reuse pixd after truncated png\n");
+        success = FALSE;
+    }
+    lept_free(data);
+    pixDestroy(&pix);
+    pixDestroy(&pixd);
+#endif  /* HAVE_LIBPNG */
+
     if (success)
         fprintf(stderr,
             "\n  ********** Success on non-tiff r/w to memory *********\n\n");
@@ -417,6 +449,38 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix1);
     pixDestroy(&pix2);
 
+        /* Read images in many strips, each decoded in place into the
+         * same pix.  The strips are moved to the pix line spacing when
+         * the width is not a multiple of 32 bits, and the last strip
+         * is short when the height is not a multiple of rowsperstrip. */
+    success = TRUE;
+    pix = pixRead(FILE_1BPP);
+    pixd = NULL;
+    if (test_strips(rp, pix, IFF_TIFF_G4, 64, &pixd)) success = FALSE;
+    if (test_strips(rp, pix, IFF_TIFF_G4, 1, &pixd)) success = FALSE;
+    box = boxCreate(0, 0, 1001, 999);
+    pix1 = pixClipRectangle(pix, box, NULL);
+    boxDestroy(&box);
+    if (test_strips(rp, pix1, IFF_TIFF_G4, 64, &pixd)) success = FALSE;
+    if (test_strips(rp, pix1, IFF_TIFF_G3, 100, &pixd)) success = FALSE;
+    if (test_strips(rp, pix1, IFF_TIFF_PACKBITS, 7, &pixd)) success = FALSE;
+    if (test_strips(rp, pix1, IFF_TIFF, 64, &pixd)) success = FALSE;
+    pix8 = pixConvertTo8(pix1, FALSE);
+    if (test_strips(rp, pix8, IFF_TIFF_LZW, 37, &pixd)) success = FALSE;
+    if (test_strips(rp, pix8, IFF_TIFF_ZIP, 2000, &pixd)) success = FALSE;
+    if (test_strips(rp, pix, IFF_TIFF_G4, 3000, &pixd)) success = FALSE;
+    pixDestroy(&pix);
+    pixDestroy(&pix1);
+    pixDestroy(&pix8);
+    pixDestroy(&pixd);
+    if (success)
+        fprintf(stderr,
+            "\n  ******* Success on tiff multistrip read to pix ******\n\n");
+    else
+        fprintf(stderr,
+            "\n  ******* Failure on tiff multistrip read to pix ******\n\n");
+    if (!success) failure = TRUE;
+
     /* ------------ Part 6: Test 24 bpp writing ------------ */
 #if  !HAVE_LIBTIFF
 part6:
@@ -671,6 +735,61 @@ PIX       *pixd = NULL;
 }
 
 
+    /* Writes pixs in strips of rowsperstrip rows, and reads it back into
+     * *ppixd, which is made on the first call and then reused. */
+static l_int32
+test_strips(L_REGPARAMS  *rp,
+            PIX          *pixs,
+            l_int32       comptype,
+            l_int32       rowsperstrip,
+            PIX         **ppixd)
+{
+char      buf[64];
+l_uint8  *data;
+l_int32   same, reused;
+size_t    size, offset;
+NUMA     *natags;
+PIX      *pixd;
+SARRAY   *savals, *satypes;
+
+    natags = numaCreate(1);
+    numaAddNumber(natags, 278);  /* TIFFTAG_ROWSPERSTRIP */
+    savals = sarrayCreate(1);
+    snprintf(buf, sizeof(buf), "%d", rowsperstrip);
+    sarrayAddString(savals, buf, L_COPY);
+    satypes = sarrayCreate(1);
+    sarrayAddString(satypes, (char *)"l_uint32", L_COPY);
+    pixWriteMemTiffCustom(&data, &size, pixs, comptype, natags, savals,
+                          satypes, NULL);
+    numaDestroy(&natags);
+    sarrayDestroy(&savals);
+    sarrayDestroy(&satypes);
+
+    offset = 0;
+    pixd = pixReadMemFromMultipageTiffToPix(*ppixd, data, size, &offset);
+    lept_free(data);
+    if (!pixd) {
+        fprintf(stderr, "Error: %d bpp, %d rows per strip not read\n",
+                pixGetDepth(pixs), rowsperstrip);
+        rp->success = FALSE;
+        return 1;
+    }
+    reused = (*ppixd == NULL || pixd == *ppixd);
+    if (!reused) {
+        fprintf(stderr, "Error: pix not reused\n");
+        rp->success = FALSE;
+        pixDestroy(ppixd);
+    }
+    *ppixd = pixd;
+    pixEqual(pixs, pixd, &same);
+    if (!same)
+        fprintf(stderr, "Error: %d bpp, %d rows per strip differ\n",
+                pixGetDepth(pixs), rowsperstrip);
+    regTestComparePix(rp, pixs, pixd);
+    return (same && reused) ? 0 : 1;
+}
+
+
     /* Composes 24 bpp rgb pix */
 static PIX *
 make_24_bpp_pix(PIX  *pixs)
@@ -37,12 +37,18 @@
  *
  *      Permutation table for 2x rank binary reduction
  *           l_uint8  *makeSubsampleTab2x(void)
+ *
+ *      Static helper for 2x subsampling of a raster line
+ *           static void  subsampleLine2xLow()
  * </pre>
  */
 
 #include <string.h>
 #include "allheaders.h"
 
+static void subsampleLine2xLow(l_uint32 *lined, l_uint32 *words,
+                               l_int32 nwords);
+
 
 /*------------------------------------------------------------------*
  *                       Subsampled reduction                       *
@@ -51,31 +57,22 @@
  * \brief   pixReduceBinary2()
  *
  * \param[in]    pixs
- * \param[in]    intab [optional]; if null, a table is made here
- *                   and destroyed before exit
+ * \param[in]    intab [optional]; no longer used
  * \return  pixd 2x subsampled, or NULL on error
  *
  * <pre>
  * Notes:
- *      (1) After folding, the data is in bytes 0 and 2 of the word,
- *          and the bits in each byte are in the following order
- *          (with 0 being the leftmost originating pair and 7 being
- *          the rightmost originating pair):
- *               0 4 1 5 2 6 3 7
- *          These need to be permuted to
- *               0 1 2 3 4 5 6 7
- *          which is done with an 8-bit table generated by makeSubsampleTab2x().
+ *      (1) The even pixels of each pair of src words are packed into
+ *          a dest word by subsampleLine2xLow(), with shifts and masks
+ *          only.  The permutation table from makeSubsampleTab2x()
+ *          that was used before is not needed, and %intab is ignored.
  * </pre>
  */
 PIX *
 pixReduceBinary2(PIX      *pixs,
                  l_uint8  *intab)
 {
-l_uint8    byte0, byte1;
-l_uint8   *tab;
-l_uint16   shortd;
-l_int32    i, id, j, ws, hs, wpls, wpld, wplsi;
-l_uint32   word;
+l_int32    i, id, ws, hs, wpls, wpld, wplsi;
 l_uint32  *datas, *datad, *lines, *lined;
 PIX       *pixd;
 
@@ -87,13 +84,6 @@ PIX       *pixd;
     if (pixGetDepth(pixs) != 1)
         return (PIX *)ERROR_PTR("pixs not binary", procName, NULL);
 
-    if (intab) {  /* use input table */
-        tab = intab;
-    } else {
-        if ((tab = makeSubsampleTab2x()) == NULL)
-            return (PIX *)ERROR_PTR("tab not made", procName, NULL);
-    }
-
     ws = pixGetWidth(pixs);
     hs = pixGetHeight(pixs);
     if (hs <= 1)
@@ -114,19 +104,9 @@ PIX       *pixd;
     for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
         lines = datas + i * wpls;
         lined = datad + id * wpld;
-        for (j = 0; j < wplsi; j++) {
-            word = *(lines + j);
-            word = word & 0xaaaaaaaa;  /* mask */
-            word = word | (word << 7);  /* fold; data in bytes 0 & 2 */
-            byte0 = word >> 24;
-            byte1 = (word >> 8) & 0xff;
-            shortd = (tab[byte0] << 8) | tab[byte1];
-            SET_DATA_TWO_BYTES(lined, j, shortd);
-        }
+        subsampleLine2xLow(lined, lines, wplsi);
     }
 
-    if (intab == NULL)
-        LEPT_FREE(tab);
     return pixd;
 }
 
@@ -157,8 +137,7 @@ pixReduceRankBinaryCascade(PIX     *pixs,
                            l_int32  level3,
                            l_int32  level4)
 {
-PIX      *pix1, *pix2, *pix3, *pix4;
-l_uint8  *tab;
+PIX  *pix1, *pix2, *pix3, *pix4;
 
     PROCNAME("pixReduceRankBinaryCascade");
 
@@ -174,32 +153,22 @@ l_uint8  *tab;
         return pixCopy(NULL, pixs);
     }
 
-    if ((tab = makeSubsampleTab2x()) == NULL)
-        return (PIX *)ERROR_PTR("tab not made", procName, NULL);
-
-    pix1 = pixReduceRankBinary2(pixs, level1, tab);
-    if (level2 <= 0) {
-        LEPT_FREE(tab);
+    pix1 = pixReduceRankBinary2(pixs, level1, NULL);
+    if (level2 <= 0)
         return pix1;
-    }
 
-    pix2 = pixReduceRankBinary2(pix1, level2, tab);
+    pix2 = pixReduceRankBinary2(pix1, level2, NULL);
     pixDestroy(&pix1);
-    if (level3 <= 0) {
-        LEPT_FREE(tab);
+    if (level3 <= 0)
         return pix2;
-    }
 
-    pix3 = pixReduceRankBinary2(pix2, level3, tab);
+    pix3 = pixReduceRankBinary2(pix2, level3, NULL);
     pixDestroy(&pix2);
-    if (level4 <= 0) {
-        LEPT_FREE(tab);
+    if (level4 <= 0)
         return pix3;
-    }
 
-    pix4 = pixReduceRankBinary2(pix3, level4, tab);
+    pix4 = pixReduceRankBinary2(pix3, level4, NULL);
     pixDestroy(&pix3);
-    LEPT_FREE(tab);
     return pix4;
 }
 
@@ -209,8 +178,7 @@ l_uint8  *tab;
  *
  * \param[in]    pixs 1 bpp
  * \param[in]    level rank threshold: 1, 2, 3, 4
- * \param[in]    intab [optional]; if null, a table is made here
- *                     and destroyed before exit
+ * \param[in]    intab [optional]; no longer used
  * \return  pixd 1 bpp, 2x rank threshold reduced, or NULL on error
  *
  * <pre>
@@ -223,6 +191,9 @@ l_uint8  *tab;
  *          using only logical operations.  Then these pixels are chosen
  *          in the 2x subsampling process, subsampled, as described
  *          above in pixReduceBinary2().
+ *      (4) Each pair of lines is filtered into a line buffer, and then
+ *          subsampled.  Both loops are simple enough for the compiler
+ *          to vectorize.
  * </pre>
  */
 PIX *
@@ -230,12 +201,9 @@ pixReduceRankBinary2(PIX      *pixs,
                      l_int32   level,
                      l_uint8  *intab)
 {
-l_uint8    byte0, byte1;
-l_uint8   *tab;
-l_uint16   shortd;
 l_int32    i, id, j, ws, hs, wpls, wpld, wplsi;
 l_uint32   word1, word2, word3, word4;
-l_uint32  *datas, *datad, *lines, *lined;
+l_uint32  *datas, *datad, *lines, *lined, *bufs;
 PIX       *pixd;
 
     PROCNAME("pixReduceRankBinary2");
@@ -249,13 +217,6 @@ PIX       *pixd;
         return (PIX *)ERROR_PTR("level must be in set {1,2,3,4}",
             procName, NULL);
 
-    if (intab) {  /* use input table */
-        tab = intab;
-    } else {
-        if ((tab = makeSubsampleTab2x()) == NULL)
-            return (PIX *)ERROR_PTR("tab not made", procName, NULL);
-    }
-
     ws = pixGetWidth(pixs);
     hs = pixGetHeight(pixs);
     if (hs <= 1)
@@ -272,36 +233,28 @@ PIX       *pixd;
 
         /* e.g., if ws = 65: wd = 32, wpls = 3, wpld = 1 --> trouble */
     wplsi = L_MIN(wpls, 2 * wpld);  /* iterate over this number of words */
+    if ((bufs = (l_uint32 *)LEPT_CALLOC(wplsi, sizeof(l_uint32))) == NULL) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("bufs not made", procName, NULL);
+    }
 
-    switch (level)
-    {
-
-    case 1:
-        for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
-            lines = datas + i * wpls;
-            lined = datad + id * wpld;
+    for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
+        lines = datas + i * wpls;
+        lined = datad + id * wpld;
+        switch (level)
+        {
+        case 1:
             for (j = 0; j < wplsi; j++) {
                 word1 = *(lines + j);
                 word2 = *(lines + wpls + j);
 
                     /* OR/OR */
                 word2 = word1 | word2;
-                word2 = word2 | (word2 << 1);
-
-                word2 = word2 & 0xaaaaaaaa;  /* mask */
-                word1 = word2 | (word2 << 7);  /* fold; data in bytes 0 & 2 */
-                byte0 = word1 >> 24;
-                byte1 = (word1 >> 8) & 0xff;
-                shortd = (tab[byte0] << 8) | tab[byte1];
-                SET_DATA_TWO_BYTES(lined, j, shortd);
+                bufs[j] = word2 | (word2 << 1);
             }
-        }
-        break;
+            break;
 
-    case 2:
-        for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
-            lines = datas + i * wpls;
-            lined = datad + id * wpld;
+        case 2:
             for (j = 0; j < wplsi; j++) {
                 word1 = *(lines + j);
                 word2 = *(lines + wpls + j);
@@ -311,22 +264,11 @@ PIX       *pixd;
                 word3 = word3 | (word3 << 1);
                 word4 = word1 | word2;
                 word4 = word4 & (word4 << 1);
-                word2 = word3 | word4;
-
-                word2 = word2 & 0xaaaaaaaa;  /* mask */
-                word1 = word2 | (word2 << 7);  /* fold; data in bytes 0 & 2 */
-                byte0 = word1 >> 24;
-                byte1 = (word1 >> 8) & 0xff;
-                shortd = (tab[byte0] << 8) | tab[byte1];
-                SET_DATA_TWO_BYTES(lined, j, shortd);
+                bufs[j] = word3 | word4;
             }
-        }
-        break;
+            break;
 
-    case 3:
-        for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
-            lines = datas + i * wpls;
-            lined = datad + id * wpld;
+        case 3:
             for (j = 0; j < wplsi; j++) {
                 word1 = *(lines + j);
                 word2 = *(lines + wpls + j);
@@ -336,43 +278,25 @@ PIX       *pixd;
                 word3 = word3 | (word3 << 1);
                 word4 = word1 | word2;
                 word4 = word4 & (word4 << 1);
-                word2 = word3 & word4;
-
-                word2 = word2 & 0xaaaaaaaa;  /* mask */
-                word1 = word2 | (word2 << 7);  /* fold; data in bytes 0 & 2 */
-                byte0 = word1 >> 24;
-                byte1 = (word1 >> 8) & 0xff;
-                shortd = (tab[byte0] << 8) | tab[byte1];
-                SET_DATA_TWO_BYTES(lined, j, shortd);
+                bufs[j] = word3 & word4;
             }
-        }
-        break;
+            break;
 
-    case 4:
-        for (i = 0, id = 0; i < hs - 1; i += 2, id++) {
-            lines = datas + i * wpls;
-            lined = datad + id * wpld;
+        case 4:
             for (j = 0; j < wplsi; j++) {
                 word1 = *(lines + j);
                 word2 = *(lines + wpls + j);
 
                     /* AND/AND */
                 word2 = word1 & word2;
-                word2 = word2 & (word2 << 1);
-
-                word2 = word2 & 0xaaaaaaaa;  /* mask */
-                word1 = word2 | (word2 << 7);  /* fold; data in bytes 0 & 2 */
-                byte0 = word1 >> 24;
-                byte1 = (word1 >> 8) & 0xff;
-                shortd = (tab[byte0] << 8) | tab[byte1];
-                SET_DATA_TWO_BYTES(lined, j, shortd);
+                bufs[j] = word2 & (word2 << 1);
             }
+            break;
         }
-        break;
+        subsampleLine2xLow(lined, bufs, wplsi);
     }
 
-    if (!intab)
-        LEPT_FREE(tab);
+    LEPT_FREE(bufs);
     return pixd;
 }
 
@@ -412,3 +336,56 @@ l_int32   i;
 
     return tab;
 }
+
+
+/*------------------------------------------------------------------*
+ *                  Static helper for 2x subsampling                *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   subsampleLine2xLow()
+ *
+ * \param[in]    lined dest raster line
+ * \param[in]    words src raster line, or a filtered copy of it
+ * \param[in]    nwords number of src words to subsample
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This takes the even pixels (bits 31, 29, ... 1) of each src
+ *          word and packs them in order into 16 bits, so each pair of
+ *          src words makes one dest word.  The packing halves the
+ *          spacing of the bits at each step, with shifts and masks.
+ *      (2) If %nwords is odd, the last src word fills only the left
+ *          half of the last dest word, and the right half is cleared.
+ * </pre>
+ */
+static void
+subsampleLine2xLow(l_uint32  *lined,
+                   l_uint32  *words,
+                   l_int32    nwords)
+{
+l_int32   j;
+l_uint32  word1, word2;
+
+    for (j = 0; j < nwords / 2; j++) {
+        word1 = (words[2 * j] >> 1) & 0x55555555;
+        word1 = (word1 | (word1 >> 1)) & 0x33333333;
+        word1 = (word1 | (word1 >> 2)) & 0x0f0f0f0f;
+        word1 = (word1 | (word1 >> 4)) & 0x00ff00ff;
+        word1 = (word1 | (word1 >> 8)) & 0x0000ffff;
+        word2 = (words[2 * j + 1] >> 1) & 0x55555555;
+        word2 = (word2 | (word2 >> 1)) & 0x33333333;
+        word2 = (word2 | (word2 >> 2)) & 0x0f0f0f0f;
+        word2 = (word2 | (word2 >> 4)) & 0x00ff00ff;
+        word2 = (word2 | (word2 >> 8)) & 0x0000ffff;
+        lined[j] = (word1 << 16) | word2;
+    }
+    if (nwords & 1) {
+        word1 = (words[nwords - 1] >> 1) & 0x55555555;
+        word1 = (word1 | (word1 >> 1)) & 0x33333333;
+        word1 = (word1 | (word1 >> 2)) & 0x0f0f0f0f;
+        word1 = (word1 | (word1 >> 4)) & 0x00ff00ff;
+        word1 = (word1 | (word1 >> 8)) & 0x0000ffff;
+        lined[nwords / 2] = word1 << 16;
+    }
+}
@@ -47,6 +47,10 @@
  *      Finds the fraction of pixels with "color" that are not close to black
  *         l_int32    pixColorFraction()
  *
+ *      Decides if an image needs color, or can be reduced to gray
+ *      or to black and white
+ *         l_int32    pixColorClass()
+ *
  *      Determine if there are significant color regions that are
  *      not background in a page image
  *         l_int32    pixFindColorRegions()
@@ -136,6 +140,7 @@
  * </pre>
  */
 
+#include <string.h>
 #include "allheaders.h"
 
 /* ----------------------------------------------------------------------- *
@@ -733,6 +738,222 @@ l_uint32  *data, *line;
 }
 
 
+/* ----------------------------------------------------------------------- *
+ *          Decides if an image is really color, gray or bitonal           *
+ * ----------------------------------------------------------------------- */
+/*!
+ * \brief   pixColorClass()
+ *
+ * \param[in]    pixs          1, 2, 4, 8, 16 or 32 bpp; colormap OK
+ * \param[in]    factor        size of the square blocks whose average
+ *                             color is tested; integer >= 1
+ * \param[in]    satthresh     minimum difference between the largest and
+ *                             smallest component for a block to have
+ *                             color; typ. 40; -1 for default
+ * \param[in]    mincolorfract minimum fraction of color blocks for the
+ *                             image to be color; typ. 0.0003; -1.0 for default
+ * \param[in]    maxmidfract   maximum fraction of intermediate gray pixels
+ *                             for the image to be bitonal; typ. 0.05;
+ *                             -1.0 for default
+ * \param[out]   pclass        L_CLASS_COLOR, L_CLASS_GRAY or L_CLASS_BITONAL
+ * \param[out]   pthresh       [optional] threshold for pixThresholdToBinary()
+ *                             on the luminance of pixs
+ * \param[out]   pcolorfract   [optional] fraction of color blocks
+ * \param[out]   pmidfract     [optional] fraction of intermediate pixels
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is meant for scanned pages, to find the smallest depth
+ *          that represents them: L_CLASS_GRAY can be converted with
+ *          pixConvertRGBToLuminance(), and L_CLASS_BITONAL can then be
+ *          thresholded at %thresh.
+ *      (2) A single pass over pixs builds a histogram of the luminance
+ *          of every pixel, and one of the saturation (max - min
+ *          component) of the average color of each %factor x %factor
+ *          block.  The per-pixel work is done a line at a time in
+ *          branch-free loops that the compiler vectorizes.
+ *      (3) Averaging over blocks removes most of the jpeg chroma noise
+ *          and the color fringes that scanners leave on the edges of
+ *          black strokes, which would otherwise be taken for color.
+ *          Partial blocks at the right and bottom are not tested.
+ *      (4) The image is color if at least %mincolorfract of the blocks
+ *          have a saturation of at least %satthresh.  The default is
+ *          low enough to keep a small color stamp on a text page: a
+ *          stamp of about 2 x 1.5 cm on a letter page is about 0.0005,
+ *          whereas gray and text scans are at most 0.0001.
+ *      (5) Otherwise the luminance histogram is split into a dark and a
+ *          light part with numaSplitDistribution().  A pixel is
+ *          intermediate if it is farther than a quarter of the distance
+ *          between the two averages from both of them.  The image is
+ *          bitonal if at most %maxmidfract of the pixels are intermediate,
+ *          the averages are at least 64 apart and the dark part has at
+ *          least 0.1% of the pixels; a page without that contrast or
+ *          without that much ink (e.g., blank) is kept gray.
+ *      (6) 1 bpp images are always bitonal, and images without color
+ *          components are never color.
+ * </pre>
+ */
+l_int32
+pixColorClass(PIX        *pixs,
+              l_int32     factor,
+              l_int32     satthresh,
+              l_float32   mincolorfract,
+              l_float32   maxmidfract,
+              l_int32    *pclass,
+              l_int32    *pthresh,
+              l_float32  *pcolorfract,
+              l_float32  *pmidfract)
+{
+l_int32    i, j, k, w, h, d, wpl, nbx, nby, ncolor, nmid, splitindex;
+l_int32    rval, gval, bval, minval, maxval;
+l_int32   *sathisto, *grayhisto, *rsum, *gsum, *bsum;
+l_uint8   *grayline;
+l_uint32   pixel;
+l_uint32  *data, *line;
+l_float32  colorfract, midfract, ave1, ave2, num1, num2, delta;
+NUMA      *na;
+PIX       *pixc, *pixt;
+
+    PROCNAME("pixColorClass");
+
+    if (pthresh) *pthresh = 128;
+    if (pcolorfract) *pcolorfract = 0.0;
+    if (pmidfract) *pmidfract = 0.0;
+    if (!pclass)
+        return ERROR_INT("&class not defined", procName, 1);
+    *pclass = L_CLASS_COLOR;
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+    if (factor < 1) factor = 1;
+    if (satthresh < 0) satthresh = 40;  /* defaults */
+    if (mincolorfract < 0.0) mincolorfract = 0.0003;
+    if (maxmidfract < 0.0) maxmidfract = 0.05;
+
+    if (pixGetColormap(pixs))
+        pixc = pixRemoveColormap(pixs, REMOVE_CMAP_BASED_ON_SRC);
+    else
+        pixc = pixClone(pixs);
+    d = pixGetDepth(pixc);
+    if (d == 1) {
+        pixDestroy(&pixc);
+        *pclass = L_CLASS_BITONAL;
+        return 0;
+    }
+    if (d != 8 && d != 32) {
+        pixt = pixConvertTo8(pixc, FALSE);
+        pixDestroy(&pixc);
+        if ((pixc = pixt) == NULL)
+            return ERROR_INT("pixc not made", procName, 1);
+        d = 8;
+    }
+
+    pixGetDimensions(pixc, &w, &h, NULL);
+    data = pixGetData(pixc);
+    wpl = pixGetWpl(pixc);
+    nbx = w / factor;
+    nby = h / factor;
+    sathisto = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
+    grayhisto = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
+    grayline = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
+    rsum = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
+    gsum = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
+    bsum = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
+    if (!sathisto || !grayhisto || !grayline || !rsum || !gsum || !bsum) {
+        pixDestroy(&pixc);
+        LEPT_FREE(sathisto);
+        LEPT_FREE(grayhisto);
+        LEPT_FREE(grayline);
+        LEPT_FREE(rsum);
+        LEPT_FREE(gsum);
+        LEPT_FREE(bsum);
+        return ERROR_INT("calloc fail for arrays", procName, 1);
+    }
+
+        /* The integer luminance weights are those of
+         * pixConvertRGBToLuminance(), scaled by 256.  The component
+         * sums of the columns are collected over each band of %factor
+         * lines, and then added over the blocks of the band. */
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        if (d == 8) {
+            for (j = 0; j < w; j++)
+                grayhisto[GET_DATA_BYTE(line, j)]++;
+            continue;
+        }
+        for (j = 0; j < w; j++) {
+            pixel = line[j];
+            rval = pixel >> L_RED_SHIFT;
+            gval = (pixel >> L_GREEN_SHIFT) & 0xff;
+            bval = (pixel >> L_BLUE_SHIFT) & 0xff;
+            rsum[j] += rval;
+            gsum[j] += gval;
+            bsum[j] += bval;
+            grayline[j] = (77 * rval + 128 * gval + 51 * bval + 128) >> 8;
+        }
+        for (j = 0; j < w; j++)
+            grayhisto[grayline[j]]++;
+        if (i % factor != factor - 1)
+            continue;
+
+        for (k = 0; k < nbx; k++) {
+            rval = gval = bval = 0;
+            for (j = k * factor; j < (k + 1) * factor; j++) {
+                rval += rsum[j];
+                gval += gsum[j];
+                bval += bsum[j];
+            }
+            minval = L_MIN(rval, gval);
+            minval = L_MIN(minval, bval);
+            maxval = L_MAX(rval, gval);
+            maxval = L_MAX(maxval, bval);
+            sathisto[(maxval - minval) / (factor * factor)]++;
+        }
+        memset(rsum, 0, w * sizeof(l_int32));
+        memset(gsum, 0, w * sizeof(l_int32));
+        memset(bsum, 0, w * sizeof(l_int32));
+    }
+    pixDestroy(&pixc);
+    LEPT_FREE(grayline);
+    LEPT_FREE(rsum);
+    LEPT_FREE(gsum);
+    LEPT_FREE(bsum);
+
+    ncolor = 0;
+    for (i = satthresh; i < 256; i++)
+        ncolor += sathisto[i];
+    colorfract = (nbx * nby > 0) ? (l_float32)ncolor / (nbx * nby) : 0.0;
+    if (pcolorfract) *pcolorfract = colorfract;
+    LEPT_FREE(sathisto);
+    if (d == 32 && colorfract >= mincolorfract) {
+        LEPT_FREE(grayhisto);
+        return 0;
+    }
+
+        /* Not color: split the luminance into dark and light parts,
+         * and count the pixels that are in neither. */
+    *pclass = L_CLASS_GRAY;
+    na = numaCreateFromIArray(grayhisto, 256);
+    numaSplitDistribution(na, 0.1, &splitindex, &ave1, &ave2,
+                          &num1, &num2, NULL);
+    numaDestroy(&na);
+    delta = (ave2 - ave1) / 4.0;
+    nmid = 0;
+    for (i = 0; i < 256; i++) {
+        if (i > ave1 + delta && i < ave2 - delta)
+            nmid += grayhisto[i];
+    }
+    LEPT_FREE(grayhisto);
+    midfract = (l_float32)nmid / ((l_float32)w * h);
+    if (pmidfract) *pmidfract = midfract;
+    if (pthresh) *pthresh = splitindex;
+    if (midfract <= maxmidfract && ave2 - ave1 >= 64.0 &&
+        num1 >= 0.001 * w * h)
+        *pclass = L_CLASS_BITONAL;
+    return 0;
+}
+
+
 /* ----------------------------------------------------------------------- *
  *     Determine if there are significant color regions in a page image    *
  * ----------------------------------------------------------------------- */
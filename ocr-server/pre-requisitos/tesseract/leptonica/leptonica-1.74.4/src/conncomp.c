@@ -28,8 +28,8 @@
  * \file conncomp.c
  * <pre>
  *
- *    Connected component counting and extraction, using Heckbert's
- *    stack-based filling algorithm.
+ *    Connected component counting and extraction, by labeling runs
+ *    with union-find, and using Heckbert's stack-based filling algorithm.
  *
  *      4- and 8-connected components: counts, bounding boxes and images
  *
@@ -58,33 +58,29 @@
  *           static void    pushFillseg()
  *           static void    popFillseg()
  *
- *  The basic method in pixConnCompBB() is very simple.  We scan the
- *  image in raster order, looking for the next ON pixel.  When it
- *  is found, we erase it and every pixel of the 4- or 8-connected
- *  component to which it belongs, using Heckbert's seedfill
- *  algorithm.  As pixels are erased, we keep track of the
- *  minimum rectangle that encloses all erased pixels; after
- *  the connected component has been erased, we save its
- *  bounding box in an array of boxes.  When all pixels in the
- *  image have been erased, we have an array that describes every
- *  4- or 8-connected component in terms of its bounding box.
+ *      Static helper functions for labeling c.c. by runs:
+ *           static CCRUNS *ccRunsCreate()
+ *           static void    ccRunsDestroy()
+ *           static BOXA   *ccRunsGetBoxa()
+ *           static void    ccUnionRowsLow()
+ *           static l_int32 findRunsOnLineLow()
+ *           static void    setRunOnLineLow()
  *
- *  pixConnCompPixa() is a slight variation on pixConnCompBB(),
- *  where we additionally save an array of images (in a Pixa)
- *  of each of the 4- or 8-connected components.  This is done trivially
- *  by maintaining two temporary images.  We erase a component from one,
- *  and use the bounding box to extract the pixels within the b.b.
- *  from each of the two images.  An XOR between these subimages
- *  gives the erased component.  Then we erase the component from the
- *  second image using the XOR again, with the extracted component
- *  placed on the second image at the location of the bounding box.
- *  Rasterop does all the work.  At the end, we have an array
- *  of the 4- or 8-connected components, as well as an array of the
- *  bounding boxes that describe where they came from in the original image.
+ *  The top-level calls label the image with ccRunsCreate().  The runs
+ *  of ON pixels in each raster line are found a word at a time, and
+ *  each run is joined with the runs that it touches in the line above
+ *  using a union-find forest over the runs.  A second pass over the
+ *  runs numbers the c.c. and finds their bounding boxes, and for
+ *  pixConnCompPixa(), writes each run into the image of its c.c.
+ *  The cost is linear in the number of words and runs, independent
+ *  of the number of c.c., and the rows can be labeled in bands in
+ *  parallel.  The c.c. are numbered in raster order of their first
+ *  pixel, which is the order in which a raster scan with
+ *  nextOnPixelInRaster() finds them.
  *
- *  If you just want the number of connected components, pixCountConnComp()
- *  is a bit faster than pixConnCompBB(), because it doesn't have to
- *  keep track of the bounding rectangles for each c.c.
+ *  The seedfill functions find and erase a single c.c. from a seed
+ *  pixel, using Heckbert's algorithm.  As pixels are erased, they keep
+ *  track of the minimum rectangle that encloses all erased pixels.
  * </pre>
  */
 
@@ -106,6 +102,36 @@ struct FillSeg
 typedef struct FillSeg    FILLSEG;
 
 
+/*!
+ * \brief   The struct CCRuns holds the runs of ON pixels of a 1 bpp image,
+ *  in raster order, and the c.c. to which each run belongs.
+ */
+struct CCRuns
+{
+    l_int32    h;          /*!< image height                                */
+    l_int32    nruns;      /*!< number of runs                              */
+    l_int32    ncomp;      /*!< number of c.c.                              */
+    l_int32   *rowstart;   /*!< index of first run of each row; h + 1 long  */
+    l_int32   *xstart;     /*!< first pixel of each run                     */
+    l_int32   *xend;       /*!< last pixel of each run                      */
+    l_int32   *label;      /*!< c.c. of each run, numbered in raster order  */
+};
+typedef struct CCRuns    CCRUNS;
+
+    /* Rows in each band of the image that is labeled independently */
+static const l_int32  CONNCOMP_BAND_ROWS = 64;
+
+
+    /* Static functions for labeling c.c. by runs */
+static CCRUNS *ccRunsCreate(PIX *pixs, l_int32 connectivity);
+static void ccRunsDestroy(CCRUNS **pccr);
+static BOXA *ccRunsGetBoxa(CCRUNS *ccr);
+static void ccUnionRowsLow(CCRUNS *ccr, l_int32 y, l_int32 slop);
+static l_int32 findRunsOnLineLow(l_uint32 *line, l_int32 wpl,
+                                 l_uint32 lastmask, l_int32 *tab,
+                                 l_int32 *xstart, l_int32 *xend);
+static void setRunOnLineLow(l_uint32 *line, l_int32 x0, l_int32 x1);
+
     /* Static accessors for FillSegs on a stack */
 static void pushFillsegBB(L_STACK *stack, l_int32 xleft, l_int32 xright,
                           l_int32 y, l_int32 dy, l_int32 ymax,
@@ -176,10 +202,10 @@ pixConnComp(PIX     *pixs,
  *      (1) This finds bounding boxes of 4- or 8-connected components
  *          in a binary image, and saves images of each c.c
  *          in a pixa array.
- *      (2) It sets up 2 temporary pix, and for each c.c. that is
- *          located in raster order, it erases the c.c. from one pix,
- *          then uses the b.b. to extract the c.c. from the two pix using
- *          an XOR, and finally erases the c.c. from the second pix.
+ *      (2) The c.c. are labeled by ccRunsCreate(), and the image of
+ *          each c.c. is made by writing its runs into a pix of the
+ *          size of its b.b.  Pixels of other c.c. within the b.b.
+ *          are not included.
  *      (3) A clone of the returned boxa (where all boxes in the array
  *          are clones) is inserted into the pixa.
  *      (4) If the input is valid, this always returns a boxa and a pixa.
@@ -191,13 +217,14 @@ pixConnCompPixa(PIX     *pixs,
                 PIXA   **ppixa,
                 l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1, *pix2, *pix3, *pix4;
-PIXA     *pixa;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32    i, j, k, x, y, iszero, wpld;
+l_uint32  *datad;
+PIX       *pixd;
+PIX      **pixs_cc;
+PIXA      *pixa;
+BOX       *box;
+BOXA      *boxa;
+CCRUNS    *ccr;
 
     PROCNAME("pixConnCompPixa");
 
@@ -209,76 +236,65 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    pix1 = pix2 = pix3 = pix4 = NULL;
-    stack = NULL;
     pixa = pixaCreate(0);
-    boxa = NULL;
     *ppixa = pixa;
     pixZero(pixs, &iszero);
     if (iszero)
         return boxaCreate(1);  /* return empty boxa and empty pixa */
 
-    pix1 = pixCopy(NULL, pixs);
-    pix2 = pixCopy(NULL, pixs);
-    if (!pix1 || !pix2) {
-        L_ERROR("pix1 or pix2 not made\n", procName);
+    if ((ccr = ccRunsCreate(pixs, connectivity)) == NULL) {
         pixaDestroy(ppixa);
-        goto cleanup;
+        return (BOXA *)ERROR_PTR("ccr not made", procName, NULL);
     }
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
+    if ((boxa = ccRunsGetBoxa(ccr)) == NULL) {
+        ccRunsDestroy(&ccr);
         pixaDestroy(ppixa);
-        goto cleanup;
+        return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
     }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
 
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
+        /* Make an empty pix for each c.c., as pixClipRectangle() would */
+    pixs_cc = (PIX **)LEPT_CALLOC(ccr->ncomp, sizeof(PIX *));
+    for (i = 0; i < ccr->ncomp; i++) {
+        box = boxaGetBox(boxa, i, L_CLONE);
+        pixd = pixCreate(box->w, box->h, 1);
+        boxDestroy(&box);
+        if (!pixd) {
+            L_ERROR("pixd not made\n", procName);
+            for (j = 0; j < i; j++)
+                pixDestroy(&pixs_cc[j]);
+            LEPT_FREE(pixs_cc);
             boxaDestroy(&boxa);
+            ccRunsDestroy(&ccr);
             pixaDestroy(ppixa);
-            L_ERROR("box not made\n", procName);
-            goto cleanup;
+            return NULL;
         }
-        boxaAddBox(boxa, box, L_INSERT);
-
-            /* Save the c.c. and remove from pix2 as well */
-        pix3 = pixClipRectangle(pix1, box, NULL);
-        pix4 = pixClipRectangle(pix2, box, NULL);
-        pixXor(pix3, pix3, pix4);
-        pixRasterop(pix2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
-                    pix3, 0, 0);
-        pixaAddPix(pixa, pix3, L_INSERT);
-        pixDestroy(&pix4);
-
-        xstart = x;
-        ystart = y;
+        pixCopyResolution(pixd, pixs);
+        pixCopyColormap(pixd, pixs);
+        pixCopyText(pixd, pixs);
+        pixs_cc[i] = pixd;
     }
 
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
+        /* Write each run into the pix of its c.c. */
+    for (y = 0; y < ccr->h; y++) {
+        for (k = ccr->rowstart[y]; k < ccr->rowstart[y + 1]; k++) {
+            i = ccr->label[k];
+            box = boxa->box[i];
+            x = box->x;
+            datad = pixGetData(pixs_cc[i]);
+            wpld = pixGetWpl(pixs_cc[i]);
+            setRunOnLineLow(datad + (y - box->y) * wpld,
+                            ccr->xstart[k] - x, ccr->xend[k] - x);
+        }
+    }
+    for (i = 0; i < ccr->ncomp; i++)
+        pixaAddPix(pixa, pixs_cc[i], L_INSERT);
+    LEPT_FREE(pixs_cc);
+    ccRunsDestroy(&ccr);
 
         /* Remove old boxa of pixa and replace with a copy */
     boxaDestroy(&pixa->boxa);
     pixa->boxa = boxaCopy(boxa, L_COPY);
     *ppixa = pixa;
-
-        /* Cleanup, freeing the fillsegs on each stack */
-cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
-    pixDestroy(&pix2);
     return boxa;
 }
 
@@ -294,21 +310,18 @@ cleanup:
  * Notes:
  *     (1) Finds bounding boxes of 4- or 8-connected components
  *         in a binary image.
- *     (2) This works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.  In the process,
- *         the b.b. is computed and saved.
+ *     (2) The c.c. are labeled by ccRunsCreate(), and are returned in
+ *         raster order of their first pixel, which is the order in
+ *         which the seedfill functions would find and erase them.
  * </pre>
  */
 BOXA *
 pixConnCompBB(PIX     *pixs,
               l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32  iszero;
+BOXA    *boxa;
+CCRUNS  *ccr;
 
     PROCNAME("pixConnCompBB");
 
@@ -317,52 +330,16 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    boxa = NULL;
-    pix1 = NULL;
-    stack = NULL;
     pixZero(pixs, &iszero);
     if (iszero)
         return boxaCreate(1);  /* return empty boxa */
 
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pix1 not made", procName, NULL);
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
-        goto cleanup;
-    }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
-            L_ERROR("box not made\n", procName);
-            boxaDestroy(&boxa);
-            goto cleanup;
-        }
-        boxaAddBox(boxa, box, L_INSERT);
-
-        xstart = x;
-        ystart = y;
-    }
-
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
-
-        /* Cleanup, freeing the fillsegs on each stack */
-cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
+    if ((ccr = ccRunsCreate(pixs, connectivity)) == NULL)
+        return (BOXA *)ERROR_PTR("ccr not made", procName, NULL);
+    boxa = ccRunsGetBoxa(ccr);
+    ccRunsDestroy(&ccr);
+    if (!boxa)
+        return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
     return boxa;
 }
 
@@ -378,18 +355,16 @@ cleanup:
  * Notes:
  *     (1 This is the top-level call for getting the number of
  *         4- or 8-connected components in a 1 bpp image.
- *     2 It works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.
+ *     2 The c.c. are labeled by ccRunsCreate(); the input pix is
+ *         not altered.
  */
 l_int32
 pixCountConnComp(PIX      *pixs,
                  l_int32   connectivity,
                  l_int32  *pcount)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-L_STACK  *stack, *auxstack;
+l_int32  iszero;
+CCRUNS  *ccr;
 
     PROCNAME("pixCountConnComp");
 
@@ -401,36 +376,14 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return ERROR_INT("connectivity not 4 or 8", procName, 1);
 
-    stack = NULL;
     pixZero(pixs, &iszero);
     if (iszero)
         return 0;
 
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return ERROR_INT("pix1 not made", procName, 1);
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        pixDestroy(&pix1);
-        return ERROR_INT("stack not made\n", procName, 1);
-    }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        pixSeedfill(pix1, stack, x, y, connectivity);
-        (*pcount)++;
-        xstart = x;
-        ystart = y;
-    }
-
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
+    if ((ccr = ccRunsCreate(pixs, connectivity)) == NULL)
+        return ERROR_INT("ccr not made", procName, 1);
+    *pcount = ccr->ncomp;
+    ccRunsDestroy(&ccr);
     return 0;
 }
 
@@ -1244,3 +1197,366 @@ L_STACK  *auxstack;
     lstackAdd(auxstack, fseg);
     return;
 }
+
+
+/*-----------------------------------------------------------------------*
+ *       Static helper functions: labeling c.c. by runs and union-find   *
+ *-----------------------------------------------------------------------*/
+/*!
+ * \brief   ccRunsCreate()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    connectivity 4 or 8
+ * \return  ccr, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This labels the c.c. with two passes over the runs of ON
+ *          pixels instead of a seedfill of each c.c., so the time
+ *          does not grow with the number of c.c.  That matters on
+ *          noisy scans with tens of thousands of specks.
+ *      (2) The runs of each row are found a word at a time, skipping
+ *          words that are all OFF (or all ON, inside a run).  Each run
+ *          is joined with the runs it touches in the row above, with a
+ *          union-find forest in which the root of a tree is always its
+ *          run of lowest index.  The rows are split into bands that
+ *          are done in parallel if OpenMP is enabled, and the unions
+ *          across band boundaries are then made in order.
+ *      (3) Runs are indexed in raster order, so the root of each c.c.
+ *          is the run that holds its first pixel in raster order.  The
+ *          c.c. are numbered in that order, which is the order in which
+ *          they are found by scanning with nextOnPixelInRaster().
+ * </pre>
+ */
+static CCRUNS *
+ccRunsCreate(PIX     *pixs,
+             l_int32  connectivity)
+{
+l_int32    w, h, wpl, i, y, k, nbands, nruns, ncomp, slop;
+l_int32   *tab, *rowstart, *label;
+l_uint32   lastmask;
+l_uint32  *data;
+CCRUNS    *ccr;
+
+    PROCNAME("ccRunsCreate");
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = pixGetWpl(pixs);
+    data = pixGetData(pixs);
+    lastmask = (w & 31) ? ~(0xffffffff >> (w & 31)) : 0xffffffff;
+    slop = (connectivity == 8) ? 1 : 0;
+    if ((tab = makeMSBitLocTab(1)) == NULL)
+        return (CCRUNS *)ERROR_PTR("tab not made", procName, NULL);
+    ccr = (CCRUNS *)LEPT_CALLOC(1, sizeof(CCRUNS));
+    ccr->h = h;
+    ccr->rowstart = (l_int32 *)LEPT_CALLOC(h + 1, sizeof(l_int32));
+    if (!ccr->rowstart) {
+        LEPT_FREE(tab);
+        ccRunsDestroy(&ccr);
+        return (CCRUNS *)ERROR_PTR("rowstart not made", procName, NULL);
+    }
+    rowstart = ccr->rowstart;
+
+        /* Count the runs in each row, and then store them */
+    nbands = (h + CONNCOMP_BAND_ROWS - 1) / CONNCOMP_BAND_ROWS;
+#ifdef _OPENMP
+#pragma omp parallel for private(y)
+#endif
+    for (i = 0; i < nbands; i++) {
+        for (y = i * CONNCOMP_BAND_ROWS;
+             y < L_MIN(h, (i + 1) * CONNCOMP_BAND_ROWS); y++) {
+            rowstart[y + 1] = findRunsOnLineLow(data + y * wpl, wpl, lastmask,
+                                                tab, NULL, NULL);
+        }
+    }
+    for (y = 0; y < h; y++)
+        rowstart[y + 1] += rowstart[y];
+    nruns = rowstart[h];
+    ccr->nruns = nruns;
+    ccr->xstart = (l_int32 *)LEPT_CALLOC(L_MAX(nruns, 1), sizeof(l_int32));
+    ccr->xend = (l_int32 *)LEPT_CALLOC(L_MAX(nruns, 1), sizeof(l_int32));
+    ccr->label = (l_int32 *)LEPT_CALLOC(L_MAX(nruns, 1), sizeof(l_int32));
+    if (!ccr->xstart || !ccr->xend || !ccr->label) {
+        LEPT_FREE(tab);
+        ccRunsDestroy(&ccr);
+        return (CCRUNS *)ERROR_PTR("run arrays not made", procName, NULL);
+    }
+    label = ccr->label;
+    for (k = 0; k < nruns; k++)
+        label[k] = k;
+
+        /* Find the runs and join them within each band; the unions
+         * only touch runs of the band, so the bands are independent */
+#ifdef _OPENMP
+#pragma omp parallel for private(y)
+#endif
+    for (i = 0; i < nbands; i++) {
+        for (y = i * CONNCOMP_BAND_ROWS;
+             y < L_MIN(h, (i + 1) * CONNCOMP_BAND_ROWS); y++) {
+            findRunsOnLineLow(data + y * wpl, wpl, lastmask, tab,
+                              ccr->xstart + rowstart[y],
+                              ccr->xend + rowstart[y]);
+            if (y > i * CONNCOMP_BAND_ROWS)
+                ccUnionRowsLow(ccr, y, slop);
+        }
+    }
+    LEPT_FREE(tab);
+
+        /* Merge across the band boundaries */
+    for (i = 1; i < nbands; i++)
+        ccUnionRowsLow(ccr, i * CONNCOMP_BAND_ROWS, slop);
+
+        /* Number the c.c.  The parent of each run has a lower index, so
+         * it has already been given its c.c. number, encoded as
+         * -(number + 1) to tell it from a run index. */
+    ncomp = 0;
+    for (k = 0; k < nruns; k++) {
+        if (label[k] == k)
+            label[k] = -(++ncomp);
+        else
+            label[k] = label[label[k]];
+    }
+    for (k = 0; k < nruns; k++)
+        label[k] = -label[k] - 1;
+    ccr->ncomp = ncomp;
+    return ccr;
+}
+
+
+/*!
+ * \brief   ccRunsDestroy()
+ *
+ * \param[in,out]   pccr will be set to null before returning
+ * \return  void
+ */
+static void
+ccRunsDestroy(CCRUNS  **pccr)
+{
+CCRUNS  *ccr;
+
+    if (pccr == NULL || (ccr = *pccr) == NULL)
+        return;
+    LEPT_FREE(ccr->rowstart);
+    LEPT_FREE(ccr->xstart);
+    LEPT_FREE(ccr->xend);
+    LEPT_FREE(ccr->label);
+    LEPT_FREE(ccr);
+    *pccr = NULL;
+}
+
+
+/*!
+ * \brief   ccRunsGetBoxa()
+ *
+ * \param[in]    ccr
+ * \return  boxa of the b.b. of each c.c., in c.c. order, or NULL on error
+ */
+static BOXA *
+ccRunsGetBoxa(CCRUNS  *ccr)
+{
+l_int32   i, k, y, ncomp;
+l_int32  *minx, *miny, *maxx, *maxy;
+BOXA     *boxa;
+
+    PROCNAME("ccRunsGetBoxa");
+
+    ncomp = ccr->ncomp;
+    minx = (l_int32 *)LEPT_CALLOC(ncomp, sizeof(l_int32));
+    miny = (l_int32 *)LEPT_CALLOC(ncomp, sizeof(l_int32));
+    maxx = (l_int32 *)LEPT_CALLOC(ncomp, sizeof(l_int32));
+    maxy = (l_int32 *)LEPT_CALLOC(ncomp, sizeof(l_int32));
+    boxa = boxaCreate(ncomp);
+    if (!minx || !miny || !maxx || !maxy || !boxa) {
+        L_ERROR("arrays not made\n", procName);
+        boxaDestroy(&boxa);
+        goto cleanup;
+    }
+    for (i = 0; i < ncomp; i++) {
+        minx[i] = miny[i] = 0x7fffffff;
+        maxx[i] = maxy[i] = -1;
+    }
+
+    for (y = 0; y < ccr->h; y++) {
+        for (k = ccr->rowstart[y]; k < ccr->rowstart[y + 1]; k++) {
+            i = ccr->label[k];
+            minx[i] = L_MIN(minx[i], ccr->xstart[k]);
+            maxx[i] = L_MAX(maxx[i], ccr->xend[k]);
+            miny[i] = L_MIN(miny[i], y);
+            maxy[i] = y;
+        }
+    }
+    for (i = 0; i < ncomp; i++) {
+        boxaAddBox(boxa, boxCreate(minx[i], miny[i], maxx[i] - minx[i] + 1,
+                                   maxy[i] - miny[i] + 1), L_INSERT);
+    }
+
+cleanup:
+    LEPT_FREE(minx);
+    LEPT_FREE(miny);
+    LEPT_FREE(maxx);
+    LEPT_FREE(maxy);
+    return boxa;
+}
+
+
+/*!
+ * \brief   ccUnionRowsLow()
+ *
+ * \param[in]    ccr
+ * \param[in]    y row whose runs are joined to the runs of row y - 1
+ * \param[in]    slop 0 for 4-connectivity, 1 for 8-connectivity
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) A run of row y and a run of row y - 1 are in the same c.c.
+ *          if they overlap, after extending each by %slop at both ends.
+ *          Both rows are sorted, so they are merged in a single pass.
+ *      (2) The union makes the root of higher index a child of the root
+ *          of lower index, so every parent has a lower index than its
+ *          children, and path halving keeps it so.
+ * </pre>
+ */
+static void
+ccUnionRowsLow(CCRUNS  *ccr,
+               l_int32  y,
+               l_int32  slop)
+{
+l_int32   p, pend, c, cend, rp, rc;
+l_int32  *xstart, *xend, *label;
+
+    xstart = ccr->xstart;
+    xend = ccr->xend;
+    label = ccr->label;
+    p = ccr->rowstart[y - 1];
+    pend = ccr->rowstart[y];
+    c = pend;
+    cend = ccr->rowstart[y + 1];
+    while (p < pend && c < cend) {
+        if (xend[p] + slop < xstart[c]) {
+            p++;
+            continue;
+        }
+        if (xend[c] + slop < xstart[p]) {
+            c++;
+            continue;
+        }
+        for (rp = p; label[rp] != rp; rp = label[rp])
+            label[rp] = label[label[rp]];
+        for (rc = c; label[rc] != rc; rc = label[rc])
+            label[rc] = label[label[rc]];
+        if (rp < rc)
+            label[rc] = rp;
+        else if (rc < rp)
+            label[rp] = rc;
+        if (xend[p] < xend[c])
+            p++;
+        else
+            c++;
+    }
+}
+
+
+/*!
+ * \brief   findRunsOnLineLow()
+ *
+ * \param[in]    line data of a raster line of a 1 bpp image
+ * \param[in]    wpl words in the line
+ * \param[in]    lastmask mask of the image pixels in the last word
+ * \param[in]    tab table from makeMSBitLocTab(1)
+ * \param[out]   xstart, xend [optional] first and last pixel of each run
+ * \return  number of runs of ON pixels in the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) Words that don't end the current run or start a new one
+ *          are skipped with a single test, and the transitions
+ *          within a word are found a byte at a time with %tab.
+ *      (2) If %xstart is null, the runs are only counted.
+ * </pre>
+ */
+static l_int32
+findRunsOnLineLow(l_uint32  *line,
+                  l_int32    wpl,
+                  l_uint32   lastmask,
+                  l_int32   *tab,
+                  l_int32   *xstart,
+                  l_int32   *xend)
+{
+l_int32   j, pos, inrun, start, n;
+l_uint32  word, val;
+
+    n = 0;
+    inrun = FALSE;
+    start = 0;
+    for (j = 0; j < wpl; j++) {
+        word = line[j];
+        if (j == wpl - 1)
+            word &= lastmask;
+        if (word == (inrun ? 0xffffffff : 0))
+            continue;
+        if (inrun) word = ~word;
+
+            /* Find each change of state in the word, from the left */
+        pos = 0;
+        while (pos < 32 && (val = word << pos) != 0) {
+            if (val & 0xff000000)
+                pos += tab[val >> 24];
+            else if (val & 0x00ff0000)
+                pos += 8 + tab[(val >> 16) & 0xff];
+            else if (val & 0x0000ff00)
+                pos += 16 + tab[(val >> 8) & 0xff];
+            else
+                pos += 24 + tab[val & 0xff];
+            if (!inrun) {
+                start = 32 * j + pos;
+            } else {
+                if (xstart) {
+                    xstart[n] = start;
+                    xend[n] = 32 * j + pos - 1;
+                }
+                n++;
+            }
+            inrun = !inrun;
+            word = ~word;
+        }
+    }
+    if (inrun) {  /* the run continues to the end of the line */
+        if (xstart) {
+            xstart[n] = start;
+            xend[n] = 32 * wpl - 1;
+        }
+        n++;
+    }
+    return n;
+}
+
+
+/*!
+ * \brief   setRunOnLineLow()
+ *
+ * \param[in]    line data of a raster line of a 1 bpp image
+ * \param[in]    x0, x1 first and last pixel of the run to set
+ * \return  void
+ */
+static void
+setRunOnLineLow(l_uint32  *line,
+                l_int32    x0,
+                l_int32    x1)
+{
+l_int32   j, j0, j1;
+l_uint32  mask0, mask1;
+
+    j0 = x0 >> 5;
+    j1 = x1 >> 5;
+    mask0 = 0xffffffff >> (x0 & 31);
+    mask1 = 0xffffffff << (31 - (x1 & 31));
+    if (j0 == j1) {
+        line[j0] |= mask0 & mask1;
+        return;
+    }
+    line[j0] |= mask0;
+    for (j = j0 + 1; j < j1; j++)
+        line[j] = 0xffffffff;
+    line[j1] |= mask1;
+}
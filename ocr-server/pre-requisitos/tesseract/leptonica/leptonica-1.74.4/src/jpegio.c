@@ -31,6 +31,7 @@
  *    Read jpeg from file
  *          PIX             *pixReadJpeg()  [special top level]
  *          PIX             *pixReadStreamJpeg()
+ *          static PIX      *pixReadStreamJpegToPix()
  *
  *    Read jpeg metadata from file
  *          l_int32          readHeaderJpeg()
@@ -44,6 +45,7 @@
  *
  *    Read/write to memory
  *          PIX             *pixReadMemJpeg()
+ *          PIX             *pixReadMemJpegToPix()
  *          l_int32          readHeaderMemJpeg()
  *          l_int32          pixWriteMemJpeg()
  *
@@ -150,6 +152,9 @@
 static void jpeg_error_catch_all_1(j_common_ptr cinfo);
 static void jpeg_error_catch_all_2(j_common_ptr cinfo);
 static l_uint8 jpeg_getc(j_decompress_ptr cinfo);
+static PIX *pixReadStreamJpegToPix(PIX *pixd, FILE *fp, l_int32 cmapflag,
+                                   l_int32 reduction, l_int32 *pnwarn,
+                                   l_int32 hint);
 
     /* Note: 'boolean' is defined in jmorecfg.h.  We use it explicitly
      * here because for windows where __MINGW32__ is defined,
@@ -271,12 +276,51 @@ pixReadStreamJpeg(FILE     *fp,
                   l_int32   reduction,
                   l_int32  *pnwarn,
                   l_int32   hint)
+{
+    return pixReadStreamJpegToPix(NULL, fp, cmapflag, reduction, pnwarn, hint);
+}
+
+
+/*!
+ * \brief   pixReadStreamJpegToPix()
+ *
+ * \param[in]    pixd [optional] pix to decode into; can be null
+ * \param[in]    fp file stream
+ * \param[in]    cmapflag 0 for no colormap in returned pix;
+ *                        1 to return an 8 bpp cmapped pix if spp = 3 or 4
+ * \param[in]    reduction scaling factor: 1, 2, 4 or 8
+ * \param[out]   pnwarn [optional] number of warnings
+ * \param[in]    hint a bitwise OR of L_JPEG_* values; 0 for default
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) If pixd is not null, it is reused for the image with
+ *          pixReuseNoInit(), and on error it is not destroyed.
+ *      (2) The scanlines are decoded directly into the raster lines
+ *          of the pix, without a row buffer:
+ *          * 8 bpp samples are written in byte order, and the
+ *            pix is byte-swapped at the end, if necessary.
+ *          * rgb samples are written into the last 3/4 of the
+ *            32 bpp line, and expanded from left to right, which
+ *            never overwrites a sample that has not yet been read.
+ *          * cmyk samples fill the 32 bpp line and are converted
+ *            to rgb in place.
+ * </pre>
+ */
+static PIX *
+pixReadStreamJpegToPix(PIX      *pixd,
+                       FILE     *fp,
+                       l_int32   cmapflag,
+                       l_int32   reduction,
+                       l_int32  *pnwarn,
+                       l_int32   hint)
 {
 l_int32                        cyan, yellow, magenta, black, nwarn;
-l_int32                        i, j, k, rval, gval, bval;
+l_int32                        i, j, k, rval, gval, bval, rgb;
 l_int32                        w, h, wpl, spp, ncolors, cindex, ycck, cmyk;
 l_uint32                      *data;
-l_uint32                      *line, *ppixel;
+l_uint32                      *line;
 JSAMPROW                       rowbuffer;
 PIX                           *pix;
 PIXCMAP                       *cmap;
@@ -284,7 +328,7 @@ struct jpeg_decompress_struct  cinfo;
 struct jpeg_error_mgr          jerr;
 jmp_buf                        jmpbuf;  /* must be local to the function */
 
-    PROCNAME("pixReadStreamJpeg");
+    PROCNAME("pixReadStreamJpegToPix");
 
     if (pnwarn) *pnwarn = 0;
     if (!fp)
@@ -299,15 +343,13 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 
     rewind(fp);
     pix = NULL;
-    rowbuffer = NULL;
 
         /* Modify the jpeg error handling to catch fatal errors  */
     cinfo.err = jpeg_std_error(&jerr);
     jerr.error_exit = jpeg_error_catch_all_1;
     cinfo.client_data = (void *)&jmpbuf;
     if (setjmp(jmpbuf)) {
-        pixDestroy(&pix);
-        LEPT_FREE(rowbuffer);
+        if (pix != pixd) pixDestroy(&pix);
         return (PIX *)ERROR_PTR("internal jpeg error", procName, NULL);
     }
 
@@ -326,28 +368,26 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
         spp = cinfo.out_color_components;
     }
 
-        /* Allocate the image and a row buffer */
+        /* Allocate the image */
     w = cinfo.output_width;
     h = cinfo.output_height;
     ycck = (cinfo.jpeg_color_space == JCS_YCCK && spp == 4 && cmapflag == 0);
     cmyk = (cinfo.jpeg_color_space == JCS_CMYK && spp == 4 && cmapflag == 0);
     if (spp != 1 && spp != 3 && !ycck && !cmyk) {
+        jpeg_destroy_decompress(&cinfo);
         return (PIX *)ERROR_PTR("spp must be 1 or 3, or YCCK or CMYK",
                                 procName, NULL);
     }
-    if ((spp == 3 && cmapflag == 0) || ycck || cmyk) {  /* rgb or 4 bpp color */
-        rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE), spp * w);
-        pix = pixCreate(w, h, 32);
-    } else {  /* 8 bpp gray or colormapped */
-        rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE), w);
-        pix = pixCreate(w, h, 8);
+    rgb = (spp == 3 && cmapflag == 0) || ycck || cmyk;
+    if (rgb)  /* rgb or 4 bpp color */
+        pix = pixReuseNoInit(pixd, w, h, 32);
+    else  /* 8 bpp gray or colormapped */
+        pix = pixReuseNoInit(pixd, w, h, 8);
+    if (!pix) {
+        jpeg_destroy_decompress(&cinfo);
+        return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     }
     pixSetInputFormat(pix, IFF_JFIF_JPEG);
-    if (!rowbuffer || !pix) {
-        LEPT_FREE(rowbuffer);
-        pixDestroy(&pix);
-        return (PIX *)ERROR_PTR("rowbuffer or pix not made", procName, NULL);
-    }
 
         /* Initialize decompression.  Set up a colormap for color
          * quantization if requested. */
@@ -386,23 +426,25 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
          * hint to have the same bit flag as L_JPEG_FAIL_ON_BAD_DATA,
          * no image will be returned if there are any warnings. */
     for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        if (rgb && spp == 3)  /* samples go at the end of the line */
+            rowbuffer = (JSAMPROW)line + w;
+        else
+            rowbuffer = (JSAMPROW)line;
         if (jpeg_read_scanlines(&cinfo, &rowbuffer, (JDIMENSION)1) == 0) {
             L_ERROR("read error at scanline %d\n", procName, i);
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
             jpeg_destroy_decompress(&cinfo);
-            LEPT_FREE(rowbuffer);
             return (PIX *)ERROR_PTR("bad data", procName, NULL);
         }
 
             /* -- 24 bit color -- */
-        if ((spp == 3 && cmapflag == 0) || ycck || cmyk) {
-            ppixel = data + i * wpl;
+        if (rgb) {
             if (spp == 3) {
-                for (j = k = 0; j < w; j++) {
-                    SET_DATA_BYTE(ppixel, COLOR_RED, rowbuffer[k++]);
-                    SET_DATA_BYTE(ppixel, COLOR_GREEN, rowbuffer[k++]);
-                    SET_DATA_BYTE(ppixel, COLOR_BLUE, rowbuffer[k++]);
-                    ppixel++;
+                for (j = k = 0; j < w; j++, k += 3) {
+                    line[j] = ((l_uint32)rowbuffer[k] << L_RED_SHIFT) |
+                              ((l_uint32)rowbuffer[k + 1] << L_GREEN_SHIFT) |
+                              ((l_uint32)rowbuffer[k + 2] << L_BLUE_SHIFT);
                 }
             } else {
                     /* This is a conversion from CMYK -> RGB that ignores
@@ -443,17 +485,18 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
                     rval = L_MIN(L_MAX(rval, 0), 255);
                     gval = L_MIN(L_MAX(gval, 0), 255);
                     bval = L_MIN(L_MAX(bval, 0), 255);
-                    composeRGBPixel(rval, gval, bval, ppixel);
-                    ppixel++;
+                    composeRGBPixel(rval, gval, bval, line + j);
                 }
             }
-        } else {    /* 8 bpp grayscale or colormapped pix */
-            line = data + i * wpl;
-            for (j = 0; j < w; j++)
-                SET_DATA_BYTE(line, j, rowbuffer[j]);
         }
     }
 
+        /* 8 bpp grayscale or colormapped pix was read in byte order */
+    if (!rgb) {
+        pixEndianByteSwap(pix);
+        pixSetPadBits(pix, 0);
+    }
+
     nwarn = cinfo.err->num_warnings;
     if (pnwarn) *pnwarn = nwarn;
 
@@ -473,12 +516,12 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 
     jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
-    LEPT_FREE(rowbuffer);
 
     if (nwarn > 0) {
         if (hint & L_JPEG_FAIL_ON_BAD_DATA) {
             L_ERROR("fail with %d warning(s) of bad data\n", procName, nwarn);
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
+            pix = NULL;
         } else {
             L_WARNING("%d warning(s) of bad data\n", procName, nwarn);
         }
@@ -986,13 +1029,53 @@ pixReadMemJpeg(const l_uint8  *data,
                l_int32         reduction,
                l_int32        *pnwarn,
                l_int32         hint)
+{
+    return pixReadMemJpegToPix(NULL, data, size, cmflag, reduction,
+                               pnwarn, hint);
+}
+
+
+/*!
+ * \brief   pixReadMemJpegToPix()
+ *
+ * \param[in]    pixd [optional] pix to decode into; can be null
+ * \param[in]    data const; jpeg-encoded
+ * \param[in]    size of data
+ * \param[in]    cmflag colormap flag 0 means return RGB image if color;
+ *                      1 means create a colormap and return
+ *                      an 8 bpp colormapped image if color
+ * \param[in]    reduction scaling factor: 1, 2, 4 or 8
+ * \param[out]   pnwarn [optional] number of warnings
+ * \param[in]    hint a bitwise OR of L_JPEG_* values; 0 for default
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixReadMemJpeg() with a pix supplied by the caller
+ *          to hold the image.  pixd is reused with pixReuseNoInit(),
+ *          so its data buffer is only reallocated if the new image is
+ *          larger than the one it holds.  This avoids allocating and
+ *          clearing a large buffer for each of a sequence of images.
+ *      (2) pixd must not be cloned.  On error, NULL is returned and
+ *          pixd, which still belongs to the caller, has undefined
+ *          image content.
+ * </pre>
+ */
+PIX *
+pixReadMemJpegToPix(PIX            *pixd,
+                    const l_uint8  *data,
+                    size_t          size,
+                    l_int32         cmflag,
+                    l_int32         reduction,
+                    l_int32        *pnwarn,
+                    l_int32         hint)
 {
 l_int32   ret;
 l_uint8  *comment;
 FILE     *fp;
 PIX      *pix;
 
-    PROCNAME("pixReadMemJpeg");
+    PROCNAME("pixReadMemJpegToPix");
 
     if (pnwarn) *pnwarn = 0;
     if (!data)
@@ -1000,7 +1083,7 @@ PIX      *pix;
 
     if ((fp = fopenReadFromMemory(data, size)) == NULL)
         return (PIX *)ERROR_PTR("stream not opened", procName, NULL);
-    pix = pixReadStreamJpeg(fp, cmflag, reduction, pnwarn, hint);
+    pix = pixReadStreamJpegToPix(pixd, fp, cmflag, reduction, pnwarn, hint);
     if (pix) {
         ret = fgetJpegComment(fp, &comment);
         if (!ret && comment) {
@@ -114,6 +114,16 @@ PIX * pixReadMemJpeg(const l_uint8 *cdata, size_t size, l_int32 cmflag,
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadMemJpegToPix(PIX *pixd, const l_uint8 *cdata, size_t size,
+                          l_int32 cmflag, l_int32 reduction, l_int32 *pnwarn,
+                          l_int32 hint)
+{
+    return (PIX * )ERROR_PTR("function not present", "pixReadMemJpegToPix",
+                             NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 readHeaderMemJpeg(const l_uint8 *cdata, size_t size,
                           l_int32 *pw, l_int32 *ph, l_int32 *pspp,
                           l_int32 *pycck, l_int32 *pcmyk)
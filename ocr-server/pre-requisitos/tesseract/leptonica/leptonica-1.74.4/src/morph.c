@@ -62,6 +62,12 @@
  *         static PIX     *processMorphArgs1()
  *         static PIX     *processMorphArgs2()
  *
+ *     Static helpers for fast 1-D brick Sels
+ *         static PIX     *pixMorphBrickLine()
+ *         static l_int32  morphBrickRowsLow()
+ *         static l_int32  morphBrickColsLow()
+ *         static void     morphShiftCombineLow()
+ *
  *  You are provided with many simple ways to do binary morphology.
  *  In particular, if you are using brick Sels, there are six
  *  convenient methods, all specially tailored for separable operations
@@ -157,12 +163,23 @@
  *  of a hit-miss Sel), followed by the HMT.
  *  Both of these 'generalized' functions are idempotent.
  *
+ *  The brick functions pix*Brick() do each 1-D part of the operation
+ *  with pixMorphBrickLine(), which gives the same result as the rasterop
+ *  implementation with the corresponding Sel, but whose cost does not
+ *  grow linearly with the Sel size: a horizontal line takes about
+ *  log2(size) word-parallel passes, and a vertical line takes a fixed
+ *  number of word operations per word (van Herk/Gil-Werman).
+ *  The inner loops are simple word loops that the compiler can
+ *  vectorize, and if compiled with OpenMP, bands of rows or columns
+ *  are processed in parallel.
+ *
  *  These functions are extensively tested in prog/binmorph1_reg.c,
  *  prog/binmorph2_reg.c, and prog/binmorph3_reg.c.
  * </pre>
  */
 
 #include <math.h>
+#include <string.h>
 #include "allheaders.h"
 
     /* Global constant; initialized here; must be declared extern
@@ -178,6 +195,25 @@ static const l_int32  ACCEPTABLE_COST = 5;
 static PIX * processMorphArgs1(PIX *pixd, PIX *pixs, SEL *sel, PIX **ppixt);
 static PIX * processMorphArgs2(PIX *pixd, PIX *pixs, SEL *sel);
 
+    /* Static helpers for fast 1-D brick Sels */
+static PIX * pixMorphBrickLine(PIX *pixd, PIX *pixs, l_int32 size,
+                               l_int32 direction, l_int32 type);
+static l_int32 morphBrickRowsLow(l_uint32 *datad, l_uint32 *datas,
+                                 l_int32 w, l_int32 wpl, l_int32 y0,
+                                 l_int32 y1, l_int32 size, l_int32 offset,
+                                 l_int32 type, l_uint32 bg);
+static l_int32 morphBrickColsLow(l_uint32 *datad, l_uint32 *datas,
+                                 l_int32 h, l_int32 wpl, l_int32 j0,
+                                 l_int32 j1, l_int32 size, l_int32 offset,
+                                 l_int32 type, l_uint32 bg);
+static void morphShiftCombineLow(l_uint32 *bufd, l_uint32 *bufs, l_int32 nw,
+                                 l_int32 shift, l_int32 type, l_uint32 bg);
+
+    /* Number of rows, and of 32-bit words of columns, in each band
+     * processed by pixMorphBrickLine() */
+static const l_int32  MORPH_BAND_ROWS = 64;
+static const l_int32  MORPH_BAND_WORDS = 32;
+
 
 /*-----------------------------------------------------------------*
  *    Generic binary morphological ops implemented with rasterop   *
@@ -687,7 +723,6 @@ pixDilateBrick(PIX     *pixd,
                l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixDilateBrick");
 
@@ -700,18 +735,14 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixDilate(pixd, pixs, sel);
-        selDestroy(&sel);
+    if (vsize == 1) {  /* no intermediate result */
+        pixd = pixMorphBrickLine(pixd, pixs, hsize, L_HORIZ, L_MORPH_DILATE);
+    } else if (hsize == 1) {
+        pixd = pixMorphBrickLine(pixd, pixs, vsize, L_VERT, L_MORPH_DILATE);
     } else {
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixs, selh);
-        pixd = pixDilate(pixd, pixt, selv);
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_DILATE);
         pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
     }
 
     return pixd;
@@ -751,7 +782,6 @@ pixErodeBrick(PIX     *pixd,
               l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixErodeBrick");
 
@@ -764,18 +794,14 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixErode(pixd, pixs, sel);
-        selDestroy(&sel);
+    if (vsize == 1) {  /* no intermediate result */
+        pixd = pixMorphBrickLine(pixd, pixs, hsize, L_HORIZ, L_MORPH_ERODE);
+    } else if (hsize == 1) {
+        pixd = pixMorphBrickLine(pixd, pixs, vsize, L_VERT, L_MORPH_ERODE);
     } else {
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixErode(NULL, pixs, selh);
-        pixd = pixErode(pixd, pixt, selv);
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_ERODE);
         pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
     }
 
     return pixd;
@@ -815,7 +841,6 @@ pixOpenBrick(PIX     *pixd,
              l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixOpenBrick");
 
@@ -828,21 +853,19 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixOpen(pixd, pixs, sel);
-        selDestroy(&sel);
+    if (vsize == 1) {  /* no intermediate result */
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixd = pixMorphBrickLine(pixd, pixt, hsize, L_HORIZ, L_MORPH_DILATE);
+    } else if (hsize == 1) {
+        pixt = pixMorphBrickLine(NULL, pixs, vsize, L_VERT, L_MORPH_ERODE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_DILATE);
     } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixErode(NULL, pixs, selh);
-        pixd = pixErode(pixd, pixt, selv);
-        pixDilate(pixt, pixd, selh);
-        pixDilate(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_ERODE);
+        pixMorphBrickLine(pixt, pixd, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_DILATE);
     }
+    pixDestroy(&pixt);
 
     return pixd;
 }
@@ -881,7 +904,6 @@ pixCloseBrick(PIX     *pixd,
               l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixCloseBrick");
 
@@ -894,21 +916,19 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixClose(pixd, pixs, sel);
-        selDestroy(&sel);
+    if (vsize == 1) {  /* no intermediate result */
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixd = pixMorphBrickLine(pixd, pixt, hsize, L_HORIZ, L_MORPH_ERODE);
+    } else if (hsize == 1) {
+        pixt = pixMorphBrickLine(NULL, pixs, vsize, L_VERT, L_MORPH_DILATE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_ERODE);
     } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixs, selh);
-        pixd = pixDilate(pixd, pixt, selv);
-        pixErode(pixt, pixd, selh);
-        pixErode(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
+        pixt = pixMorphBrickLine(NULL, pixs, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixd = pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_DILATE);
+        pixMorphBrickLine(pixt, pixd, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixMorphBrickLine(pixd, pixt, vsize, L_VERT, L_MORPH_ERODE);
     }
+    pixDestroy(&pixt);
 
     return pixd;
 }
@@ -953,7 +973,6 @@ pixCloseSafeBrick(PIX     *pixd,
 {
 l_int32  maxtrans, bordsize;
 PIX     *pixsb, *pixt, *pixdb;
-SEL     *sel, *selh, *selv;
 
     PROCNAME("pixCloseSafeBrick");
 
@@ -975,20 +994,20 @@ SEL     *sel, *selh, *selv;
     bordsize = 32 * ((maxtrans + 31) / 32);  /* full 32 bit words */
     pixsb = pixAddBorder(pixs, bordsize, 0);
 
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixdb = pixClose(NULL, pixsb, sel);
-        selDestroy(&sel);
+    if (vsize == 1) {  /* no intermediate result */
+        pixt = pixMorphBrickLine(NULL, pixsb, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixdb = pixMorphBrickLine(NULL, pixt, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixDestroy(&pixt);
+    } else if (hsize == 1) {
+        pixt = pixMorphBrickLine(NULL, pixsb, vsize, L_VERT, L_MORPH_DILATE);
+        pixdb = pixMorphBrickLine(NULL, pixt, vsize, L_VERT, L_MORPH_ERODE);
+        pixDestroy(&pixt);
     } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixsb, selh);
-        pixdb = pixDilate(NULL, pixt, selv);
-        pixErode(pixt, pixdb, selh);
-        pixErode(pixdb, pixt, selv);
+        pixt = pixMorphBrickLine(NULL, pixsb, hsize, L_HORIZ, L_MORPH_DILATE);
+        pixdb = pixMorphBrickLine(NULL, pixt, vsize, L_VERT, L_MORPH_DILATE);
+        pixMorphBrickLine(pixt, pixdb, hsize, L_HORIZ, L_MORPH_ERODE);
+        pixMorphBrickLine(pixdb, pixt, vsize, L_VERT, L_MORPH_ERODE);
         pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
     }
 
     pixt = pixRemoveBorder(pixdb, bordsize);
@@ -1818,3 +1837,359 @@ l_int32  sx, sy;
     pixResizeImageData(pixd, pixs);
     return pixd;
 }
+
+
+/*-----------------------------------------------------------------*
+ *             Static helpers for fast 1-D brick Sels              *
+ *-----------------------------------------------------------------*/
+/*!
+ * \brief   pixMorphBrickLine()
+ *
+ * \param[in]    pixd  [optional]; this can be null, equal to pixs,
+ *                     or different from pixs
+ * \param[in]    pixs 1 bpp
+ * \param[in]    size length of the line Sel
+ * \param[in]    direction L_HORIZ, L_VERT
+ * \param[in]    type L_MORPH_DILATE, L_MORPH_ERODE
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This gives the same result as pixDilate() or pixErode()
+ *          with the 1-D brick Sel of the given size and direction,
+ *          with origin at size / 2, including the boundary condition
+ *          given by MORPH_BC.
+ *      (2) Each result pixel is the OR (dilation) or AND (erosion) of
+ *          the src pixels in a window of the given size, with pixels
+ *          outside the image being OFF, except for erosion with
+ *          symmetric b.c., where they are ON.
+ *      (3) For L_HORIZ, each row is combined with itself shifted,
+ *          doubling the window covered by each bit every pass, so
+ *          it takes ceil(log2(size)) word-parallel passes.
+ *      (4) For L_VERT, the van Herk/Gil-Werman method is used on
+ *          32 columns at a time: running combinations forward and
+ *          backward within blocks of size rows give each window
+ *          with a single further op, independent of size.
+ * </pre>
+ */
+static PIX *
+pixMorphBrickLine(PIX     *pixd,
+                  PIX     *pixs,
+                  l_int32  size,
+                  l_int32  direction,
+                  l_int32  type)
+{
+l_int32    w, h, wpl, offset, nbands, i, nfail;
+l_uint32   bg;
+l_uint32  *datas, *datad;
+PIX       *pixt;
+
+    PROCNAME("pixMorphBrickLine");
+
+    if (!pixd) {
+        if ((pixd = pixCreateTemplate(pixs)) == NULL)
+            return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+        pixt = pixClone(pixs);
+    } else {
+        pixResizeImageData(pixd, pixs);
+        if (pixd == pixs) {  /* in-place; must make a copy of pixs */
+            if ((pixt = pixCopy(NULL, pixs)) == NULL)
+                return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
+        } else {
+            pixt = pixClone(pixs);
+        }
+    }
+
+        /* The result at x is the op over src pixels in the window
+         * [x + offset, x + offset + size - 1], with the window placed
+         * as by the Sel origin for each op. */
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if (type == L_MORPH_DILATE) {
+        offset = size / 2 - size + 1;
+        bg = 0;
+    } else {
+        offset = -(size / 2);
+        bg = (MORPH_BC == SYMMETRIC_MORPH_BC) ? 0xffffffff : 0;
+    }
+    wpl = pixGetWpl(pixd);
+    datas = pixGetData(pixt);
+    datad = pixGetData(pixd);
+    nfail = 0;
+    if (direction == L_HORIZ) {
+        nbands = (h + MORPH_BAND_ROWS - 1) / MORPH_BAND_ROWS;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nfail)
+#endif
+        for (i = 0; i < nbands; i++) {
+            nfail += morphBrickRowsLow(datad, datas, w, wpl,
+                                       i * MORPH_BAND_ROWS,
+                                       L_MIN(h, (i + 1) * MORPH_BAND_ROWS),
+                                       size, offset, type, bg);
+        }
+    } else {
+        nbands = (wpl + MORPH_BAND_WORDS - 1) / MORPH_BAND_WORDS;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nfail)
+#endif
+        for (i = 0; i < nbands; i++) {
+            nfail += morphBrickColsLow(datad, datas, h, wpl,
+                                       i * MORPH_BAND_WORDS,
+                                       L_MIN(wpl, (i + 1) * MORPH_BAND_WORDS),
+                                       size, offset, type, bg);
+        }
+    }
+    pixSetPadBits(pixd, 0);
+    pixDestroy(&pixt);
+    if (nfail > 0)
+        L_ERROR("buffer alloc failed\n", procName);
+    return pixd;
+}
+
+
+/*!
+ * \brief   morphBrickRowsLow()
+ *
+ * \param[in]    datad, datas dest and src image data
+ * \param[in]    w, wpl width and words/line of both images
+ * \param[in]    y0, y1 rows [y0, y1) to process
+ * \param[in]    size, offset the window for each pixel
+ * \param[in]    type L_MORPH_DILATE, L_MORPH_ERODE
+ * \param[in]    bg value of pixels outside the image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each row is copied into a buffer with margins of bg words
+ *          on both sides, big enough for the whole window of every
+ *          pixel, so the passes need no boundary tests.
+ * </pre>
+ */
+static l_int32
+morphBrickRowsLow(l_uint32  *datad,
+                  l_uint32  *datas,
+                  l_int32    w,
+                  l_int32    wpl,
+                  l_int32    y0,
+                  l_int32    y1,
+                  l_int32    size,
+                  l_int32    offset,
+                  l_int32    type,
+                  l_uint32   bg)
+{
+l_int32    i, j, lw, nw, pos, q, r, covered, shift;
+l_uint32   mask;
+l_uint32  *bufs, *bufd, *buft, *lines, *lined;
+
+    lw = (L_MAX(0, -offset) + 31) / 32;
+    nw = lw + wpl + (offset + size + 63) / 32 + 1;
+    bufs = (l_uint32 *)LEPT_CALLOC(nw, sizeof(l_uint32));
+    bufd = (l_uint32 *)LEPT_CALLOC(nw, sizeof(l_uint32));
+    if (!bufs || !bufd) {
+        LEPT_FREE(bufs);
+        LEPT_FREE(bufd);
+        return 1;
+    }
+
+        /* Mask for the pixels of the last word that are in the image */
+    mask = (w & 31) ? 0xffffffff << (32 - (w & 31)) : 0xffffffff;
+        /* Position in the buffer of the window of the first pixel */
+    pos = 32 * lw + offset;
+    q = pos >> 5;
+    r = pos & 31;
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * wpl;
+        lined = datad + i * wpl;
+        for (j = 0; j < lw; j++)
+            bufs[j] = bg;
+        memcpy(bufs + lw, lines, 4 * wpl);
+        bufs[lw + wpl - 1] = (bufs[lw + wpl - 1] & mask) | (bg & ~mask);
+        for (j = lw + wpl; j < nw; j++)
+            bufs[j] = bg;
+
+            /* After each pass, each bit holds the op over the following
+             * %covered pixels.  The last pass may overlap the previous
+             * ones, which is harmless for OR and AND. */
+        for (covered = 1; covered < size; covered += shift) {
+            shift = L_MIN(covered, size - covered);
+            morphShiftCombineLow(bufd, bufs, nw, shift, type, bg);
+            buft = bufs;
+            bufs = bufd;
+            bufd = buft;
+        }
+
+        if (r == 0) {
+            memcpy(lined, bufs + q, 4 * wpl);
+        } else {
+            for (j = 0; j < wpl; j++)
+                lined[j] = (bufs[q + j] << r) | (bufs[q + j + 1] >> (32 - r));
+        }
+    }
+
+    LEPT_FREE(bufs);
+    LEPT_FREE(bufd);
+    return 0;
+}
+
+
+/*!
+ * \brief   morphShiftCombineLow()
+ *
+ * \param[in]    bufd dest buffer
+ * \param[in]    bufs src buffer
+ * \param[in]    nw number of words in each buffer
+ * \param[in]    shift number of pixels
+ * \param[in]    type L_MORPH_DILATE, L_MORPH_ERODE
+ * \param[in]    bg value of pixels beyond the end of bufs
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each pixel x of bufd is set to bufs[x] | bufs[x + shift]
+ *          for dilation, or bufs[x] & bufs[x + shift] for erosion.
+ * </pre>
+ */
+static void
+morphShiftCombineLow(l_uint32  *bufd,
+                     l_uint32  *bufs,
+                     l_int32    nw,
+                     l_int32    shift,
+                     l_int32    type,
+                     l_uint32   bg)
+{
+l_int32   j, q, r, nmain;
+l_uint32  word1, word2, shifted;
+
+    q = shift >> 5;
+    r = shift & 31;
+    nmain = L_MAX(0, nw - q - 1);
+    if (type == L_MORPH_DILATE) {
+        if (r == 0) {
+            for (j = 0; j < nmain; j++)
+                bufd[j] = bufs[j] | bufs[j + q];
+        } else {
+            for (j = 0; j < nmain; j++)
+                bufd[j] = bufs[j] | (bufs[j + q] << r) |
+                          (bufs[j + q + 1] >> (32 - r));
+        }
+    } else {
+        if (r == 0) {
+            for (j = 0; j < nmain; j++)
+                bufd[j] = bufs[j] & bufs[j + q];
+        } else {
+            for (j = 0; j < nmain; j++)
+                bufd[j] = bufs[j] & ((bufs[j + q] << r) |
+                                     (bufs[j + q + 1] >> (32 - r)));
+        }
+    }
+
+        /* The last words, which take bg from beyond the end */
+    for (j = nmain; j < nw; j++) {
+        word1 = (j + q < nw) ? bufs[j + q] : bg;
+        word2 = (j + q + 1 < nw) ? bufs[j + q + 1] : bg;
+        shifted = (r == 0) ? word1 : (word1 << r) | (word2 >> (32 - r));
+        if (type == L_MORPH_DILATE)
+            bufd[j] = bufs[j] | shifted;
+        else
+            bufd[j] = bufs[j] & shifted;
+    }
+}
+
+
+/*!
+ * \brief   morphBrickColsLow()
+ *
+ * \param[in]    datad, datas dest and src image data
+ * \param[in]    h, wpl height and words/line of both images
+ * \param[in]    j0, j1 words [j0, j1) of each row to process
+ * \param[in]    size, offset the window for each pixel
+ * \param[in]    type L_MORPH_DILATE, L_MORPH_ERODE
+ * \param[in]    bg value of pixels outside the image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Index t runs over the h + size - 1 src rows y = t + offset
+ *          that are in any window, using bg for rows outside the image.
+ *          With blocks of size rows starting at t = 0, the forward pass
+ *          stores in fwd the op from the start of the block of t to t,
+ *          and the backward pass keeps in bwd the op from t to the end
+ *          of its block.  The window of dest row t is then
+ *          bwd(t) op fwd(t + size - 1).
+ * </pre>
+ */
+static l_int32
+morphBrickColsLow(l_uint32  *datad,
+                  l_uint32  *datas,
+                  l_int32    h,
+                  l_int32    wpl,
+                  l_int32    j0,
+                  l_int32    j1,
+                  l_int32    size,
+                  l_int32    offset,
+                  l_int32    type,
+                  l_uint32   bg)
+{
+l_int32    t, y, j, nj, len;
+l_uint32  *fwd, *bwd, *bgline, *lines, *lined, *linef, *linep;
+
+    nj = j1 - j0;
+    len = h + size - 1;
+    fwd = (l_uint32 *)LEPT_CALLOC((size_t)len * nj, sizeof(l_uint32));
+    bwd = (l_uint32 *)LEPT_CALLOC(nj, sizeof(l_uint32));
+    bgline = (l_uint32 *)LEPT_CALLOC(nj, sizeof(l_uint32));
+    if (!fwd || !bwd || !bgline) {
+        LEPT_FREE(fwd);
+        LEPT_FREE(bwd);
+        LEPT_FREE(bgline);
+        return 1;
+    }
+    for (j = 0; j < nj; j++)
+        bgline[j] = bg;
+
+    for (t = 0; t < len; t++) {
+        y = t + offset;
+        lines = (y >= 0 && y < h) ? datas + y * wpl + j0 : bgline;
+        linef = fwd + (size_t)t * nj;
+        linep = linef - nj;
+        if (t % size == 0) {
+            for (j = 0; j < nj; j++)
+                linef[j] = lines[j];
+        } else if (type == L_MORPH_DILATE) {
+            for (j = 0; j < nj; j++)
+                linef[j] = linep[j] | lines[j];
+        } else {
+            for (j = 0; j < nj; j++)
+                linef[j] = linep[j] & lines[j];
+        }
+    }
+
+    for (t = len - 1; t >= 0; t--) {
+        y = t + offset;
+        lines = (y >= 0 && y < h) ? datas + y * wpl + j0 : bgline;
+        if (t == len - 1 || t % size == size - 1) {
+            for (j = 0; j < nj; j++)
+                bwd[j] = lines[j];
+        } else if (type == L_MORPH_DILATE) {
+            for (j = 0; j < nj; j++)
+                bwd[j] |= lines[j];
+        } else {
+            for (j = 0; j < nj; j++)
+                bwd[j] &= lines[j];
+        }
+        if (t >= h) continue;
+        lined = datad + t * wpl + j0;
+        linef = fwd + (size_t)(t + size - 1) * nj;
+        if (type == L_MORPH_DILATE) {
+            for (j = 0; j < nj; j++)
+                lined[j] = bwd[j] | linef[j];
+        } else {
+            for (j = 0; j < nj; j++)
+                lined[j] = bwd[j] & linef[j];
+        }
+    }
+
+    LEPT_FREE(fwd);
+    LEPT_FREE(bwd);
+    LEPT_FREE(bgline);
+    return 0;
+}
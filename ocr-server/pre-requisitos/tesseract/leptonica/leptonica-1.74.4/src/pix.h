@@ -813,6 +813,18 @@ enum {
 };
 
 
+/*-------------------------------------------------------------------------*
+ *                        Image color class flags                          *
+ *-------------------------------------------------------------------------*/
+
+/*! Image color class flags */
+enum {
+    L_CLASS_COLOR = 1,          /*!< image needs full color                */
+    L_CLASS_GRAY = 2,           /*!< image can be reduced to gray          */
+    L_CLASS_BITONAL = 3         /*!< image can be reduced to black/white   */
+};
+
+
 /*-------------------------------------------------------------------------*
  *                         16-bit conversion flags                         *
  *-------------------------------------------------------------------------*/
@@ -48,6 +48,7 @@
  *    Pix creation
  *          PIX          *pixCreate()
  *          PIX          *pixCreateNoInit()
+ *          PIX          *pixReuseNoInit()
  *          PIX          *pixCreateTemplate()
  *          PIX          *pixCreateTemplateNoInit()
  *          PIX          *pixCreateHeader()
@@ -350,6 +351,75 @@ l_uint32  *data;
 }
 
 
+/*!
+ * \brief   pixReuseNoInit()
+ *
+ * \param[in]    pixd [optional] pix to be reused; can be null
+ * \param[in]    width, height, depth
+ * \return  pixd with data of the requested size but not initialized,
+ *              or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) If pixd is null, this is pixCreateNoInit().  Otherwise, pixd
+ *          is given the requested size and depth, and is returned
+ *          as if it were new: spp, resolution, input format, text and
+ *          colormap are reset.
+ *      (2) The image data buffer of pixd is kept if the image it holds
+ *          is at least as large as the new image; otherwise it is
+ *          replaced.  So when the same pix is reused for a sequence of
+ *          images of the same size, such as the pages of a scanned
+ *          document, the buffer is allocated only once.
+ *      (3) pixd must not be cloned, because the other handles would
+ *          see the change.  On error, pixd is not changed.
+ *      (4) As with pixCreateNoInit(), the pad bits are set to 0 and
+ *          the image pixels are left uninitialized.
+ * </pre>
+ */
+PIX *
+pixReuseNoInit(PIX     *pixd,
+               l_int32  width,
+               l_int32  height,
+               l_int32  depth)
+{
+l_int32    wpl;
+l_uint32  *data;
+PIX       *pixt;
+
+    PROCNAME("pixReuseNoInit");
+
+    if (!pixd)
+        return pixCreateNoInit(width, height, depth);
+    if (pixGetRefcount(pixd) > 1)
+        return (PIX *)ERROR_PTR("pixd is cloned", procName, NULL);
+
+        /* Validate the size and get the wpl, as for a new pix */
+    if ((pixt = pixCreateHeader(width, height, depth)) == NULL)
+        return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
+    wpl = pixGetWpl(pixt);
+    pixDestroy(&pixt);
+
+    if (!pixGetData(pixd) ||
+        (l_int64)wpl * height > (l_int64)pixGetWpl(pixd) * pixGetHeight(pixd)) {
+        if ((data = (l_uint32 *)pix_malloc(4LL * wpl * height)) == NULL)
+            return (PIX *)ERROR_PTR("pix_malloc fail for data", procName, NULL);
+        pixFreeData(pixd);
+        pixSetData(pixd, data);
+    }
+    pixSetDimensions(pixd, width, height, depth);
+    pixSetWpl(pixd, wpl);
+    pixSetSpp(pixd, (depth == 24 || depth == 32) ? 3 : 1);
+    pixSetXRes(pixd, 0);
+    pixSetYRes(pixd, 0);
+    pixSetInputFormat(pixd, IFF_UNKNOWN);
+    pixSetSpecial(pixd, 0);
+    pixSetText(pixd, NULL);
+    pixDestroyColormap(pixd);
+    pixSetPadBits(pixd, 0);
+    return pixd;
+}
+
+
 /*!
  * \brief   pixCreateTemplate()
  *
@@ -749,7 +749,8 @@ pixConvertRGBToGray(PIX       *pixs,
                     l_float32  gwt,
                     l_float32  bwt)
 {
-l_int32    i, j, w, h, wpls, wpld, val;
+l_int32    i, j, w, h, wpls, wpld;
+l_uint8   *buf;
 l_uint32   word;
 l_uint32  *datas, *lines, *datad, *lined;
 l_float32  sum;
@@ -789,18 +790,32 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
+        /* The gray values of a line are found in a simple loop into
+         * a byte array, and then packed into the dest line, so that
+         * both loops can be vectorized by the compiler. */
+    if ((buf = (l_uint8 *)LEPT_CALLOC(4 * wpld, sizeof(l_uint8))) == NULL) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("buf not made", procName, NULL);
+    }
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
         for (j = 0; j < w; j++) {
             word = *(lines + j);
-            val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
-                            gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
-                            bwt * ((word >> L_BLUE_SHIFT) & 0xff) + 0.5);
-            SET_DATA_BYTE(lined, j, val);
+            buf[j] = (l_uint8)(l_int32)
+                     (rwt * ((word >> L_RED_SHIFT) & 0xff) +
+                      gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
+                      bwt * ((word >> L_BLUE_SHIFT) & 0xff) + 0.5);
+        }
+        for (j = 0; j < wpld; j++) {
+            *(lined + j) = ((l_uint32)buf[4 * j] << 24) |
+                           ((l_uint32)buf[4 * j + 1] << 16) |
+                           ((l_uint32)buf[4 * j + 2] << 8) |
+                           (l_uint32)buf[4 * j + 3];
         }
     }
 
+    LEPT_FREE(buf);
     return pixd;
 }
 
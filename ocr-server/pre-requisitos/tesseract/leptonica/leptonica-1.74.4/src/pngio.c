@@ -58,6 +58,7 @@
  *
  *    Reading png from memory
  *          PIX        *pixReadMemPng()
+ *          PIX        *pixReadMemPngToPix()
  *
  *    Writing png to memory
  *          l_int32     pixWriteMemPng()
@@ -1455,6 +1456,8 @@ char       *data = 0;
  * Notes:
  *      (1) This is a libpng callback that reads an image from a single
  *          memory buffer.
+ *      (2) Reading past the end of the buffer, as for truncated data,
+ *          is a png error, which longjmps to the reader's handler.
  * </pre>
  */
 static void
@@ -1467,6 +1470,8 @@ MEMIODATA  *thing;
     PROCNAME("memio_png_read_data");
 
     thing = (MEMIODATA *)png_get_io_ptr(png_ptr);
+    if (byteCountToRead > (png_size_t)(thing->m_Size - thing->m_Count))
+        png_error(png_ptr, "read past end of png data");  /* no return */
     memcpy(outBytes, thing->m_Buffer + thing->m_Count, byteCountToRead);
     thing->m_Count += byteCountToRead;
 }
@@ -1518,34 +1523,74 @@ MEMIODATA  *buffer, *old;
  *
  * <pre>
  * Notes:
- *      (1) See pixReastreamPng().
+ *      (1) See pixReadStreamPng() and pixReadMemPngToPix().
  * </pre>
  */
 PIX *
 pixReadMemPng(const l_uint8  *filedata,
               size_t          filesize)
+{
+    return pixReadMemPngToPix(NULL, filedata, filesize);
+}
+
+
+/*!
+ * \brief   pixReadMemPngToPix()
+ *
+ * \param[in]    pixd       [optional] pix to decode into; can be null
+ * \param[in]    filedata   png compressed data in memory
+ * \param[in]    filesize   number of bytes in data
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixReadMemPng() with a pix supplied by the caller
+ *          to hold the image.  pixd is reused with pixReuseNoInit(),
+ *          so its data buffer is only reallocated if the new image is
+ *          larger than the one it holds.  pixd must not be cloned.
+ *          On error, NULL is returned and pixd, which still belongs
+ *          to the caller, has undefined image content.
+ *      (2) The conversions are the same as in pixReadStreamPng().
+ *          However, this uses the low-level png interface, where the
+ *          header is read first and the raster image is then decoded
+ *          into buffers that we supply, instead of into rows that
+ *          are allocated by png_read_png().  For 1 spp without
+ *          transparency (gray, bilevel and colormapped images),
+ *          the rows are the raster lines of the pix itself, which
+ *          are byte-swapped in place if necessary.  Otherwise they
+ *          are a single temporary buffer.
+ *      (3) Only a single image is read from the data, so the problem
+ *          of successive reads from a stream, noted in
+ *          pixReadStreamPng(), does not arise.
+ * </pre>
+ */
+PIX *
+pixReadMemPngToPix(PIX            *pixd,
+                   const l_uint8  *filedata,
+                   size_t          filesize)
 {
 l_uint8      byte;
-l_int32      rval, gval, bval;
+l_uint8     *volatile rowdata;
+l_int32      rval, gval, bval, aval;
 l_int32      i, j, k, index, ncolors, bitval;
 l_int32      wpl, d, spp, cindex, tRNS;
-l_uint32     png_transforms;
-l_uint32    *data, *line, *ppixel;
+l_uint32    *data, *ppixel;
 int          num_palette, num_text, num_trans;
 png_byte     bit_depth, color_type, channels;
 png_uint_32  w, h, rowbytes;
 png_uint_32  xres, yres;
 png_bytep    rowptr, trans;
-png_bytep   *row_pointers;
+png_bytep   *volatile row_pointers;
 png_structp  png_ptr;
 png_infop    info_ptr, end_info;
 png_colorp   palette;
 png_textp    text_ptr;  /* ptr to text_chunk */
-PIX         *pix, *pix1;
+PIX         *volatile pix;
+PIX         *pix1;
 PIXCMAP     *cmap;
 MEMIODATA    state;
 
-    PROCNAME("pixReadMemPng");
+    PROCNAME("pixReadMemPngToPix");
 
     if (!filedata)
         return (PIX *)ERROR_PTR("filedata not defined", procName, NULL);
@@ -1558,6 +1603,8 @@ MEMIODATA    state;
     state.m_Buffer = (char*)filedata;
     state.m_Size = filesize;
     pix = NULL;
+    rowdata = NULL;
+    row_pointers = NULL;
 
         /* Allocate the 3 data structures */
     if ((png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
@@ -1574,32 +1621,36 @@ MEMIODATA    state;
         return (PIX *)ERROR_PTR("end_info not made", procName, NULL);
     }
 
-        /* Set up png setjmp error handling */
+        /* Set up png setjmp error handling.  The row buffers and the
+         * pix are volatile so that they can be freed here; pixd
+         * still belongs to the caller. */
     if (setjmp(png_jmpbuf(png_ptr))) {
+        LEPT_FREE(row_pointers);
+        LEPT_FREE(rowdata);
+        if ((pix1 = pix) != pixd) pixDestroy(&pix1);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
         return (PIX *)ERROR_PTR("internal png error", procName, NULL);
     }
 
     png_set_read_fn(png_ptr, &state, memio_png_read_data);
+    png_read_info(png_ptr, info_ptr);
 
         /* ---------------------------------------------------------- *
-         *  Set the transforms flags.  Whatever happens here,
-         *  NEVER invert 1 bpp using PNG_TRANSFORM_INVERT_MONO.
-         *  Also, do not use PNG_TRANSFORM_EXPAND, which would
+         *  Set the transforms.  Whatever happens here,
+         *  NEVER invert 1 bpp using png_set_invert_mono().
+         *  Also, do not use png_set_expand(), which would
          *  expand all images with bpp < 8 to 8 bpp.
+         *  These are the transforms that png_read_png() would do
+         *  in pixReadStreamPng().
          * ---------------------------------------------------------- */
-        /* To strip 16 --> 8 bit depth, use PNG_TRANSFORM_STRIP_16 */
     if (var_PNG_STRIP_16_TO_8 == 1) {  /* our default */
-        png_transforms = PNG_TRANSFORM_STRIP_16;
+        png_set_strip_16(png_ptr);
     } else {
-        png_transforms = PNG_TRANSFORM_IDENTITY;
         L_INFO("not stripping 16 --> 8 in png reading\n", procName);
     }
+    png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
 
-        /* Read it */
-    png_read_png(png_ptr, info_ptr, png_transforms, NULL);
-
-    row_pointers = png_get_rows(png_ptr, info_ptr);
     w = png_get_image_width(png_ptr, info_ptr);
     h = png_get_image_height(png_ptr, info_ptr);
     bit_depth = png_get_bit_depth(png_ptr, info_ptr);
@@ -1636,10 +1687,9 @@ MEMIODATA    state;
         }
     }
 
-    if ((pix = pixCreate(w, h, d)) == NULL) {
+    if ((pix = pixReuseNoInit(pixd, w, h, d)) == NULL) {
         pixcmapDestroy(&cmap);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-        pixcmapDestroy(&cmap);
         return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     }
     pixSetInputFormat(pix, IFF_PNG);
@@ -1648,14 +1698,31 @@ MEMIODATA    state;
     pixSetColormap(pix, cmap);
     pixSetSpp(pix, spp);
 
-    if (spp == 1 && !tRNS) {  /* copy straight from buffer to pix */
-        for (i = 0; i < h; i++) {
-            line = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = 0; j < rowbytes; j++) {
-                    SET_DATA_BYTE(line, j, rowptr[j]);
-            }
+        /* Decode the raster image.  With 1 spp and no transparency,
+         * the png rows have the layout of the pix lines in byte order. */
+    if (spp == 1 && !tRNS) {
+        row_pointers = (png_bytep *)pixGetLinePtrs(pix, NULL);
+    } else {
+        rowdata = (l_uint8 *)LEPT_MALLOC((size_t)h * rowbytes);
+        row_pointers = (png_bytep *)LEPT_MALLOC(h * sizeof(png_bytep));
+        if (rowdata && row_pointers) {
+            for (i = 0; i < h; i++)
+                row_pointers[i] = rowdata + (size_t)i * rowbytes;
         }
+    }
+    if (!row_pointers || (!rowdata && !(spp == 1 && !tRNS))) {
+        LEPT_FREE(row_pointers);
+        LEPT_FREE(rowdata);
+        if ((pix1 = pix) != pixd) pixDestroy(&pix1);
+        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return (PIX *)ERROR_PTR("row buffers not made", procName, NULL);
+    }
+    png_read_image(png_ptr, row_pointers);
+    png_read_end(png_ptr, info_ptr);
+
+    if (spp == 1 && !tRNS) {  /* already in the pix */
+        pixEndianByteSwap(pix);
+        pixSetPadBits(pix, 0);
     } else if (spp == 2) {  /* grayscale + alpha; convert to RGBA */
         L_INFO("converting (gray + alpha) ==> RGBA\n", procName);
         for (i = 0; i < h; i++) {
@@ -1676,11 +1743,11 @@ MEMIODATA    state;
             ppixel = data + i * wpl;
             rowptr = row_pointers[i];
             for (j = k = 0; j < w; j++) {
-                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
-                if (spp == 4)
-                    SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
+                rval = rowptr[k++];
+                gval = rowptr[k++];
+                bval = rowptr[k++];
+                aval = (spp == 4) ? rowptr[k++] : 0;
+                composeRGBAPixel(rval, gval, bval, aval, ppixel);
                 ppixel++;
             }
         }
@@ -1690,35 +1757,50 @@ MEMIODATA    state;
          *    (1) 8 bpp without colormap; assume full transparency
          *    (2) 1 bpp with colormap + trans array (for alpha)
          *    (3) 8 bpp with colormap + trans array (for alpha)
-         * These all require converting to RGBA */
+         * These all require converting to RGBA, which is done
+         * by reusing the pix at 32 bpp. */
     if (spp == 1 && tRNS) {
         if (!cmap) {
                 /* Case 1: make fully transparent RGBA image */
             L_INFO("transparency, 1 spp, no colormap, no transparency array: "
                    "convention is fully transparent image\n", procName);
             L_INFO("converting (fully transparent 1 spp) ==> RGBA\n", procName);
-            pixDestroy(&pix);
-            pix = pixCreate(w, h, 32);  /* init to alpha = 0 (transparent) */
-            pixSetSpp(pix, 4);
+            if (pixReuseNoInit(pix, w, h, 32) == NULL) {
+                L_ERROR("pix not made at 32 bpp\n", procName);
+                if ((pix1 = pix) != pixd) pixDestroy(&pix1);
+                pix = NULL;
+            } else {
+                pixClearAll(pix);  /* alpha = 0 (transparent) */
+                pixSetSpp(pix, 4);
+                pixSetInputFormat(pix, IFF_PNG);
+            }
         } else {
             L_INFO("converting (cmap + alpha) ==> RGBA\n", procName);
 
                 /* Grab the transparency array */
             png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, NULL);
             if (!trans) {  /* invalid png file */
-                pixDestroy(&pix);
+                if ((pix1 = pix) != pixd) pixDestroy(&pix1);
+                LEPT_FREE(row_pointers);
+                LEPT_FREE(rowdata);
                 png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
                 return (PIX *)ERROR_PTR("cmap, tRNS, but no transparency array",
                                         procName, NULL);
             }
 
-                /* Save the cmap and destroy the pix */
+                /* Save the cmap and start over with 32 bit RGBA */
             cmap = pixcmapCopy(pixGetColormap(pix));
             ncolors = pixcmapGetCount(cmap);
-            pixDestroy(&pix);
-
-                /* Start over with 32 bit RGBA */
-            pix = pixCreate(w, h, 32);
+            if (pixReuseNoInit(pix, w, h, 32) == NULL) {
+                pixcmapDestroy(&cmap);
+                if ((pix1 = pix) != pixd) pixDestroy(&pix1);
+                LEPT_FREE(row_pointers);
+                LEPT_FREE(rowdata);
+                png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+                return (PIX *)ERROR_PTR("pix not made at 32 bpp",
+                                        procName, NULL);
+            }
+            pixSetInputFormat(pix, IFF_PNG);
             wpl = pixGetWpl(pix);
             data = pixGetData(pix);
             pixSetSpp(pix, 4);
@@ -1781,61 +1863,37 @@ MEMIODATA    state;
             } else {
                 L_ERROR("spp == 1, cmap, trans array, invalid depth: %d\n",
                         procName, d);
+                pixClearAll(pix);
             }
             pixcmapDestroy(&cmap);
         }
     }
+    LEPT_FREE(row_pointers);
+    LEPT_FREE(rowdata);
 
-#if  DEBUG_READ
-    if (cmap) {
-        for (i = 0; i < 16; i++) {
-            fprintf(stderr, "[%d] = %d\n", i,
-                   ((l_uint8 *)(cmap->array))[i]);
-        }
-    }
-#endif  /* DEBUG_READ */
-
-        /* Final adjustments for bpp = 1.
-         *   + If there is no colormap, the image must be inverted because
-         *     png stores black pixels as 0.
-         *   + We have already handled the case of cmapped, 1 bpp pix
-         *     with transparency, where the output pix is 32 bpp RGBA.
-         *     If there is no transparency but the pix has a colormap,
-         *     we remove the colormap, because functions operating on
-         *     1 bpp images in leptonica assume no colormap.
-         *   + The colormap must be removed in such a way that the pixel
-         *     values are not changed.  If the values are only black and
-         *     white, we return a 1 bpp image; if gray, return an 8 bpp pix;
-         *     otherwise, return a 32 bpp rgb pix.
-         *
-         * Note that we cannot use the PNG_TRANSFORM_INVERT_MONO flag
-         * to do the inversion, because that flag (since version 1.0.9)
-         * inverts 8 bpp grayscale as well, which we don't want to do.
-         * (It also doesn't work if there is a colormap.)
-         *
-         * Note that if the input png is a 1-bit with colormap and
-         * transparency, it has already been rendered as a 32 bpp,
-         * spp = 4 rgba pix.
-         */
-    if (pixGetDepth(pix) == 1) {
+        /* Final adjustments for bpp = 1; see pixReadStreamPng().
+         * A colormap is removed by putting the data of the converted
+         * pix into this one. */
+    if (pix && pixGetDepth(pix) == 1) {
         if (!cmap) {
             pixInvert(pix, pix);
-        } else {
-            pix1 = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
-            pixDestroy(&pix);
-            pix = pix1;
+        } else if ((pix1 = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC))
+                   != NULL) {
+            pixTransferAllData(pix, &pix1, 0, 0);
         }
     }
 
-    xres = png_get_x_pixels_per_meter(png_ptr, info_ptr);
-    yres = png_get_y_pixels_per_meter(png_ptr, info_ptr);
-    pixSetXRes(pix, (l_int32)((l_float32)xres / 39.37 + 0.5));  /* to ppi */
-    pixSetYRes(pix, (l_int32)((l_float32)yres / 39.37 + 0.5));  /* to ppi */
+    if (pix) {
+        xres = png_get_x_pixels_per_meter(png_ptr, info_ptr);
+        yres = png_get_y_pixels_per_meter(png_ptr, info_ptr);
+        pixSetXRes(pix, (l_int32)((l_float32)xres / 39.37 + 0.5));  /* ppi */
+        pixSetYRes(pix, (l_int32)((l_float32)yres / 39.37 + 0.5));  /* ppi */
 
-        /* Get the text if there is any */
-    png_get_text(png_ptr, info_ptr, &text_ptr, &num_text);
-    if (num_text && text_ptr)
-        pixSetText(pix, text_ptr->text);
+            /* Get the text if there is any */
+        png_get_text(png_ptr, info_ptr, &text_ptr, &num_text);
+        if (num_text && text_ptr)
+            pixSetText(pix, text_ptr->text);
+    }
 
     png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
     return pix;
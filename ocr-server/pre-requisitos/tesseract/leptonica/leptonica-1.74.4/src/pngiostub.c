@@ -132,6 +132,14 @@ PIX * pixReadMemPng(const l_uint8 *filedata, size_t filesize)
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadMemPngToPix(PIX *pixd, const l_uint8 *filedata, size_t filesize)
+{
+    return (PIX * )ERROR_PTR("function not present", "pixReadMemPngToPix",
+                             NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 pixWriteMemPng(l_uint8 **pfiledata, size_t *pfilesize, PIX *pix,
                        l_float32 gamma)
 {
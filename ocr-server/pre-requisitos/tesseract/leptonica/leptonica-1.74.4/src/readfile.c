@@ -47,6 +47,7 @@
  *
  *      Read from memory
  *           PIX       *pixReadMem()
+ *           PIX       *pixReadMemToPix()
  *           l_int32    pixReadHeaderMem()
  *
  *      Output image file information
@@ -919,6 +920,93 @@ PIX     *pix;
 }
 
 
+/*!
+ * \brief   pixReadMemToPix()
+ *
+ * \param[in]    pixd [optional] pix to decode into; can be null
+ * \param[in]    data const; encoded
+ * \param[in]    size size of data
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixReadMem() with a pix supplied by the caller to
+ *          hold the image.  It is intended for reading a sequence of
+ *          images, such as the pages of a document, with the same pix,
+ *          to avoid allocating the image data for each of them.
+ *      (2) jpeg, png and tiff are decoded directly into pixd, which is
+ *          reused with pixReuseNoInit().  Its data buffer is only
+ *          reallocated if the new image is larger than the one it holds.
+ *          Other formats are read into a new pix, and the image data
+ *          is then transferred to pixd without a copy.
+ *      (3) pixd must not be cloned.  On error, NULL is returned and
+ *          pixd, which still belongs to the caller, has undefined
+ *          image content.
+ *      (4) For tiff, the first image is read.
+ * </pre>
+ */
+PIX *
+pixReadMemToPix(PIX            *pixd,
+                const l_uint8  *data,
+                size_t          size)
+{
+l_int32  format;
+size_t   offset;
+PIX     *pix;
+
+    PROCNAME("pixReadMemToPix");
+
+    if (!pixd)
+        return pixReadMem(data, size);
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if (size < 12)
+        return (PIX *)ERROR_PTR("size < 12", procName, NULL);
+    if (pixGetRefcount(pixd) > 1)
+        return (PIX *)ERROR_PTR("pixd is cloned", procName, NULL);
+
+    findFileFormatBuffer(data, &format);
+    switch (format)
+    {
+    case IFF_JFIF_JPEG:
+        if ((pix = pixReadMemJpegToPix(pixd, data, size, 0, 1, NULL, 0))
+            == NULL)
+            return (PIX *)ERROR_PTR( "jpeg: no pix returned", procName, NULL);
+        break;
+
+    case IFF_PNG:
+        if ((pix = pixReadMemPngToPix(pixd, data, size)) == NULL)
+            return (PIX *)ERROR_PTR("png: no pix returned", procName, NULL);
+        break;
+
+    case IFF_TIFF:
+    case IFF_TIFF_PACKBITS:
+    case IFF_TIFF_RLE:
+    case IFF_TIFF_G3:
+    case IFF_TIFF_G4:
+    case IFF_TIFF_LZW:
+    case IFF_TIFF_ZIP:
+        offset = 0;
+        if ((pix = pixReadMemFromMultipageTiffToPix(pixd, data, size,
+                                                    &offset)) == NULL)
+            return (PIX *)ERROR_PTR("tiff: no pix returned", procName, NULL);
+        break;
+
+    default:  /* read a new pix; the input format is set by pixReadMem() */
+        if ((pix = pixReadMem(data, size)) == NULL)
+            return (PIX *)ERROR_PTR("no pix returned", procName, NULL);
+        pixTransferAllData(pixd, &pix, 1, 1);
+        return pixd;
+    }
+
+        /* Set the input format as in pixReadMem() */
+    if (format == IFF_TIFF && pixGetDepth(pix) == 1)
+        format = IFF_TIFF_G4;
+    pixSetInputFormat(pix, format);
+    return pix;
+}
+
+
 /*!
  * \brief   pixReadHeaderMem()
  *
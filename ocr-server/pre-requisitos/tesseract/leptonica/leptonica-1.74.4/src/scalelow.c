@@ -91,6 +91,10 @@
  *         Grayscale mipmap
  *                  l_int32    scaleMipmapLow()
  *
+ *         Static helpers for 8 bpp lines
+ *                  static void  unpackGrayLineLow()
+ *                  static void  packGrayLineLow()
+ *
  * </pre>
  */
 
@@ -102,6 +106,9 @@
 #define  DEBUG_UNROLLING  0
 #endif  /* ~NO_CONSOLE_IO */
 
+static void unpackGrayLineLow(l_uint8 *bufd, l_uint32 *lines, l_int32 wpls);
+static void packGrayLineLow(l_uint32 *lined, l_uint8 *bufs, l_int32 wpld);
+
 
 /*------------------------------------------------------------------*
  *            General linear interpolated color scaling             *
@@ -220,6 +227,15 @@ l_float32  scx, scy;
  *  fractional area (i.e., number of sub-pixels divided
  *  by 256) associated with each of the four nearest src pixels,
  *  and weighting each pixel value by this fractional area.
+ *
+ *  The weights are separable, so each dest line is made by first
+ *  interpolating between the two src lines for all src pixels,
+ *  and then interpolating along that line for each dest pixel.
+ *  The sums are the same integers as when the four weighted src
+ *  pixels are added directly, so the result is unchanged.  The
+ *  vertical step runs over unpacked src lines and is vectorized
+ *  by the compiler, and the src locations and fractions of the
+ *  dest columns are computed once.
  */
 void
 scaleGrayLILow(l_uint32  *datad,
@@ -234,11 +250,13 @@ scaleGrayLILow(l_uint32  *datad,
 l_int32    i, j, wm2, hm2;
 l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
 l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
-l_int32    v00, v01, v10, v11, v00_val, v01_val, v10_val, v11_val;
-l_uint8    val;
-l_uint32  *lines, *lined;
+l_int32    yplast;
+l_int32   *xpa, *xp1a, *xfa, *vline;
+l_uint8   *line0, *line1, *lined8;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayLILow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -248,51 +266,67 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+    xpa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xp1a = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xfa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    vline = (l_int32 *)LEPT_CALLOC(ws, sizeof(l_int32));
+    line0 = (l_uint8 *)LEPT_CALLOC(4 * wpls, sizeof(l_uint8));
+    line1 = (l_uint8 *)LEPT_CALLOC(4 * wpls, sizeof(l_uint8));
+    lined8 = (l_uint8 *)LEPT_CALLOC(4 * wpld, sizeof(l_uint8));
+    if (!xpa || !xp1a || !xfa || !vline || !line0 || !line1 || !lined8) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
+    }
+
+        /* The src pixel and fraction of each dest column.  At the right
+         * side, the pixel to the right is the pixel itself. */
+    for (j = 0; j < wd; j++) {
+        xpm = (l_int32)(scx * (l_float32)j);
+        xp = xpm >> 4;
+        xpa[j] = xp;
+        xp1a[j] = (xp > wm2) ? xp : xp + 1;
+        xfa[j] = xpm & 0x0f;
+    }
+
+        /* Iterate over the destination lines */
+    yplast = -1;
     for (i = 0; i < hd; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
-        lined = datad + i * wpld;
-        lines = datas + yp * wpls;
-        for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
 
-                /* Do bilinear interpolation.  Without this, we could
-                 * simply subsample:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!  */
-            v00_val = GET_DATA_BYTE(lines, xp);
-            if (xp > wm2 || yp > hm2) {
-                if (yp > hm2 && xp <= wm2) {  /* pixels near bottom */
-                    v01_val = v00_val;
-                    v10_val = GET_DATA_BYTE(lines, xp + 1);
-                    v11_val = v10_val;
-                } else if (xp > wm2 && yp <= hm2) {  /* pixels near rt side */
-                    v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                    v10_val = v00_val;
-                    v11_val = v01_val;
-                } else {  /* pixels at LR corner */
-                    v10_val = v01_val = v11_val = v00_val;
-                }
-            } else {
-                v10_val = GET_DATA_BYTE(lines, xp + 1);
-                v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                v11_val = GET_DATA_BYTE(lines + wpls, xp + 1);
-            }
-
-            v00 = (16 - xf) * (16 - yf) * v00_val;
-            v10 = xf * (16 - yf) * v10_val;
-            v01 = (16 - xf) * yf * v01_val;
-            v11 = xf * yf * v11_val;
+            /* Unpack the src line and the one below it; at the bottom,
+             * the line below is the line itself. */
+        if (yp != yplast) {
+            unpackGrayLineLow(line0, datas + yp * wpls, wpls);
+            unpackGrayLineLow(line1, datas + ((yp > hm2) ? yp : yp + 1) * wpls,
+                              wpls);
+            yplast = yp;
+        }
 
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
-            SET_DATA_BYTE(lined, j, val);
+            /* Do bilinear interpolation.  Without this, we could
+             * simply subsample, which is faster but gives lousy
+             * results!  The sum of the 4 weighted pixels is
+             *   (16 - xf) * v0[xp] + xf * v0[xp + 1]
+             * where v0[x] = (16 - yf) * line0[x] + yf * line1[x]. */
+        for (j = 0; j < ws; j++)
+            vline[j] = (16 - yf) * line0[j] + yf * line1[j];
+        for (j = 0; j < wd; j++) {
+            xf = xfa[j];
+            lined8[j] = (l_uint8)(((16 - xf) * vline[xpa[j]] +
+                                   xf * vline[xp1a[j]] + 128) >> 8);
         }
+        packGrayLineLow(datad + i * wpld, lined8, wpld);
     }
 
+cleanup:
+    LEPT_FREE(xpa);
+    LEPT_FREE(xp1a);
+    LEPT_FREE(xfa);
+    LEPT_FREE(vline);
+    LEPT_FREE(line0);
+    LEPT_FREE(line1);
+    LEPT_FREE(lined8);
     return;
 }
 
@@ -1413,6 +1447,14 @@ l_float32  scx, scy;
  *  factors between 1.5 and 5.  All src pixels are subdivided
  *  into 256 sub-pixels, and are weighted by the number of
  *  sub-pixels covered by the dest pixel.
+ *
+ *  The weight of each src pixel is the product of its weights in
+ *  x and y, so the sum for each dest line is made in two steps.
+ *  First the src lines that it covers are added with their y weights,
+ *  for all src pixels of the line, in a loop that the compiler
+ *  vectorizes.  Then, for each dest pixel, the sums of the src
+ *  columns that it covers are added with their x weights.  The
+ *  result is identical to adding the weighted src pixels directly.
  */
 void
 scaleGrayAreaMapLow(l_uint32  *datad,
@@ -1429,17 +1471,15 @@ l_int32    xu, yu;  /* UL corner in src image, to 1/16 of a pixel */
 l_int32    xl, yl;  /* LR corner in src image, to 1/16 of a pixel */
 l_int32    xup, yup, xuf, yuf;  /* UL src pixel: integer and fraction */
 l_int32    xlp, ylp, xlf, ylf;  /* LR src pixel: integer and fraction */
-l_int32    delx, dely, area;
-l_int32    v00;  /* contrib. from UL src pixel */
-l_int32    v01;  /* contrib. from LL src pixel */
-l_int32    v10;  /* contrib from UR src pixel */
-l_int32    v11;  /* contrib from LR src pixel */
-l_int32    vin;  /* contrib from all full interior src pixels */
-l_int32    vmid;  /* contrib from side parts that are full in 1 direction */
-l_int32    val;
+l_int32    delx, dely, area, areay;
+l_int32    sum;
+l_int32   *xupa, *xufa, *xlpa, *xlfa, *vline;
+l_uint8   *lines8, *lined8;
 l_uint32  *lines, *lined;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayAreaMapLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1449,7 +1489,29 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+    xupa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xufa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xlpa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xlfa = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    vline = (l_int32 *)LEPT_CALLOC(ws, sizeof(l_int32));
+    lines8 = (l_uint8 *)LEPT_CALLOC(4 * wpls, sizeof(l_uint8));
+    lined8 = (l_uint8 *)LEPT_CALLOC(4 * wpld, sizeof(l_uint8));
+    if (!xupa || !xufa || !xlpa || !xlfa || !vline || !lines8 || !lined8) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
+    }
+
+        /* The src pixels and fractions of each dest column */
+    for (j = 0; j < wd; j++) {
+        xu = (l_int32)(scx * j);
+        xl = (l_int32)(scx * (j + 1.0));
+        xupa[j] = xu >> 4;
+        xufa[j] = xu & 0x0f;
+        xlpa[j] = xl >> 4;
+        xlfa[j] = xl & 0x0f;
+    }
+
+        /* Iterate over the destination lines */
     for (i = 0; i < hd; i++) {
         yu = (l_int32)(scy * i);
         yl = (l_int32)(scy * (i + 1.0));
@@ -1460,53 +1522,68 @@ l_float32  scx, scy;
         dely = ylp - yup;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
-        for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
-            xup = xu >> 4;
-            xuf = xu & 0x0f;
-            xlp = xl >> 4;
-            xlf = xl & 0x0f;
-            delx = xlp - xup;
 
-                /* If near the edge, just use a src pixel value */
-            if (xlp > wm2 || ylp > hm2) {
-                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup));
+            /* If near the bottom, just use a src pixel value */
+        if (ylp > hm2) {
+            for (j = 0; j < wd; j++)
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xupa[j]));
+            continue;
+        }
+
+            /* Sum the src lines with their y weights: top, full
+             * interior lines, and bottom */
+        unpackGrayLineLow(lines8, lines, wpls);
+        for (m = 0; m < ws; m++)
+            vline[m] = (16 - yuf) * lines8[m];
+        for (k = 1; k < dely; k++) {
+            unpackGrayLineLow(lines8, lines + k * wpls, wpls);
+            for (m = 0; m < ws; m++)
+                vline[m] += 16 * lines8[m];
+        }
+        unpackGrayLineLow(lines8, lines + dely * wpls, wpls);
+        for (m = 0; m < ws; m++)
+            vline[m] += ylf * lines8[m];
+        areay = (16 - yuf) + 16 * (dely - 1) + ylf;
+
+        for (j = 0; j < wd; j++) {
+            xup = xupa[j];
+            xuf = xufa[j];
+            xlp = xlpa[j];
+            xlf = xlfa[j];
+
+                /* If near the right side, just use a src pixel value */
+            if (xlp > wm2) {
+                lined8[j] = GET_DATA_BYTE(lines, xup);
                 continue;
             }
 
                 /* Area summed over, in subpixels.  This varies
                  * due to the quantization, so we can't simply take
                  * the area to be a constant: area = scx * scy. */
-            area = ((16 - xuf) + 16 * (delx - 1) + xlf) *
-                   ((16 - yuf) + 16 * (dely - 1) + ylf);
+            delx = xlp - xup;
+            area = ((16 - xuf) + 16 * (delx - 1) + xlf) * areay;
 
-                /* Do area map summation */
-            v00 = (16 - xuf) * (16 - yuf) * GET_DATA_BYTE(lines, xup);
-            v10 = xlf * (16 - yuf) * GET_DATA_BYTE(lines, xlp);
-            v01 = (16 - xuf) * ylf * GET_DATA_BYTE(lines + dely * wpls, xup);
-            v11 = xlf * ylf * GET_DATA_BYTE(lines + dely * wpls, xlp);
-            for (vin = 0, k = 1; k < dely; k++) {  /* for full src pixels */
-                 for (m = 1; m < delx; m++) {
-                     vin += 256 * GET_DATA_BYTE(lines + k * wpls, xup + m);
-                 }
-            }
-            for (vmid = 0, k = 1; k < dely; k++)  /* for left side */
-                vmid += (16 - xuf) * 16 * GET_DATA_BYTE(lines + k * wpls, xup);
-            for (k = 1; k < dely; k++)  /* for right side */
-                vmid += xlf * 16 * GET_DATA_BYTE(lines + k * wpls, xlp);
-            for (m = 1; m < delx; m++)  /* for top side */
-                vmid += 16 * (16 - yuf) * GET_DATA_BYTE(lines, xup + m);
-            for (m = 1; m < delx; m++)  /* for bottom side */
-                vmid += 16 * ylf * GET_DATA_BYTE(lines + dely * wpls, xup + m);
-            val = (v00 + v01 + v10 + v11 + vin + vmid + 128) / area;
+                /* Do area map summation over the weighted columns */
+            sum = (16 - xuf) * vline[xup] + xlf * vline[xlp];
+            for (m = 1; m < delx; m++)  /* for full src columns */
+                sum += 16 * vline[xup + m];
+            lined8[j] = (l_uint8)((sum + 128) / area);
 #if  DEBUG_OVERFLOW
-            if (val > 255) fprintf(stderr, "val overflow: %d\n", val);
+            if ((sum + 128) / area > 255)
+                fprintf(stderr, "val overflow: %d\n", (sum + 128) / area);
 #endif  /* DEBUG_OVERFLOW */
-            SET_DATA_BYTE(lined, j, val);
         }
+        packGrayLineLow(lined, lined8, wpld);
     }
 
+cleanup:
+    LEPT_FREE(xupa);
+    LEPT_FREE(xufa);
+    LEPT_FREE(xlpa);
+    LEPT_FREE(xlfa);
+    LEPT_FREE(vline);
+    LEPT_FREE(lines8);
+    LEPT_FREE(lined8);
     return;
 }
 
@@ -1532,13 +1609,33 @@ scaleAreaMapLow2(l_uint32  *datad,
 {
 l_int32    i, j, val, rval, gval, bval;
 l_uint32  *lines, *lined;
-l_uint32   pixel;
+l_uint32   pixel, sum1, sum2;
 
     if (d == 8) {
         for (i = 0; i < hd; i++) {
             lines = datas + 2 * i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < wd; j++) {
+
+                /* Four dest pixels at a time from two src words in each
+                 * line.  The pairs of pixels in a word are added in
+                 * 16-bit fields, and then the two lines are added. */
+            for (j = 0; j < wd / 4; j++) {
+                sum1 = ((lines[2 * j] >> 8) & 0x00ff00ff) +
+                       (lines[2 * j] & 0x00ff00ff) +
+                       ((lines[wpls + 2 * j] >> 8) & 0x00ff00ff) +
+                       (lines[wpls + 2 * j] & 0x00ff00ff);
+                sum2 = ((lines[2 * j + 1] >> 8) & 0x00ff00ff) +
+                       (lines[2 * j + 1] & 0x00ff00ff) +
+                       ((lines[wpls + 2 * j + 1] >> 8) & 0x00ff00ff) +
+                       (lines[wpls + 2 * j + 1] & 0x00ff00ff);
+                sum1 = (sum1 >> 2) & 0x00ff00ff;
+                sum2 = (sum2 >> 2) & 0x00ff00ff;
+                lined[j] = ((sum1 & 0x00ff0000) << 8) |
+                           ((sum1 & 0x000000ff) << 16) |
+                           ((sum2 & 0x00ff0000) >> 8) |
+                           (sum2 & 0x000000ff);
+            }
+            for (j = 4 * (wd / 4); j < wd; j++) {
                     /* Average each dest pixel using 4 src pixels */
                 val = GET_DATA_BYTE(lines, 2 * j);
                 val += GET_DATA_BYTE(lines, 2 * j + 1);
@@ -2480,3 +2577,53 @@ l_float32  ratio, w1, w2;
     LEPT_FREE(scol);
     return 0;
 }
+
+
+/*------------------------------------------------------------------*
+ *                  Static helpers for 8 bpp lines                  *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   unpackGrayLineLow()
+ *
+ *  Copies the 8 bpp pixels of the %wpls words of a raster line into
+ *  a byte array in pixel order, whatever the byte order of the
+ *  machine, so they can be used in simple vectorizable loops.
+ */
+static void
+unpackGrayLineLow(l_uint8   *bufd,
+                  l_uint32  *lines,
+                  l_int32    wpls)
+{
+l_int32   j;
+l_uint32  word;
+
+    for (j = 0; j < wpls; j++) {
+        word = lines[j];
+        bufd[4 * j] = (l_uint8)(word >> 24);
+        bufd[4 * j + 1] = (l_uint8)(word >> 16);
+        bufd[4 * j + 2] = (l_uint8)(word >> 8);
+        bufd[4 * j + 3] = (l_uint8)word;
+    }
+}
+
+
+/*!
+ * \brief   packGrayLineLow()
+ *
+ *  The inverse of unpackGrayLineLow(): writes the byte array of
+ *  %4 * wpld pixels into the words of a raster line.
+ */
+static void
+packGrayLineLow(l_uint32  *lined,
+                l_uint8   *bufs,
+                l_int32    wpld)
+{
+l_int32  j;
+
+    for (j = 0; j < wpld; j++) {
+        lined[j] = ((l_uint32)bufs[4 * j] << 24) |
+                   ((l_uint32)bufs[4 * j + 1] << 16) |
+                   ((l_uint32)bufs[4 * j + 2] << 8) |
+                   (l_uint32)bufs[4 * j + 3];
+    }
+}
@@ -39,6 +39,7 @@
  *             PIX       *pixReadTiff()             [ special top level ]
  *             PIX       *pixReadStreamTiff()
  *      static PIX       *pixReadFromTiffStream()
+ *      static l_int32    tiffReadStripsToPix()
  *
  *     Writing tiff:
  *             l_int32    pixWriteTiff()            [ special top level ]
@@ -50,6 +51,7 @@
  *
  *     Reading and writing multipage tiff
  *             PIX       *pixReadFromMultipageTiff()
+ *             PIX       *pixReadFromMultipageTiffToPix()
  *             PIXA      *pixaReadMultipageTiff()   [ special top level ]
  *             l_int32    pixaWriteMultipageTiff()  [ special top level ]
  *             l_int32    writeMultipageTiff()      [ special top level ]
@@ -80,6 +82,7 @@
  *             [10 static helper functions]
  *             PIX       *pixReadMemTiff();
  *             PIX       *pixReadMemFromMultipageTiff();
+ *             PIX       *pixReadMemFromMultipageTiffToPix();
  *             PIXA      *pixaReadMemMultipageTiff()    [ special top level ]
  *             l_int32    pixaWriteMemMultipageTiff()   [ special top level ]
  *             l_int32    pixWriteMemTiff();
@@ -122,7 +125,8 @@ static const l_int32  MANY_PAGES_IN_TIFF_FILE = 3000;  /* warn if big */
 
 
     /* All functions with TIFF interfaces are static. */
-static PIX      *pixReadFromTiffStream(TIFF *tif);
+static PIX      *pixReadFromTiffStream(PIX *pixd, TIFF *tif);
+static l_int32   tiffReadStripsToPix(TIFF *tif, PIX *pix, l_uint32 tiffbpl);
 static l_int32   getTiffStreamResolution(TIFF *tif, l_int32 *pxres,
                                          l_int32 *pyres);
 static l_int32   tiffReadHeaderTiff(TIFF *tif, l_int32 *pwidth,
@@ -424,7 +428,7 @@ TIFF    *tif;
         TIFFCleanup(tif);
         return NULL;
     }
-    if ((pix = pixReadFromTiffStream(tif)) == NULL) {
+    if ((pix = pixReadFromTiffStream(NULL, tif)) == NULL) {
         TIFFCleanup(tif);
         return NULL;
     }
@@ -436,8 +440,9 @@ TIFF    *tif;
 /*!
  * \brief   pixReadFromTiffStream()
  *
+ * \param[in]    pixd [optional] pix to decode into; can be null
  * \param[in]    tif TIFF handle
- * \return  pix, or NULL on error
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
  *
  * <pre>
  * Notes:
@@ -464,12 +469,17 @@ TIFF    *tif;
  *          bilevel to RGB, greyscale to RGB, CMYK to RGB, YCbCr to RGB,
  *          16-bit samples to 8-bit samples, associated/unassociated alpha,
  *          etc."
+ *      (4) If pixd is not null, it is reused for the image with
+ *          pixReuseNoInit(), and on error it is not destroyed.
+ *      (5) 1 spp images, including g4, are decoded directly into the
+ *          pix; see tiffReadStripsToPix().
  * </pre>
  */
 static PIX *
-pixReadFromTiffStream(TIFF  *tif)
+pixReadFromTiffStream(PIX   *pixd,
+                      TIFF  *tif)
 {
-l_uint8   *linebuf, *data;
+l_uint8   *data;
 l_uint16   spp, bps, bpp, photometry, tiffcomp, orientation;
 l_uint16  *redmap, *greenmap, *bluemap;
 l_int32    d, wpl, bpl, comptype, i, j, ncolors, rval, gval, bval;
@@ -477,7 +487,7 @@ l_int32    xres, yres;
 l_uint32   w, h, tiffbpl, tiffword;
 l_uint32  *line, *ppixel, *tiffdata;
 l_uint32   read_oriented;
-PIX       *pix;
+PIX       *pix, *pix1;
 PIXCMAP   *cmap;
 
     PROCNAME("pixReadFromTiffStream");
@@ -505,7 +515,7 @@ PIXCMAP   *cmap;
     TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
     tiffbpl = TIFFScanlineSize(tif);
 
-    if ((pix = pixCreate(w, h, d)) == NULL)
+    if ((pix = pixReuseNoInit(pixd, w, h, d)) == NULL)
         return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     pixSetInputFormat(pix, IFF_TIFF);
     data = (l_uint8 *)pixGetData(pix);
@@ -514,33 +524,37 @@ PIXCMAP   *cmap;
 
         /* Read the data */
     if (spp == 1) {
-        linebuf = (l_uint8 *)LEPT_CALLOC(tiffbpl + 1, sizeof(l_uint8));
-        for (i = 0 ; i < h ; i++) {
-            if (TIFFReadScanline(tif, linebuf, i, 0) < 0) {
-                LEPT_FREE(linebuf);
-                pixDestroy(&pix);
-                return (PIX *)ERROR_PTR("line read fail", procName, NULL);
+        if (!TIFFIsTiled(tif)) {
+            if (tiffReadStripsToPix(tif, pix, tiffbpl)) {
+                if (pix != pixd) pixDestroy(&pix);
+                return (PIX *)ERROR_PTR("strip read fail", procName, NULL);
+            }
+        } else {  /* each line is read into the pix */
+            for (i = 0 ; i < h ; i++) {
+                if (TIFFReadScanline(tif, data, i, 0) < 0) {
+                    if (pix != pixd) pixDestroy(&pix);
+                    return (PIX *)ERROR_PTR("line read fail", procName, NULL);
+                }
+                data += bpl;
             }
-            memcpy((char *)data, (char *)linebuf, tiffbpl);
-            data += bpl;
         }
         if (bps <= 8)
             pixEndianByteSwap(pix);
         else   /* bps == 16 */
             pixEndianTwoByteSwap(pix);
-        LEPT_FREE(linebuf);
+        pixSetPadBits(pix, 0);
     }
     else {  /* rgb */
         if ((tiffdata = (l_uint32 *)LEPT_CALLOC(w * h, sizeof(l_uint32)))
             == NULL) {
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
             return (PIX *)ERROR_PTR("calloc fail for tiffdata", procName, NULL);
         }
             /* TIFFReadRGBAImageOriented() converts to 8 bps */
         if (!TIFFReadRGBAImageOriented(tif, w, h, (uint32 *)tiffdata,
                                        ORIENTATION_TOPLEFT, 0)) {
             LEPT_FREE(tiffdata);
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
             return (PIX *)ERROR_PTR("failed to read tiffdata", procName, NULL);
         } else {
             read_oriented = 1;
@@ -577,11 +591,11 @@ PIXCMAP   *cmap;
              * and go from black (0) to white (0xffff), the
              * the pix cmap takes the most significant byte. */
         if (bps > 8) {
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
             return (PIX *)ERROR_PTR("invalid bps; > 8", procName, NULL);
         }
         if ((cmap = pixcmapCreate(bps)) == NULL) {
-            pixDestroy(&pix);
+            if (pix != pixd) pixDestroy(&pix);
             return (PIX *)ERROR_PTR("cmap not made", procName, NULL);
         }
         ncolors = 1 << bps;
@@ -614,10 +628,9 @@ PIXCMAP   *cmap;
                 &tiff_orientation_transforms[orientation - 1];
             if (transform->vflip) pixFlipTB(pix, pix);
             if (transform->hflip) pixFlipLR(pix, pix);
-            if (transform->rotate) {
-                PIX *oldpix = pix;
-                pix = pixRotate90(oldpix, transform->rotate);
-                pixDestroy(&oldpix);
+            if (transform->rotate) {  /* keep the same pix */
+                if ((pix1 = pixRotate90(pix, transform->rotate)) != NULL)
+                    pixTransferAllData(pix, &pix1, 0, 0);
             }
         }
     }
@@ -627,6 +640,77 @@ PIXCMAP   *cmap;
 
 
 
+/*!
+ * \brief   tiffReadStripsToPix()
+ *
+ * \param[in]    tif TIFF handle, for a 1 spp image in strips
+ * \param[in]    pix of the size of the image
+ * \param[in]    tiffbpl bytes in each line of the tiff image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each strip is decoded with a single call, directly into the
+ *          pix data at the start of its first line, and its lines are
+ *          then moved in place to the pix line spacing, starting with
+ *          the last.  Because tiffbpl is never larger than the pix bpl,
+ *          the strip never overwrites a previous line, and a line is
+ *          never moved over one that has not been moved yet.  So
+ *          there is no temporary buffer, and no copy of lines that
+ *          are already in place (e.g., 1 bpp with width a multiple
+ *          of 32).  For g4, this is the whole page in a single call,
+ *          because the page is usually a single strip.
+ *      (2) The data is in byte order, as for TIFFReadScanline().
+ *          The caller does the byte swap to the pix word layout.
+ * </pre>
+ */
+static l_int32
+tiffReadStripsToPix(TIFF     *tif,
+                    PIX      *pix,
+                    l_uint32  tiffbpl)
+{
+l_uint8   *data, *dest;
+l_int32    i, nrows;
+l_uint32   h, bpl, row, strip, nstrips, rowsperstrip;
+
+    PROCNAME("tiffReadStripsToPix");
+
+    if (!tif)
+        return ERROR_INT("tif not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+
+    h = pixGetHeight(pix);
+    bpl = 4 * pixGetWpl(pix);
+    if (tiffbpl == 0 || tiffbpl > bpl)
+        return ERROR_INT("invalid tiffbpl", procName, 1);
+    data = (l_uint8 *)pixGetData(pix);
+    rowsperstrip = h;
+    TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsperstrip);
+    if (rowsperstrip == 0 || rowsperstrip > h)
+        rowsperstrip = h;
+    nstrips = TIFFNumberOfStrips(tif);
+
+    for (strip = 0, row = 0; row < h; strip++, row += rowsperstrip) {
+        if (strip >= nstrips)
+            return ERROR_INT("too few strips", procName, 1);
+        nrows = L_MIN(rowsperstrip, h - row);
+        dest = data + (size_t)row * bpl;
+        if (TIFFReadEncodedStrip(tif, strip, dest,
+                                 (tsize_t)nrows * tiffbpl) < 0) {
+            L_ERROR("read fail for strip %u\n", procName, strip);
+            return 1;
+        }
+        if (bpl != tiffbpl) {
+            for (i = nrows - 1; i > 0; i--)
+                memmove(dest + (size_t)i * bpl, dest + (size_t)i * tiffbpl,
+                        tiffbpl);
+        }
+    }
+    return 0;
+}
+
+
 /*--------------------------------------------------------------*
  *                       Writing to file                        *
  *--------------------------------------------------------------*/
@@ -707,6 +791,8 @@ pixWriteTiff(const char  *filename,
  *          f VERY IMPORTANT: if there are any tags that require the
  *              extra size value, stored in nasizes, they must be
  *              written first!
+ *          g The image is written as a single strip, unless
+ *              TIFFTAG_ROWSPERSTRIP is given as an "l_uint32" tag.
  */
 l_int32
 pixWriteTiffCustom(const char  *filename,
@@ -964,6 +1050,9 @@ char      *text;
         TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
     }
 
+        /* Use single strip for image, unless a custom tag says otherwise */
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, h);
+
         /* This is a no-op if arrays are NULL */
     writeCustomTiffTags(tif, natags, savals, satypes, nasizes);
 
@@ -976,9 +1065,6 @@ char      *text;
     if ((linebuf = (l_uint8 *)LEPT_CALLOC(1, bpl)) == NULL)
         return ERROR_INT("calloc fail for linebuf", procName, 1);
 
-        /* Use single strip for image */
-    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, h);
-
     if (d != 24 && d != 32) {
         if (d == 16)
             pixt = pixEndianTwoByteSwapNew(pix);
@@ -1172,18 +1258,58 @@ l_uint32   uval, uval2;
  *                Pix *pix = pixReadFromMultipageTiff(filename, &offset);
  *                // do something with pix
  *            } while (offset != 0);
+ *      (8) To decode all the images into the same pix, use
+ *          pixReadFromMultipageTiffToPix().
  * </pre>
  */
 PIX *
 pixReadFromMultipageTiff(const char  *fname,
                          size_t      *poffset)
+{
+    return pixReadFromMultipageTiffToPix(NULL, fname, poffset);
+}
+
+
+/*!
+ * \brief   pixReadFromMultipageTiffToPix()
+ *
+ * \param[in]    pixd      [optional] pix to decode into; can be null
+ * \param[in]    fname     filename
+ * \param[in,out]  &offset  set offset to 0 for first image
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *              or if previous call returned the last image
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixReadFromMultipageTiff() with a pix supplied by
+ *          the caller to hold the image.  pixd is reused with
+ *          pixReuseNoInit(), so when it is used for all the images
+ *          of a file of pages of the same size, its data buffer
+ *          is allocated only once.
+ *      (2) pixd must not be cloned.  When NULL is returned, pixd still
+ *          belongs to the caller, and its image content is undefined.
+ *      (3) Example usage for reading all the images in the tif file:
+ *            size_t offset = 0;
+ *            Pix *pix = pixCreate(1, 1, 1);
+ *            do {
+ *                if (!pixReadFromMultipageTiffToPix(pix, filename, &offset))
+ *                    break;
+ *                // do something with pix
+ *            } while (offset != 0);
+ *            pixDestroy(&pix);
+ * </pre>
+ */
+PIX *
+pixReadFromMultipageTiffToPix(PIX         *pixd,
+                              const char  *fname,
+                              size_t      *poffset)
 {
 l_int32  retval;
 size_t   offset;
 PIX     *pix;
 TIFF    *tif;
 
-    PROCNAME("pixReadFromMultipageTiff");
+    PROCNAME("pixReadFromMultipageTiffToPix");
 
     if (!fname)
         return (PIX *)ERROR_PTR("fname not defined", procName, NULL);
@@ -1204,7 +1330,7 @@ TIFF    *tif;
         return NULL;
     }
 
-    if ((pix = pixReadFromTiffStream(tif)) == NULL) {
+    if ((pix = pixReadFromTiffStream(pixd, tif)) == NULL) {
         TIFFCleanup(tif);
         return NULL;
     }
@@ -1252,7 +1378,7 @@ TIFF    *tif;
     pixa = pixaCreate(npages);
     pix = NULL;
     for (i = 0; i < npages; i++) {
-        if ((pix = pixReadFromTiffStream(tif)) != NULL) {
+        if ((pix = pixReadFromTiffStream(NULL, tif)) != NULL) {
             pixaAddPix(pixa, pix, L_INSERT);
         } else {
             L_WARNING("pix not read for page %d\n", procName, i);
@@ -2448,7 +2574,7 @@ TIFF     *tif;
     pix = NULL;
     for (i = 0; ; i++) {
         if (i == n) {
-            if ((pix = pixReadFromTiffStream(tif)) == NULL) {
+            if ((pix = pixReadFromTiffStream(NULL, tif)) == NULL) {
                 TIFFClose(tif);
                 return NULL;
             }
@@ -2489,12 +2615,40 @@ TIFF     *tif;
  *                Pix *pix = pixReadMemFromMultipageTiff(data, size, &offset);
  *                // do something with pix
  *            } while (offset != 0);
+ *      (4) To decode all the images into the same pix, use
+ *          pixReadMemFromMultipageTiffToPix().
  * </pre>
  */
 PIX *
 pixReadMemFromMultipageTiff(const l_uint8  *cdata,
                             size_t          size,
                             size_t         *poffset)
+{
+    return pixReadMemFromMultipageTiffToPix(NULL, cdata, size, poffset);
+}
+
+
+/*!
+ * \brief   pixReadMemFromMultipageTiffToPix()
+ *
+ * \param[in]    pixd       [optional] pix to decode into; can be null
+ * \param[in]    cdata      const; tiff-encoded
+ * \param[in]    size       size of cdata
+ * \param[in,out]  &offset  set offset to 0 for first image
+ * \return  pixd, or a new pix if pixd is null, or NULL on error
+ *              or if previous call returned the last image
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is a read-from-memory version of
+ *          pixReadFromMultipageTiffToPix().  See that function for usage.
+ * </pre>
+ */
+PIX *
+pixReadMemFromMultipageTiffToPix(PIX            *pixd,
+                                 const l_uint8  *cdata,
+                                 size_t          size,
+                                 size_t         *poffset)
 {
 l_uint8  *data;
 l_int32   retval;
@@ -2502,7 +2656,7 @@ size_t    offset;
 PIX      *pix;
 TIFF     *tif;
 
-    PROCNAME("pixReadMemFromMultipageTiff");
+    PROCNAME("pixReadMemFromMultipageTiffToPix");
 
     if (!cdata)
         return (PIX *)ERROR_PTR("cdata not defined", procName, NULL);
@@ -2522,7 +2676,7 @@ TIFF     *tif;
         return NULL;
     }
 
-    if ((pix = pixReadFromTiffStream(tif)) == NULL) {
+    if ((pix = pixReadFromTiffStream(pixd, tif)) == NULL) {
         TIFFClose(tif);
         return NULL;
     }
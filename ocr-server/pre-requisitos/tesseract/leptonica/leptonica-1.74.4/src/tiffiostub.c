@@ -96,6 +96,15 @@ PIX * pixReadFromMultipageTiff(const char *filename, size_t *poffset)
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadFromMultipageTiffToPix(PIX *pixd, const char *filename,
+                                    size_t *poffset)
+{
+    return (PIX *)ERROR_PTR("function not present",
+                            "pixReadFromMultipageTiffToPix", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 PIXA * pixaReadMultipageTiff(const char *filename)
 {
     return (PIXA *)ERROR_PTR("function not present",
@@ -207,6 +216,15 @@ PIX * pixReadMemFromMultipageTiff(const l_uint8 *cdata, size_t size,
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadMemFromMultipageTiffToPix(PIX *pixd, const l_uint8 *cdata,
+                                       size_t size, size_t *poffset)
+{
+    return (PIX *)ERROR_PTR("function not present",
+                            "pixReadMemFromMultipageTiffToPix", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 PIXA * pixaReadMemMultipageTiff(const l_uint8 *data, size_t size)
 {
     return (PIXA *)ERROR_PTR("function not present",
@@ -56,6 +56,8 @@
 #include "blobclass.h"
 #include "resultiterator.h"
 #include "mutableiterator.h"
+#include "pageskew.h"
+#include "pagesnapshot.h"
 #include "thresholder.h"
 #include "tesseractclass.h"
 #include "pageres.h"
@@ -186,7 +188,10 @@ TessBaseAPI::TessBaseAPI()
       rect_width_(0),
       rect_height_(0),
       image_width_(0),
-      image_height_(0) {}
+      image_height_(0),
+      image_skew_(0.0),
+      image_skew_found_(false),
+      skewed_input_(NULL) {}
 
 TessBaseAPI::~TessBaseAPI() {
   End();
@@ -283,7 +288,7 @@ bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
 
 bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
   IntParam *p = ParamUtils::FindParam<IntParam>(
-      name, GlobalParams()->int_params, tesseract_->params()->int_params);
+      name, GlobalParams()->int_index, &tesseract_->params()->int_index);
   if (p == NULL) return false;
   *value = (inT32)(*p);
   return true;
@@ -291,7 +296,7 @@ bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
 
 bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      name, GlobalParams()->bool_params, tesseract_->params()->bool_params);
+      name, GlobalParams()->bool_index, &tesseract_->params()->bool_index);
   if (p == NULL) return false;
   *value = (BOOL8)(*p);
   return true;
@@ -299,13 +304,13 @@ bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
 
 const char *TessBaseAPI::GetStringVariable(const char *name) const {
   StringParam *p = ParamUtils::FindParam<StringParam>(
-      name, GlobalParams()->string_params, tesseract_->params()->string_params);
+      name, GlobalParams()->string_index, &tesseract_->params()->string_index);
   return (p != NULL) ? p->string() : NULL;
 }
 
 bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
   DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      name, GlobalParams()->double_params, tesseract_->params()->double_params);
+      name, GlobalParams()->double_index, &tesseract_->params()->double_index);
   if (p == NULL) return false;
   *value = (double)(*p);
   return true;
@@ -439,6 +444,39 @@ void TessBaseAPI::GetLoadedLanguagesAsVector(
   }
 }
 
+/**
+ * Returns, in the same order as GetLoadedLanguagesAsVector, the number of
+ * times each loaded language's recognizer has been run on a word.
+ */
+void TessBaseAPI::GetLangRunCounts(GenericVector<int>* counts) const {
+  counts->clear();
+  if (tesseract_ != NULL) {
+    counts->push_back(tesseract_->lang_run_count());
+    int num_subs = tesseract_->num_sub_langs();
+    for (int i = 0; i < num_subs; ++i)
+      counts->push_back(tesseract_->get_sub_lang(i)->lang_run_count());
+  }
+}
+
+/** Zeroes the counters returned by GetLangRunCounts. */
+void TessBaseAPI::ResetLangRunCounts() {
+  if (tesseract_ != NULL) tesseract_->ResetLangRunCounts();
+}
+
+/**
+ * Returns, in the same order as GetLoadedLanguagesAsVector, the number of
+ * bytes held by each loaded language's LSTM recoder and beam search.
+ */
+void TessBaseAPI::GetLSTMMemoryUsed(GenericVector<int>* bytes) const {
+  bytes->clear();
+  if (tesseract_ != NULL) {
+    bytes->push_back(tesseract_->lstm_memory_used());
+    int num_subs = tesseract_->num_sub_langs();
+    for (int i = 0; i < num_subs; ++i)
+      bytes->push_back(tesseract_->get_sub_lang(i)->lstm_memory_used());
+  }
+}
+
 /**
  * Returns the available languages in the vector of STRINGs.
  */
@@ -933,9 +971,16 @@ int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
 }
 
 // Takes ownership of the input pix.
-void TessBaseAPI::SetInputImage(Pix* pix) { tesseract_->set_pix_original(pix); }
+void TessBaseAPI::SetInputImage(Pix* pix) {
+  pixDestroy(&skewed_input_);
+  tesseract_->set_pix_original(pix);
+}
 
-Pix* TessBaseAPI::GetInputImage() { return tesseract_->pix_original(); }
+// Results are given in the coordinates of the image as it was input, so if
+// it has been deskewed, that is the image returned, not the deskewed copy.
+Pix* TessBaseAPI::GetInputImage() {
+  return skewed_input_ != NULL ? skewed_input_ : tesseract_->pix_original();
+}
 
 const char * TessBaseAPI::GetInputName() {
   if (input_file_)
@@ -1021,27 +1066,35 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
                                             TessResultRenderer* renderer,
                                             int tessedit_page_number) {
 #ifndef ANDROID_BUILD
-  Pix *pix = NULL;
+  // All the pages are decoded into the same Pix, so a run of pages of the
+  // same size allocates the image buffer only once. ProcessPage keeps no
+  // reference to it, as SetImage makes its own copy.
+  Pix *pix = pixCreate(1, 1, 1);
+  if (pix == NULL) return false;
   int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
   size_t offset = 0;
+  bool result = true;
   for (; ; ++page) {
     if (tessedit_page_number >= 0)
       page = tessedit_page_number;
-    pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
-                 : pixReadFromMultipageTiff(filename, &offset);
-    if (pix == NULL) break;
+    Pix *page_pix =
+        (data) ? pixReadMemFromMultipageTiffToPix(pix, data, size, &offset)
+               : pixReadFromMultipageTiffToPix(pix, filename, &offset);
+    if (page_pix == NULL) break;
     tprintf("Page %d\n", page + 1);
     char page_str[kMaxIntSize];
     snprintf(page_str, kMaxIntSize - 1, "%d", page);
     SetVariable("applybox_page", page_str);
-    bool r = ProcessPage(pix, page, filename, retry_config,
-                           timeout_millisec, renderer);
-    pixDestroy(&pix);
-    if (!r) return false;
+    if (!ProcessPage(pix, page, filename, retry_config,
+                     timeout_millisec, renderer)) {
+      result = false;
+      break;
+    }
     if (tessedit_page_number >= 0) break;
     if (!offset) break;
   }
-  return true;
+  pixDestroy(&pix);
+  return result;
 #else
   return false;
 #endif
@@ -1277,73 +1330,61 @@ MutableIterator* TessBaseAPI::GetMutableIterator() {
 
 /** Make a text string from the internal data structures. */
 char* TessBaseAPI::GetUTF8Text() {
-  if (tesseract_ == NULL ||
-      (!recognition_done_ && Recognize(NULL) < 0))
-    return NULL;
   STRING text("");
-  ResultIterator *it = GetIterator();
-  do {
-    if (it->Empty(RIL_PARA)) continue;
-    const std::unique_ptr<const char[]> para_text(it->GetUTF8Text(RIL_PARA));
-    text += para_text.get();
-  } while (it->Next(RIL_PARA));
+  if (!GetUTF8Text(&text)) return NULL;
   char* result = new char[text.length() + 1];
   strncpy(result, text.string(), text.length() + 1);
-  delete it;
   return result;
 }
 
 /**
- * Gets the block orientation at the current iterator position.
+ * Replaces the contents of *text with the recognized text, reusing its
+ * storage. Returns false on failure.
  */
-static tesseract::Orientation GetBlockTextOrientation(const PageIterator *it) {
-  tesseract::Orientation orientation;
-  tesseract::WritingDirection writing_direction;
-  tesseract::TextlineOrder textline_order;
-  float deskew_angle;
-  it->Orientation(&orientation, &writing_direction, &textline_order,
-                  &deskew_angle);
-  return orientation;
+bool TessBaseAPI::GetUTF8Text(STRING* text) {
+  if (tesseract_ == NULL ||
+      (!recognition_done_ && Recognize(NULL) < 0))
+    return false;
+  text->truncate_at(0);
+  ResultIterator *it = GetIterator();
+  do {
+    if (it->Empty(RIL_PARA)) continue;
+    it->AppendUTF8ParagraphText(text);
+  } while (it->Next(RIL_PARA));
+  delete it;
+  return true;
 }
 
 /**
- * Fits a line to the baseline at the given level, and appends its coefficients
- * to the hOCR string.
+ * Fits a line to the baseline of the given textline of a block, and appends
+ * its coefficients to the hOCR string.
  * NOTE: The hOCR spec is unclear on how to specify baseline coefficients for
  * rotated textlines. For this reason, on textlines that are not upright, this
  * method currently only inserts a 'textangle' property to indicate the rotation
  * direction and does not add any baseline information to the hocr string.
  */
-static void AddBaselineCoordsTohOCR(const PageIterator *it,
-                                    PageIteratorLevel level,
+static void AddBaselineCoordsTohOCR(const SnapshotBlock& block,
+                                    const SnapshotLine& line,
                                     STRING* hocr_str) {
-  tesseract::Orientation orientation = GetBlockTextOrientation(it);
-  if (orientation != ORIENTATION_PAGE_UP) {
-    hocr_str->add_str_int("; textangle ", 360 - orientation * 90);
+  if (block.orientation != ORIENTATION_PAGE_UP) {
+    hocr_str->add_str_int("; textangle ", 360 - block.orientation * 90);
     return;
   }
 
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
-
-  // Try to get the baseline coordinates at this level.
-  int x1, y1, x2, y2;
-  if (!it->Baseline(level, &x1, &y1, &x2, &y2))
-    return;
   // Following the description of this field of the hOCR spec, we convert the
   // baseline coordinates so that "the bottom left of the bounding box is the
   // origin".
-  x1 -= left;
-  x2 -= left;
-  y1 -= bottom;
-  y2 -= bottom;
+  int x1 = line.baseline_x1 - line.box.left;
+  int x2 = line.baseline_x2 - line.box.left;
+  int y1 = line.baseline_y1 - line.box.bottom;
+  int y2 = line.baseline_y2 - line.box.bottom;
 
   // Now fit a line through the points so we can extract coefficients for the
   // equation:  y = p1 x + p0
   double p1 = 0;
   double p0 = 0;
   if (x1 == x2) {
-    // Problem computing the polynomial coefficients.
+    // Problem computing the polynomial coefficients, or no baseline.
     return;
   }
   p1 = (y2 - y1) / static_cast<double>(x2 - x1);
@@ -1368,40 +1409,30 @@ static void AddIdTohOCR(STRING* hocr_str, const std::string base, int num1,
   *hocr_str += "'";
 }
 
-static void AddBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
-                         STRING* hocr_str) {
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
+/**
+ * Appends the given box to the hOCR string. If line is not NULL, box is its
+ * box, and its baseline and heights in the given block are added too.
+ */
+static void AddBoxTohOCR(const SnapshotBox& box, const SnapshotBlock& block,
+                         const SnapshotLine* line, STRING* hocr_str) {
   // This is the only place we use double quotes instead of single quotes,
   // but it may too late to change for consistency
-  hocr_str->add_str_int(" title=\"bbox ", left);
-  hocr_str->add_str_int(" ", top);
-  hocr_str->add_str_int(" ", right);
-  hocr_str->add_str_int(" ", bottom);
+  hocr_str->add_str_int(" title=\"bbox ", box.left);
+  hocr_str->add_str_int(" ", box.top);
+  hocr_str->add_str_int(" ", box.right);
+  hocr_str->add_str_int(" ", box.bottom);
   // Add baseline coordinates & heights for textlines only.
-  if (level == RIL_TEXTLINE) {
-    AddBaselineCoordsTohOCR(it, level, hocr_str);
+  if (line != NULL) {
+    AddBaselineCoordsTohOCR(block, *line, hocr_str);
     // add custom height measures
-    float row_height, descenders, ascenders;  // row attributes
-    it->RowAttributes(&row_height, &descenders, &ascenders);
     // TODO(rays): Do we want to limit these to a single decimal place?
-    hocr_str->add_str_double("; x_size ", row_height);
-    hocr_str->add_str_double("; x_descenders ", descenders * -1);
-    hocr_str->add_str_double("; x_ascenders ", ascenders);
+    hocr_str->add_str_double("; x_size ", line->row_height);
+    hocr_str->add_str_double("; x_descenders ", line->descenders * -1);
+    hocr_str->add_str_double("; x_ascenders ", line->ascenders);
   }
   *hocr_str += "\">";
 }
 
-static void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
-                        STRING* hocr_str) {
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
-  hocr_str->add_str_int("\t", left);
-  hocr_str->add_str_int("\t", top);
-  hocr_str->add_str_int("\t", right - left);
-  hocr_str->add_str_int("\t", bottom - top);
-}
-
 /**
  * Make a HTML-formatted string with hOCR markup from the internal
  * data structures.
@@ -1430,8 +1461,6 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
 
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
   int page_id = page_number + 1;  // hOCR uses 1-based page numbers.
-  bool para_is_ltr = true;        // Default direction is LTR
-  const char* paragraph_lang = NULL;
   bool font_info = false;
   GetBoolVariable("hocr_font_info", &font_info);
 
@@ -1472,225 +1501,187 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   hocr_str.add_str_int("; ppageno ", page_number);
   hocr_str += "'>\n";
 
-  ResultIterator *res_it = GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
-
-    // Open any new block/paragraph/textline.
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      para_is_ltr = true;  // reset to default direction
-      hocr_str += "   <div class='ocr_carea'";
-      AddIdTohOCR(&hocr_str, "block", page_id, bcnt);
-      AddBoxTohOCR(res_it, RIL_BLOCK, &hocr_str);
-    }
-    if (res_it->IsAtBeginningOf(RIL_PARA)) {
+  std::unique_ptr<PageSnapshot> snapshot(GetPageSnapshot());
+  if (snapshot == nullptr) return NULL;
+  const char* text = snapshot->text();
+  for (int b = 0; b < snapshot->num_blocks(); ++b) {
+    const SnapshotBlock& block = snapshot->block(b);
+    hocr_str += "   <div class='ocr_carea'";
+    AddIdTohOCR(&hocr_str, "block", page_id, bcnt);
+    AddBoxTohOCR(block.box, block, NULL, &hocr_str);
+    for (int p = 0; p < block.num_paras; ++p) {
+      const SnapshotPara& para = snapshot->para(block.first_para + p);
       hocr_str += "\n    <p class='ocr_par'";
-      para_is_ltr = res_it->ParagraphIsLtr();
+      bool para_is_ltr = para.is_ltr != 0;
       if (!para_is_ltr) {
         hocr_str += " dir='rtl'";
       }
       AddIdTohOCR(&hocr_str, "par", page_id, pcnt);
-      paragraph_lang = res_it->WordRecognitionLanguage();
+      // The language of a paragraph is that of its first word.
+      const SnapshotLine& first_line = snapshot->line(para.first_line);
+      const char* paragraph_lang =
+          snapshot->name(snapshot->word(first_line.first_word).lang);
       if (paragraph_lang) {
         hocr_str += " lang='";
         hocr_str += paragraph_lang;
         hocr_str += "'";
       }
-      AddBoxTohOCR(res_it, RIL_PARA, &hocr_str);
-    }
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      hocr_str += "\n     <span class='ocr_line'";
-      AddIdTohOCR(&hocr_str, "line", page_id, lcnt);
-      AddBoxTohOCR(res_it, RIL_TEXTLINE, &hocr_str);
-    }
-
-    // Now, process the word...
-    hocr_str += "<span class='ocrx_word'";
-    AddIdTohOCR(&hocr_str, "word", page_id, wcnt);
-    int left, top, right, bottom;
-    bool bold, italic, underlined, monospace, serif, smallcaps;
-    int pointsize, font_id;
-    const char *font_name;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
-    font_name = res_it->WordFontAttributes(&bold, &italic, &underlined,
-                                           &monospace, &serif, &smallcaps,
-                                           &pointsize, &font_id);
-    hocr_str.add_str_int(" title='bbox ", left);
-    hocr_str.add_str_int(" ", top);
-    hocr_str.add_str_int(" ", right);
-    hocr_str.add_str_int(" ", bottom);
-    hocr_str.add_str_int("; x_wconf ", res_it->Confidence(RIL_WORD));
-    if (font_info) {
-      if (font_name) {
-        hocr_str += "; x_font ";
-        hocr_str += HOcrEscape(font_name);
-      }
-      hocr_str.add_str_int("; x_fsize ", pointsize);
-    }
-    hocr_str += "'";
-    const char* lang = res_it->WordRecognitionLanguage();
-    if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
-      hocr_str += " lang='";
-      hocr_str += lang;
-      hocr_str += "'";
-    }
-    switch (res_it->WordDirection()) {
-      // Only emit direction if different from current paragraph direction
-      case DIR_LEFT_TO_RIGHT:
-        if (!para_is_ltr) hocr_str += " dir='ltr'";
-        break;
-      case DIR_RIGHT_TO_LEFT:
-        if (para_is_ltr) hocr_str += " dir='rtl'";
-        break;
-      case DIR_MIX:
-      case DIR_NEUTRAL:
-      default:  // Do nothing.
-        break;
-    }
-    hocr_str += ">";
-    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
-    bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
-    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    if (bold) hocr_str += "<strong>";
-    if (italic) hocr_str += "<em>";
-    do {
-      const std::unique_ptr<const char[]> grapheme(
-          res_it->GetUTF8Text(RIL_SYMBOL));
-      if (grapheme && grapheme[0] != 0) {
-        hocr_str += HOcrEscape(grapheme.get());
+      AddBoxTohOCR(para.box, block, NULL, &hocr_str);
+      for (int l = 0; l < para.num_lines; ++l) {
+        const SnapshotLine& line = snapshot->line(para.first_line + l);
+        hocr_str += "\n     <span class='ocr_line'";
+        AddIdTohOCR(&hocr_str, "line", page_id, lcnt);
+        AddBoxTohOCR(line.box, block, &line, &hocr_str);
+        for (int w = 0; w < line.num_words; ++w) {
+          const SnapshotWord& word = snapshot->word(line.first_word + w);
+          hocr_str += "<span class='ocrx_word'";
+          AddIdTohOCR(&hocr_str, "word", page_id, wcnt);
+          hocr_str.add_str_int(" title='bbox ", word.box.left);
+          hocr_str.add_str_int(" ", word.box.top);
+          hocr_str.add_str_int(" ", word.box.right);
+          hocr_str.add_str_int(" ", word.box.bottom);
+          hocr_str.add_str_int("; x_wconf ", word.confidence);
+          if (font_info) {
+            const char* font_name = snapshot->name(word.font_name);
+            if (font_name) {
+              hocr_str += "; x_font ";
+              hocr_str += HOcrEscape(font_name);
+            }
+            hocr_str.add_str_int("; x_fsize ", word.pointsize);
+          }
+          hocr_str += "'";
+          const char* lang = snapshot->name(word.lang);
+          if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
+            hocr_str += " lang='";
+            hocr_str += lang;
+            hocr_str += "'";
+          }
+          switch (word.direction) {
+            // Only emit direction if different from current paragraph
+            // direction
+            case DIR_LEFT_TO_RIGHT:
+              if (!para_is_ltr) hocr_str += " dir='ltr'";
+              break;
+            case DIR_RIGHT_TO_LEFT:
+              if (para_is_ltr) hocr_str += " dir='rtl'";
+              break;
+            case DIR_MIX:
+            case DIR_NEUTRAL:
+            default:  // Do nothing.
+              break;
+          }
+          hocr_str += ">";
+          bool bold = (word.flags & SWF_BOLD) != 0;
+          bool italic = (word.flags & SWF_ITALIC) != 0;
+          if (bold) hocr_str += "<strong>";
+          if (italic) hocr_str += "<em>";
+          hocr_str += HOcrEscape(
+              STRING(text + word.text_offset, word.text_length).string());
+          if (italic) hocr_str += "</em>";
+          if (bold) hocr_str += "</strong>";
+          hocr_str += "</span> ";
+          wcnt++;
+        }
+        // Close the textline.
+        hocr_str += "\n     </span>";
+        lcnt++;
       }
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    if (italic) hocr_str += "</em>";
-    if (bold) hocr_str += "</strong>";
-    hocr_str += "</span> ";
-    wcnt++;
-    // Close any ending block/paragraph/textline.
-    if (last_word_in_line) {
-      hocr_str += "\n     </span>";
-      lcnt++;
-    }
-    if (last_word_in_para) {
       hocr_str += "\n    </p>\n";
       pcnt++;
-      para_is_ltr = true;  // back to default direction
-    }
-    if (last_word_in_block) {
-      hocr_str += "   </div>\n";
-      bcnt++;
     }
+    hocr_str += "   </div>\n";
+    bcnt++;
   }
   hocr_str += "  </div>\n";
 
   char *ret = new char[hocr_str.length() + 1];
   strcpy(ret, hocr_str.string());
-  delete res_it;
   return ret;
 }
 
+/**
+ * Returns a flat snapshot of the results of Recognize, calling it first if
+ * needed. The returned snapshot must be deleted after use.
+ */
+PageSnapshot* TessBaseAPI::GetPageSnapshot() {
+  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
+    return NULL;
+  ResultIterator* res_it = GetIterator();
+  PageSnapshot* snapshot = new PageSnapshot;
+  snapshot->Capture(res_it);
+  delete res_it;
+  return snapshot;
+}
+
+/** Adds the row numbering and box of a TSV row, given the level. */
+static void AddTSVRowStart(int level, int page_num, int block_num,
+                           int par_num, int line_num, int word_num,
+                           const SnapshotBox& box, STRING* tsv_str) {
+  tsv_str->add_str_int("", level);
+  tsv_str->add_str_int("\t", page_num);
+  tsv_str->add_str_int("\t", block_num);
+  tsv_str->add_str_int("\t", par_num);
+  tsv_str->add_str_int("\t", line_num);
+  tsv_str->add_str_int("\t", word_num);
+  tsv_str->add_str_int("\t", box.left);
+  tsv_str->add_str_int("\t", box.top);
+  tsv_str->add_str_int("\t", box.right - box.left);
+  tsv_str->add_str_int("\t", box.bottom - box.top);
+}
+
 /**
  * Make a TSV-formatted string from the internal data structures.
  * page_number is 0-based but will appear in the output as 1-based.
  * Returned string must be freed with the delete [] operator.
  */
 char* TessBaseAPI::GetTSVText(int page_number) {
-  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
+  std::unique_ptr<PageSnapshot> snapshot(GetPageSnapshot());
+  if (snapshot == nullptr) return NULL;
 
-  int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
-  int page_id = page_number + 1;  // we use 1-based page numbers.
+  int page_num = page_number + 1;  // we use 1-based page numbers.
 
   STRING tsv_str("");
-
-  int page_num = page_id, block_num = 0, par_num = 0, line_num = 0,
-      word_num = 0;
-
-  tsv_str.add_str_int("1\t", page_num);  // level 1 - page
-  tsv_str.add_str_int("\t", block_num);
-  tsv_str.add_str_int("\t", par_num);
-  tsv_str.add_str_int("\t", line_num);
-  tsv_str.add_str_int("\t", word_num);
-  tsv_str.add_str_int("\t", rect_left_);
-  tsv_str.add_str_int("\t", rect_top_);
-  tsv_str.add_str_int("\t", rect_width_);
-  tsv_str.add_str_int("\t", rect_height_);
+  SnapshotBox page_box;
+  page_box.left = rect_left_;
+  page_box.top = rect_top_;
+  page_box.right = rect_left_ + rect_width_;
+  page_box.bottom = rect_top_ + rect_height_;
+  AddTSVRowStart(1, page_num, 0, 0, 0, 0, page_box, &tsv_str);
   tsv_str += "\t-1\t\n";
 
-  ResultIterator* res_it = GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
-
-    // Add rows for any new block/paragraph/textline.
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      block_num++, par_num = 0, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("2\t", page_num);  // level 2 - block
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_BLOCK, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for block
-    }
-    if (res_it->IsAtBeginningOf(RIL_PARA)) {
-      par_num++, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("3\t", page_num);  // level 3 - paragraph
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_PARA, &tsv_str);
+  const char* text = snapshot->text();
+  for (int b = 0; b < snapshot->num_blocks(); ++b) {
+    const SnapshotBlock& block = snapshot->block(b);
+    int block_num = b + 1;
+    AddTSVRowStart(2, page_num, block_num, 0, 0, 0, block.box, &tsv_str);
+    tsv_str += "\t-1\t\n";  // end of row for block
+    for (int p = 0; p < block.num_paras; ++p) {
+      const SnapshotPara& para = snapshot->para(block.first_para + p);
+      int par_num = p + 1;
+      AddTSVRowStart(3, page_num, block_num, par_num, 0, 0, para.box,
+                     &tsv_str);
       tsv_str += "\t-1\t\n";  // end of row for para
+      for (int l = 0; l < para.num_lines; ++l) {
+        const SnapshotLine& line = snapshot->line(para.first_line + l);
+        int line_num = l + 1;
+        AddTSVRowStart(4, page_num, block_num, par_num, line_num, 0, line.box,
+                       &tsv_str);
+        tsv_str += "\t-1\t\n";  // end of row for line
+        for (int w = 0; w < line.num_words; ++w) {
+          const SnapshotWord& word = snapshot->word(line.first_word + w);
+          AddTSVRowStart(5, page_num, block_num, par_num, line_num, w + 1,
+                         word.box, &tsv_str);
+          tsv_str.add_str_int("\t", word.confidence);
+          tsv_str += "\t";
+          tsv_str += STRING(text + word.text_offset, word.text_length);
+          tsv_str += "\n";  // end of row
+        }
+      }
     }
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      line_num++, word_num = 0;
-      tsv_str.add_str_int("4\t", page_num);  // level 4 - line
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_TEXTLINE, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for line
-    }
-
-    // Now, process the word...
-    int left, top, right, bottom;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
-    word_num++;
-    tsv_str.add_str_int("5\t", page_num);  // level 5 - word
-    tsv_str.add_str_int("\t", block_num);
-    tsv_str.add_str_int("\t", par_num);
-    tsv_str.add_str_int("\t", line_num);
-    tsv_str.add_str_int("\t", word_num);
-    tsv_str.add_str_int("\t", left);
-    tsv_str.add_str_int("\t", top);
-    tsv_str.add_str_int("\t", right - left);
-    tsv_str.add_str_int("\t", bottom - top);
-    tsv_str.add_str_int("\t", res_it->Confidence(RIL_WORD));
-    tsv_str += "\t";
-
-    // Increment counts if at end of block/paragraph/textline.
-    if (res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD)) lcnt++;
-    if (res_it->IsAtFinalElement(RIL_PARA, RIL_WORD)) pcnt++;
-    if (res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD)) bcnt++;
-
-    do {
-      tsv_str +=
-          std::unique_ptr<const char[]>(res_it->GetUTF8Text(RIL_SYMBOL)).get();
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    tsv_str += "\n";  // end of row
-    wcnt++;
   }
 
   char* ret = new char[tsv_str.length() + 1];
   strcpy(ret, tsv_str.string());
-  delete res_it;
   return ret;
 }
 
@@ -2042,6 +2033,7 @@ bool TessBaseAPI::AdaptToWordStr(PageSegMode mode, const char* wordstr) {
     if (success) {
       tesseract_->EnableLearning = true;
       tesseract_->LearnWord(NULL, word_res);
+      tesseract_->ApplyDeferredAdaption();
     }
   } else {
     success = false;
@@ -2197,6 +2189,8 @@ bool TessBaseAPI::InternalSetImage() {
   if (thresholder_ == NULL)
     thresholder_ = new ImageThresholder;
   ClearResults();
+  image_skew_ = 0.0;
+  image_skew_found_ = false;
   return true;
 }
 
@@ -2233,6 +2227,7 @@ bool TessBaseAPI::Threshold(Pix** pix) {
     tesseract_->set_pix_thresholds(NULL);
     tesseract_->set_pix_grey(NULL);
   }
+  DeskewImages(pix);
   // Set the internal resolution that is used for layout parameters from the
   // estimated resolution, rather than the image resolution, which may be
   // fabricated, but we will use the image resolution, if there is one, to
@@ -2249,6 +2244,53 @@ bool TessBaseAPI::Threshold(Pix** pix) {
   return true;
 }
 
+// Helper returns a copy of pix rotated clockwise by angle radians about its
+// centre, with a shear rotation that keeps its size and depth.
+static Pix* RotateShear(Pix* pix, double angle) {
+  return pixRotateShearCenter(pix, static_cast<l_float32>(angle),
+                              L_BRING_IN_WHITE);
+}
+
+void TessBaseAPI::DeskewImages(Pix** pix) {
+  tesseract_->set_image_reskew(FCOORD(1.0f, 0.0f));
+  if (!tesseract_->tessedit_deskew_image) return;
+  if (!image_skew_found_) {
+    image_skew_found_ = true;
+    image_skew_ = 0.0;
+    double angle, confidence;
+    if (FindPageSkew(*pix, tesseract_->tessedit_deskew_max_angle, &angle,
+                     &confidence) &&
+        fabs(angle) * 180 / M_PI >= tesseract_->tessedit_deskew_min_angle) {
+      image_skew_ = angle;
+      // The original is kept across calls to Threshold, so it is rotated
+      // only here, when the skew is found. Recognition takes words from the
+      // rotated copy, and GetInputImage still returns the input.
+      Pix* original = tesseract_->pix_original();
+      if (original != NULL && pixGetWidth(original) == pixGetWidth(*pix) &&
+          pixGetHeight(original) == pixGetHeight(*pix)) {
+        pixDestroy(&skewed_input_);
+        skewed_input_ = pixClone(original);
+        tesseract_->set_pix_original(RotateShear(original, image_skew_));
+      }
+    }
+  }
+  if (image_skew_ == 0.0) return;
+  Pix* rotated = RotateShear(*pix, image_skew_);
+  pixDestroy(pix);
+  *pix = rotated;
+  if (tesseract_->pix_grey() != NULL)
+    tesseract_->set_pix_grey(RotateShear(tesseract_->pix_grey(), image_skew_));
+  if (tesseract_->pix_thresholds() != NULL) {
+    tesseract_->set_pix_thresholds(
+        RotateShear(tesseract_->pix_thresholds(), image_skew_));
+  }
+  // Results in the deskewed images go back to the source image by the
+  // opposite rotation, which is anticlockwise in tesseract coordinates.
+  tesseract_->set_image_reskew(
+      FCOORD(static_cast<float>(cos(image_skew_)),
+             static_cast<float>(sin(image_skew_))));
+}
+
 /** Find lines from the image making the BLOCK_LIST. */
 int TessBaseAPI::FindLines() {
   if (thresholder_ == NULL || thresholder_->IsEmpty()) {
@@ -68,6 +68,7 @@ class PageIterator;
 class LTRResultIterator;
 class ResultIterator;
 class MutableIterator;
+class PageSnapshot;
 class TessResultRenderer;
 class Tesseract;
 class Trie;
@@ -258,6 +259,25 @@ class TESS_API TessBaseAPI {
    */
   void GetLoadedLanguagesAsVector(GenericVector<STRING>* langs) const;
 
+  /**
+   * Returns, in the same order as GetLoadedLanguagesAsVector, the number of
+   * times each loaded language's recognizer has been run on a word since
+   * Init or the last ResetLangRunCounts. Useful to check how often
+   * multilang_gated_routing falls back to the secondary languages.
+   */
+  void GetLangRunCounts(GenericVector<int>* counts) const;
+
+  /** Zeroes the counters returned by GetLangRunCounts. */
+  void ResetLangRunCounts();
+
+  /**
+   * Returns, in the same order as GetLoadedLanguagesAsVector, the number of
+   * bytes held by each loaded language's LSTM unicharset recoder and beam
+   * search lattice, or 0 for a language without an LSTM model. The beam
+   * memory is retained between lines, so it reflects the widest line seen.
+   */
+  void GetLSTMMemoryUsed(GenericVector<int>* bytes) const;
+
   /**
    * Returns the available languages in the vector of STRINGs.
    */
@@ -573,12 +593,28 @@ class TESS_API TessBaseAPI {
    */
   MutableIterator* GetMutableIterator();
 
+  /**
+   * Returns a flat snapshot of the results of Recognize, calling it first if
+   * needed, or NULL on error. Unlike the iterators, the snapshot holds its
+   * own copy of the results, so it remains valid after the next SetImage or
+   * Recognize, and can be serialized. The returned snapshot must be deleted
+   * after use.
+   */
+  PageSnapshot* GetPageSnapshot();
+
   /**
    * The recognized text is returned as a char* which is coded
    * as UTF8 and must be freed with the delete [] operator.
    */
   char* GetUTF8Text();
 
+  /**
+   * As GetUTF8Text, but replaces the contents of *text with the recognized
+   * text instead of allocating a new buffer, so a STRING that is reused
+   * across pages keeps its storage. Returns false on failure.
+   */
+  bool GetUTF8Text(STRING* text);
+
   /**
    * Make a HTML-formatted string with hOCR markup from the internal
    * data structures.
@@ -798,6 +834,15 @@ class TESS_API TessBaseAPI {
    */
   TESS_LOCAL virtual bool Threshold(Pix** pix);
 
+  /**
+   * If tessedit_deskew_image, rotates the thresholded image in *pix, and the
+   * grey, threshold and original images held by tesseract_, to remove the
+   * skew of the page, which is found on the first call after SetImage.
+   * Sets the rotation that PageIterator uses to map results back to the
+   * source image.
+   */
+  TESS_LOCAL void DeskewImages(Pix** pix);
+
   /**
    * Find lines from the image making the BLOCK_LIST.
    * @return 0 on success.
@@ -890,6 +935,9 @@ class TESS_API TessBaseAPI {
   int image_width_;
   int image_height_;
   /* @} */
+  double image_skew_;      ///< Skew found by DeskewImages, radians clockwise.
+  bool image_skew_found_;  ///< DeskewImages has looked for the skew.
+  Pix* skewed_input_;      ///< Input image, if tesseract_ has a deskewed copy.
 
  private:
   // A list of image filenames gets special consideration
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////
+// File:        batchapi.cpp
+// Description: Recognizes batches of images on a pool of engines.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "batchapi.h"
+
+#include <string.h>
+#include "baseapi.h"
+#include "strngs.h"
+#include "svutil.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+TessBatchAPI::TessBatchAPI()
+  : default_psm_(PSM_SINGLE_BLOCK),
+    mutex_(new SVMutex),
+    queue_head_(0),
+    outstanding_(0),
+    waiters_(0),
+    next_engine_(0),
+    shutdown_(false),
+    work_available_(new SVSemaphore),
+    all_done_(new SVSemaphore),
+    worker_exited_(new SVSemaphore) {
+}
+
+TessBatchAPI::~TessBatchAPI() {
+  Wait();
+  mutex_->Lock();
+  shutdown_ = true;
+  mutex_->Unlock();
+  // Every engine has a worker, even if it has not yet taken its engine.
+  int num_workers = engines_.size();
+  for (int i = 0; i < num_workers; ++i) work_available_->Signal();
+  for (int i = 0; i < num_workers; ++i) worker_exited_->Wait();
+  engines_.delete_data_pointers();
+  delete mutex_;
+  delete work_available_;
+  delete all_done_;
+  delete worker_exited_;
+}
+
+// Starts num_engines workers, each with its own engine. Returns false, with
+// no workers running, if any engine fails to initialize, or, changing
+// nothing, if Init has already succeeded.
+bool TessBatchAPI::Init(const char* datapath, const char* language,
+                        OcrEngineMode oem, int num_engines) {
+  if (!engines_.empty()) {
+    tprintf("Batch already initialized with %d engines\n", engines_.size());
+    return false;
+  }
+  for (int e = 0; e < num_engines; ++e) {
+    TessBaseAPI* engine = new TessBaseAPI;
+    engines_.push_back(engine);
+    if (engine->Init(datapath, language, oem) != 0) {
+      tprintf("Batch engine %d failed to initialize %s\n", e,
+              language != NULL ? language : "eng");
+      engines_.delete_data_pointers();
+      engines_.clear();
+      return false;
+    }
+  }
+  if (!engines_.empty()) default_psm_ = engines_[0]->GetPageSegMode();
+  for (int e = 0; e < engines_.size(); ++e)
+    SVSync::StartThread(WorkerFunc, this);
+  return !engines_.empty();
+}
+
+// Sets a variable on every engine. Returns false if any engine rejects it,
+// or without setting it if images are pending.
+bool TessBatchAPI::SetVariable(const char* name, const char* value) {
+  SVAutoLock lock(mutex_);
+  if (outstanding_ > 0) {
+    tprintf("Can't set %s while %d batch images are pending\n", name,
+            outstanding_);
+    return false;
+  }
+  bool ok = true;
+  for (int e = 0; e < engines_.size(); ++e)
+    ok = engines_[e]->SetVariable(name, value) && ok;
+  if (ok && strcmp(name, "tessedit_pageseg_mode") == 0 && !engines_.empty())
+    default_psm_ = engines_[0]->GetPageSegMode();
+  return ok;
+}
+
+// Queues count images for recognition, in order. Returns false, queueing
+// nothing, if there are no engines.
+bool TessBatchAPI::Submit(TessBatchImage* images, int count,
+                          TessBatchCallback callback) {
+  if (engines_.empty()) {
+    tprintf("Batch images submitted before a successful Init\n");
+    return false;
+  }
+  mutex_->Lock();
+  for (int i = 0; i < count; ++i) {
+    images[i].status = TESS_BATCH_PENDING;
+    Job job = {&images[i], callback};
+    queue_.push_back(job);
+  }
+  outstanding_ += count;
+  mutex_->Unlock();
+  for (int i = 0; i < count; ++i) work_available_->Signal();
+  return true;
+}
+
+// Returns true if the image is no longer pending. Never blocks.
+bool TessBatchAPI::IsDone(const TessBatchImage* image) {
+  SVAutoLock lock(mutex_);
+  return image->status != TESS_BATCH_PENDING;
+}
+
+// Blocks until every image submitted so far is done.
+void TessBatchAPI::Wait() {
+  mutex_->Lock();
+  ++waiters_;
+  while (outstanding_ > 0) {
+    mutex_->Unlock();
+    all_done_->Wait();
+    mutex_->Lock();
+  }
+  --waiters_;
+  // Each waiter wakes the next, as all_done_ is only signalled once.
+  if (waiters_ > 0) all_done_->Signal();
+  mutex_->Unlock();
+}
+
+// Thread entry point. arg is the TessBatchAPI.
+void* TessBatchAPI::WorkerFunc(void* arg) {
+  TessBatchAPI* batch = static_cast<TessBatchAPI*>(arg);
+  batch->mutex_->Lock();
+  TessBaseAPI* engine = batch->engines_[batch->next_engine_++];
+  batch->mutex_->Unlock();
+  batch->RunWorker(engine);
+  batch->worker_exited_->Signal();
+  return NULL;
+}
+
+// Pops and recognizes jobs with the engine until shutdown.
+void TessBatchAPI::RunWorker(TessBaseAPI* engine) {
+  // Holds the text of each image in turn, keeping its storage.
+  STRING text;
+  while (true) {
+    work_available_->Wait();
+    mutex_->Lock();
+    if (queue_head_ >= queue_.size()) {
+      bool done = shutdown_;
+      mutex_->Unlock();
+      if (done) return;
+      continue;
+    }
+    Job job = queue_[queue_head_++];
+    if (queue_head_ == queue_.size()) {
+      // Drained, so reuse the storage from the start.
+      queue_.truncate(0);
+      queue_head_ = 0;
+    }
+    PageSegMode default_psm = default_psm_;
+    mutex_->Unlock();
+
+    int status = Recognize(engine, default_psm, job.image, &text);
+
+    mutex_->Lock();
+    job.image->status = status;
+    if (--outstanding_ == 0 && waiters_ > 0) all_done_->Signal();
+    mutex_->Unlock();
+    // Outside the lock and after the image is done, so the callback may
+    // use the batch, even to Wait.
+    if (job.callback != NULL) (*job.callback)(job.image);
+  }
+}
+
+// Recognizes the image and fills in its outputs except status, which is
+// returned. text is the worker's buffer for the recognized text.
+int TessBatchAPI::Recognize(TessBaseAPI* engine, PageSegMode default_psm,
+                            TessBatchImage* image, STRING* text) {
+  image->text_length = 0;
+  image->mean_text_conf = 0;
+  if (image->text_arena != NULL && image->text_arena_size > 0)
+    image->text_arena[0] = '\0';
+  engine->SetPageSegMode(image->page_seg_mode >= 0
+                             ? static_cast<PageSegMode>(image->page_seg_mode)
+                             : default_psm);
+  engine->SetImage(image->imagedata, image->width, image->height,
+                   image->bytes_per_pixel, image->bytes_per_line);
+  if (image->source_resolution > 0)
+    engine->SetSourceResolution(image->source_resolution);
+  if (!engine->GetUTF8Text(text)) {
+    engine->Clear();
+    return TESS_BATCH_FAILED;
+  }
+  image->mean_text_conf = engine->MeanTextConf();
+  engine->Clear();
+  size_t length = text->length();
+  image->text_length = length;
+  int status = TESS_BATCH_OK;
+  if (image->text_arena == NULL || length >= image->text_arena_size) {
+    status = TESS_BATCH_TRUNCATED;
+    length = image->text_arena_size > 0 ? image->text_arena_size - 1 : 0;
+  }
+  if (image->text_arena != NULL && image->text_arena_size > 0) {
+    memcpy(image->text_arena, text->string(), length);
+    image->text_arena[length] = '\0';
+  }
+  return status;
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// File:        batchapi.h
+// Description: Recognizes batches of images on a pool of engines.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_BATCHAPI_H_
+#define TESSERACT_API_BATCHAPI_H_
+
+// To avoid collision with other typenames include the ABSOLUTE MINIMUM
+// complexity of includes here. Use forward declarations wherever possible
+// and hide includes of complex types in batchapi.cpp.
+#include "batchtypes.h"
+#include "genericvector.h"
+#include "platform.h"
+#include "publictypes.h"
+
+class STRING;
+class SVMutex;
+class SVSemaphore;
+
+namespace tesseract {
+
+class TessBaseAPI;
+
+/**
+ * Runs a fixed pool of TessBaseAPI engines, each on its own worker thread,
+ * over a queue of caller-owned TessBatchImages. All the state lives in the
+ * instance, so a process may run as many independent batches as it likes.
+ *
+ * Typical use:
+ *   TessBatchAPI batch;
+ *   batch.Init(NULL, "por", OEM_DEFAULT, 4);
+ *   batch.Submit(images, num_images, NULL);
+ *   batch.Wait();
+ */
+class TESS_API TessBatchAPI {
+ public:
+  TessBatchAPI();
+  /** Waits for all submitted images, then stops the workers. */
+  ~TessBatchAPI();
+
+  /**
+   * Starts num_engines workers, each with its own engine initialized as
+   * TessBaseAPI::Init(datapath, language, oem). Returns false, with no
+   * workers running, if any engine fails to initialize. Once it has
+   * succeeded, further calls return false and change nothing.
+   */
+  bool Init(const char* datapath, const char* language, OcrEngineMode oem,
+            int num_engines);
+
+  /**
+   * Sets a variable on every engine. Returns false if any engine rejects it,
+   * or, setting nothing, if images are pending.
+   */
+  bool SetVariable(const char* name, const char* value);
+
+  /**
+   * Queues count images for recognition, in order. Each image's status is
+   * set to TESS_BATCH_PENDING now, and to its final value when it is done,
+   * after which callback (if not NULL) is called with it from the worker
+   * thread, outside any lock. The callback may call any method, including
+   * Wait, but a Wait in a callback can only return if other engines are
+   * free to finish the remaining images. Returns false, queueing nothing,
+   * if Init has not succeeded.
+   */
+  bool Submit(TessBatchImage* images, int count, TessBatchCallback callback);
+
+  /** Returns true if the image is no longer pending. Never blocks. */
+  bool IsDone(const TessBatchImage* image);
+
+  /**
+   * Blocks until every image submitted so far is done. Callbacks of the
+   * last images may still be running; the destructor waits for them.
+   */
+  void Wait();
+
+  int num_engines() const { return engines_.size(); }
+
+ private:
+  // A queued image and the callback to run when it is done.
+  struct Job {
+    TessBatchImage* image;
+    TessBatchCallback callback;
+  };
+
+  // Thread entry point. arg is the TessBatchAPI.
+  static void* WorkerFunc(void* arg);
+  // Pops and recognizes jobs with the engine until shutdown.
+  void RunWorker(TessBaseAPI* engine);
+  // Recognizes the image and fills in its outputs except status, which is
+  // returned. text is the worker's buffer for the recognized text.
+  static int Recognize(TessBaseAPI* engine, PageSegMode default_psm,
+                       TessBatchImage* image, STRING* text);
+
+  // One engine per worker, owned.
+  GenericVector<TessBaseAPI*> engines_;
+  // Page segmentation mode of the engines when no per-image mode is given.
+  PageSegMode default_psm_;
+  // Guards everything below, and the status of the submitted images.
+  SVMutex* mutex_;
+  // Pending jobs. queue_[queue_head_] is the next to run.
+  GenericVector<Job> queue_;
+  int queue_head_;
+  // Number of submitted images that are not yet done.
+  int outstanding_;
+  // Number of threads blocked in Wait.
+  int waiters_;
+  // Index of the engine the next started worker takes.
+  int next_engine_;
+  // Set to stop the workers.
+  bool shutdown_;
+  // Signalled once per queued job, and once per worker at shutdown.
+  SVSemaphore* work_available_;
+  // Signalled when outstanding_ drops to zero while there are waiters.
+  SVSemaphore* all_done_;
+  // Signalled by each worker as it exits.
+  SVSemaphore* worker_exited_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_BATCHAPI_H_
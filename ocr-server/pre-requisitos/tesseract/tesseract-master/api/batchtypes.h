@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////
+// File:        batchtypes.h
+// Description: Plain C types shared by TessBatchAPI and the C-API.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_BATCHTYPES_H_
+#define TESSERACT_API_BATCHTYPES_H_
+
+#include <stddef.h>
+
+/* Values of TessBatchImage::status. */
+#define TESS_BATCH_PENDING   (-1)  /* Submitted, not yet recognized. */
+#define TESS_BATCH_OK          0   /* Text is complete in text_arena. */
+#define TESS_BATCH_TRUNCATED   1   /* Text did not fit in text_arena. */
+#define TESS_BATCH_FAILED      2   /* Recognition failed. */
+
+/*
+ * One image of a batch. The caller owns the struct, the image buffer and the
+ * text arena, all of which must stay valid until the image is done. The
+ * engine writes only the output fields and the arena, so no memory is
+ * allocated for the caller and nothing has to be freed afterwards.
+ */
+typedef struct TessBatchImage {
+  /* Input, set by the caller. */
+  const unsigned char* imagedata;
+  int width;
+  int height;
+  int bytes_per_pixel;    /* 0 (1 bit), 1, 3 or 4, as TessBaseAPI::SetImage. */
+  int bytes_per_line;     /* Stride, may include padding. */
+  int source_resolution;  /* In ppi, or 0 to keep the engine's estimate. */
+  int page_seg_mode;      /* A PageSegMode, or -1 for the engine default. */
+  char* text_arena;       /* Receives the NUL-terminated UTF-8 text. */
+  size_t text_arena_size;
+  void* user_data;        /* Not used by the engine. */
+  /* Output, set by the engine. */
+  size_t text_length;     /* Full text length, even if truncated. */
+  int mean_text_conf;     /* As TessBaseAPI::MeanTextConf. */
+  int status;             /* One of TESS_BATCH_*. */
+} TessBatchImage;
+
+/* Called from a worker thread as soon as an image is done. */
+typedef void (*TessBatchCallback)(TessBatchImage* image);
+
+#endif  /* TESSERACT_API_BATCHTYPES_H_ */
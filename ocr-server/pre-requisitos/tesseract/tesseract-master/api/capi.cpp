@@ -812,3 +812,40 @@ TESS_API float TESS_CALL TessChoiceIteratorConfidence(const TessChoiceIterator*
 {
     return handle->Confidence();
 }
+
+TESS_API TessBatchAPI* TESS_CALL TessBatchAPICreate()
+{
+    return new TessBatchAPI;
+}
+
+TESS_API void TESS_CALL TessBatchAPIDelete(TessBatchAPI* handle)
+{
+    delete handle;
+}
+
+TESS_API BOOL TESS_CALL TessBatchAPIInit(TessBatchAPI* handle, const char* datapath, const char* language,
+                                         TessOcrEngineMode oem, int num_engines)
+{
+    return handle->Init(datapath, language, oem, num_engines) ? TRUE : FALSE;
+}
+
+TESS_API BOOL TESS_CALL TessBatchAPISetVariable(TessBatchAPI* handle, const char* name, const char* value)
+{
+    return handle->SetVariable(name, value) ? TRUE : FALSE;
+}
+
+TESS_API BOOL TESS_CALL TessBatchAPISubmit(TessBatchAPI* handle, TessBatchImage* images, int count,
+                                           TessBatchCallback callback)
+{
+    return handle->Submit(images, count, callback) ? TRUE : FALSE;
+}
+
+TESS_API BOOL TESS_CALL TessBatchAPIIsDone(TessBatchAPI* handle, const TessBatchImage* image)
+{
+    return handle->IsDone(image) ? TRUE : FALSE;
+}
+
+TESS_API void TESS_CALL TessBatchAPIWait(TessBatchAPI* handle)
+{
+    handle->Wait();
+}
@@ -20,10 +20,12 @@
 
 #ifdef TESS_CAPI_INCLUDE_BASEAPI
 #   include "baseapi.h"
+#   include "batchapi.h"
 #   include "pageiterator.h"
 #   include "resultiterator.h"
 #   include "renderer.h"
 #else
+#   include "batchtypes.h"
 #   include "platform.h"
 #   include <stdio.h>
 #endif
@@ -54,6 +56,7 @@ typedef tesseract::TessPDFRenderer TessPDFRenderer;
 typedef tesseract::TessUnlvRenderer TessUnlvRenderer;
 typedef tesseract::TessBoxTextRenderer TessBoxTextRenderer;
 typedef tesseract::TessBaseAPI TessBaseAPI;
+typedef tesseract::TessBatchAPI TessBatchAPI;
 typedef tesseract::PageIterator TessPageIterator;
 typedef tesseract::ResultIterator TessResultIterator;
 typedef tesseract::MutableIterator TessMutableIterator;
@@ -81,6 +84,7 @@ typedef struct TessPDFRenderer TessPDFRenderer;
 typedef struct TessUnlvRenderer TessUnlvRenderer;
 typedef struct TessBoxTextRenderer TessBoxTextRenderer;
 typedef struct TessBaseAPI TessBaseAPI;
+typedef struct TessBatchAPI TessBatchAPI;
 typedef struct TessPageIterator TessPageIterator;
 typedef struct TessResultIterator TessResultIterator;
 typedef struct TessMutableIterator TessMutableIterator;
@@ -390,6 +394,19 @@ TESS_API BOOL  TESS_CALL TessChoiceIteratorNext(TessChoiceIterator* handle);
 TESS_API const char* TESS_CALL TessChoiceIteratorGetUTF8Text(const TessChoiceIterator* handle);
 TESS_API float TESS_CALL TessChoiceIteratorConfidence(const TessChoiceIterator* handle);
 
+/* Batch API */
+
+TESS_API TessBatchAPI*
+              TESS_CALL TessBatchAPICreate();
+TESS_API void TESS_CALL TessBatchAPIDelete(TessBatchAPI* handle);
+TESS_API BOOL TESS_CALL TessBatchAPIInit(TessBatchAPI* handle, const char* datapath, const char* language,
+                                         TessOcrEngineMode oem, int num_engines);
+TESS_API BOOL TESS_CALL TessBatchAPISetVariable(TessBatchAPI* handle, const char* name, const char* value);
+TESS_API BOOL TESS_CALL TessBatchAPISubmit(TessBatchAPI* handle, TessBatchImage* images, int count,
+                                           TessBatchCallback callback);
+TESS_API BOOL TESS_CALL TessBatchAPIIsDone(TessBatchAPI* handle, const TessBatchImage* image);
+TESS_API void TESS_CALL TessBatchAPIWait(TessBatchAPI* handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 #include "allheaders.h"
 #include "baseapi.h"
 #include "math.h"
+#include "pagesnapshot.h"
 #include "renderer.h"
 #include "strngs.h"
 #include "tprintf.h"
@@ -358,138 +359,121 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
   int line_x2 = 0;
   int line_y2 = 0;
 
-  ResultIterator *res_it = api->GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      pdf_str += "BT\n3 Tr";     // Begin text object, use invisible ink
-      old_fontsize = 0;          // Every block will declare its fontsize
-      new_block = true;          // Every block will declare its affine matrix
-    }
-
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      int x1, y1, x2, y2;
-      res_it->Baseline(RIL_TEXTLINE, &x1, &y1, &x2, &y2);
-      ClipBaseline(ppi, x1, y1, x2, y2, &line_x1, &line_y1, &line_x2, &line_y2);
-    }
-
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
-
-    // Writing direction changes at a per-word granularity
-    tesseract::WritingDirection writing_direction;
-    {
-      tesseract::Orientation orientation;
-      tesseract::TextlineOrder textline_order;
-      float deskew_angle;
-      res_it->Orientation(&orientation, &writing_direction,
-                          &textline_order, &deskew_angle);
-      if (writing_direction != WRITING_DIRECTION_TOP_TO_BOTTOM) {
-        switch (res_it->WordDirection()) {
-          case DIR_LEFT_TO_RIGHT:
-            writing_direction = WRITING_DIRECTION_LEFT_TO_RIGHT;
-            break;
-          case DIR_RIGHT_TO_LEFT:
-            writing_direction = WRITING_DIRECTION_RIGHT_TO_LEFT;
-            break;
-          default:
-            writing_direction = old_writing_direction;
+  std::unique_ptr<PageSnapshot> snapshot(api->GetPageSnapshot());
+  if (snapshot == nullptr) snapshot.reset(new PageSnapshot);
+  const char* text = snapshot->text();
+  // Blocks without words (eg images) are not in the snapshot, so each text
+  // object begun here has words to end it.
+  for (int blk = 0; blk < snapshot->num_blocks(); ++blk) {
+    const SnapshotBlock& block = snapshot->block(blk);
+    pdf_str += "BT\n3 Tr";     // Begin text object, use invisible ink
+    old_fontsize = 0;          // Every block will declare its fontsize
+    new_block = true;          // Every block will declare its affine matrix
+    const SnapshotPara& first_para = snapshot->para(block.first_para);
+    const SnapshotPara& last_para =
+        snapshot->para(block.first_para + block.num_paras - 1);
+    int end_line = last_para.first_line + last_para.num_lines;
+    for (int l = first_para.first_line; l < end_line; ++l) {
+      const SnapshotLine& line = snapshot->line(l);
+      ClipBaseline(ppi, line.baseline_x1, line.baseline_y1, line.baseline_x2,
+                   line.baseline_y2, &line_x1, &line_y1, &line_x2, &line_y2);
+      for (int w = 0; w < line.num_words; ++w) {
+        const SnapshotWord& word = snapshot->word(line.first_word + w);
+        // Writing direction changes at a per-word granularity
+        tesseract::WritingDirection writing_direction =
+            static_cast<tesseract::WritingDirection>(block.writing_direction);
+        if (writing_direction != WRITING_DIRECTION_TOP_TO_BOTTOM) {
+          switch (word.direction) {
+            case DIR_LEFT_TO_RIGHT:
+              writing_direction = WRITING_DIRECTION_LEFT_TO_RIGHT;
+              break;
+            case DIR_RIGHT_TO_LEFT:
+              writing_direction = WRITING_DIRECTION_RIGHT_TO_LEFT;
+              break;
+            default:
+              writing_direction = old_writing_direction;
+          }
         }
-      }
-    }
-
-    // Where is word origin and how long is it?
-    double x, y, word_length;
-    {
-      int word_x1, word_y1, word_x2, word_y2;
-      res_it->Baseline(RIL_WORD, &word_x1, &word_y1, &word_x2, &word_y2);
-      GetWordBaseline(writing_direction, ppi, height,
-                      word_x1, word_y1, word_x2, word_y2,
-                      line_x1, line_y1, line_x2, line_y2,
-                      &x, &y, &word_length);
-    }
 
-    if (writing_direction != old_writing_direction || new_block) {
-      AffineMatrix(writing_direction,
-                   line_x1, line_y1, line_x2, line_y2, &a, &b, &c, &d);
-      pdf_str.add_str_double(" ", prec(a));  // . This affine matrix
-      pdf_str.add_str_double(" ", prec(b));  // . sets the coordinate
-      pdf_str.add_str_double(" ", prec(c));  // . system for all
-      pdf_str.add_str_double(" ", prec(d));  // . text that follows.
-      pdf_str.add_str_double(" ", prec(x));  // .
-      pdf_str.add_str_double(" ", prec(y));  // .
-      pdf_str += (" Tm ");                   // Place cursor absolutely
-      new_block = false;
-    } else {
-      double dx = x - old_x;
-      double dy = y - old_y;
-      pdf_str.add_str_double(" ", prec(dx * a + dy * b));
-      pdf_str.add_str_double(" ", prec(dx * c + dy * d));
-      pdf_str += (" Td ");                   // Relative moveto
-    }
-    old_x = x;
-    old_y = y;
-    old_writing_direction = writing_direction;
-
-    // Adjust font size on a per word granularity. Pay attention to
-    // fontsize, old_fontsize, and pdf_str. We've found that for
-    // in Arabic, Tesseract will happily return a fontsize of zero,
-    // so we make up a default number to protect ourselves.
-    {
-      bool bold, italic, underlined, monospace, serif, smallcaps;
-      int font_id;
-      res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
-                                 &serif, &smallcaps, &fontsize, &font_id);
-      const int kDefaultFontsize = 8;
-      if (fontsize <= 0)
-        fontsize = kDefaultFontsize;
-      if (fontsize != old_fontsize) {
-        char textfont[20];
-        snprintf(textfont, sizeof(textfont), "/f-0-0 %d Tf ", fontsize);
-        pdf_str += textfont;
-        old_fontsize = fontsize;
-      }
-    }
+        // Where is word origin and how long is it?
+        double x, y, word_length;
+        GetWordBaseline(writing_direction, ppi, height,
+                        word.baseline_x1, word.baseline_y1,
+                        word.baseline_x2, word.baseline_y2,
+                        line_x1, line_y1, line_x2, line_y2,
+                        &x, &y, &word_length);
+
+        if (writing_direction != old_writing_direction || new_block) {
+          AffineMatrix(writing_direction,
+                       line_x1, line_y1, line_x2, line_y2, &a, &b, &c, &d);
+          pdf_str.add_str_double(" ", prec(a));  // . This affine matrix
+          pdf_str.add_str_double(" ", prec(b));  // . sets the coordinate
+          pdf_str.add_str_double(" ", prec(c));  // . system for all
+          pdf_str.add_str_double(" ", prec(d));  // . text that follows.
+          pdf_str.add_str_double(" ", prec(x));  // .
+          pdf_str.add_str_double(" ", prec(y));  // .
+          pdf_str += (" Tm ");                   // Place cursor absolutely
+          new_block = false;
+        } else {
+          double dx = x - old_x;
+          double dy = y - old_y;
+          pdf_str.add_str_double(" ", prec(dx * a + dy * b));
+          pdf_str.add_str_double(" ", prec(dx * c + dy * d));
+          pdf_str += (" Td ");                   // Relative moveto
+        }
+        old_x = x;
+        old_y = y;
+        old_writing_direction = writing_direction;
+
+        // Adjust font size on a per word granularity. Pay attention to
+        // fontsize, old_fontsize, and pdf_str. We've found that for
+        // in Arabic, Tesseract will happily return a fontsize of zero,
+        // so we make up a default number to protect ourselves.
+        {
+          fontsize = word.pointsize;
+          const int kDefaultFontsize = 8;
+          if (fontsize <= 0)
+            fontsize = kDefaultFontsize;
+          if (fontsize != old_fontsize) {
+            char textfont[20];
+            snprintf(textfont, sizeof(textfont), "/f-0-0 %d Tf ", fontsize);
+            pdf_str += textfont;
+            old_fontsize = fontsize;
+          }
+        }
 
-    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
-    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    STRING pdf_word("");
-    int pdf_word_len = 0;
-    do {
-      const std::unique_ptr<const char[]> grapheme(
-          res_it->GetUTF8Text(RIL_SYMBOL));
-      if (grapheme && grapheme[0] != '\0') {
-        std::vector<char32> unicodes = UNICHAR::UTF8ToUTF32(grapheme.get());
-        char utf16[kMaxBytesPerCodepoint];
-        for (char32 code : unicodes) {
-          if (CodepointToUtf16be(code, utf16)) {
-            pdf_word += utf16;
-            pdf_word_len++;
+        STRING pdf_word("");
+        int pdf_word_len = 0;
+        for (int sym = 0; sym < word.num_symbols; ++sym) {
+          const SnapshotSymbol& symbol =
+              snapshot->symbol(word.first_symbol + sym);
+          if (symbol.text_length == 0) continue;
+          std::vector<char32> unicodes = UNICHAR::UTF8ToUTF32(
+              STRING(text + symbol.text_offset, symbol.text_length).string());
+          char utf16[kMaxBytesPerCodepoint];
+          for (char32 code : unicodes) {
+            if (CodepointToUtf16be(code, utf16)) {
+              pdf_word += utf16;
+              pdf_word_len++;
+            }
           }
         }
+        if (word_length > 0 && pdf_word_len > 0 && fontsize > 0) {
+          double h_stretch =
+              kCharWidth * prec(100.0 * word_length / (fontsize * pdf_word_len));
+          pdf_str.add_str_double("", h_stretch);
+          pdf_str += " Tz";          // horizontal stretch
+          pdf_str += " [ <";
+          pdf_str += pdf_word;       // UTF-16BE representation
+          pdf_str += "> ] TJ";       // show the text
+        }
       }
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    if (word_length > 0 && pdf_word_len > 0 && fontsize > 0) {
-      double h_stretch =
-          kCharWidth * prec(100.0 * word_length / (fontsize * pdf_word_len));
-      pdf_str.add_str_double("", h_stretch);
-      pdf_str += " Tz";          // horizontal stretch
-      pdf_str += " [ <";
-      pdf_str += pdf_word;       // UTF-16BE representation
-      pdf_str += "> ] TJ";       // show the text
-    }
-    if (last_word_in_line) {
-      pdf_str += " \n";
-    }
-    if (last_word_in_block) {
-      pdf_str += "ET\n";         // end the text object
+      pdf_str += " \n";             // end of the line
     }
+    pdf_str += "ET\n";              // end the text object
   }
   char *ret = new char[pdf_str.length() + 1];
   strcpy(ret, pdf_str.string());
-  delete res_it;
   return ret;
 }
 
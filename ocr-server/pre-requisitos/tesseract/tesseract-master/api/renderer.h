@@ -193,6 +193,8 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   virtual bool BeginDocumentHandler();
   virtual bool AddImageHandler(TessBaseAPI* api);
   virtual bool EndDocumentHandler();
+  // Create the /Contents object for an entire page.
+  char* GetPDFTextObjects(TessBaseAPI* api, double width, double height);
 
  private:
   // We don't want to have every image in memory at once,
@@ -209,8 +211,6 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   void AppendPDFObjectDIY(size_t objectsize);
   // Bookkeeping + emit data.
   void AppendPDFObject(const char *data);
-  // Create the /Contents object for an entire page.
-  char* GetPDFTextObjects(TessBaseAPI* api, double width, double height);
   // Turn an image into a PDF object. Only transcode if we have to.
   static bool imageToPDFObj(Pix *pix, char *filename, long int objnum,
                           char **pdf_object, long int *pdf_object_size);
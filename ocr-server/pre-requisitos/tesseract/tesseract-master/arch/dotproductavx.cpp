@@ -28,6 +28,11 @@ double DotProductAVX(const double* u, const double* v, int n) {
   fprintf(stderr, "DotProductAVX can't be used on Android\n");
   abort();
 }
+void DotProduct4AVX(const double* const* u, const double* v, int n,
+                    double* results) {
+  fprintf(stderr, "DotProduct4AVX can't be used on Android\n");
+  abort();
+}
 }  // namespace tesseract
 
 #else  // !defined(__AVX__)
@@ -110,6 +115,52 @@ double DotProductAVX(const double* u, const double* v, int n) {
   return result;
 }
 
+// Computes the dot products of each of the 4 n-vectors u[0..3] with the
+// n-vector v, putting them in results[0..3]. Each result is bit-identical to
+// DotProductAVX(u[i], v, n), but v is loaded only once for all 4.
+void DotProduct4AVX(const double* const* u, const double* v, int n,
+                    double* results) {
+  int max_offset = n - 4;
+  int offset = 0;
+  // Accumulate a set of 4 sums for each u in the same order as DotProductAVX.
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  __m256d sum2 = _mm256_setzero_pd();
+  __m256d sum3 = _mm256_setzero_pd();
+  if (offset <= max_offset) {
+    __m256d floats2 = _mm256_loadu_pd(v);
+    sum0 = _mm256_mul_pd(_mm256_loadu_pd(u[0]), floats2);
+    sum1 = _mm256_mul_pd(_mm256_loadu_pd(u[1]), floats2);
+    sum2 = _mm256_mul_pd(_mm256_loadu_pd(u[2]), floats2);
+    sum3 = _mm256_mul_pd(_mm256_loadu_pd(u[3]), floats2);
+    offset = 4;
+    while (offset <= max_offset) {
+      floats2 = _mm256_loadu_pd(v + offset);
+      sum0 = _mm256_add_pd(
+          sum0, _mm256_mul_pd(_mm256_loadu_pd(u[0] + offset), floats2));
+      sum1 = _mm256_add_pd(
+          sum1, _mm256_mul_pd(_mm256_loadu_pd(u[1] + offset), floats2));
+      sum2 = _mm256_add_pd(
+          sum2, _mm256_mul_pd(_mm256_loadu_pd(u[2] + offset), floats2));
+      sum3 = _mm256_add_pd(
+          sum3, _mm256_mul_pd(_mm256_loadu_pd(u[3] + offset), floats2));
+      offset += 4;
+    }
+  }
+  // Add the 4 product sums of each u together horizontally, in the same order
+  // as the hadds of DotProductAVX.
+  double sums[4][4];
+  _mm256_storeu_pd(sums[0], sum0);
+  _mm256_storeu_pd(sums[1], sum1);
+  _mm256_storeu_pd(sums[2], sum2);
+  _mm256_storeu_pd(sums[3], sum3);
+  for (int i = 0; i < 4; ++i) {
+    double result = (sums[i][0] + sums[i][1]) + (sums[i][2] + sums[i][3]);
+    for (int k = offset; k < n; ++k) result += u[i][k] * v[k];
+    results[i] = result;
+  }
+}
+
 }  // namespace tesseract.
 
 #endif  // ANDROID_BUILD
@@ -25,6 +25,12 @@ namespace tesseract {
 // Uses Intel AVX intrinsics to access the SIMD instruction set.
 double DotProductAVX(const double* u, const double* v, int n);
 
+// Computes the dot products of each of the 4 n-vectors u[0..3] with the
+// n-vector v, putting them in results[0..3]. Each result is bit-identical to
+// DotProductAVX(u[i], v, n), but v is loaded only once for all 4.
+void DotProduct4AVX(const double* const* u, const double* v, int n,
+                    double* results);
+
 }  // namespace tesseract.
 
 #endif  // TESSERACT_ARCH_DOTPRODUCTAVX_H_
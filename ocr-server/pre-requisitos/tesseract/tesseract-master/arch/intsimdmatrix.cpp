@@ -48,10 +48,23 @@ void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w) {
   // The rounded-up sizes of the reshaped weight matrix, excluding biases.
   int rounded_num_in = Roundup(num_in, num_inputs_per_group_);
   int rounded_num_out = RoundOutputs(num_out);
-  // Add the bias and compute the required size.
-  shaped_w_.resize((rounded_num_in + 1) * rounded_num_out, 0);
-  int shaped_index = 0;
+  // Add the padded biases and compute the required size.
+  int shaped_size = 0;
   int output = 0;
+  for (int num_registers = max_output_registers_; num_registers >= 1;
+       num_registers /= 2) {
+    int num_outputs_per_register_set =
+        num_registers * num_outputs_per_register_;
+    for (; output + num_outputs_per_register_set <= rounded_num_out;
+         output += num_outputs_per_register_set) {
+      shaped_size +=
+          ShapedSetSize(rounded_num_in, num_outputs_per_register_set);
+    }
+  }
+  shaped_w_.Resize(1, shaped_size, 0);
+  int8_t* shaped_w = shaped_w_[0];
+  int shaped_index = 0;
+  output = 0;
   // Each number of registers needs a different format! Iterates over the
   // different numbers of registers (each a power of 2).
   for (int num_registers = max_output_registers_; num_registers >= 1;
@@ -72,7 +85,7 @@ void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w) {
             int8_t weight = 0;
             if (output + j < num_out && input + i < num_in)
               weight = w(output + j, input + i);
-            shaped_w_[shaped_index++] = weight;
+            shaped_w[shaped_index++] = weight;
           }
         }
       }
@@ -80,8 +93,10 @@ void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w) {
       for (int j = 0; j < num_outputs_per_register_set; ++j) {
         int8_t weight = 0;
         if (output + j < num_out) weight = w(output + j, num_in);
-        shaped_w_[shaped_index++] = weight;
+        shaped_w[shaped_index++] = weight;
       }
+      // Skip the padding, which is left at zero.
+      shaped_index = Roundup(shaped_index, num_inputs_per_register_);
       output += num_outputs_per_register_set;
     }
   }
@@ -106,7 +121,7 @@ void IntSimdMatrix::MatrixDotVector(const GENERIC_2D_ARRAY<int8_t>& w,
       v[i] = (static_cast<double>(total) / MAX_INT8 + wi[num_in]) * scales[i];
     }
   } else {
-    const int8_t* w_data = shaped_w_.data();
+    const int8_t* w_data = shaped_w_[0];
     const double* scales_data = &scales[0];
     // Each call to a partial_func_ produces group_size outputs, except the
     // last one, which can produce less.
@@ -116,7 +131,7 @@ void IntSimdMatrix::MatrixDotVector(const GENERIC_2D_ARRAY<int8_t>& w,
     int output = 0;
     for (auto fn : partial_funcs_) {
       // The amount of w_data consumed by each call to fn.
-      int w_step = (rounded_num_in + 1) * group_size;
+      int w_step = ShapedSetSize(rounded_num_in, group_size);
       // Run with this group size, until it would produce too much output, then
       // switch to a smaller size.
       for (; output + group_size <= rounded_num_out; output += group_size) {
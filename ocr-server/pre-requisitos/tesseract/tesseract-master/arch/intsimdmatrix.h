@@ -53,6 +53,9 @@ namespace tesseract {
 // results in the process, but it doesn't have to be implemented that way.
 // The weights are re-ordered by Init() to be used sequentially by the above
 // algorithm, followed by the biases, so they can be added at the end.
+// The re-ordered weights are aligned to kMatrixAlignment, and the biases of
+// each register set are padded to a whole input register, so every load of
+// weights is aligned to the input register size.
 // The base class computes the base C++ implementation.
 // NOTE that, although the subclasses execute on different SIMD hardware, no
 // virtual methods are needed, as the constructor sets up everything that
@@ -113,6 +116,13 @@ class IntSimdMatrix {
   static int Roundup(int input, int factor) {
     return (input + factor - 1) / factor * factor;
   }
+  // Returns the amount of shaped_w_ used by a register set of the given
+  // number of outputs: the weights, then the biases padded to a whole input
+  // register.
+  int ShapedSetSize(int rounded_num_in, int num_outputs) const {
+    return rounded_num_in * num_outputs +
+           Roundup(num_outputs, num_inputs_per_register_);
+  }
 
   // Number of 32 bit outputs held in each register.
   int num_outputs_per_register_;
@@ -124,8 +134,9 @@ class IntSimdMatrix {
   int num_inputs_per_group_;
   // Number of groups of inputs to be broadcast.
   int num_input_groups_;
-  // The weights matrix reorganized in whatever way suits this instance.
-  std::vector<int8_t> shaped_w_;
+  // The weights matrix reorganized in whatever way suits this instance, as a
+  // single row.
+  GENERIC_2D_ARRAY<int8_t> shaped_w_;
   // A series of functions to compute a partial result.
   std::vector<PartialFunc> partial_funcs_;
 };
@@ -49,8 +49,8 @@ constexpr int kNumInputGroups = kNumInputsPerRegister / kNumInputsPerGroup;
 inline void MultiplyGroup(const __m256i& rep_input, const __m256i& ones,
                           const int8_t*& wi, __m256i& weights, __m256i& reps,
                           __m256i& result) {
-  // Load a 4x8 block of weights.
-  weights = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wi));
+  // Load a 4x8 block of weights, which IntSimdMatrix::Init aligned.
+  weights = _mm256_load_si256(reinterpret_cast<const __m256i*>(wi));
   wi += kNumInputsPerRegister;
   // Normalize the signs on rep_input, weights, so weights is always +ve.
   reps = _mm256_sign_epi8(rep_input, weights);
@@ -212,9 +212,10 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                                    GenericVector<WordData>* words) {
   // TODO(rays) Before this loop can be parallelized (it would yield a massive
   // speed-up) all remaining member globals need to be converted to local/heap
-  // (eg set_pass1 and set_pass2) and an intermediate adaption pass needs to be
-  // added. The results will be significantly different with adaption on, and
-  // deterioration will need investigation.
+  // (eg set_pass1 and set_pass2). The intermediate adaption pass is available
+  // with classify_defer_adaption, which keeps the adapted templates read-only
+  // during the loop. The results will be significantly different with
+  // deferred adaption, and deterioration will need investigation.
   pr_it->restart_page();
   for (int w = 0; w < words->size(); ++w) {
     WordData* word = &(*words)[w];
@@ -303,6 +304,11 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
                                 const char* word_config,
                                 int dopasses) {
   PAGE_RES_IT page_res_it(page_res);
+  // The word run counts before this page, to report those of the page alone.
+  GenericVector<int> page_start_run_counts;
+  page_start_run_counts.push_back(lang_run_count_);
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    page_start_run_counts.push_back(sub_langs_[i]->lang_run_count_);
 
   if (tessedit_minimal_rej_pass1) {
     tessedit_test_adaption.set_value (TRUE);
@@ -348,8 +354,15 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     stats_.doc_good_char_quality = 0;
 
     most_recently_used_ = this;
+    route_block_ = NULL;
     // Run pass 1 word recognition.
-    if (!RecogAllWordsPassN(1, monitor, &page_res_it, &words)) return false;
+    bool pass1_ok = RecogAllWordsPassN(1, monitor, &page_res_it, &words);
+    // Adaption deferred by classify_defer_adaption takes effect between
+    // passes.
+    ApplyDeferredAdaption();
+    for (int i = 0; i < sub_langs_.size(); ++i)
+      sub_langs_[i]->ApplyDeferredAdaption();
+    if (!pass1_ok) return false;
     // Pass 1 post-processing.
     for (page_res_it.restart_page(); page_res_it.word() != NULL;
          page_res_it.forward()) {
@@ -384,6 +397,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
       PrerecAllWordsPar(words);
     }
     most_recently_used_ = this;
+    route_block_ = NULL;
     // Run pass 2 word recognition.
     if (!RecogAllWordsPassN(2, monitor, &page_res_it, &words)) return false;
   }
@@ -441,6 +455,15 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     }
   }
 
+  if (multilang_debug_level > 0 && !sub_langs_.empty()) {
+    tprintf("Words run on this page per lang: %s=%d", lang.string(),
+            lang_run_count_ - page_start_run_counts[0]);
+    for (int i = 0; i < sub_langs_.size(); ++i) {
+      tprintf(" %s=%d", sub_langs_[i]->lang.string(),
+              sub_langs_[i]->lang_run_count_ - page_start_run_counts[i + 1]);
+    }
+    tprintf("\n");
+  }
   if (monitor != NULL) {
     monitor->progress = 100;
   }
@@ -894,6 +917,7 @@ int Tesseract::RetryWithLanguage(const WordData& word_data,
             lang.string(), static_cast<int>(tessedit_ocr_engine_mode));
   }
   // Run the recognizer on the word.
+  ++lang_run_count_;
   PointerVector<WERD_RES> new_words;
   (this->*recognizer)(word_data, in_word, &new_words);
   if (new_words.empty()) {
@@ -921,6 +945,60 @@ static bool WordsAcceptable(const PointerVector<WERD_RES>& words) {
   return true;
 }
 
+// Helper returns true if any of the words failed or has no best choice.
+static bool WordsFailed(const PointerVector<WERD_RES>& words) {
+  if (words.empty()) return true;
+  for (int w = 0; w < words.size(); ++w) {
+    if (words[w]->tess_failed || words[w]->best_choice == nullptr) return true;
+  }
+  return false;
+}
+
+// Returns true if multilang_gated_routing is on and every word has a
+// certainty of at least multilang_gate_certainty and a dictionary (or
+// number) permuter, so no other language needs to be tried.
+bool Tesseract::WordsPassLangGate(const PointerVector<WERD_RES>& words) const {
+  if (!multilang_gated_routing || WordsFailed(words)) return false;
+  for (int w = 0; w < words.size(); ++w) {
+    const WERD_CHOICE* choice = words[w]->best_choice;
+    if (choice->certainty() < multilang_gate_certainty ||
+        !Dict::valid_word_permuter(choice->permuter(), true))
+      return false;
+  }
+  return true;
+}
+
+// Updates the per-block language routing after a word in block was
+// recognized by lang_tess. gated is true if the result passed the gate.
+// A block is routed to a single language once multilang_block_route_words
+// consecutive words in it passed the gate in that language, and stays routed
+// until the block ends or a word fails outright.
+void Tesseract::UpdateLangRoute(const BLOCK* block, Tesseract* lang_tess,
+                                bool gated) {
+  if (block != route_block_) {
+    route_block_ = block;
+    route_tess_ = NULL;
+    route_streak_ = 0;
+  }
+  if (gated && lang_tess == route_tess_) {
+    ++route_streak_;
+  } else if (gated) {
+    route_tess_ = lang_tess;
+    route_streak_ = 1;
+  } else if (route_streak_ < multilang_block_route_words) {
+    route_tess_ = NULL;
+    route_streak_ = 0;
+  }
+}
+
+// Returns true if UpdateLangRoute has routed block to lang_tess alone.
+bool Tesseract::IsBlockRouted(const BLOCK* block,
+                              const Tesseract* lang_tess) const {
+  return multilang_gated_routing && multilang_block_route_words > 0 &&
+         route_block_ == block && route_tess_ == lang_tess &&
+         route_streak_ >= multilang_block_route_words;
+}
+
 // Moves good-looking "noise"/diacritics from the reject list to the main
 // blob list on the current word. Returns true if anything was done, and
 // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -1282,6 +1360,10 @@ float Tesseract::ClassifyBlobAsWord(int pass_n, PAGE_RES_IT* pr_it,
 // Recognizes in the current language, and if successful that is all.
 // If recognition was not successful, tries all available languages until
 // it gets a successful result or runs out of languages. Keeps the best result.
+// With multilang_gated_routing, the other languages are also skipped if the
+// current language's result passes WordsPassLangGate, or if the block has
+// been routed to the current language by UpdateLangRoute and the word did not
+// fail outright.
 void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
                                            WordData* word_data) {
   WordRecognizer recognizer = pass_n == 1 ? &Tesseract::classify_word_pass1
@@ -1310,10 +1392,22 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
     for (sub = 0; sub < sub_langs_.size() &&
          most_recently_used_ != sub_langs_[sub]; ++sub) {}
   }
+  // True if the block is routed to most_recently_used_ alone.
+  bool block_routed = IsBlockRouted(word_data->block, most_recently_used_);
   most_recently_used_->RetryWithLanguage(
       *word_data, recognizer, debug, &word_data->lang_words[sub], &best_words);
   Tesseract* best_lang_tess = most_recently_used_;
-  if (!WordsAcceptable(best_words)) {
+  bool gated = WordsPassLangGate(best_words);
+  if (block_routed && WordsFailed(best_words)) {
+    // The routed language failed this word, so open the block up again.
+    block_routed = false;
+    route_streak_ = 0;
+  }
+  if (debug && (gated || block_routed)) {
+    tprintf("Lang %s kept by %s\n", most_recently_used_->lang.string(),
+            block_routed ? "block route" : "certainty gate");
+  }
+  if (!WordsAcceptable(best_words) && !gated && !block_routed) {
     // Try all the other languages to see if they are any better.
     if (most_recently_used_ != this &&
         this->RetryWithLanguage(*word_data, recognizer, debug,
@@ -1332,6 +1426,10 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
     }
   }
   most_recently_used_ = best_lang_tess;
+  if (multilang_gated_routing && !sub_langs_.empty()) {
+    UpdateLangRoute(word_data->block, best_lang_tess,
+                    gated || WordsPassLangGate(best_words));
+  }
   if (!best_words.empty()) {
     if (best_words.size() == 1 && !best_words[0]->combination) {
       // Move the best single result to the main word.
@@ -332,6 +332,15 @@ bool PageIterator::BoundingBox(PageIteratorLevel level, const int padding,
                                int* right, int* bottom) const {
   if (!BoundingBoxInternal(level, left, top, right, bottom))
     return false;
+  if (tesseract_->image_reskew().y() != 0.0f) {
+    const int pix_height = pixGetHeight(tesseract_->pix_binary());
+    TBOX box(*left, pix_height - *bottom, *right, pix_height - *top);
+    UndoImageDeskew(&box);
+    *left = box.left();
+    *top = pix_height - box.top();
+    *right = box.right();
+    *bottom = pix_height - box.bottom();
+  }
   // Convert to the coordinate system of the original image.
   *left = ClipToRange(*left / scale_ + rect_left_ - padding,
                       rect_left_, rect_left_ + rect_width_);
@@ -373,10 +382,11 @@ Pta* PageIterator::BlockPolygon() const {
   Pta* pta = ptaCreate(it.length());
   int num_pts = 0;
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward(), ++num_pts) {
-    ICOORD* pt = it.data();
+    ICOORD pt = *it.data();
+    UndoImageDeskew(&pt);
     // Convert to top-down coords within the input image.
-    float x = static_cast<float>(pt->x()) / scale_ + rect_left_;
-    float y = rect_top_ + rect_height_ - static_cast<float>(pt->y()) / scale_;
+    float x = static_cast<float>(pt.x()) / scale_ + rect_left_;
+    float y = rect_top_ + rect_height_ - static_cast<float>(pt.y()) / scale_;
     ptaAddPt(pta, x, y);
   }
   return pta;
@@ -499,6 +509,8 @@ bool PageIterator::Baseline(PageIteratorLevel level,
   // Rotate to image coordinates and convert to global image coords.
   startpt.rotate(it_->block()->block->re_rotation());
   endpt.rotate(it_->block()->block->re_rotation());
+  UndoImageDeskew(&startpt);
+  UndoImageDeskew(&endpt);
   *x1 = startpt.x() / scale_ + rect_left_;
   *y1 = (rect_height_ - startpt.y()) / scale_ + rect_top_;
   *x2 = endpt.x() / scale_ + rect_left_;
@@ -622,4 +634,27 @@ bool PageIterator::SetWordBlamerBundle(BlamerBundle *blamer_bundle) {
   }
 }
 
+void PageIterator::UndoImageDeskew(ICOORD* pt) const {
+  const FCOORD& rotation = tesseract_->image_reskew();
+  if (rotation.y() == 0.0f) return;
+  // The images were rotated about the centre of the binary image.
+  const int pix_height = pixGetHeight(tesseract_->pix_binary());
+  ICOORD centre(pixGetWidth(tesseract_->pix_binary()) / 2,
+                pix_height - pix_height / 2);
+  *pt -= centre;
+  pt->rotate(rotation);
+  *pt += centre;
+}
+
+void PageIterator::UndoImageDeskew(TBOX* box) const {
+  const FCOORD& rotation = tesseract_->image_reskew();
+  if (rotation.y() == 0.0f) return;
+  const int pix_height = pixGetHeight(tesseract_->pix_binary());
+  ICOORD centre(pixGetWidth(tesseract_->pix_binary()) / 2,
+                pix_height - pix_height / 2);
+  box->move(-centre);
+  box->rotate_large(rotation);
+  box->move(centre);
+}
+
 }  // namespace tesseract.
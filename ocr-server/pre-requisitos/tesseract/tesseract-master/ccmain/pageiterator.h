@@ -26,8 +26,10 @@
 
 struct BlamerBundle;
 class C_BLOB_IT;
+class ICOORD;
 class PAGE_RES;
 class PAGE_RES_IT;
+class TBOX;
 class WERD;
 struct Pix;
 struct Pta;
@@ -323,6 +325,14 @@ class TESS_API PageIterator {
    */
   TESS_LOCAL void BeginWord(int offset);
 
+  /**
+   * Maps a point or box in tesseract coordinates of the binary image back to
+   * the source image, undoing any deskew of the images by the API. A box is
+   * replaced by the bounding box of its rotated corners.
+   */
+  TESS_LOCAL void UndoImageDeskew(ICOORD* pt) const;
+  TESS_LOCAL void UndoImageDeskew(TBOX* box) const;
+
   /** Pointer to the page_res owned by the API. */
   PAGE_RES* page_res_;
   /** Pointer to the Tesseract object owned by the API. */
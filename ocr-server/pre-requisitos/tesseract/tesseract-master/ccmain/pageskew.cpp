@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageskew.cpp
+// Description: Fast estimation of the skew of a page image from the
+//              projection profile of a reduced binary image.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pageskew.h"
+
+#include <math.h>
+#include <string.h>
+#include "allheaders.h"
+#include "genericvector.h"
+#include "helpers.h"
+
+namespace tesseract {
+
+// Width in pixels of the strips of the 4x reduced image. Each strip is
+// shifted as a whole, and a byte of the image is one strip.
+const int kSkewStripWidth = 8;
+// Step in degrees of the initial sweep over all the angles.
+const double kSkewSweepStep = 0.25;
+// The search around the best angle of the sweep stops when its step in
+// degrees is below this.
+const double kSkewMinSearchStep = 0.01;
+// Minimum ratio of the best to the worst score of the sweep to believe the
+// best angle.
+const double kMinSkewConfidence = 3.0;
+// Minimum number of black pixels in the reduced image to try at all.
+const int kMinSkewPixels = 1000;
+
+// Returns the sum of squared differences between adjacent rows of the
+// projection profile of the strips, shifted down by x * tan_angle for strip
+// center x relative to the middle of the image, so that text lines that rise
+// by tan_angle to the right are projected onto single rows. counts holds the
+// height row counts of each of num_strips strips in turn. profile is
+// scratch space of height + 2 * max_shift + 1 elements.
+static double ProjectionScore(const GenericVector<int>& counts,
+                              int num_strips, int height, double tan_angle,
+                              int max_shift, GenericVector<int>* profile) {
+  int* proj = &(*profile)[0];
+  memset(proj, 0, profile->size() * sizeof(*proj));
+  double centre = num_strips * kSkewStripWidth / 2.0;
+  for (int s = 0; s < num_strips; ++s) {
+    double x = (s + 0.5) * kSkewStripWidth - centre;
+    int* dest = proj + max_shift + IntCastRounded(x * tan_angle);
+    const int* src = &counts[s * height];
+    for (int y = 0; y < height; ++y) dest[y] += src[y];
+  }
+  double score = 0.0;
+  for (int i = 1; i < profile->size(); ++i) {
+    double diff = proj[i] - proj[i - 1];
+    score += diff * diff;
+  }
+  return score;
+}
+
+// Returns the ProjectionScore for the given angle in degrees.
+static double AngleScore(const GenericVector<int>& counts, int num_strips,
+                         int height, double degrees, int max_shift,
+                         GenericVector<int>* profile) {
+  return ProjectionScore(counts, num_strips, height, tan(degrees * M_PI / 180),
+                         max_shift, profile);
+}
+
+bool FindPageSkew(Pix* pix, double max_angle, double* angle,
+                  double* confidence) {
+  *angle = 0.0;
+  *confidence = 0.0;
+  if (pix == NULL || pixGetDepth(pix) != 1 || max_angle <= 0.0) return false;
+  // Reduce 4x, keeping any black pixel, so text lines become solid bands.
+  Pix* reduced = pixReduceRankBinaryCascade(pix, 1, 1, 0, 0);
+  if (reduced == NULL) return false;
+  pixSetPadBits(reduced, 0);
+  int width = pixGetWidth(reduced);
+  int height = pixGetHeight(reduced);
+  int wpl = pixGetWpl(reduced);
+  l_uint32* data = pixGetData(reduced);
+  int num_strips = (width + kSkewStripWidth - 1) / kSkewStripWidth;
+  // Row counts of each strip, stored strip by strip so each strip is added
+  // to the profile with a single contiguous loop.
+  GenericVector<int> counts;
+  counts.init_to_size(num_strips * height, 0);
+  l_int32* sum_tab = makePixelSumTab8();
+  int total = 0;
+  for (int y = 0; y < height; ++y) {
+    l_uint32* line = data + y * wpl;
+    for (int s = 0; s < num_strips; ++s) {
+      int count = sum_tab[GET_DATA_BYTE(line, s)];
+      counts[s * height + y] = count;
+      total += count;
+    }
+  }
+  lept_free(sum_tab);
+  pixDestroy(&reduced);
+  if (total < kMinSkewPixels) return false;
+
+  int max_shift =
+      static_cast<int>(ceil(num_strips * kSkewStripWidth / 2.0 *
+                            tan(max_angle * M_PI / 180))) + 1;
+  GenericVector<int> profile;
+  profile.init_to_size(height + 2 * max_shift + 1, 0);
+  // Sweep all the angles for the best and worst scores.
+  int num_steps = static_cast<int>(max_angle / kSkewSweepStep);
+  double best_angle = 0.0;
+  double best_score = -1.0;
+  double worst_score = 0.0;
+  for (int i = -num_steps; i <= num_steps; ++i) {
+    double degrees = i * kSkewSweepStep;
+    double score = AngleScore(counts, num_strips, height, degrees, max_shift,
+                              &profile);
+    if (score > best_score) {
+      best_score = score;
+      best_angle = degrees;
+    }
+    if (i == -num_steps || score < worst_score) worst_score = score;
+  }
+  if (worst_score <= 0.0) return false;
+  // Refine around the best angle with halving steps.
+  for (double step = kSkewSweepStep / 2; step >= kSkewMinSearchStep;
+       step /= 2) {
+    double centre = best_angle;
+    for (int dir = -1; dir <= 1; dir += 2) {
+      double degrees = centre + dir * step;
+      if (fabs(degrees) > max_angle) continue;
+      double score = AngleScore(counts, num_strips, height, degrees,
+                                max_shift, &profile);
+      if (score > best_score) {
+        best_score = score;
+        best_angle = degrees;
+      }
+    }
+  }
+  // Lines that rise to the right need a clockwise rotation.
+  *angle = best_angle * M_PI / 180;
+  *confidence = best_score / worst_score;
+  return *confidence >= kMinSkewConfidence;
+}
+
+}  // namespace tesseract.
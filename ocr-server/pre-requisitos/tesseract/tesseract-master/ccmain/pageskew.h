@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageskew.h
+// Description: Fast estimation of the skew of a page image from the
+//              projection profile of a reduced binary image.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCMAIN_PAGESKEW_H_
+#define TESSERACT_CCMAIN_PAGESKEW_H_
+
+struct Pix;
+
+namespace tesseract {
+
+// Finds the skew of the text lines in the given binary image (1 = black),
+// searching angles within +/-max_angle degrees.
+// The image is reduced 4x and cut into narrow vertical strips. The row
+// pixel counts of each strip are computed once, and the projection profile
+// at each angle is made by adding them with the row offset of the strip at
+// that angle, instead of shearing the image. The angle that maximizes the
+// sum of squared differences between adjacent rows of the profile is found
+// by a coarse sweep followed by a search with halving steps.
+// On success, returns true and sets *angle to the rotation in radians,
+// clockwise positive as for pixRotateShear, that makes the text lines
+// horizontal. *confidence is set to the ratio of the best to the worst
+// score in the sweep, and false is returned if it is too low, as on pages
+// with little or no text.
+bool FindPageSkew(Pix* pix, double max_angle, double* angle,
+                  double* confidence);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCMAIN_PAGESKEW_H_
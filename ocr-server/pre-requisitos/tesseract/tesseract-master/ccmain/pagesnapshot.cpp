@@ -0,0 +1,433 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagesnapshot.cpp
+// Description: Flat, contiguous copy of the recognition results of a page,
+//              captured once from a ResultIterator.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagesnapshot.h"
+
+#include <stdint.h>
+#include <string.h>
+#include "resultiterator.h"
+#include "serialis.h"
+
+namespace tesseract {
+
+// Identifies a serialized PageSnapshot.
+const char kSnapshotMagic[4] = {'T', 'P', 'S', 'N'};
+// Written in native order, so a reader of the other byte order sees it
+// reversed.
+const inT32 kSnapshotByteOrder = 0x01020304;
+// Version of the serialized layout.
+const inT32 kSnapshotVersion = 2;
+
+// Helper fills *box with the bounding box of the given level at it.
+static void GetSnapshotBox(const ResultIterator* it, PageIteratorLevel level,
+                           SnapshotBox* box) {
+  int left = 0, top = 0, right = 0, bottom = 0;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  box->left = left;
+  box->top = top;
+  box->right = right;
+  box->bottom = bottom;
+}
+
+// Helper appends the UTF-8 text of the symbol at it to *text, returning the
+// number of bytes appended.
+static int AppendSymbolText(const ResultIterator* it,
+                            GenericVector<char>* text) {
+  char* utf8 = it->GetUTF8Text(RIL_SYMBOL);
+  if (utf8 == NULL) return 0;
+  int length = strlen(utf8);
+  for (int i = 0; i < length; ++i) text->push_back(utf8[i]);
+  delete[] utf8;
+  return length;
+}
+
+// Helper returns the offset of name in *names, appending it with its
+// terminating null if it is not there already, or -1 if name is NULL.
+static int AddSnapshotName(const char* name, GenericVector<char>* names) {
+  if (name == NULL) return -1;
+  int length = strlen(name);
+  for (int offset = 0; offset < names->size();
+       offset += strlen(&(*names)[offset]) + 1) {
+    if (strcmp(&(*names)[offset], name) == 0) return offset;
+  }
+  int offset = names->size();
+  for (int i = 0; i <= length; ++i) names->push_back(name[i]);
+  return offset;
+}
+
+PageSnapshot::PageSnapshot() : data_(NULL), size_(0) { Clear(); }
+
+PageSnapshot::PageSnapshot(const PageSnapshot& src) : data_(NULL), size_(0) {
+  *this = src;
+}
+
+PageSnapshot::~PageSnapshot() {}
+
+// Copies always own their buffer, even if src borrows its buffer.
+PageSnapshot& PageSnapshot::operator=(const PageSnapshot& src) {
+  if (this == &src) return *this;
+  owned_.init_to_size(src.size_ / sizeof(inT32), 0);
+  memcpy(&owned_[0], src.data_, src.size_);
+  data_ = reinterpret_cast<const char*>(&owned_[0]);
+  size_ = src.size_;
+  return *this;
+}
+
+// Replaces the content with the results from it, starting from its current
+// position, which is normally the beginning of the page. Leaves it at the
+// end of the page.
+void PageSnapshot::Capture(ResultIterator* it) {
+  GenericVector<SnapshotBlock> blocks;
+  GenericVector<SnapshotPara> paras;
+  GenericVector<SnapshotLine> lines;
+  GenericVector<SnapshotWord> words;
+  GenericVector<SnapshotSymbol> symbols;
+  GenericVector<char> text;
+  GenericVector<char> names;
+  while (!it->Empty(RIL_BLOCK)) {
+    if (it->Empty(RIL_WORD)) {
+      it->Next(RIL_WORD);
+      continue;
+    }
+    bool new_block = false, new_para = false;
+    if (it->IsAtBeginningOf(RIL_BLOCK)) {
+      SnapshotBlock block;
+      GetSnapshotBox(it, RIL_BLOCK, &block.box);
+      block.block_type = it->BlockType();
+      Orientation orientation;
+      WritingDirection writing_direction;
+      TextlineOrder textline_order;
+      float deskew_angle;
+      it->Orientation(&orientation, &writing_direction, &textline_order,
+                      &deskew_angle);
+      block.orientation = orientation;
+      block.writing_direction = writing_direction;
+      block.first_para = paras.size();
+      block.num_paras = 0;
+      block.text_offset = 0;
+      block.text_length = 0;
+      blocks.push_back(block);
+      new_block = true;
+    }
+    if (it->IsAtBeginningOf(RIL_PARA)) {
+      SnapshotPara para;
+      GetSnapshotBox(it, RIL_PARA, &para.box);
+      para.is_ltr = it->ParagraphIsLtr();
+      para.first_line = lines.size();
+      para.num_lines = 0;
+      para.text_offset = 0;
+      para.text_length = 0;
+      paras.push_back(para);
+      if (!blocks.empty()) ++blocks.back().num_paras;
+      new_para = true;
+    }
+    if (it->IsAtBeginningOf(RIL_TEXTLINE)) {
+      SnapshotLine line;
+      GetSnapshotBox(it, RIL_TEXTLINE, &line.box);
+      int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+      it->Baseline(RIL_TEXTLINE, &x1, &y1, &x2, &y2);
+      line.baseline_x1 = x1;
+      line.baseline_y1 = y1;
+      line.baseline_x2 = x2;
+      line.baseline_y2 = y2;
+      it->RowAttributes(&line.row_height, &line.descenders, &line.ascenders);
+      line.first_word = words.size();
+      line.num_words = 0;
+      if (!lines.empty()) text.push_back('\n');
+      line.text_offset = text.size();
+      line.text_length = 0;
+      lines.push_back(line);
+      if (!paras.empty()) ++paras.back().num_lines;
+    } else if (!words.empty()) {
+      text.push_back(' ');
+    }
+    // Elements start at the text of their first word.
+    if (new_block) blocks.back().text_offset = text.size();
+    if (new_para) paras.back().text_offset = text.size();
+
+    SnapshotWord word;
+    GetSnapshotBox(it, RIL_WORD, &word.box);
+    word.confidence = it->Confidence(RIL_WORD);
+    bool is_bold = false, is_italic = false, is_underlined = false;
+    bool is_monospace = false, is_serif = false, is_smallcaps = false;
+    int pointsize = 0, font_id = -1;
+    const char* font_name = it->WordFontAttributes(
+        &is_bold, &is_italic, &is_underlined, &is_monospace, &is_serif,
+        &is_smallcaps, &pointsize, &font_id);
+    word.flags = (is_bold ? SWF_BOLD : 0) | (is_italic ? SWF_ITALIC : 0) |
+                 (is_underlined ? SWF_UNDERLINED : 0) |
+                 (is_monospace ? SWF_MONOSPACE : 0) |
+                 (is_serif ? SWF_SERIF : 0) |
+                 (is_smallcaps ? SWF_SMALLCAPS : 0) |
+                 (it->WordIsFromDictionary() ? SWF_FROM_DICTIONARY : 0) |
+                 (it->WordIsNumeric() ? SWF_NUMERIC : 0);
+    word.pointsize = pointsize;
+    word.font_id = font_id;
+    word.direction = it->WordDirection();
+    int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+    it->Baseline(RIL_WORD, &x1, &y1, &x2, &y2);
+    word.baseline_x1 = x1;
+    word.baseline_y1 = y1;
+    word.baseline_x2 = x2;
+    word.baseline_y2 = y2;
+    word.lang = AddSnapshotName(it->WordRecognitionLanguage(), &names);
+    word.font_name = AddSnapshotName(font_name, &names);
+    word.first_symbol = symbols.size();
+    word.num_symbols = 0;
+    word.text_offset = text.size();
+    do {
+      SnapshotSymbol symbol;
+      GetSnapshotBox(it, RIL_SYMBOL, &symbol.box);
+      symbol.confidence = it->Confidence(RIL_SYMBOL);
+      symbol.flags = (it->SymbolIsSuperscript() ? SSF_SUPERSCRIPT : 0) |
+                     (it->SymbolIsSubscript() ? SSF_SUBSCRIPT : 0) |
+                     (it->SymbolIsDropcap() ? SSF_DROPCAP : 0);
+      symbol.text_offset = text.size();
+      symbol.text_length = AppendSymbolText(it, &text);
+      symbols.push_back(symbol);
+      ++word.num_symbols;
+      it->Next(RIL_SYMBOL);
+    } while (!it->Empty(RIL_BLOCK) && !it->IsAtBeginningOf(RIL_WORD));
+    word.text_length = text.size() - word.text_offset;
+    words.push_back(word);
+    // Extend the enclosing elements to the end of this word.
+    if (!lines.empty()) {
+      ++lines.back().num_words;
+      lines.back().text_length = text.size() - lines.back().text_offset;
+    }
+    if (!paras.empty())
+      paras.back().text_length = text.size() - paras.back().text_offset;
+    if (!blocks.empty())
+      blocks.back().text_length = text.size() - blocks.back().text_offset;
+  }
+  Pack(blocks, paras, lines, words, symbols, text, names);
+}
+
+// Writes to the given file. Returns false in case of error.
+bool PageSnapshot::Serialize(TFile* fp) const {
+  return fp->FWrite(data_, 1, size_) == size_;
+}
+
+// Reads from the given file into an owned buffer. Returns false in case of
+// error, leaving *this empty.
+bool PageSnapshot::DeSerialize(TFile* fp) {
+  Header header;
+  if (fp->FRead(&header, sizeof(header), 1) != 1 ||
+      header.byte_order != kSnapshotByteOrder ||
+      header.size < static_cast<int>(sizeof(header)) ||
+      header.size - static_cast<int>(sizeof(header)) > fp->remaining()) {
+    Clear();
+    return false;
+  }
+  owned_.init_to_size((header.size + sizeof(inT32) - 1) / sizeof(inT32), 0);
+  char* buffer = reinterpret_cast<char*>(&owned_[0]);
+  memcpy(buffer, &header, sizeof(header));
+  int remaining = header.size - sizeof(header);
+  if (fp->FRead(buffer + sizeof(header), 1, remaining) != remaining ||
+      !IsValid(buffer, header.size)) {
+    Clear();
+    return false;
+  }
+  data_ = buffer;
+  size_ = header.size;
+  return true;
+}
+
+// Uses the given serialized buffer in place, without copying. Returns false
+// if the buffer is not a valid snapshot, leaving *this empty.
+bool PageSnapshot::SetFromBuffer(const char* data, int size) {
+  if (!IsValid(data, size)) {
+    Clear();
+    return false;
+  }
+  owned_.clear();
+  data_ = data;
+  size_ = reinterpret_cast<const Header*>(data)->size;
+  return true;
+}
+
+// Packs the given arrays, text and names into owned_, and points data_ at
+// it.
+void PageSnapshot::Pack(const GenericVector<SnapshotBlock>& blocks,
+                        const GenericVector<SnapshotPara>& paras,
+                        const GenericVector<SnapshotLine>& lines,
+                        const GenericVector<SnapshotWord>& words,
+                        const GenericVector<SnapshotSymbol>& symbols,
+                        const GenericVector<char>& text,
+                        const GenericVector<char>& names) {
+  Header header;
+  memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.byte_order = kSnapshotByteOrder;
+  header.version = kSnapshotVersion;
+  header.num_blocks = blocks.size();
+  header.num_paras = paras.size();
+  header.num_lines = lines.size();
+  header.num_words = words.size();
+  header.num_symbols = symbols.size();
+  header.blocks_offset = sizeof(header);
+  header.paras_offset =
+      header.blocks_offset + blocks.size() * sizeof(SnapshotBlock);
+  header.lines_offset =
+      header.paras_offset + paras.size() * sizeof(SnapshotPara);
+  header.words_offset =
+      header.lines_offset + lines.size() * sizeof(SnapshotLine);
+  header.symbols_offset =
+      header.words_offset + words.size() * sizeof(SnapshotWord);
+  header.text_offset =
+      header.symbols_offset + symbols.size() * sizeof(SnapshotSymbol);
+  header.text_length = text.size();
+  // The names follow the terminating null of the text.
+  header.names_offset = header.text_offset + text.size() + 1;
+  header.names_length = names.size();
+  // Rounded up to a whole inT32.
+  int num_ints = (header.names_offset + names.size() + sizeof(inT32) - 1) /
+                 sizeof(inT32);
+  header.size = num_ints * sizeof(inT32);
+  owned_.init_to_size(num_ints, 0);
+  char* buffer = reinterpret_cast<char*>(&owned_[0]);
+  memcpy(buffer, &header, sizeof(header));
+  if (!blocks.empty()) {
+    memcpy(buffer + header.blocks_offset, &blocks[0],
+           blocks.size() * sizeof(SnapshotBlock));
+  }
+  if (!paras.empty()) {
+    memcpy(buffer + header.paras_offset, &paras[0],
+           paras.size() * sizeof(SnapshotPara));
+  }
+  if (!lines.empty()) {
+    memcpy(buffer + header.lines_offset, &lines[0],
+           lines.size() * sizeof(SnapshotLine));
+  }
+  if (!words.empty()) {
+    memcpy(buffer + header.words_offset, &words[0],
+           words.size() * sizeof(SnapshotWord));
+  }
+  if (!symbols.empty()) {
+    memcpy(buffer + header.symbols_offset, &symbols[0],
+           symbols.size() * sizeof(SnapshotSymbol));
+  }
+  if (!text.empty())
+    memcpy(buffer + header.text_offset, &text[0], text.size());
+  if (!names.empty())
+    memcpy(buffer + header.names_offset, &names[0], names.size());
+  data_ = buffer;
+  size_ = header.size;
+}
+
+// Helper returns true if [first, first + count) is within [0, limit).
+static bool RangeIsValid(inT32 first, inT32 count, inT32 limit) {
+  return first >= 0 && count >= 0 &&
+         static_cast<inT64>(first) + count <= limit;
+}
+
+// Helper returns true if the array of count elements of element_size at
+// offset is 4-byte aligned and within a buffer of the given size.
+static bool ArrayIsValid(inT32 offset, inT32 count, int element_size,
+                         int size) {
+  return offset >= 0 && count >= 0 && offset % sizeof(inT32) == 0 &&
+         offset + static_cast<inT64>(count) * element_size <= size;
+}
+
+// Helper returns true if offset is -1 or within names of the given length.
+// As the names end with a null, any such offset is a valid C string.
+static bool NameIsValid(inT32 offset, inT32 names_length) {
+  return offset == -1 || (offset >= 0 && offset < names_length);
+}
+
+// Returns true if the header and all the ranges in the buffer are
+// consistent, so no accessor can read outside the buffer.
+/* static */
+bool PageSnapshot::IsValid(const char* data, int size) {
+  if (data == NULL || reinterpret_cast<uintptr_t>(data) % sizeof(inT32) != 0 ||
+      size < static_cast<int>(sizeof(Header)))
+    return false;
+  const Header& h = *reinterpret_cast<const Header*>(data);
+  if (memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0 ||
+      h.byte_order != kSnapshotByteOrder || h.version != kSnapshotVersion ||
+      h.size < static_cast<int>(sizeof(Header)) || h.size > size)
+    return false;
+  if (!ArrayIsValid(h.blocks_offset, h.num_blocks, sizeof(SnapshotBlock),
+                    h.size) ||
+      !ArrayIsValid(h.paras_offset, h.num_paras, sizeof(SnapshotPara),
+                    h.size) ||
+      !ArrayIsValid(h.lines_offset, h.num_lines, sizeof(SnapshotLine),
+                    h.size) ||
+      !ArrayIsValid(h.words_offset, h.num_words, sizeof(SnapshotWord),
+                    h.size) ||
+      !ArrayIsValid(h.symbols_offset, h.num_symbols, sizeof(SnapshotSymbol),
+                    h.size) ||
+      !RangeIsValid(h.text_offset, h.text_length, h.size - 1) ||
+      data[h.text_offset + h.text_length] != '\0' ||
+      !RangeIsValid(h.names_offset, h.names_length, h.size) ||
+      (h.names_length > 0 &&
+       data[h.names_offset + h.names_length - 1] != '\0'))
+    return false;
+  const SnapshotBlock* blocks =
+      reinterpret_cast<const SnapshotBlock*>(data + h.blocks_offset);
+  for (int i = 0; i < h.num_blocks; ++i) {
+    if (!RangeIsValid(blocks[i].first_para, blocks[i].num_paras,
+                      h.num_paras) ||
+        !RangeIsValid(blocks[i].text_offset, blocks[i].text_length,
+                      h.text_length))
+      return false;
+  }
+  const SnapshotPara* paras =
+      reinterpret_cast<const SnapshotPara*>(data + h.paras_offset);
+  for (int i = 0; i < h.num_paras; ++i) {
+    if (!RangeIsValid(paras[i].first_line, paras[i].num_lines, h.num_lines) ||
+        !RangeIsValid(paras[i].text_offset, paras[i].text_length,
+                      h.text_length))
+      return false;
+  }
+  const SnapshotLine* lines =
+      reinterpret_cast<const SnapshotLine*>(data + h.lines_offset);
+  for (int i = 0; i < h.num_lines; ++i) {
+    if (!RangeIsValid(lines[i].first_word, lines[i].num_words, h.num_words) ||
+        !RangeIsValid(lines[i].text_offset, lines[i].text_length,
+                      h.text_length))
+      return false;
+  }
+  const SnapshotWord* words =
+      reinterpret_cast<const SnapshotWord*>(data + h.words_offset);
+  for (int i = 0; i < h.num_words; ++i) {
+    if (!RangeIsValid(words[i].first_symbol, words[i].num_symbols,
+                      h.num_symbols) ||
+        !RangeIsValid(words[i].text_offset, words[i].text_length,
+                      h.text_length) ||
+        !NameIsValid(words[i].lang, h.names_length) ||
+        !NameIsValid(words[i].font_name, h.names_length))
+      return false;
+  }
+  const SnapshotSymbol* symbols =
+      reinterpret_cast<const SnapshotSymbol*>(data + h.symbols_offset);
+  for (int i = 0; i < h.num_symbols; ++i) {
+    if (!RangeIsValid(symbols[i].text_offset, symbols[i].text_length,
+                      h.text_length))
+      return false;
+  }
+  return true;
+}
+
+// Sets *this to a valid empty snapshot.
+void PageSnapshot::Clear() {
+  Pack(GenericVector<SnapshotBlock>(), GenericVector<SnapshotPara>(),
+       GenericVector<SnapshotLine>(), GenericVector<SnapshotWord>(),
+       GenericVector<SnapshotSymbol>(), GenericVector<char>(),
+       GenericVector<char>());
+}
+
+}  // namespace tesseract.
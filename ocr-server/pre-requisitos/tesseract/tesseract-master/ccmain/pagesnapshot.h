@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagesnapshot.h
+// Description: Flat, contiguous copy of the recognition results of a page,
+//              captured once from a ResultIterator.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCMAIN_PAGESNAPSHOT_H_
+#define TESSERACT_CCMAIN_PAGESNAPSHOT_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "platform.h"
+
+namespace tesseract {
+
+class ResultIterator;
+class TFile;
+
+// Bounding box in original image coordinates, as given by
+// PageIterator::BoundingBox, with top < bottom.
+struct SnapshotBox {
+  inT32 left;
+  inT32 top;
+  inT32 right;
+  inT32 bottom;
+};
+
+// Flags for SnapshotWord::flags.
+enum SnapshotWordFlags {
+  SWF_BOLD = 1,
+  SWF_ITALIC = 2,
+  SWF_UNDERLINED = 4,
+  SWF_MONOSPACE = 8,
+  SWF_SERIF = 16,
+  SWF_SMALLCAPS = 32,
+  SWF_FROM_DICTIONARY = 64,
+  SWF_NUMERIC = 128,
+};
+
+// Flags for SnapshotSymbol::flags.
+enum SnapshotSymbolFlags {
+  SSF_SUPERSCRIPT = 1,
+  SSF_SUBSCRIPT = 2,
+  SSF_DROPCAP = 4,
+};
+
+// The elements of each level refer to their children by a range of indices
+// into the array of the next level down, and to their text by a range of
+// bytes in the single UTF-8 text buffer. Within the text buffer, the symbols
+// of a word are contiguous, words of a line are separated by a space, and
+// lines are separated by a newline, so the text of any element is a
+// substring of the buffer.
+// All members are 32 bits, so the arrays can be used directly from a
+// serialized buffer.
+struct SnapshotBlock {
+  SnapshotBox box;
+  inT32 block_type;         // PolyBlockType.
+  inT32 orientation;        // tesseract::Orientation.
+  inT32 writing_direction;  // tesseract::WritingDirection.
+  inT32 first_para;
+  inT32 num_paras;
+  inT32 text_offset;
+  inT32 text_length;
+};
+
+struct SnapshotPara {
+  SnapshotBox box;
+  inT32 is_ltr;  // 1 if the paragraph is left-to-right, else 0.
+  inT32 first_line;
+  inT32 num_lines;
+  inT32 text_offset;
+  inT32 text_length;
+};
+
+struct SnapshotLine {
+  SnapshotBox box;
+  // The baseline passes through (x1, y1) and (x2, y2). All zero if there
+  // is no baseline.
+  inT32 baseline_x1;
+  inT32 baseline_y1;
+  inT32 baseline_x2;
+  inT32 baseline_y2;
+  // As given by LTRResultIterator::RowAttributes.
+  float row_height;
+  float descenders;
+  float ascenders;
+  inT32 first_word;
+  inT32 num_words;
+  inT32 text_offset;
+  inT32 text_length;
+};
+
+struct SnapshotWord {
+  SnapshotBox box;
+  float confidence;
+  inT32 flags;      // SnapshotWordFlags.
+  inT32 pointsize;  // Printers points, or 0 if unknown.
+  inT32 font_id;    // -1 if unknown.
+  inT32 direction;  // StrongScriptDirection.
+  // The baseline of the word, as for SnapshotLine.
+  inT32 baseline_x1;
+  inT32 baseline_y1;
+  inT32 baseline_x2;
+  inT32 baseline_y2;
+  // Offsets of the recognition language and font name in the names, or -1
+  // if unknown. See PageSnapshot::name.
+  inT32 lang;
+  inT32 font_name;
+  inT32 first_symbol;
+  inT32 num_symbols;
+  inT32 text_offset;
+  inT32 text_length;
+};
+
+struct SnapshotSymbol {
+  SnapshotBox box;
+  float confidence;
+  inT32 flags;  // SnapshotSymbolFlags.
+  inT32 text_offset;
+  inT32 text_length;
+};
+
+// A snapshot of the results of a page: arrays of blocks, paragraphs, lines,
+// words and symbols, and the text, all held in one contiguous buffer that is
+// also the serialized form. It is captured with a single walk of a
+// ResultIterator, so renderers and indexers can make any number of passes
+// over it without touching PAGE_RES, allocating strings or recomputing boxes,
+// and it remains valid after the TessBaseAPI has moved on to the next page.
+// Blocks that contain no words (eg images) are omitted, as in GetTSVText.
+// The serialized form is in native byte order, and is rejected on load by a
+// machine of the other byte order.
+class TESS_API PageSnapshot {
+ public:
+  PageSnapshot();
+  PageSnapshot(const PageSnapshot& src);
+  ~PageSnapshot();
+  PageSnapshot& operator=(const PageSnapshot& src);
+
+  // Replaces the content with the results from it, starting from its current
+  // position, which is normally the beginning of the page. Leaves it at the
+  // end of the page.
+  void Capture(ResultIterator* it);
+
+  // Accessors.
+  int num_blocks() const { return header()->num_blocks; }
+  int num_paras() const { return header()->num_paras; }
+  int num_lines() const { return header()->num_lines; }
+  int num_words() const { return header()->num_words; }
+  int num_symbols() const { return header()->num_symbols; }
+  const SnapshotBlock& block(int index) const { return blocks()[index]; }
+  const SnapshotPara& para(int index) const { return paras()[index]; }
+  const SnapshotLine& line(int index) const { return lines()[index]; }
+  const SnapshotWord& word(int index) const { return words()[index]; }
+  const SnapshotSymbol& symbol(int index) const { return symbols()[index]; }
+  // The UTF-8 text of all the elements. It is null-terminated after
+  // text_length() bytes, so the whole page text can be used as a C string.
+  const char* text() const { return data_ + header()->text_offset; }
+  int text_length() const { return header()->text_length; }
+  // Returns the null-terminated name at the given offset from a
+  // SnapshotWord, or NULL if the offset is -1. Each distinct language or
+  // font name is stored once.
+  const char* name(int offset) const {
+    return offset < 0 ? NULL : data_ + header()->names_offset + offset;
+  }
+
+  // The buffer that holds everything, which is also the serialized form.
+  const char* data() const { return data_; }
+  int size() const { return size_; }
+
+  // Writes to the given file. Returns false in case of error.
+  bool Serialize(TFile* fp) const;
+  // Reads from the given file into an owned buffer. Returns false in case of
+  // error, leaving *this empty.
+  bool DeSerialize(TFile* fp);
+  // Uses the given serialized buffer in place, without copying. The buffer
+  // must be 4-byte aligned and outlive *this, or the next call to Capture,
+  // DeSerialize or SetFromBuffer. Returns false if the buffer is not a valid
+  // snapshot, leaving *this empty.
+  bool SetFromBuffer(const char* data, int size);
+
+ private:
+  // Serialized header. The arrays follow in the order blocks, paras, lines,
+  // words, symbols, each at the offset given, then the text and the names.
+  struct Header {
+    char magic[4];
+    inT32 byte_order;
+    inT32 version;
+    inT32 size;
+    inT32 num_blocks;
+    inT32 num_paras;
+    inT32 num_lines;
+    inT32 num_words;
+    inT32 num_symbols;
+    inT32 blocks_offset;
+    inT32 paras_offset;
+    inT32 lines_offset;
+    inT32 words_offset;
+    inT32 symbols_offset;
+    inT32 text_offset;
+    inT32 text_length;
+    inT32 names_offset;
+    inT32 names_length;
+  };
+
+  const Header* header() const {
+    return reinterpret_cast<const Header*>(data_);
+  }
+  const SnapshotBlock* blocks() const {
+    return reinterpret_cast<const SnapshotBlock*>(data_ +
+                                                  header()->blocks_offset);
+  }
+  const SnapshotPara* paras() const {
+    return reinterpret_cast<const SnapshotPara*>(data_ +
+                                                 header()->paras_offset);
+  }
+  const SnapshotLine* lines() const {
+    return reinterpret_cast<const SnapshotLine*>(data_ +
+                                                 header()->lines_offset);
+  }
+  const SnapshotWord* words() const {
+    return reinterpret_cast<const SnapshotWord*>(data_ +
+                                                 header()->words_offset);
+  }
+  const SnapshotSymbol* symbols() const {
+    return reinterpret_cast<const SnapshotSymbol*>(data_ +
+                                                   header()->symbols_offset);
+  }
+
+  // Packs the given arrays, text and names into owned_, and points data_ at
+  // it.
+  void Pack(const GenericVector<SnapshotBlock>& blocks,
+            const GenericVector<SnapshotPara>& paras,
+            const GenericVector<SnapshotLine>& lines,
+            const GenericVector<SnapshotWord>& words,
+            const GenericVector<SnapshotSymbol>& symbols,
+            const GenericVector<char>& text,
+            const GenericVector<char>& names);
+  // Returns true if the header and all the ranges in the buffer are
+  // consistent, so no accessor can read outside the buffer.
+  static bool IsValid(const char* data, int size);
+  // Sets *this to a valid empty snapshot.
+  void Clear();
+
+  // The buffer, either owned_ or borrowed from SetFromBuffer.
+  const char* data_;
+  int size_;
+  // Storage for data_ when it is owned. Held as inT32 for alignment.
+  GenericVector<inT32> owned_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCMAIN_PAGESNAPSHOT_H_
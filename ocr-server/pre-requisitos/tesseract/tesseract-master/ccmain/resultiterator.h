@@ -94,6 +94,14 @@ class TESS_API ResultIterator : public LTRResultIterator {
   */
   virtual char* GetUTF8Text(PageIteratorLevel level) const;
 
+  /**
+   * Appends the text of the current paragraph in reading order
+   * to the given buffer, as GetUTF8Text(RIL_PARA) returns it.
+   * Each textline is terminated in a single newline character, and the
+   * paragraph gets an extra newline at the end.
+   */
+  void AppendUTF8ParagraphText(STRING *text) const;
+
   /**
    * Return whether the current paragraph's dominant reading direction
    * is left-to-right (as opposed to right-to-left).
@@ -214,14 +222,6 @@ class TESS_API ResultIterator : public LTRResultIterator {
    */
   void IterateAndAppendUTF8TextlineText(STRING *text);
 
-  /**
-   * Appends the text of the current paragraph in reading order
-   * to the given buffer.
-   * Each textline is terminated in a single newline character, and the
-   * paragraph gets an extra newline at the end.
-   */
-  void AppendUTF8ParagraphText(STRING *text) const;
-
   /** Returns whether the bidi_debug flag is set to at least min_level. */
   bool BidiDebug(int min_level) const;
 
@@ -216,6 +216,20 @@ Tesseract::Tesseract()
       double_MEMBER(test_pt_y, 99999.99, "ycoord", this->params()),
       INT_MEMBER(multilang_debug_level, 0, "Print multilang debug info.",
                  this->params()),
+      BOOL_MEMBER(multilang_gated_routing, false,
+                  "Only try other languages on a word if the current"
+                  " language's result is below multilang_gate_certainty or"
+                  " not a dictionary word",
+                  this->params()),
+      double_MEMBER(multilang_gate_certainty, -3.0,
+                    "Word certainty at or above which multilang_gated_routing"
+                    " keeps the current language's result",
+                    this->params()),
+      INT_MEMBER(multilang_block_route_words, 3,
+                 "Consecutive gated words in one language after which the"
+                 " rest of the block is routed to that language alone"
+                 " (0 = never)",
+                 this->params()),
       INT_MEMBER(paragraph_debug_level, 0, "Print paragraph debug info.",
                  this->params()),
       BOOL_MEMBER(paragraph_text_based, true,
@@ -508,6 +522,16 @@ Tesseract::Tesseract()
       STRING_MEMBER(page_separator, "\f",
                     "Page separator (default is form feed control character)",
                     this->params()),
+      BOOL_MEMBER(tessedit_deskew_image, false,
+                  "Deskew the page image before layout analysis",
+                  this->params()),
+      double_MEMBER(tessedit_deskew_max_angle, 5.0,
+                    "Largest skew in degrees searched by tessedit_deskew_image",
+                    this->params()),
+      double_MEMBER(tessedit_deskew_min_angle, 0.1,
+                    "Smallest skew in degrees corrected by "
+                    "tessedit_deskew_image",
+                    this->params()),
 
       // The following parameters were deprecated and removed from their
       // original
@@ -610,7 +634,12 @@ Tesseract::Tesseract()
       scaled_factor_(-1),
       deskew_(1.0f, 0.0f),
       reskew_(1.0f, 0.0f),
+      image_reskew_(1.0f, 0.0f),
       most_recently_used_(this),
+      lang_run_count_(0),
+      route_block_(NULL),
+      route_tess_(NULL),
+      route_streak_(0),
       font_table_size_(0),
       equ_detect_(NULL),
 #ifndef ANDROID_BUILD
@@ -652,8 +681,10 @@ void Tesseract::Clear() {
   pixDestroy(&scaled_color_);
   deskew_ = FCOORD(1.0f, 0.0f);
   reskew_ = FCOORD(1.0f, 0.0f);
+  image_reskew_ = FCOORD(1.0f, 0.0f);
   splitter_.Clear();
   scaled_factor_ = -1;
+  ClearFeatureCache();
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
 }
@@ -671,6 +702,23 @@ void Tesseract::ResetAdaptiveClassifier() {
   }
 }
 
+// Zeroes the word run counters for this and all sub-languages.
+void Tesseract::ResetLangRunCounts() {
+  lang_run_count_ = 0;
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->lang_run_count_ = 0;
+  }
+}
+
+// Bytes held by this language's LSTM recoder tables and beam search, or 0
+// if it has no LSTM recognizer.
+int Tesseract::lstm_memory_used() const {
+#ifndef ANDROID_BUILD
+  if (lstm_recognizer_ != NULL) return lstm_recognizer_->MemoryUsed();
+#endif
+  return 0;
+}
+
 // Clear the document dictionary for this and all subclassifiers.
 void Tesseract::ResetDocumentDictionary() {
   getDict().ResetDocumentDictionary();
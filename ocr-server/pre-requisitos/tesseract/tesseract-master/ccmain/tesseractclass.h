@@ -184,6 +184,15 @@ class Tesseract : public Wordrec {
   const FCOORD& reskew() const {
     return reskew_;
   }
+  // Rotation that takes tesseract coordinates in pix_binary back to the
+  // source image, if TessBaseAPI deskewed the images (tessedit_deskew_image).
+  // It is about the centre of pix_binary, and (1, 0) if there was no deskew.
+  const FCOORD& image_reskew() const {
+    return image_reskew_;
+  }
+  void set_image_reskew(const FCOORD& image_reskew) {
+    image_reskew_ = image_reskew;
+  }
   // Destroy any existing pix and return a pointer to the pointer.
   Pix** mutable_pix_binary() {
     pixDestroy(&pix_binary_);
@@ -225,6 +234,9 @@ class Tesseract : public Wordrec {
     else
       return pix_binary_;
   }
+  Pix* pix_thresholds() const {
+    return pix_thresholds_;
+  }
   void set_pix_thresholds(Pix* thresholds) {
     pixDestroy(&pix_thresholds_);
     pix_thresholds_ = thresholds;
@@ -267,6 +279,16 @@ class Tesseract : public Wordrec {
   Tesseract* get_sub_lang(int index) const {
     return sub_langs_[index];
   }
+  // Number of times this language's recognizer has been run on a word since
+  // Init or the last ResetLangRunCounts.
+  int lang_run_count() const {
+    return lang_run_count_;
+  }
+  // Zeroes lang_run_count for this and all sub-languages.
+  void ResetLangRunCounts();
+  // Bytes held by this language's LSTM recoder tables and beam search, or 0
+  // if it has no LSTM recognizer.
+  int lstm_memory_used() const;
   // Returns true if any language uses Tesseract (as opposed to LSTM).
   bool AnyTessLang() const {
     if (tessedit_ocr_engine_mode != OEM_LSTM_ONLY) return true;
@@ -388,6 +410,15 @@ class Tesseract : public Wordrec {
   int RetryWithLanguage(const WordData& word_data, WordRecognizer recognizer,
                         bool debug, WERD_RES** in_word,
                         PointerVector<WERD_RES>* best_words);
+  // Returns true if multilang_gated_routing is on and every word has a
+  // certainty of at least multilang_gate_certainty and a dictionary (or
+  // number) permuter, so no other language needs to be tried.
+  bool WordsPassLangGate(const PointerVector<WERD_RES>& words) const;
+  // Updates the per-block language routing after a word in block was
+  // recognized by lang_tess. gated is true if the result passed the gate.
+  void UpdateLangRoute(const BLOCK* block, Tesseract* lang_tess, bool gated);
+  // Returns true if UpdateLangRoute has routed block to lang_tess alone.
+  bool IsBlockRouted(const BLOCK* block, const Tesseract* lang_tess) const;
   // Moves good-looking "noise"/diacritics from the reject list to the main
   // blob list on the current word. Returns true if anything was done, and
   // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -911,6 +942,16 @@ class Tesseract : public Wordrec {
   double_VAR_H(test_pt_x, 99999.99, "xcoord");
   double_VAR_H(test_pt_y, 99999.99, "ycoord");
   INT_VAR_H(multilang_debug_level, 0, "Print multilang debug info.");
+  BOOL_VAR_H(multilang_gated_routing, false,
+             "Only try other languages on a word if the current language's"
+             " result is below multilang_gate_certainty or not a dictionary"
+             " word");
+  double_VAR_H(multilang_gate_certainty, -3.0,
+               "Word certainty at or above which multilang_gated_routing"
+               " keeps the current language's result");
+  INT_VAR_H(multilang_block_route_words, 3,
+            "Consecutive gated words in one language after which the rest of"
+            " the block is routed to that language alone (0 = never)");
   INT_VAR_H(paragraph_debug_level, 0, "Print paragraph debug info.");
   BOOL_VAR_H(paragraph_text_based, true,
              "Run paragraph detection on the post-text-recognition "
@@ -1105,6 +1146,12 @@ class Tesseract : public Wordrec {
              "Preserve multiple interword spaces");
   STRING_VAR_H(page_separator, "\f",
                "Page separator (default is form feed control character)");
+  BOOL_VAR_H(tessedit_deskew_image, false,
+             "Deskew the page image before layout analysis");
+  double_VAR_H(tessedit_deskew_max_angle, 5.0,
+               "Largest skew in degrees searched by tessedit_deskew_image");
+  double_VAR_H(tessedit_deskew_min_angle, 0.1,
+               "Smallest skew in degrees corrected by tessedit_deskew_image");
 
   // The following parameters were deprecated and removed from their original
   // locations. The parameters are temporarily kept here to give Tesseract
@@ -1210,12 +1257,23 @@ class Tesseract : public Wordrec {
   int scaled_factor_;
   FCOORD deskew_;
   FCOORD reskew_;
+  FCOORD image_reskew_;
   TesseractStats stats_;
   // Sub-languages to be tried in addition to this.
   GenericVector<Tesseract*> sub_langs_;
   // Most recently used Tesseract out of this and sub_langs_. The default
   // language for the next word.
   Tesseract* most_recently_used_;
+  // Number of words this language has been run on. See lang_run_count().
+  int lang_run_count_;
+  // Per-block language routing for multilang_gated_routing. route_block_ is
+  // the block of the last word, route_tess_ the language that passed the gate
+  // on the last route_streak_ consecutive words of it. Once route_streak_
+  // reaches multilang_block_route_words, the rest of the block uses only
+  // route_tess_.
+  const BLOCK* route_block_;
+  Tesseract* route_tess_;
+  int route_streak_;
   // The size of the font table, ie max possible font id + 1.
   int font_table_size_;
   // Equation detector. Note: this pointer is NOT owned by the class.
@@ -33,7 +33,8 @@ ImageThresholder::ImageThresholder()
   : pix_(NULL),
     image_width_(0), image_height_(0),
     pix_channels_(0), pix_wpl_(0),
-    scale_(1), yres_(300), estimated_res_(300) {
+    scale_(1), yres_(300), estimated_res_(300),
+    grey_histogram_(NULL) {
   SetRectangle(0, 0, 0, 0);
 }
 
@@ -44,6 +45,8 @@ ImageThresholder::~ImageThresholder() {
 // Destroy the Pix if there is one, freeing memory.
 void ImageThresholder::Clear() {
   pixDestroy(&pix_);
+  delete [] grey_histogram_;
+  grey_histogram_ = NULL;
 }
 
 // Return true if no image has been set.
@@ -53,6 +56,8 @@ bool ImageThresholder::IsEmpty() const {
 
 // SetImage makes a copy of all the image data, so it may be deleted
 // immediately after this call.
+// The data is converted straight into the Pix that is kept, so there is only
+// one copy, and greyscale input has its histogram gathered in the same pass.
 // Greyscale of 8 and color of 24 or 32 bits per pixel may be given.
 // Palette color images will not work properly and must be converted to
 // 24 bit.
@@ -67,10 +72,20 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
   Pix* pix = pixCreate(width, height, bpp == 24 ? 32 : bpp);
   l_uint32* data = pixGetData(pix);
   int wpl = pixGetWpl(pix);
+  int* histogram = NULL;
   switch (bpp) {
-  case 1:
+  case 1: {
+    // Whole words are packed big-endian and inverted, as a one pixel is black
+    // in a Pix. The tail of each line is done a bit at a time.
+    int full_words = width / 32;
     for (int y = 0; y < height; ++y, data += wpl, imagedata += bytes_per_line) {
-      for (int x = 0; x < width; ++x) {
+      const unsigned char* src = imagedata;
+      for (int w = 0; w < full_words; ++w, src += 4) {
+        data[w] = ~((static_cast<l_uint32>(src[0]) << 24) |
+                    (static_cast<l_uint32>(src[1]) << 16) |
+                    (static_cast<l_uint32>(src[2]) << 8) | src[3]);
+      }
+      for (int x = full_words * 32; x < width; ++x) {
         if (imagedata[x / 8] & (0x80 >> (x % 8)))
           CLEAR_DATA_BIT(data, x);
         else
@@ -78,14 +93,32 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
       }
     }
     break;
+  }
 
-  case 8:
-    // Greyscale just copies the bytes in the right order.
+  case 8: {
+    // Greyscale packs the bytes into big-endian words, counting the
+    // histogram on the way so thresholding doesn't need another pass.
+    histogram = new int[kHistogramSize];
+    memset(histogram, 0, sizeof(*histogram) * kHistogramSize);
+    int full_words = width / 4;
     for (int y = 0; y < height; ++y, data += wpl, imagedata += bytes_per_line) {
-      for (int x = 0; x < width; ++x)
+      const unsigned char* src = imagedata;
+      for (int w = 0; w < full_words; ++w, src += 4) {
+        data[w] = (static_cast<l_uint32>(src[0]) << 24) |
+                  (static_cast<l_uint32>(src[1]) << 16) |
+                  (static_cast<l_uint32>(src[2]) << 8) | src[3];
+        ++histogram[src[0]];
+        ++histogram[src[1]];
+        ++histogram[src[2]];
+        ++histogram[src[3]];
+      }
+      for (int x = full_words * 4; x < width; ++x) {
         SET_DATA_BYTE(data, x, imagedata[x]);
+        ++histogram[imagedata[x]];
+      }
     }
     break;
+  }
 
   case 24:
     // Put the colors in the correct places in the line buffer.
@@ -112,8 +145,10 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
     tprintf("Cannot convert RAW image to Pix with bpp = %d\n", bpp);
   }
   pixSetYRes(pix, 300);
-  SetImage(pix);
-  pixDestroy(&pix);
+  // The new pix is already in a form that SetImage(const Pix*) would accept
+  // as is, so take it over rather than copying it again.
+  TakeImage(pix);
+  grey_histogram_ = histogram;
 }
 
 // Store the coordinates of the rectangle to process for later use.
@@ -146,29 +181,39 @@ void ImageThresholder::GetImageSizes(int* left, int* top,
 // immediately after, but may not go away until after the Thresholder has
 // finished with it.
 void ImageThresholder::SetImage(const Pix* pix) {
-  if (pix_ != NULL)
-    pixDestroy(&pix_);
   Pix* src = const_cast<Pix*>(pix);
-  int depth;
-  pixGetDimensions(src, &image_width_, &image_height_, &depth);
+  int depth = pixGetDepth(src);
   // Convert the image as necessary so it is one of binary, plain RGB, or
   // 8 bit with no colormap. Guarantee that we always end up with our own copy,
   // not just a clone of the input.
+  Pix* copy;
   if (pixGetColormap(src)) {
     Pix* tmp = pixRemoveColormap(src, REMOVE_CMAP_BASED_ON_SRC);
     depth = pixGetDepth(tmp);
     if (depth > 1 && depth < 8) {
-      pix_ = pixConvertTo8(tmp, false);
+      copy = pixConvertTo8(tmp, false);
       pixDestroy(&tmp);
     } else {
-      pix_ = tmp;
+      copy = tmp;
     }
   } else if (depth > 1 && depth < 8) {
-    pix_ = pixConvertTo8(src, false);
+    copy = pixConvertTo8(src, false);
   } else {
-    pix_ = pixCopy(NULL, src);
+    copy = pixCopy(NULL, src);
   }
-  depth = pixGetDepth(pix_);
+  TakeImage(copy);
+}
+
+// Takes ownership of the given pix, which must already be binary, plain RGB,
+// or 8 bit with no colormap, and sets up the image parameters from it.
+// Any cached histogram of the previous image is discarded.
+void ImageThresholder::TakeImage(Pix* pix) {
+  pixDestroy(&pix_);
+  delete [] grey_histogram_;
+  grey_histogram_ = NULL;
+  pix_ = pix;
+  int depth;
+  pixGetDimensions(pix_, &image_width_, &image_height_, &depth);
   pix_channels_ = depth / 8;
   pix_wpl_ = pixGetWpl(pix_);
   scale_ = 1;
@@ -191,6 +236,15 @@ bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
     Pix* original = GetPixRect();
     *pix = pixCopy(nullptr, original);
     pixDestroy(&original);
+  } else if (pix_channels_ == 1 && IsFullImage()) {
+    // Use the histogram that may already have been gathered by SetImage,
+    // and will be reused by GetPixRectThresholds.
+    int* thresholds;
+    int* hi_values;
+    OtsuThresholdFromHistograms(GreyHistogram(), 1, &thresholds, &hi_values);
+    ThresholdRectToPix(pix_, 1, thresholds, hi_values, pix);
+    delete [] thresholds;
+    delete [] hi_values;
   } else {
     OtsuThresholdRectToPix(pix_, pix);
   }
@@ -206,13 +260,19 @@ bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
 // Returns NULL if the input is binary. PixDestroy after use.
 Pix* ImageThresholder::GetPixRectThresholds() {
   if (IsBinary()) return NULL;
-  Pix* pix_grey = GetPixRectGrey();
-  int width = pixGetWidth(pix_grey);
-  int height = pixGetHeight(pix_grey);
+  int width = rect_width_;
+  int height = rect_height_;
   int* thresholds;
   int* hi_values;
-  OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
-  pixDestroy(&pix_grey);
+  if (pix_channels_ == 1 && IsFullImage()) {
+    OtsuThresholdFromHistograms(GreyHistogram(), 1, &thresholds, &hi_values);
+  } else {
+    Pix* pix_grey = GetPixRectGrey();
+    width = pixGetWidth(pix_grey);
+    height = pixGetHeight(pix_grey);
+    OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
+    pixDestroy(&pix_grey);
+  }
   Pix* pix_thresholds = pixCreate(width, height, 8);
   int threshold = thresholds[0] > 0 ? thresholds[0] : 128;
   pixSetAllArbitrary(pix_thresholds, threshold);
@@ -221,6 +281,18 @@ Pix* ImageThresholder::GetPixRectThresholds() {
   return pix_thresholds;
 }
 
+// Returns the kHistogramSize element histogram of the full 8 bit pix_,
+// computing it on the first call after the image was set, so that
+// ThresholdToPix and GetPixRectThresholds share a single pass over the
+// pixels. Must only be called with a single channel image.
+const int* ImageThresholder::GreyHistogram() {
+  if (grey_histogram_ == NULL) {
+    grey_histogram_ = new int[kHistogramSize];
+    HistogramRect(pix_, 0, 0, 0, image_width_, image_height_, grey_histogram_);
+  }
+  return grey_histogram_;
+}
+
 // Common initialization shared between SetImage methods.
 void ImageThresholder::Init() {
   SetRectangle(0, 0, image_width_, image_height_);
@@ -305,6 +377,24 @@ void ImageThresholder::ThresholdRectToPix(Pix* src_pix,
   int wpl = pixGetWpl(*pix);
   int src_wpl = pixGetWpl(src_pix);
   uinT32* srcdata = pixGetData(src_pix);
+  if (num_channels == 1) {
+    // The new pix is all white, so with a single channel only the black
+    // pixels need to be touched, and there is no channel loop.
+    int threshold = thresholds[0];
+    bool hi_black = hi_values[0] == 0;
+    if (hi_values[0] >= 0) {
+      for (int y = 0; y < rect_height_; ++y) {
+        const uinT32* linedata = srcdata + (y + rect_top_) * src_wpl;
+        uinT32* pixline = pixdata + y * wpl;
+        for (int x = 0; x < rect_width_; ++x) {
+          if ((GET_DATA_BYTE(linedata, x + rect_left_) > threshold) == hi_black)
+            SET_DATA_BIT(pixline, x);
+        }
+      }
+    }
+    PERF_COUNT_END
+    return;
+  }
   for (int y = 0; y < rect_height_; ++y) {
     const uinT32* linedata = srcdata + (y + rect_top_) * src_wpl;
     uinT32* pixline = pixdata + y * wpl;
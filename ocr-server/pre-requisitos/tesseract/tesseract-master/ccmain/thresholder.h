@@ -46,6 +46,9 @@ class TESS_API ImageThresholder {
 
   /// SetImage makes a copy of all the image data, so it may be deleted
   /// immediately after this call.
+  /// The data is converted straight into the Pix that is kept, so there is
+  /// only one copy, and greyscale input has its histogram gathered in the
+  /// same pass, ready for thresholding.
   /// Greyscale of 8 and color of 24 or 32 bits per pixel may be given.
   /// Palette color images will not work properly and must be converted to
   /// 24 bit.
@@ -108,7 +111,7 @@ class TESS_API ImageThresholder {
   }
 
   /// Pix vs raw, which to use? Pix is the preferred input for efficiency,
-  /// since raw buffers are copied.
+  /// since raw buffers are converted, although only once.
   /// SetImage for Pix clones its input, so the source pix may be pixDestroyed
   /// immediately after, but may not go away until after the Thresholder has
   /// finished with it.
@@ -149,6 +152,14 @@ class TESS_API ImageThresholder {
   /// Common initialization shared between SetImage methods.
   virtual void Init();
 
+  /// Takes ownership of the given pix, which must already be binary, plain
+  /// RGB, or 8 bit with no colormap, and sets up the image parameters from it.
+  void TakeImage(Pix* pix);
+
+  // Returns the histogram of the full 8 bit pix_, computing it only if it
+  // was not already gathered since the image was set.
+  const int* GreyHistogram();
+
   /// Return true if we are processing the full image.
   bool IsFullImage() const {
     return rect_left_ == 0 && rect_top_ == 0 &&
@@ -183,6 +194,9 @@ class TESS_API ImageThresholder {
   int                  rect_top_;
   int                  rect_width_;
   int                  rect_height_;
+  // Histogram of the full image if pix_ is 8 bit and it has been computed,
+  // otherwise NULL. Shared by thresholding and GetPixRectThresholds.
+  int*                 grey_histogram_;
 };
 
 }  // namespace tesseract.
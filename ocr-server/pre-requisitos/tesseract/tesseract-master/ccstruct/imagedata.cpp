@@ -565,9 +565,17 @@ bool DocumentData::ReCachePages() {
 
 // A collection of DocumentData that knows roughly how much memory it is using.
 DocumentCache::DocumentCache(inT64 max_memory)
-    : num_pages_per_doc_(0), max_memory_(max_memory) {}
+    : num_pages_per_doc_(0), max_memory_(max_memory),
+      read_ahead_(kMaxReadAhead) {}
 DocumentCache::~DocumentCache() {}
 
+// Sets the number of documents beyond the current one that
+// GetPageRoundRobin loads in the background, so that a whole batch of
+// samples can be ready when needed. Never less than the default.
+void DocumentCache::set_read_ahead(int read_ahead) {
+  read_ahead_ = MAX(read_ahead, kMaxReadAhead);
+}
+
 // Adds all the documents in the list of filenames, counting memory.
 // The reader is used to read the files.
 bool DocumentCache::LoadDocuments(const GenericVector<STRING>& filenames,
@@ -635,7 +643,7 @@ const ImageData* DocumentCache::GetPageRoundRobin(int serial) {
   int num_docs = documents_.size();
   int doc_index = serial % num_docs;
   const ImageData* doc = documents_[doc_index]->GetPage(serial / num_docs);
-  for (int offset = 1; offset <= kMaxReadAhead && offset < num_docs; ++offset) {
+  for (int offset = 1; offset <= read_ahead_ && offset < num_docs; ++offset) {
     doc_index = (serial + offset) % num_docs;
     int page = (serial + offset) / num_docs;
     documents_[doc_index]->LoadPageInBackground(page);
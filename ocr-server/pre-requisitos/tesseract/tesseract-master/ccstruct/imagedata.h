@@ -342,6 +342,10 @@ class DocumentCache {
   const PointerVector<DocumentData>& documents() const {
     return documents_;
   }
+  // Sets the number of documents beyond the current one that
+  // GetPageRoundRobin loads in the background, so that a whole batch of
+  // samples can be ready when needed. Never less than the default.
+  void set_read_ahead(int read_ahead);
   // Returns the total number of pages in an epoch. For CS_ROUND_ROBIN cache
   // strategy, could take a long time.
   int TotalPages();
@@ -369,6 +373,8 @@ class DocumentCache {
   int num_pages_per_doc_;
   // Max memory allowed in this cache.
   inT64 max_memory_;
+  // Number of documents to load ahead in GetPageRoundRobin.
+  int read_ahead_;
 };
 
 }  // namespace tesseract
@@ -30,6 +30,12 @@
 #define TESSERACT_CCSTRUCT_MATRIX_H_
 
 #include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <type_traits>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 #include "kdpair.h"
 #include "points.h"
 #include "serialis.h"
@@ -40,6 +46,11 @@ class BLOB_CHOICE_LIST;
 
 #define NOT_CLASSIFIED static_cast<BLOB_CHOICE_LIST*>(0)
 
+// Alignment in bytes of the storage of a GENERIC_2D_ARRAY of a plain data
+// type. A cache line, which is also enough for the widest SIMD registers, so
+// aligned loads can be used and no load is split across cache lines.
+const int kMatrixAlignment = 64;
+
 // A generic class to hold a 2-D matrix with entries of type T, but can also
 // act as a base class for other implementations, such as a triangular or
 // banded matrix.
@@ -50,6 +61,7 @@ class GENERIC_2D_ARRAY {
   // for the subclasses or initialize because calls to the num_elements
   // member will be routed to the base class implementation. Subclasses can
   // either pass the memory in, or allocate after by calling Resize().
+  // Memory passed in must have been allocated with AllocArray.
   GENERIC_2D_ARRAY(int dim1, int dim2, const T& empty, T* array)
     : empty_(empty), dim1_(dim1), dim2_(dim2), array_(array)  {
     size_allocated_ = dim1 * dim2;
@@ -58,9 +70,8 @@ class GENERIC_2D_ARRAY {
   // and initialize it to empty.
   GENERIC_2D_ARRAY(int dim1, int dim2, const T& empty)
     : empty_(empty), dim1_(dim1), dim2_(dim2)  {
-    int new_size = dim1 * dim2;
-    array_ = new T[new_size];
-    size_allocated_ = new_size;
+    size_allocated_ = RoundupAllocation(dim1 * dim2);
+    array_ = AllocArray(size_allocated_);
     for (int i = 0; i < size_allocated_; ++i)
       array_[i] = empty_;
   }
@@ -74,23 +85,54 @@ class GENERIC_2D_ARRAY {
       size_allocated_(0) {
     *this = src;
   }
-  virtual ~GENERIC_2D_ARRAY() { delete[] array_; }
+  // Takes the memory of src, leaving it empty.
+  GENERIC_2D_ARRAY(GENERIC_2D_ARRAY<T>&& src)
+    : array_(src.array_), empty_(src.empty_), dim1_(src.dim1_),
+      dim2_(src.dim2_), size_allocated_(src.size_allocated_) {
+    src.array_ = NULL;
+    src.dim1_ = src.dim2_ = src.size_allocated_ = 0;
+  }
+  virtual ~GENERIC_2D_ARRAY() { FreeArray(array_); }
 
   void operator=(const GENERIC_2D_ARRAY<T>& src) {
     ResizeNoInit(src.dim1(), src.dim2());
     memcpy(array_, src.array_, num_elements() * sizeof(array_[0]));
   }
+  // Swaps memory with src, so the old memory of *this is freed with src, or
+  // reused if src is resized.
+  void operator=(GENERIC_2D_ARRAY<T>&& src) {
+    Swap(&src);
+  }
+  // Exchanges the content of *this and other without copying any elements.
+  void Swap(GENERIC_2D_ARRAY<T>* other) {
+    std::swap(array_, other->array_);
+    std::swap(empty_, other->empty_);
+    std::swap(dim1_, other->dim1_);
+    std::swap(dim2_, other->dim2_);
+    std::swap(size_allocated_, other->size_allocated_);
+  }
+
+  // Allocates uninitialized storage for size elements, aligned to
+  // kMatrixAlignment if T is a plain data type. Free with FreeArray.
+  static T* AllocArray(int size) {
+    return AllocArray(size, std::is_trivial<T>());
+  }
+  static void FreeArray(T* array) {
+    FreeArray(array, std::is_trivial<T>());
+  }
 
   // Reallocates the array to the given size. Does not keep old data, but does
   // not initialize the array either.
   // The allocated memory is expanded on the end by pad, allowing deliberate
   // access beyond the bounds of the array.
+  // The memory is retained when shrinking, so it can be re-expanded without
+  // a further alloc.
   void ResizeNoInit(int size1, int size2, int pad = 0) {
     int new_size = size1 * size2 + pad;
     if (new_size > size_allocated_) {
-      delete [] array_;
-      array_ = new T[new_size];
-      size_allocated_ = new_size;
+      FreeArray(array_);
+      size_allocated_ = RoundupAllocation(new_size);
+      array_ = AllocArray(size_allocated_);
     }
     dim1_ = size1;
     dim2_ = size2;
@@ -105,11 +147,14 @@ class GENERIC_2D_ARRAY {
     Clear();
   }
 
-  // Reallocate the array to the given size, keeping old data.
+  // Reallocate the array to the given size, keeping old data. If the new
+  // size fits in the allocated memory, the data is moved in place.
   void ResizeWithCopy(int size1, int size2) {
-    if (size1 != dim1_ || size2 != dim2_) {
-      int new_size = size1 * size2;
-      T* new_array = new T[new_size];
+    if (size1 == dim1_ && size2 == dim2_) return;
+    int new_size = size1 * size2;
+    if (new_size > size_allocated_) {
+      int new_allocated = RoundupAllocation(new_size);
+      T* new_array = AllocArray(new_allocated);
       for (int col = 0; col < size1; ++col) {
         for (int row = 0; row < size2; ++row) {
           int old_index = col * dim2() + row;
@@ -121,12 +166,29 @@ class GENERIC_2D_ARRAY {
           }
         }
       }
-      delete[] array_;
+      FreeArray(array_);
       array_ = new_array;
-      dim1_ = size1;
-      dim2_ = size2;
-      size_allocated_ = new_size;
+      size_allocated_ = new_allocated;
+    } else if (size2 <= dim2_) {
+      // Each element moves to a lower or equal index, so work forwards.
+      for (int col = 0; col < size1; ++col) {
+        for (int row = 0; row < size2; ++row) {
+          array_[col * size2 + row] =
+              col < dim1_ ? array_[col * dim2_ + row] : empty_;
+        }
+      }
+    } else {
+      // Each element moves to a higher or equal index, so work backwards.
+      for (int col = size1 - 1; col >= 0; --col) {
+        for (int row = size2 - 1; row >= 0; --row) {
+          array_[col * size2 + row] = col < dim1_ && row < dim2_
+                                          ? array_[col * dim2_ + row]
+                                          : empty_;
+        }
+      }
     }
+    dim1_ = size1;
+    dim2_ = size2;
   }
 
   // Sets all the elements of the array to the empty value.
@@ -461,6 +523,36 @@ class GENERIC_2D_ARRAY {
   }
 
  protected:
+  // Rounds a number of elements up to fill whole kMatrixAlignment blocks for
+  // plain data types, which costs nothing extra with aligned allocation and
+  // makes the tail safe to over-read with SIMD loads.
+  static int RoundupAllocation(int size) {
+    if (!std::is_trivial<T>::value || sizeof(T) >= kMatrixAlignment)
+      return size;
+    const int kPerBlock = kMatrixAlignment / sizeof(T);
+    return (size + kPerBlock - 1) / kPerBlock * kPerBlock;
+  }
+  static T* AllocArray(int size, std::true_type) {
+    void* array = NULL;
+    size_t bytes = MAX(size, 1) * sizeof(T);
+#ifdef _WIN32
+    array = _aligned_malloc(bytes, kMatrixAlignment);
+#else
+    if (posix_memalign(&array, kMatrixAlignment, bytes) != 0) array = NULL;
+#endif
+    ASSERT_HOST(array != NULL);
+    return static_cast<T*>(array);
+  }
+  static T* AllocArray(int size, std::false_type) { return new T[size]; }
+  static void FreeArray(T* array, std::true_type) {
+#ifdef _WIN32
+    _aligned_free(array);
+#else
+    free(array);
+#endif
+  }
+  static void FreeArray(T* array, std::false_type) { delete[] array; }
+
   // Factored helper to serialize the size.
   bool SerializeSize(FILE* fp) const {
     inT32 size = dim1_;
@@ -545,7 +637,7 @@ class BandTriMatrix : public GENERIC_2D_ARRAY<T> {
   void AttachOnCorner(BandTriMatrix<T>* array2) {
     int new_dim1 = this->dim1_ + array2->dim1_;
     int new_dim2 = MAX(this->dim2_, array2->dim2_);
-    T* new_array = new T[new_dim1 * new_dim2];
+    T* new_array = this->AllocArray(new_dim1 * new_dim2);
     for (int col = 0; col < new_dim1; ++col) {
       for (int j = 0; j < new_dim2; ++j) {
         int new_index = col * new_dim2 + j;
@@ -560,10 +652,11 @@ class BandTriMatrix : public GENERIC_2D_ARRAY<T> {
         }
       }
     }
-    delete[] this->array_;
+    this->FreeArray(this->array_);
     this->array_ = new_array;
     this->dim1_ = new_dim1;
     this->dim2_ = new_dim2;
+    this->size_allocated_ = new_dim1 * new_dim2;
   }
 };
 
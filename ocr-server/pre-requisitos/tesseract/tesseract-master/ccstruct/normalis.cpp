@@ -354,6 +354,68 @@ void DENORM::NormTransform(const DENORM* first_norm, const FCOORD& pt,
   LocalNormTransform(src_pt, transformed);
 }
 
+// As NormTransform, but transforms num_pts points in place, applying each
+// step of the transformation sequence to all the points before moving on
+// to the next. Gives identical results to NormTransform on each point.
+void DENORM::NormTransformPoints(const DENORM* first_norm, int num_pts,
+                                 FCOORD* pts) const {
+  if (first_norm != this) {
+    if (predecessor_ != NULL) {
+      predecessor_->NormTransformPoints(first_norm, num_pts, pts);
+    } else if (block_ != NULL) {
+      FCOORD fwd_rotation(block_->re_rotation().x(),
+                          -block_->re_rotation().y());
+      for (int i = 0; i < num_pts; ++i) pts[i].rotate(fwd_rotation);
+    }
+  }
+  if ((x_map_ != NULL && y_map_ != NULL) || rotation_ != NULL) {
+    for (int i = 0; i < num_pts; ++i) LocalNormTransform(pts[i], &pts[i]);
+    return;
+  }
+  // Plain scaling is the common case, and is a simple loop over the points
+  // that performs the same float operations as LocalNormTransform.
+  float x_origin = x_origin_, y_origin = y_origin_;
+  float x_scale = x_scale_, y_scale = y_scale_;
+  float x_shift = final_xshift_, y_shift = final_yshift_;
+  for (int i = 0; i < num_pts; ++i) {
+    pts[i].set_x((pts[i].x() - x_origin) * x_scale + x_shift);
+    pts[i].set_y((pts[i].y() - y_origin) * y_scale + y_shift);
+  }
+}
+
+// Helper appends the bytes of value to key.
+template <typename T>
+static void AppendBytesToKey(const T& value, GenericVector<char>* key) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  for (size_t i = 0; i < sizeof(value); ++i) key->push_back(bytes[i]);
+}
+
+// Appends to key the parameters of this and all its predecessors, such that
+// DENORMs with equal keys perform identical forward transformations.
+void DENORM::AppendTransformKey(GenericVector<char>* key) const {
+  for (const DENORM* denorm = this; denorm != NULL;
+       denorm = denorm->predecessor_) {
+    AppendBytesToKey(denorm->block_, key);
+    bool rotated = denorm->rotation_ != NULL;
+    AppendBytesToKey(rotated, key);
+    if (rotated) AppendBytesToKey(*denorm->rotation_, key);
+    int map_sizes[2] = {0, 0};
+    if (denorm->x_map_ != NULL && denorm->y_map_ != NULL) {
+      map_sizes[0] = denorm->x_map_->size();
+      map_sizes[1] = denorm->y_map_->size();
+    }
+    AppendBytesToKey(map_sizes, key);
+    for (int i = 0; i < map_sizes[0]; ++i)
+      AppendBytesToKey((*denorm->x_map_)[i], key);
+    for (int i = 0; i < map_sizes[1]; ++i)
+      AppendBytesToKey((*denorm->y_map_)[i], key);
+    float params[6] = {denorm->x_origin_, denorm->y_origin_,
+                       denorm->x_scale_, denorm->y_scale_,
+                       denorm->final_xshift_, denorm->final_yshift_};
+    AppendBytesToKey(params, key);
+  }
+}
+
 // Transforms the given coords one step back to source space, without
 // using to any block rotation or predecessor.
 void DENORM::LocalDenormTransform(const TPOINT& pt, TPOINT* original) const {
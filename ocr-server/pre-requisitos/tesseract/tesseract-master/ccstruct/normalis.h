@@ -213,6 +213,14 @@ class DENORM {
                      TPOINT* transformed) const;
   void NormTransform(const DENORM* first_norm, const FCOORD& pt,
                      FCOORD* transformed) const;
+  // As NormTransform, but transforms num_pts points in place, applying each
+  // step of the transformation sequence to all the points before moving on
+  // to the next. Gives identical results to NormTransform on each point.
+  void NormTransformPoints(const DENORM* first_norm, int num_pts,
+                           FCOORD* pts) const;
+  // Appends to key the parameters of this and all its predecessors, such that
+  // DENORMs with equal keys perform identical forward transformations.
+  void AppendTransformKey(GenericVector<char>* key) const;
   // Transforms the given coords one step back to source space, without
   // using to any block rotation or predecessor.
   void LocalDenormTransform(const TPOINT& pt, TPOINT* original) const;
@@ -39,21 +39,12 @@ namespace tesseract {
 int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
                   int** thresholds, int** hi_values) {
   int num_channels = pixGetDepth(src_pix) / 8;
-  // Of all channels with no good hi_value, keep the best so we can always
-  // produce at least one answer.
   PERF_COUNT_START("OtsuThreshold")
-  int best_hi_value = 1;
-  int best_hi_index = 0;
-  bool any_good_hivalue = false;
-  double best_hi_dist = 0.0;
-  *thresholds = new int[num_channels];
-  *hi_values = new int[num_channels];
-
-  // only use opencl if compiled w/ OpenCL and selected device is opencl
-#ifdef USE_OPENCL
   // all of channel 0 then all of channel 1...
   int* histogramAllChannels = new int[kHistogramSize * num_channels];
 
+  // only use opencl if compiled w/ OpenCL and selected device is opencl
+#ifdef USE_OPENCL
   // Calculate Histogram on GPU
   OpenclDevice od;
   if (od.selectedDeviceIsOpenCL() && (num_channels == 1 || num_channels == 4) &&
@@ -61,87 +52,73 @@ int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
     od.HistogramRectOCL((unsigned char*)pixGetData(src_pix), num_channels,
                         pixGetWpl(src_pix) * 4, left, top, width, height,
                         kHistogramSize, histogramAllChannels);
-
-    // Calculate Threshold from Histogram on cpu
-    for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
-      int *histogram = &histogramAllChannels[kHistogramSize * ch];
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
-    }
   } else {
 #endif
     for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
       // Compute the histogram of the image rectangle.
-      int histogram[kHistogramSize];
-      HistogramRect(src_pix, ch, left, top, width, height, histogram);
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
+      HistogramRect(src_pix, ch, left, top, width, height,
+                    &histogramAllChannels[kHistogramSize * ch]);
     }
 #ifdef USE_OPENCL
   }
-  delete[] histogramAllChannels;
 #endif  // USE_OPENCL
+  // Calculate Threshold from Histogram on cpu
+  OtsuThresholdFromHistograms(histogramAllChannels, num_channels, thresholds,
+                              hi_values);
+  delete[] histogramAllChannels;
+  PERF_COUNT_END
+  return num_channels;
+}
+
+// As OtsuThreshold, but takes precomputed histograms, kHistogramSize
+// elements for each channel in turn, instead of an image.
+void OtsuThresholdFromHistograms(const int* histograms, int num_channels,
+                                 int** thresholds, int** hi_values) {
+  // Of all channels with no good hi_value, keep the best so we can always
+  // produce at least one answer.
+  int best_hi_value = 1;
+  int best_hi_index = 0;
+  bool any_good_hivalue = false;
+  double best_hi_dist = 0.0;
+  *thresholds = new int[num_channels];
+  *hi_values = new int[num_channels];
+  for (int ch = 0; ch < num_channels; ++ch) {
+    (*thresholds)[ch] = -1;
+    (*hi_values)[ch] = -1;
+    const int* histogram = &histograms[kHistogramSize * ch];
+    int H;
+    int best_omega_0;
+    int best_t = OtsuStats(histogram, &H, &best_omega_0);
+    if (best_omega_0 == 0 || best_omega_0 == H) {
+       // This channel is empty.
+       continue;
+     }
+    // To be a convincing foreground we must have a small fraction of H
+    // or to be a convincing background we must have a large fraction of H.
+    // In between we assume this channel contains no thresholding information.
+    int hi_value = best_omega_0 < H * 0.5;
+    (*thresholds)[ch] = best_t;
+    if (best_omega_0 > H * 0.75) {
+      any_good_hivalue = true;
+      (*hi_values)[ch] = 0;
+    } else if (best_omega_0 < H * 0.25) {
+      any_good_hivalue = true;
+      (*hi_values)[ch] = 1;
+    } else {
+      // In case all channels are like this, keep the best of the bad lot.
+      double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
+      if (hi_dist > best_hi_dist) {
+        best_hi_dist = hi_dist;
+        best_hi_value = hi_value;
+        best_hi_index = ch;
+      }
+    }
+  }
 
   if (!any_good_hivalue) {
     // Use the best of the ones that were not good enough.
     (*hi_values)[best_hi_index] = best_hi_value;
   }
-  PERF_COUNT_END
-  return num_channels;
 }
 
 // Computes the histogram for the given image rectangle, and the given
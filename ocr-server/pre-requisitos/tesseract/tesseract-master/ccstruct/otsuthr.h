@@ -38,6 +38,13 @@ const int kHistogramSize = 256;  // The size of a histogram of pixel values.
 int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
                   int** thresholds, int** hi_values);
 
+// As OtsuThreshold, but computes the thresholds from num_channels
+// precomputed histograms, stored one after the other, each of
+// kHistogramSize elements. Used when the histogram has already been
+// gathered, eg while copying the image.
+void OtsuThresholdFromHistograms(const int* histograms, int num_channels,
+                                 int** thresholds, int** hi_values);
+
 // Computes the histogram for the given image rectangle, and the given
 // single channel. Each channel is always one byte per pixel.
 // Histogram is always a kHistogramSize(256) element array to count
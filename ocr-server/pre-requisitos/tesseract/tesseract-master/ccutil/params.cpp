@@ -92,21 +92,21 @@ bool ParamUtils::SetParam(const char *name, const char* value,
                           SetParamConstraint constraint,
                           ParamsVectors *member_params) {
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_index,
+                                           &member_params->string_index);
   if (sp != NULL && sp->constraint_ok(constraint)) sp->set_value(value);
   if (*value == '\0') return (sp != NULL);
 
   // Look for the parameter among int parameters.
   int intval;
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_index,
+                                     &member_params->int_index);
   if (ip && ip->constraint_ok(constraint) && sscanf(value, "%d", &intval) == 1)
     ip->set_value(intval);
 
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_index,
+                                       &member_params->bool_index);
   if (bp != NULL && bp->constraint_ok(constraint)) {
     if (*value == 'T' || *value == 't' ||
         *value == 'Y' || *value == 'y' || *value == '1') {
@@ -119,8 +119,8 @@ bool ParamUtils::SetParam(const char *name, const char* value,
 
   // Look for the parameter among double parameters.
   double doubleval;
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_index,
+                                           &member_params->double_index);
   if (dp != NULL && dp->constraint_ok(constraint)) {
 #ifdef EMBEDDED
       doubleval = strtofloat(value);
@@ -136,15 +136,15 @@ bool ParamUtils::GetParamAsString(const char *name,
                                   const ParamsVectors* member_params,
                                   STRING *value) {
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_index,
+                                           &member_params->string_index);
   if (sp) {
     *value = sp->string();
     return true;
   }
   // Look for the parameter among int parameters.
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_index,
+                                     &member_params->int_index);
   if (ip) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%d", inT32(*ip));
@@ -152,15 +152,15 @@ bool ParamUtils::GetParamAsString(const char *name,
     return true;
   }
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_index,
+                                       &member_params->bool_index);
   if (bp != NULL) {
     *value = BOOL8(*bp) ? "1": "0";
     return true;
   }
   // Look for the parameter among double parameters.
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_index,
+                                           &member_params->double_index);
   if (dp != NULL) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%g", double(*dp));
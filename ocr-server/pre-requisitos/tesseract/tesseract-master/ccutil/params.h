@@ -21,6 +21,8 @@
 #define           PARAMS_H
 
 #include          <stdio.h>
+#include          <string.h>
+#include          <unordered_map>
 
 #include          "genericvector.h"
 #include          "strngs.h"
@@ -40,11 +42,64 @@ enum SetParamConstraint {
   SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
 };
 
+// Hash table from name to the first param of type T with that name, kept in
+// step with one of the vectors of a ParamsVectors by the param constructors
+// and destructors, so params can be found by name without a linear search.
+template <class T>
+class ParamIndex {
+ public:
+  // Adds param to the index, unless an earlier one has the same name.
+  void Add(T* param) { map_.insert(std::make_pair(param->name_str(), param)); }
+  // Removes param from the index, given the vector that it was in, which may
+  // hold another param of the same name to take its place.
+  void Remove(T* param, const GenericVector<T*>& vec) {
+    typename Map::iterator it = map_.find(param->name_str());
+    if (it == map_.end() || it->second != param) return;
+    map_.erase(it);
+    for (int i = 0; i < vec.size(); ++i) {
+      if (vec[i] != param &&
+          strcmp(vec[i]->name_str(), param->name_str()) == 0) {
+        Add(vec[i]);
+        return;
+      }
+    }
+  }
+  // Returns the param with the given name, or NULL if there isn't one.
+  T* Find(const char* name) const {
+    typename Map::const_iterator it = map_.find(name);
+    return it == map_.end() ? NULL : it->second;
+  }
+
+ private:
+  // Hash and equality of C strings, so lookups don't allocate.
+  struct NameHash {
+    size_t operator()(const char* name) const {
+      size_t hash = 2166136261u;
+      for (; *name != '\0'; ++name)
+        hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+      return hash;
+    }
+  };
+  struct NameEqual {
+    bool operator()(const char* a, const char* b) const {
+      return strcmp(a, b) == 0;
+    }
+  };
+  // The keys are the names owned by the params themselves.
+  typedef std::unordered_map<const char*, T*, NameHash, NameEqual> Map;
+  Map map_;
+};
+
 struct ParamsVectors {
   GenericVector<IntParam *> int_params;
   GenericVector<BoolParam *> bool_params;
   GenericVector<StringParam *> string_params;
   GenericVector<DoubleParam *> double_params;
+  // Name indices of the above, for FindParam.
+  ParamIndex<IntParam> int_index;
+  ParamIndex<BoolParam> bool_index;
+  ParamIndex<StringParam> string_index;
+  ParamIndex<DoubleParam> double_index;
 };
 
 // Utility functions for working with Tesseract parameters.
@@ -70,8 +125,17 @@ class ParamUtils {
                        ParamsVectors *member_params);
 
   // Returns the pointer to the parameter with the given name (of the
-  // appropriate type) if it was found in the vector obtained from
-  // GlobalParams() or in the given member_params.
+  // appropriate type) if it was found in the index of the params obtained
+  // from GlobalParams() or in the given member_index, which may be NULL.
+  template<class T>
+  static T *FindParam(const char *name, const ParamIndex<T> &global_index,
+                      const ParamIndex<T> *member_index) {
+    T *param = global_index.Find(name);
+    if (param == NULL && member_index != NULL)
+      param = member_index->Find(name);
+    return param;
+  }
+  // As above, but with a linear search of the given vectors.
   template<class T>
   static T *FindParam(const char *name,
                       const GenericVector<T *> &global_vec,
@@ -146,9 +210,14 @@ class IntParam : public Param {
     value_ = value;
     default_ = value;
     params_vec_ = &(vec->int_params);
+    params_index_ = &(vec->int_index);
     vec->int_params.push_back(this);
+    vec->int_index.Add(this);
+  }
+  ~IntParam() {
+    ParamUtils::RemoveParam<IntParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
-  ~IntParam() { ParamUtils::RemoveParam<IntParam>(this, params_vec_); }
   operator inT32() const { return value_; }
   void operator=(inT32 value) { value_ = value; }
   void set_value(inT32 value) { value_ = value; }
@@ -161,6 +230,8 @@ class IntParam : public Param {
   inT32 default_;
   // Pointer to the vector that contains this param (not owened by this class).
   GenericVector<IntParam *> *params_vec_;
+  // Pointer to the name index that contains this param (not owned).
+  ParamIndex<IntParam> *params_index_;
 };
 
 class BoolParam : public Param {
@@ -170,9 +241,14 @@ class BoolParam : public Param {
     value_ = value;
     default_ = value;
     params_vec_ = &(vec->bool_params);
+    params_index_ = &(vec->bool_index);
     vec->bool_params.push_back(this);
+    vec->bool_index.Add(this);
+  }
+  ~BoolParam() {
+    ParamUtils::RemoveParam<BoolParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
-  ~BoolParam() { ParamUtils::RemoveParam<BoolParam>(this, params_vec_); }
   operator BOOL8() const { return value_; }
   void operator=(BOOL8 value) { value_ = value; }
   void set_value(BOOL8 value) { value_ = value; }
@@ -185,6 +261,8 @@ class BoolParam : public Param {
   BOOL8 default_;
   // Pointer to the vector that contains this param (not owned by this class).
   GenericVector<BoolParam *> *params_vec_;
+  // Pointer to the name index that contains this param (not owned).
+  ParamIndex<BoolParam> *params_index_;
 };
 
 class StringParam : public Param {
@@ -195,9 +273,14 @@ class StringParam : public Param {
     value_ = value;
     default_ = value;
     params_vec_ = &(vec->string_params);
+    params_index_ = &(vec->string_index);
     vec->string_params.push_back(this);
+    vec->string_index.Add(this);
+  }
+  ~StringParam() {
+    ParamUtils::RemoveParam<StringParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
-  ~StringParam() { ParamUtils::RemoveParam<StringParam>(this, params_vec_); }
   operator STRING &() { return value_; }
   const char *string() const { return value_.string(); }
   const char *c_str() const { return value_.string(); }
@@ -214,6 +297,8 @@ class StringParam : public Param {
   STRING default_;
   // Pointer to the vector that contains this param (not owened by this class).
   GenericVector<StringParam *> *params_vec_;
+  // Pointer to the name index that contains this param (not owned).
+  ParamIndex<StringParam> *params_index_;
 };
 
 class DoubleParam : public Param {
@@ -223,9 +308,14 @@ class DoubleParam : public Param {
     value_ = value;
     default_ = value;
     params_vec_ = &(vec->double_params);
+    params_index_ = &(vec->double_index);
     vec->double_params.push_back(this);
+    vec->double_index.Add(this);
+  }
+  ~DoubleParam() {
+    ParamUtils::RemoveParam<DoubleParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
-  ~DoubleParam() { ParamUtils::RemoveParam<DoubleParam>(this, params_vec_); }
   operator double() const { return value_; }
   void operator=(double value) { value_ = value; }
   void set_value(double value) { value_ = value; }
@@ -238,6 +328,8 @@ class DoubleParam : public Param {
   double default_;
   // Pointer to the vector that contains this param (not owned by this class).
   GenericVector<DoubleParam *> *params_vec_;
+  // Pointer to the name index that contains this param (not owned).
+  ParamIndex<DoubleParam> *params_index_;
 };
 
 }  // namespace tesseract
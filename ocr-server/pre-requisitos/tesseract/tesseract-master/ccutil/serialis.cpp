@@ -94,14 +94,43 @@ char* TFile::FGets(char* buffer, int buffer_size) {
   return size > 0 ? buffer : NULL;
 }
 
-int TFile::FReadEndian(void* buffer, int size, int count) {
-  int num_read = FRead(buffer, size, count);
-  if (swap_) {
-    char* char_buffer = static_cast<char*>(buffer);
-    for (int i = 0; i < num_read; ++i, char_buffer += size) {
-      ReverseN(char_buffer, size);
+// Reverses the bytes of each of the count elements of the given size in
+// buffer. The common sizes use whole-word byte swaps, written so that the
+// compiler turns them into bswap instructions, or vectorizes the loop.
+static void ReverseElements(char* buffer, int size, int count) {
+  if (size == 2) {
+    for (int i = 0; i < count; ++i, buffer += size) {
+      uinT16 v;
+      memcpy(&v, buffer, sizeof(v));
+      v = static_cast<uinT16>((v >> 8) | (v << 8));
+      memcpy(buffer, &v, sizeof(v));
+    }
+  } else if (size == 4) {
+    for (int i = 0; i < count; ++i, buffer += size) {
+      uinT32 v;
+      memcpy(&v, buffer, sizeof(v));
+      v = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+      memcpy(buffer, &v, sizeof(v));
     }
+  } else if (size == 8) {
+    for (int i = 0; i < count; ++i, buffer += size) {
+      uinT64 v;
+      memcpy(&v, buffer, sizeof(v));
+      v = ((v & 0x00000000ffffffffULL) << 32) | (v >> 32);
+      v = ((v & 0x0000ffff0000ffffULL) << 16) |
+          ((v >> 16) & 0x0000ffff0000ffffULL);
+      v = ((v & 0x00ff00ff00ff00ffULL) << 8) |
+          ((v >> 8) & 0x00ff00ff00ff00ffULL);
+      memcpy(buffer, &v, sizeof(v));
+    }
+  } else if (size > 1) {
+    for (int i = 0; i < count; ++i, buffer += size) ReverseN(buffer, size);
   }
+}
+
+int TFile::FReadEndian(void* buffer, int size, int count) {
+  int num_read = FRead(buffer, size, count);
+  if (swap_) ReverseElements(static_cast<char*>(buffer), size, num_read);
   return num_read;
 }
 
@@ -122,6 +151,11 @@ void TFile::Rewind() {
   offset_ = 0;
 }
 
+int TFile::remaining() const {
+  ASSERT_HOST(!is_writing_);
+  return data_ == NULL ? 0 : data_->size() - offset_;
+}
+
 void TFile::OpenWrite(GenericVector<char>* data) {
   offset_ = 0;
   if (data != NULL) {
@@ -78,6 +78,8 @@ class TFile {
   // Resets the TFile as if it has been Opened, but nothing read.
   // Only allowed while reading!
   void Rewind();
+  // Returns the number of bytes not yet read. Only allowed while reading!
+  int remaining() const;
 
   // Open for writing. Either supply a non-NULL data with OpenWrite before
   // calling FWrite, (no close required), or supply a NULL data to OpenWrite
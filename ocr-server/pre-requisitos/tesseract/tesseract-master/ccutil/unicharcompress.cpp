@@ -30,6 +30,9 @@ namespace tesseract {
 const char* kNullChar = "<nul>";
 // Radix to make unique values from the stored radical codes.
 const int kRadicalRadix = 29;
+// Max number of codes in a decoder trie node to search linearly instead of
+// with a binary search.
+const int kMaxLinearSearch = 16;
 
 // "Hash" function for const std::vector<int> computes the sum of elements.
 // Build a unique number for each code sequence that we can use as the index in
@@ -297,9 +300,25 @@ int UnicharCompress::EncodeUnichar(int unichar_id, RecodedCharID* code) const {
 int UnicharCompress::DecodeUnichar(const RecodedCharID& code) const {
   int len = code.length();
   if (len <= 0 || len > RecodedCharID::kMaxCodeLen) return INVALID_UNICHAR_ID;
-  auto it = decoder_.find(code);
-  if (it == decoder_.end()) return INVALID_UNICHAR_ID;
-  return it->second;
+  int node = FindNode(code, len - 1);
+  if (node < 0) return INVALID_UNICHAR_ID;
+  int index = FindInNode(final_starts_, final_codes_, final_sorted_,
+                         final_root_, node, code(len - 1));
+  if (index < 0) return INVALID_UNICHAR_ID;
+  return final_unichar_ids_[index];
+}
+
+// Returns the number of bytes used by the encoder and decoder tables.
+int UnicharCompress::MemoryUsed() const {
+  int total = encoder_.size_reserved() * sizeof(RecodedCharID) +
+              is_valid_start_.size_reserved() * sizeof(bool);
+  const GenericVector<int>* tables[] = {
+      &next_starts_,  &next_codes_,  &next_nodes_,        &next_sorted_,
+      &final_starts_, &final_codes_, &final_unichar_ids_, &final_sorted_,
+      &next_root_,    &final_root_};
+  for (const GenericVector<int>* table : tables)
+    total += table->size_reserved() * sizeof(int);
+  return total;
 }
 
 // Writes to the given file. Returns false in case of error.
@@ -375,56 +394,151 @@ void UnicharCompress::ComputeCodeRange() {
   ++code_range_;
 }
 
-// Initializes the decoding hash_map from the encoding array.
+// Helper sorts the indices of each node range of codes by code, so that
+// FindInNode can binary search, while codes keeps its first-use order.
+// The root node is instead indexed directly by code in *root.
+static void IndexNodeRanges(const GenericVector<int>& starts,
+                            const GenericVector<int>& codes, int code_range,
+                            GenericVector<int>* sorted,
+                            GenericVector<int>* root) {
+  root->init_to_size(code_range, -1);
+  for (int i = starts[0]; i < starts[1]; ++i) (*root)[codes[i]] = i;
+  sorted->init_to_size(codes.size(), 0);
+  for (int i = 0; i < codes.size(); ++i) (*sorted)[i] = i;
+  for (int n = 1; n + 1 < starts.size(); ++n) {
+    if (starts[n + 1] - starts[n] < 2) continue;
+    std::sort(&(*sorted)[0] + starts[n], &(*sorted)[0] + starts[n + 1],
+              [&codes](int a, int b) { return codes[a] < codes[b]; });
+  }
+}
+
+// Initializes the decoding trie from the encoding array.
 void UnicharCompress::SetupDecoder() {
   Cleanup();
   is_valid_start_.init_to_size(code_range_, false);
+  // Build the trie edges in first-use order, keyed by node * code_range_ +
+  // code, then flatten them into the per-node ranges.
+  std::unordered_map<int64_t, int> next_map, final_map;
+  GenericVector<int> edge_parents, edge_codes;
+  GenericVector<int> end_parents, end_codes, end_ids;
+  int num_nodes = 1;
   for (int c = 0; c < encoder_.size(); ++c) {
     const RecodedCharID& code = encoder_[c];
-    decoder_[code] = c;
+    int len = code.length();
+    if (len <= 0) continue;
     is_valid_start_[code(0)] = true;
-    RecodedCharID prefix = code;
-    int len = code.length() - 1;
-    prefix.Truncate(len);
-    auto final_it = final_codes_.find(prefix);
-    if (final_it == final_codes_.end()) {
-      GenericVectorEqEq<int>* code_list = new GenericVectorEqEq<int>;
-      code_list->push_back(code(len));
-      final_codes_[prefix] = code_list;
-      while (--len >= 0) {
-        prefix.Truncate(len);
-        auto next_it = next_codes_.find(prefix);
-        if (next_it == next_codes_.end()) {
-          GenericVectorEqEq<int>* code_list = new GenericVectorEqEq<int>;
-          code_list->push_back(code(len));
-          next_codes_[prefix] = code_list;
-        } else {
-          // We still have to search the list as we may get here via multiple
-          // lengths of code.
-          if (!next_it->second->contains(code(len)))
-            next_it->second->push_back(code(len));
-          break;  // This prefix has been processed.
-        }
+    int node = 0;
+    for (int i = 0; i + 1 < len; ++i) {
+      int64_t key = static_cast<int64_t>(node) * code_range_ + code(i);
+      auto it = next_map.find(key);
+      if (it == next_map.end()) {
+        edge_parents.push_back(node);
+        edge_codes.push_back(code(i));
+        it = next_map.insert(std::make_pair(key, num_nodes++)).first;
       }
+      node = it->second;
+    }
+    int64_t key = static_cast<int64_t>(node) * code_range_ + code(len - 1);
+    auto it = final_map.find(key);
+    if (it == final_map.end()) {
+      final_map[key] = end_ids.size();
+      end_parents.push_back(node);
+      end_codes.push_back(code(len - 1));
+      end_ids.push_back(c);
     } else {
-      if (!final_it->second->contains(code(len)))
-        final_it->second->push_back(code(len));
+      // Duplicate codes decode to the last unichar-id that uses them.
+      end_ids[it->second] = c;
+    }
+  }
+  // Counting sort of the edges by parent node, which keeps first-use order
+  // within each node. Edge e leads to node e + 1.
+  next_starts_.init_to_size(num_nodes + 1, 0);
+  for (int e = 0; e < edge_parents.size(); ++e)
+    ++next_starts_[edge_parents[e] + 1];
+  for (int n = 0; n < num_nodes; ++n) next_starts_[n + 1] += next_starts_[n];
+  next_codes_.init_to_size(edge_codes.size(), 0);
+  next_nodes_.init_to_size(edge_codes.size(), 0);
+  GenericVector<int> fill(next_starts_);
+  for (int e = 0; e < edge_parents.size(); ++e) {
+    int index = fill[edge_parents[e]]++;
+    next_codes_[index] = edge_codes[e];
+    next_nodes_[index] = e + 1;
+  }
+  final_starts_.init_to_size(num_nodes + 1, 0);
+  for (int e = 0; e < end_parents.size(); ++e)
+    ++final_starts_[end_parents[e] + 1];
+  for (int n = 0; n < num_nodes; ++n) final_starts_[n + 1] += final_starts_[n];
+  final_codes_.init_to_size(end_codes.size(), 0);
+  final_unichar_ids_.init_to_size(end_codes.size(), 0);
+  fill = final_starts_;
+  for (int e = 0; e < end_parents.size(); ++e) {
+    int index = fill[end_parents[e]]++;
+    final_codes_[index] = end_codes[e];
+    final_unichar_ids_[index] = end_ids[e];
+  }
+  IndexNodeRanges(next_starts_, next_codes_, code_range_, &next_sorted_,
+                  &next_root_);
+  IndexNodeRanges(final_starts_, final_codes_, code_range_, &final_sorted_,
+                  &final_root_);
+}
+
+// Returns the trie node reached by the first length codes of code, or -1
+// if there is no such prefix.
+int UnicharCompress::FindNode(const RecodedCharID& code, int length) const {
+  if (next_starts_.empty()) return -1;
+  int node = 0;
+  for (int i = 0; i < length; ++i) {
+    int index = FindInNode(next_starts_, next_codes_, next_sorted_,
+                           next_root_, node, code(i));
+    if (index < 0) return -1;
+    node = next_nodes_[index];
+  }
+  return node;
+}
+
+// Returns the index in codes of the given code within the range of node,
+// using root for node 0 and otherwise binary searching the code-sorted
+// index, or -1 if not found.
+/* static */
+int UnicharCompress::FindInNode(const GenericVector<int>& starts,
+                                const GenericVector<int>& codes,
+                                const GenericVector<int>& sorted,
+                                const GenericVector<int>& root, int node,
+                                int code) {
+  if (node == 0) return 0 <= code && code < root.size() ? root[code] : -1;
+  int start = starts[node];
+  int end = starts[node + 1];
+  if (end - start <= kMaxLinearSearch) {
+    for (int i = start; i < end; ++i) {
+      if (codes[i] == code) return i;
     }
+    return -1;
+  }
+  while (start < end) {
+    int mid = (start + end) / 2;
+    int index = sorted[mid];
+    if (codes[index] == code) return index;
+    if (codes[index] < code)
+      start = mid + 1;
+    else
+      end = mid;
   }
+  return -1;
 }
 
 // Frees allocated memory.
 void UnicharCompress::Cleanup() {
-  decoder_.clear();
   is_valid_start_.clear();
-  for (auto it = next_codes_.begin(); it != next_codes_.end(); ++it) {
-    delete it->second;
-  }
-  for (auto it = final_codes_.begin(); it != final_codes_.end(); ++it) {
-    delete it->second;
-  }
+  next_starts_.clear();
   next_codes_.clear();
+  next_nodes_.clear();
+  next_sorted_.clear();
+  final_starts_.clear();
   final_codes_.clear();
+  final_unichar_ids_.clear();
+  final_sorted_.clear();
+  next_root_.clear();
+  final_root_.clear();
 }
 
 }  // namespace tesseract.
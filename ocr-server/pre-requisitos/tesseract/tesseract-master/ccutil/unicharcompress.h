@@ -175,17 +175,23 @@ class UnicharCompress {
   // Returns true if the given code is a valid start or single code.
   bool IsValidFirstCode(int code) const { return is_valid_start_[code]; }
   // Returns a list of valid non-final next codes for a given prefix code,
-  // which may be empty.
-  const GenericVector<int>* GetNextCodes(const RecodedCharID& code) const {
-    auto it = next_codes_.find(code);
-    return it == next_codes_.end() ? NULL : it->second;
+  // with the length of the list in *num_codes, or NULL if there are none.
+  const int* GetNextCodes(const RecodedCharID& code, int* num_codes) const {
+    int node = FindNode(code, code.length());
+    if (node < 0) return NULL;
+    *num_codes = next_starts_[node + 1] - next_starts_[node];
+    return *num_codes > 0 ? &next_codes_[next_starts_[node]] : NULL;
   }
-  // Returns a list of valid final codes for a given prefix code, which may
-  // be empty.
-  const GenericVector<int>* GetFinalCodes(const RecodedCharID& code) const {
-    auto it = final_codes_.find(code);
-    return it == final_codes_.end() ? NULL : it->second;
+  // Returns a list of valid final codes for a given prefix code, with the
+  // length of the list in *num_codes, or NULL if there are none.
+  const int* GetFinalCodes(const RecodedCharID& code, int* num_codes) const {
+    int node = FindNode(code, code.length());
+    if (node < 0) return NULL;
+    *num_codes = final_starts_[node + 1] - final_starts_[node];
+    return *num_codes > 0 ? &final_codes_[final_starts_[node]] : NULL;
   }
+  // Returns the number of bytes used by the encoder and decoder tables.
+  int MemoryUsed() const;
 
   // Writes to the given file. Returns false in case of error.
   bool Serialize(TFile* fp) const;
@@ -213,29 +219,50 @@ class UnicharCompress {
   void DefragmentCodeValues(int encoded_null);
   // Computes the value of code_range_ from the encoder_.
   void ComputeCodeRange();
-  // Initializes the decoding hash_map from the encoder_ array.
+  // Initializes the decoding trie from the encoder_ array.
   void SetupDecoder();
   // Frees allocated memory.
   void Cleanup();
+  // Returns the trie node reached by the first length codes of code, or -1
+  // if there is no such prefix.
+  int FindNode(const RecodedCharID& code, int length) const;
+  // Returns the index in codes of the given code within the range of node,
+  // using root for node 0 and otherwise binary searching the code-sorted
+  // index, or -1 if not found.
+  static int FindInNode(const GenericVector<int>& starts,
+                        const GenericVector<int>& codes,
+                        const GenericVector<int>& sorted,
+                        const GenericVector<int>& root, int node, int code);
 
   // The encoder that maps a unichar-id to a sequence of small codes.
   // encoder_ is the only part that is serialized. The rest is computed on load.
   GenericVector<RecodedCharID> encoder_;
-  // Decoder converts the output of encoder back to a unichar-id.
-  std::unordered_map<RecodedCharID, int, RecodedCharID::RecodedCharIDHash>
-      decoder_;
   // True if the index is a valid single or start code.
   GenericVector<bool> is_valid_start_;
-  // Maps a prefix code to a list of valid next codes.
-  // The map owns the vectors.
-  std::unordered_map<RecodedCharID, GenericVectorEqEq<int>*,
-                     RecodedCharID::RecodedCharIDHash>
-      next_codes_;
-  // Maps a prefix code to a list of valid final codes.
-  // The map owns the vectors.
-  std::unordered_map<RecodedCharID, GenericVectorEqEq<int>*,
-                     RecodedCharID::RecodedCharIDHash>
-      final_codes_;
+  // The decoder is a trie of code prefixes, with node 0 being the empty
+  // prefix, stored in compressed-row form, so there is no per-prefix
+  // allocation, even for alphabets of tens of thousands of unichars.
+  // The valid non-final next codes of node n are in
+  // next_codes_[next_starts_[n], next_starts_[n + 1]), in order of first use
+  // in encoder_, with the node that each leads to in next_nodes_.
+  GenericVector<int> next_starts_;
+  GenericVector<int> next_codes_;
+  GenericVector<int> next_nodes_;
+  // Indices into next_codes_ within each node range, sorted by code, for
+  // binary search.
+  GenericVector<int> next_sorted_;
+  // The valid final codes of node n are in
+  // final_codes_[final_starts_[n], final_starts_[n + 1]), with the unichar-id
+  // that each decodes to in final_unichar_ids_.
+  GenericVector<int> final_starts_;
+  GenericVector<int> final_codes_;
+  GenericVector<int> final_unichar_ids_;
+  // Indices into final_codes_ within each node range, sorted by code.
+  GenericVector<int> final_sorted_;
+  // The root node holds every single and start code, so it is indexed
+  // directly by code to give the index in next_codes_/final_codes_, or -1.
+  GenericVector<int> next_root_;
+  GenericVector<int> final_root_;
   // Max of any value in encoder_ + 1.
   int code_range_;
 };
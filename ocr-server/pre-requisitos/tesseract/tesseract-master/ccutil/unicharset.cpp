@@ -44,6 +44,12 @@ static const int ISUPPER_MASK = 0x4;
 static const int ISDIGIT_MASK = 0x8;
 static const int ISPUNCTUATION_MASK = 0x10;
 
+// First line of a binary format unicharset, chosen so that the text parser
+// of older versions rejects it cleanly. It is followed by kBinaryVersion and
+// the size of the rest in bytes, so a reader of a FILE knows where it ends.
+static const char kBinaryMagic[] = "#binary unicharset\n";
+static const inT32 kBinaryVersion = 2;
+
 // Y coordinate threshold for determining cap-height vs x-height.
 // TODO(rays) Bring the global definition down to the ccutil library level,
 // so this constant is relative to some other constants.
@@ -751,6 +757,12 @@ class InMemoryFilePointer {
 
 bool UNICHARSET::load_from_inmemory_file(
     const char *memory, int mem_size, bool skip_fragments) {
+  int magic_length = strlen(kBinaryMagic);
+  if (mem_size >= magic_length &&
+      memcmp(memory, kBinaryMagic, magic_length) == 0) {
+    tesseract::TFile fp;
+    return fp.Open(memory, mem_size) && load_from_file(&fp, skip_fragments);
+  }
   InMemoryFilePointer mem_fp(memory, mem_size);
   TessResultCallback2<char *, char *, int> *fgets_cb =
       NewPermanentTessCallback(&mem_fp, &InMemoryFilePointer::fgets);
@@ -770,6 +782,23 @@ class LocalFilePointer {
 };
 
 bool UNICHARSET::load_from_file(FILE *file, bool skip_fragments) {
+  // Check for the binary format, and otherwise rewind to parse the text.
+  long start = ftell(file);
+  char buffer[sizeof(kBinaryMagic)];
+  if (fgets(buffer, sizeof(buffer), file) != NULL &&
+      strcmp(buffer, kBinaryMagic) == 0) {
+    // Read just the version, size and body, leaving the file after them for
+    // the caller to read whatever follows.
+    long body_start = ftell(file);
+    inT32 header[2];
+    if (fread(header, sizeof(header[0]), 2, file) != 2 || header[1] < 0 ||
+        fseek(file, body_start, SEEK_SET) != 0)
+      return false;
+    tesseract::TFile fp;
+    return fp.Open(file, body_start + sizeof(header) + header[1]) &&
+           load_binary(&fp, skip_fragments);
+  }
+  if (fseek(file, start, SEEK_SET) != 0) return false;
   LocalFilePointer lfp(file);
   TessResultCallback2<char *, char *, int> *fgets_cb =
       NewPermanentTessCallback(&lfp, &LocalFilePointer::fgets);
@@ -778,14 +807,176 @@ bool UNICHARSET::load_from_file(FILE *file, bool skip_fragments) {
   return success;
 }
 
+// Wraps a TFile for load_via_fgets, returning a line that has already been
+// read as the first line.
+class PushbackFilePointer {
+ public:
+  PushbackFilePointer(tesseract::TFile *file, const char *first_line)
+      : file_(file), first_line_(first_line) {}
+  char *fgets(char *dst, int size) {
+    if (first_line_ == NULL) return file_->FGets(dst, size);
+    if (size < 1) return dst;
+    strncpy(dst, first_line_, size - 1);
+    dst[size - 1] = '\0';
+    first_line_ = NULL;
+    return dst;
+  }
+
+ private:
+  tesseract::TFile *file_;
+  const char *first_line_;
+};
+
 bool UNICHARSET::load_from_file(tesseract::TFile *file, bool skip_fragments) {
+  char first_line[256];
+  if (file->FGets(first_line, sizeof(first_line)) == NULL) return false;
+  if (strcmp(first_line, kBinaryMagic) == 0)
+    return load_binary(file, skip_fragments);
+  PushbackFilePointer pfp(file, first_line);
   TessResultCallback2<char *, char *, int> *fgets_cb =
-      NewPermanentTessCallback(file, &tesseract::TFile::FGets);
+      NewPermanentTessCallback(&pfp, &PushbackFilePointer::fgets);
   bool success = load_via_fgets(fgets_cb, skip_fragments);
   delete fgets_cb;
   return success;
 }
 
+// Saves the content of the UNICHARSET to the given file in the binary
+// format, which holds exactly the same information as the text format, but
+// loads several times faster. load_from_file recognizes either format.
+// The layout, after the magic line, version and size of the rest, is the
+// script table as a count and STRINGs, followed by the unichar count and, for each unichar,
+// its representation, properties, top/bottom, the width, bearing and
+// advance stats, script_id, other_case, direction, mirror and normed string.
+bool UNICHARSET::save_binary(tesseract::TFile *file) const {
+  // The body is built first, as its size precedes it.
+  GenericVector<char> body;
+  tesseract::TFile body_fp;
+  body_fp.OpenWrite(&body);
+  if (!save_binary_body(&body_fp)) return false;
+  int magic_length = strlen(kBinaryMagic);
+  inT32 body_size = body.size();
+  return file->FWrite(kBinaryMagic, 1, magic_length) == magic_length &&
+         file->FWrite(&kBinaryVersion, sizeof(kBinaryVersion), 1) == 1 &&
+         file->FWrite(&body_size, sizeof(body_size), 1) == 1 &&
+         file->FWrite(&body[0], 1, body_size) == body_size;
+}
+
+// Writes the part of the binary format after the size.
+bool UNICHARSET::save_binary_body(tesseract::TFile *file) const {
+  inT32 num_scripts = script_table_size_used;
+  if (file->FWrite(&num_scripts, sizeof(num_scripts), 1) != 1) return false;
+  for (int s = 0; s < num_scripts; ++s) {
+    if (!STRING(script_table[s]).Serialize(file)) return false;
+  }
+  inT32 num_unichars = size_used;
+  if (file->FWrite(&num_unichars, sizeof(num_unichars), 1) != 1) return false;
+  for (UNICHAR_ID id = 0; id < size_used; ++id) {
+    if (!STRING(id_to_unichar(id)).Serialize(file)) return false;
+    uinT32 properties = get_properties(id);
+    if (file->FWrite(&properties, sizeof(properties), 1) != 1) return false;
+    int min_bottom, max_bottom, min_top, max_top;
+    get_top_bottom(id, &min_bottom, &max_bottom, &min_top, &max_top);
+    uinT8 top_bottom[4] = {static_cast<uinT8>(min_bottom),
+                           static_cast<uinT8>(max_bottom),
+                           static_cast<uinT8>(min_top),
+                           static_cast<uinT8>(max_top)};
+    if (file->FWrite(top_bottom, sizeof(top_bottom), 1) != 1) return false;
+    float stats[6];
+    get_width_stats(id, &stats[0], &stats[1]);
+    get_bearing_stats(id, &stats[2], &stats[3]);
+    get_advance_stats(id, &stats[4], &stats[5]);
+    if (file->FWrite(stats, sizeof(stats[0]), 6) != 6) return false;
+    inT32 ids[4] = {get_script(id), get_other_case(id), get_direction(id),
+                    get_mirror(id)};
+    if (file->FWrite(ids, sizeof(ids[0]), 4) != 4) return false;
+    if (!STRING(get_normed_unichar(id)).Serialize(file)) return false;
+  }
+  return true;
+}
+
+// Loads the rest of a binary format file, after its magic line, performing
+// the same insertions and property settings as load_via_fgets. Reads exactly
+// the size given in the file, and fails if the content doesn't fill it.
+bool UNICHARSET::load_binary(tesseract::TFile *file, bool skip_fragments) {
+  this->clear();
+  inT32 version, body_size;
+  if (file->FReadEndian(&version, sizeof(version), 1) != 1) return false;
+  if (version != kBinaryVersion) {
+    tprintf("Unsupported binary unicharset version %d\n", version);
+    return false;
+  }
+  if (file->FReadEndian(&body_size, sizeof(body_size), 1) != 1 ||
+      body_size < 0 || body_size > file->remaining())
+    return false;
+  int end_remaining = file->remaining() - body_size;
+  inT32 num_scripts;
+  if (file->FReadEndian(&num_scripts, sizeof(num_scripts), 1) != 1 ||
+      num_scripts < 0)
+    return false;
+  GenericVector<STRING> scripts;
+  scripts.init_to_size(num_scripts, STRING());
+  for (int s = 0; s < num_scripts; ++s) {
+    if (!scripts[s].DeSerialize(file)) return false;
+  }
+  inT32 unicharset_size;
+  if (file->FReadEndian(&unicharset_size, sizeof(unicharset_size), 1) != 1 ||
+      unicharset_size < 0)
+    return false;
+  this->reserve(unicharset_size);
+  STRING unichar, normed;
+  for (UNICHAR_ID id = 0; id < unicharset_size; ++id) {
+    uinT32 properties;
+    uinT8 top_bottom[4];
+    float stats[6];
+    inT32 ids[4];
+    if (!unichar.DeSerialize(file) ||
+        file->FReadEndian(&properties, sizeof(properties), 1) != 1 ||
+        file->FRead(top_bottom, sizeof(top_bottom), 1) != 1 ||
+        file->FReadEndian(stats, sizeof(stats[0]), 6) != 6 ||
+        file->FReadEndian(ids, sizeof(ids[0]), 4) != 4 ||
+        !normed.DeSerialize(file) || ids[0] < 0 || ids[0] >= num_scripts)
+      return false;
+    // Skip fragments if needed.
+    CHAR_FRAGMENT *frag = NULL;
+    if (skip_fragments &&
+        (frag = CHAR_FRAGMENT::parse_from_string(unichar.string()))) {
+      int num_pieces = frag->get_total();
+      delete frag;
+      // Skip multi-element fragments, but keep singles like UNICHAR_BROKEN in.
+      if (num_pieces > 1)
+        continue;
+    }
+    // Insert unichar into unicharset and set its properties.
+    if (strcmp(unichar.string(), " ") == 0)
+      this->unichar_insert(" ");
+    else
+      this->unichar_insert_backwards_compatible(unichar.string());
+
+    this->set_isalpha(id, properties & ISALPHA_MASK);
+    this->set_islower(id, properties & ISLOWER_MASK);
+    this->set_isupper(id, properties & ISUPPER_MASK);
+    this->set_isdigit(id, properties & ISDIGIT_MASK);
+    this->set_ispunctuation(id, properties & ISPUNCTUATION_MASK);
+    this->set_isngram(id, false);
+    this->set_script(id, scripts[ids[0]].string());
+    this->unichars[id].properties.enabled = true;
+    this->set_top_bottom(id, top_bottom[0], top_bottom[1], top_bottom[2],
+                         top_bottom[3]);
+    this->set_width_stats(id, stats[0], stats[1]);
+    this->set_bearing_stats(id, stats[2], stats[3]);
+    this->set_advance_stats(id, stats[4], stats[5]);
+    this->set_direction(id, static_cast<UNICHARSET::Direction>(ids[2]));
+    this->set_other_case(
+        id, (ids[1] >= 0 && ids[1] < unicharset_size) ? ids[1] : id);
+    this->set_mirror(id,
+                     (ids[3] >= 0 && ids[3] < unicharset_size) ? ids[3] : id);
+    this->set_normed(id, normed.string());
+  }
+  if (file->remaining() != end_remaining) return false;
+  post_load_setup();
+  return true;
+}
+
 bool UNICHARSET::load_via_fgets(
     TessResultCallback2<char *, char *, int> *fgets_cb,
     bool skip_fragments) {
@@ -367,6 +367,12 @@ class UNICHARSET {
     return true;
   }
 
+  // Saves the content of the UNICHARSET to the given file in the binary
+  // format, which holds exactly the same information as the text format, but
+  // loads several times faster. load_from_file recognizes either format.
+  // Returns true if the operation is successful.
+  bool save_binary(tesseract::TFile *file) const;
+
   // Saves the content of the UNICHARSET to the given STRING.
   // Returns true if the operation is successful.
   bool save_to_string(STRING *str) const;
@@ -1003,6 +1009,10 @@ class UNICHARSET {
   // the public routines load_from_file() and load_from_inmemory_file().
   bool load_via_fgets(TessResultCallback2<char *, char *, int> *fgets_cb,
                       bool skip_fragments);
+  // Writes the part of the binary format that follows its size.
+  bool save_binary_body(tesseract::TFile *file) const;
+  // Loads the rest of a binary format file, after its magic line.
+  bool load_binary(tesseract::TFile *file, bool skip_fragments);
 
   // List of mappings to make when ingesting strings from the outside.
   // The substitutions clean up text that should exists for rendering of
@@ -420,12 +420,20 @@ void Classify::LearnPieces(const char* fontname, int start, int length,
               unicharset.id_to_unichar(class_id), threshold, font_id);
     // If filename is not NULL we are doing recognition
     // (as opposed to training), so we must have already set word fonts.
-    AdaptToChar(rotated_blob, class_id, font_id, threshold, AdaptedTemplates);
-    if (BackupAdaptedTemplates != NULL) {
-      // Adapt the backup templates too. They will be used if the primary gets
-      // too full.
+    if (classify_defer_adaption) {
+      // Keep an unrotated copy. The word's C_OUTLINEs may not outlive the
+      // current pass, eg the temporary words of ReassignDiacritics.
+      deferred_adaptions_.push_back(
+          new AdaptionEvent(*blob, class_id, font_id, threshold));
+    } else {
       AdaptToChar(rotated_blob, class_id, font_id, threshold,
-                  BackupAdaptedTemplates);
+                  AdaptedTemplates);
+      if (BackupAdaptedTemplates != NULL) {
+        // Adapt the backup templates too. They will be used if the primary
+        // gets too full.
+        AdaptToChar(rotated_blob, class_id, font_id, threshold,
+                    BackupAdaptedTemplates);
+      }
     }
   } else if (classify_debug_level >= 1) {
     tprintf("Can't adapt to %s not in unicharset\n", correct_text);
@@ -438,6 +446,76 @@ void Classify::LearnPieces(const char* fontname, int start, int length,
                     start + length - 1);
 }  // LearnPieces.
 
+// Copies word_blob, and gives the copy its own copies of the C_OUTLINEs that
+// its points refer to, as they are needed to extract the same features as
+// adaption to word_blob would.
+AdaptionEvent::AdaptionEvent(const TBLOB& word_blob, CLASS_ID id, int font,
+                             float thr)
+  : blob(new TBLOB(word_blob)), class_id(id), font_id(font), threshold(thr) {
+  GenericVector<C_OUTLINE*> sources;
+  GenericVector<C_OUTLINE*> copies;
+  C_OUTLINE_IT ol_it(&outlines);
+  for (TESSLINE* ol = blob->outlines; ol != NULL; ol = ol->next) {
+    EDGEPT* pt = ol->loop;
+    do {
+      if (pt->src_outline != NULL) {
+        int index = 0;
+        while (index < sources.size() && sources[index] != pt->src_outline)
+          ++index;
+        if (index == sources.size()) {
+          C_OUTLINE* copy = C_OUTLINE::deep_copy(pt->src_outline);
+          // Holes have their own TESSLINEs, so they are copied on their own.
+          copy->child()->clear();
+          ol_it.add_to_end(copy);
+          sources.push_back(pt->src_outline);
+          copies.push_back(copy);
+        }
+        pt->src_outline = copies[index];
+      }
+      pt = pt->next;
+    } while (pt != ol->loop);
+  }
+}
+
+AdaptionEvent::~AdaptionEvent() {
+  delete blob;
+}
+
+// Applies, in the order they were queued, all the adaptions deferred by
+// classify_defer_adaption to the adapted (and backup) templates, then
+// empties the queue. Queue order is word order, so the result does not depend
+// on how the words of the pass were scheduled.
+void Classify::ApplyDeferredAdaption() {
+  if (classify_learning_debug_level >= 1 && !deferred_adaptions_.empty()) {
+    tprintf("Applying %d deferred adaptions\n", deferred_adaptions_.size());
+  }
+  for (int i = 0; i < deferred_adaptions_.size(); ++i) {
+    const AdaptionEvent* event = deferred_adaptions_[i];
+    TBLOB* rotated_blob = event->blob->ClassifyNormalizeIfNeeded();
+    if (rotated_blob == NULL)
+      rotated_blob = event->blob;
+    AdaptToChar(rotated_blob, event->class_id, event->font_id,
+                event->threshold, AdaptedTemplates);
+    if (BackupAdaptedTemplates != NULL) {
+      AdaptToChar(rotated_blob, event->class_id, event->font_id,
+                  event->threshold, BackupAdaptedTemplates);
+    }
+    if (rotated_blob != event->blob)
+      delete rotated_blob;
+  }
+  deferred_adaptions_.clear();
+}
+
+// Returns the name of the file used to load and save adapted templates.
+static STRING AdaptedTemplatesFilename(const char* templates_file,
+                                       const STRING& imagefile) {
+  if (templates_file != NULL && templates_file[0] != '\0')
+    return STRING(templates_file);
+  STRING filename = imagefile;
+  filename += ADAPT_TEMPLATE_SUFFIX;
+  return filename;
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine performs cleanup operations
@@ -459,7 +537,8 @@ void Classify::EndAdaptiveClassifier() {
 
   if (AdaptedTemplates != NULL &&
       classify_enable_adaptive_matcher && classify_save_adapted_templates) {
-    Filename = imagefile + ADAPT_TEMPLATE_SUFFIX;
+    Filename = AdaptedTemplatesFilename(
+        classify_adapted_templates_file.string(), imagefile);
     File = fopen (Filename.string(), "wb");
     if (File == NULL)
       cprintf ("Unable to save adapted templates to %s!\n", Filename.string());
@@ -472,6 +551,7 @@ void Classify::EndAdaptiveClassifier() {
     }
   }
 
+  deferred_adaptions_.clear();
   if (AdaptedTemplates != NULL) {
     free_adapted_templates(AdaptedTemplates);
     AdaptedTemplates = NULL;
@@ -573,8 +653,8 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
     TFile fp;
     STRING Filename;
 
-    Filename = imagefile;
-    Filename += ADAPT_TEMPLATE_SUFFIX;
+    Filename = AdaptedTemplatesFilename(
+        classify_adapted_templates_file.string(), imagefile);
     if (!fp.Open(Filename.string(), nullptr)) {
       AdaptedTemplates = NewAdaptedTemplates(true);
     } else {
@@ -601,6 +681,7 @@ void Classify::ResetAdaptiveClassifierInternal() {
     tprintf("Resetting adaptive classifier (NumAdaptationsFailed=%d)\n",
             NumAdaptationsFailed);
   }
+  deferred_adaptions_.clear();
   free_adapted_templates(AdaptedTemplates);
   AdaptedTemplates = NewAdaptedTemplates(true);
   if (BackupAdaptedTemplates != NULL)
@@ -1573,7 +1654,7 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
       BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+                           &bl_features, FeatureCache());
   if (sample == NULL) return;
 
   if (AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min ||
@@ -1634,7 +1715,7 @@ UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
   GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
       BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+                           &bl_features, FeatureCache());
   if (sample == NULL) {
     delete Results;
     return NULL;
@@ -72,6 +72,16 @@ Classify::Classify()
                   "Use pre-adapted classifier templates", this->params()),
       BOOL_MEMBER(classify_save_adapted_templates, 0,
                   "Save adapted templates to a file", this->params()),
+      STRING_MEMBER(classify_adapted_templates_file, "",
+                    "File for classify_use_pre_adapted_templates and"
+                    " classify_save_adapted_templates, instead of imagefile.a."
+                    " Lets the pages of one document seed each other.",
+                    this->params()),
+      BOOL_MEMBER(classify_defer_adaption, 0,
+                  "Queue adaption to words during a pass and apply it between"
+                  " passes, keeping the adapted templates read-only while"
+                  " words are recognized",
+                  this->params()),
       BOOL_MEMBER(classify_enable_adaptive_debugger, 0, "Enable match debugger",
                   this->params()),
       BOOL_MEMBER(classify_nonlinear_norm, 0,
@@ -150,6 +160,9 @@ Classify::Classify()
                  "Class Pruner CutoffStrength:         ", this->params()),
       INT_MEMBER(classify_integer_matcher_multiplier, 10,
                  "Integer Matcher Multiplier  0-255:   ", this->params()),
+      INT_MEMBER(classify_feature_cache_size, 4096,
+                 "Number of recently classified blobs whose features are kept"
+                 " for reuse, 0 to disable", this->params()),
       EnableLearning(true),
       INT_MEMBER(il1_adaption_test, 0,
                  "Don't adapt to i/I at beginning of word", this->params()),
@@ -201,6 +214,12 @@ void Classify::SetStaticClassifier(ShapeClassifier* static_classifier) {
   static_classifier_ = static_classifier;
 }
 
+// Returns the blob feature cache, sized to classify_feature_cache_size.
+IntFeatureCache* Classify::FeatureCache() {
+  feature_cache_.set_max_size(classify_feature_cache_size);
+  return &feature_cache_;
+}
+
 // Moved from speckle.cpp
 // Adds a noise classification result that is a bit worse than the worst
 // current result, or the worst possible result if no current results.
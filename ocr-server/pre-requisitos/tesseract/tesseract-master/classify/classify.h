@@ -22,6 +22,7 @@
 #include "adaptive.h"
 #include "ccstruct.h"
 #include "classify.h"
+#include "coutln.h"
 #include "dict.h"
 #include "featdefs.h"
 #include "fontinfo.h"
@@ -58,6 +59,23 @@ enum CharSegmentationType {
   CST_NGRAM      // Multiple characters.
 };
 
+// A single adaption recorded by LearnPieces while classify_defer_adaption is
+// on. The blob is a baseline-normalized copy, owned by the event, that is
+// adapted to by ApplyDeferredAdaption once the current pass is over.
+// The event also owns copies of the C_OUTLINEs that the points of the blob
+// refer to, so the features are those of immediate adaption, even after the
+// word that the blob came from has been deleted.
+struct AdaptionEvent {
+  AdaptionEvent(const TBLOB& word_blob, CLASS_ID id, int font, float thr);
+  ~AdaptionEvent();
+
+  TBLOB* blob;
+  C_OUTLINE_LIST outlines;
+  CLASS_ID class_id;
+  int font_id;
+  float threshold;
+};
+
 class Classify : public CCStruct {
  public:
   Classify();
@@ -257,6 +275,9 @@ class Classify : public CCStruct {
   void DisplayAdaptedChar(TBLOB* blob, INT_CLASS_STRUCT* int_class);
   bool AdaptableWord(WERD_RES* word);
   void EndAdaptiveClassifier();
+  // Clears the cache of blob features. Must be called before the outlines of
+  // the cached blobs may be deleted, eg at the end of each page.
+  void ClearFeatureCache() { feature_cache_.Clear(); }
   void SettupPass1();
   void SettupPass2();
   void AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices);
@@ -264,6 +285,12 @@ class Classify : public CCStruct {
   void ResetAdaptiveClassifierInternal();
   void SwitchAdaptiveClassifier();
   void StartBackupAdaptiveClassifier();
+  // Applies, in the order they were queued, all the adaptions deferred by
+  // classify_defer_adaption to the adapted (and backup) templates, then
+  // empties the queue. The events don't refer to the words they came from,
+  // which may already have been deleted.
+  void ApplyDeferredAdaption();
+  int NumDeferredAdaptions() const { return deferred_adaptions_.size(); }
 
   int GetCharNormFeature(const INT_FX_RESULT_STRUCT& fx_info,
                          INT_TEMPLATES templates,
@@ -410,6 +437,14 @@ class Classify : public CCStruct {
              "Use pre-adapted classifier templates");
   BOOL_VAR_H(classify_save_adapted_templates, 0,
              "Save adapted templates to a file");
+  STRING_VAR_H(classify_adapted_templates_file, "",
+               "File for classify_use_pre_adapted_templates and"
+               " classify_save_adapted_templates, instead of imagefile.a."
+               " Lets the pages of one document seed each other.");
+  BOOL_VAR_H(classify_defer_adaption, 0,
+             "Queue adaption to words during a pass and apply it between"
+             " passes, keeping the adapted templates read-only while words"
+             " are recognized");
   BOOL_VAR_H(classify_enable_adaptive_debugger, 0, "Enable match debugger");
   BOOL_VAR_H(classify_nonlinear_norm, 0,
              "Non-linear stroke-density normalization");
@@ -466,6 +501,9 @@ class Classify : public CCStruct {
             "Class Pruner CutoffStrength:         ");
   INT_VAR_H(classify_integer_matcher_multiplier, 10,
             "Integer Matcher Multiplier  0-255:   ");
+  INT_VAR_H(classify_feature_cache_size, 4096,
+            "Number of recently classified blobs whose features are kept"
+            " for reuse, 0 to disable");
 
   // Use class variables to hold onto built-in templates and adapted templates.
   INT_TEMPLATES PreTrainedTemplates;
@@ -515,9 +553,19 @@ class Classify : public CCStruct {
   // The currently active static classifier.
   ShapeClassifier* static_classifier_;
 
+  // Returns the blob feature cache, sized to classify_feature_cache_size.
+  IntFeatureCache* FeatureCache();
+
   /* variables used to hold performance statistics */
   int NumAdaptationsFailed;
 
+  // Features of recently classified blobs, for reuse when the same blob is
+  // classified again.
+  IntFeatureCache feature_cache_;
+
+  // Adaptions queued by LearnPieces when classify_defer_adaption is on.
+  PointerVector<AdaptionEvent> deferred_adaptions_;
+
   // Training data gathered here for all the images in a document.
   STRING tr_file_data_;
 
@@ -22,6 +22,7 @@
 #include "helpers.h"
 #include "kdpair.h"
 #include "matrix.h"
+#include "svutil.h"
 #include "tprintf.h"
 #include "danerror.h"
 #include <math.h>
@@ -1858,7 +1859,9 @@ uinT16 OptimumNumberOfBuckets(uinT32 SampleCount) {
  * corresponds to a different alpha value and its corresponding
  * chi-squared value.  Therefore, once a particular chi-squared
  * value is computed, it is stored in the list and never
- * needs to be computed again.
+ * needs to be computed again.  The table is shared by all
+ * clusterers, so it is guarded by a mutex to allow classes
+ * to be clustered in parallel.
  * @param DegreesOfFreedom  determines shape of distribution
  * @param Alpha probability of right tail
  * @return Desired chi-squared value
@@ -1871,6 +1874,7 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
 #define MINALPHA  (1e-200)
 {
   static LIST ChiWith[MAXDEGREESOFFREEDOM + 1];
+  static SVMutex ChiWithMutex;
 
   CHISTRUCT *OldChiSquared;
   CHISTRUCT SearchKey;
@@ -1885,6 +1889,7 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
      for the specified number of degrees of freedom.  Search the list for
      the desired chi-squared. */
   SearchKey.Alpha = Alpha;
+  SVAutoLock lock(&ChiWithMutex);
   OldChiSquared = (CHISTRUCT *) first_node (search (ChiWith[DegreesOfFreedom],
     &SearchKey, AlphaMatch));
 
@@ -2466,9 +2471,6 @@ MultipleCharSamples (CLUSTERER * Clusterer,
 CLUSTER * Cluster, FLOAT32 MaxIllegal)
 #define ILLEGAL_CHAR    2
 {
-  static BOOL8 *CharFlags = NULL;
-  static inT32 NumFlags = 0;
-  int i;
   LIST SearchState;
   SAMPLE *Sample;
   inT32 CharID;
@@ -2480,14 +2482,10 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
   NumCharInCluster = Cluster->SampleCount;
   NumIllegalInCluster = 0;
 
-  if (Clusterer->NumChar > NumFlags) {
-    free(CharFlags);
-    NumFlags = Clusterer->NumChar;
-    CharFlags = (BOOL8 *) Emalloc (NumFlags * sizeof (BOOL8));
-  }
-
-  for (i = 0; i < NumFlags; i++)
-    CharFlags[i] = FALSE;
+  // Kept local (rather than a static buffer) so that separate clusterers
+  // can be run on separate threads.
+  GenericVector<BOOL8> CharFlags;
+  CharFlags.init_to_size(Clusterer->NumChar, FALSE);
 
   // find each sample in the cluster and check if we have seen it before
   InitSampleSearch(SearchState, Cluster);
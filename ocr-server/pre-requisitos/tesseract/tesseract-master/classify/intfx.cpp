@@ -80,10 +80,15 @@ namespace tesseract {
 // is now a member of Classify.
 TrainingSample* BlobToTrainingSample(
     const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
+    GenericVector<INT_FEATURE_STRUCT>* bl_features, IntFeatureCache* cache) {
   GenericVector<INT_FEATURE_STRUCT> cn_features;
-  Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
-                            &cn_features, fx_info, NULL);
+  if (cache != NULL) {
+    cache->ExtractFeatures(blob, nonlinear_norm, bl_features, &cn_features,
+                           fx_info);
+  } else {
+    Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
+                              &cn_features, fx_info, NULL);
+  }
   // TODO(rays) Use blob->PreciseBoundingBox() instead.
   TBOX box = blob.bounding_box();
   TrainingSample* sample = NULL;
@@ -256,12 +261,61 @@ static int ComputeFeatures(const FCOORD& start_pt, const FCOORD& end_pt,
   return num_features;
 }
 
+// Normalizes all the outline steps of a run in one batch, for use by
+// GatherPoints. On input pos must point to the position corresponding to
+// start_index. On return, (*normed_pts)[i] is the normalized sub-pixel
+// position of the step at start_index + i, and (*normed_dirs)[i] is its
+// normalized direction, or -1 if it has no direction. The results are the
+// same as normalizing each point and direction individually with
+// NormTransform and NormalizeDirection, but batching the points allows each
+// step of the transformation to run as a tight loop.
+static void NormalizeRun(const C_OUTLINE* outline, const DENORM& denorm,
+                         const DENORM* root_denorm, ICOORD pos,
+                         int start_index, int end_index,
+                         GenericVector<FCOORD>* normed_pts,
+                         GenericVector<int>* normed_dirs) {
+  int step_length = outline->pathlength();
+  int num_pts = end_index - start_index + 1;
+  normed_pts->init_to_size(num_pts, FCOORD());
+  normed_dirs->init_to_size(num_pts, -1);
+  // The positions come first, followed by the ends of the unit direction
+  // vectors of the points that have a direction.
+  GenericVector<FCOORD> pts;
+  pts.reserve(2 * num_pts);
+  for (int i = 0; i < num_pts; ++i) {
+    int index = (start_index + i) % step_length;
+    pts.push_back(outline->sub_pixel_pos_at_index(pos, index));
+    pos += outline->step(index);
+  }
+  for (int i = 0; i < num_pts; ++i) {
+    int direction = outline->direction_at_index((start_index + i) %
+                                                step_length);
+    if (direction >= 0) {
+      FCOORD dir_end;
+      dir_end.from_direction(direction);
+      dir_end += pts[i];
+      pts.push_back(dir_end);
+      (*normed_dirs)[i] = direction;
+    }
+  }
+  denorm.NormTransformPoints(root_denorm, pts.size(), &pts[0]);
+  int dir_end_index = num_pts;
+  for (int i = 0; i < num_pts; ++i) {
+    (*normed_pts)[i] = pts[i];
+    if ((*normed_dirs)[i] >= 0) {
+      FCOORD normed_end = pts[dir_end_index++];
+      normed_end -= pts[i];
+      (*normed_dirs)[i] = normed_end.to_direction();
+    }
+  }
+}
+
 // Gathers outline points and their directions from start_index into dirs by
-// stepping along the outline and normalizing the coordinates until the
-// required feature_length has been collected or end_index is reached.
-// On input pos must point to the position corresponding to start_index and on
-// return pos is updated to the current raw position, and pos_normed is set to
-// the normed version of pos.
+// stepping along the outline until the required feature_length has been
+// collected or end_index is reached. The normalized positions and directions
+// are taken from normed_pts and normed_dirs, as computed by NormalizeRun,
+// which are indexed from run_start. On return pos_normed is set to the
+// normed position of the last point visited.
 // Since directions wrap-around, they need special treatment to get the mean.
 // Provided the cluster of directions doesn't straddle the wrap-around point,
 // the simple mean works. If they do, then, unless the directions are wildly
@@ -271,12 +325,11 @@ static int ComputeFeatures(const FCOORD& start_pt, const FCOORD& end_pt,
 // dir and dir+128 (128 is 180 degrees) and then use the resulting mean
 // with the least variance.
 static int GatherPoints(const C_OUTLINE* outline, double feature_length,
-                        const DENORM& denorm, const DENORM* root_denorm,
-                        int start_index, int end_index,
-                        ICOORD* pos, FCOORD* pos_normed,
-                        LLSQ* points, LLSQ* dirs) {
+                        const GenericVector<FCOORD>& normed_pts,
+                        const GenericVector<int>& normed_dirs,
+                        int run_start, int start_index, int end_index,
+                        FCOORD* pos_normed, LLSQ* points, LLSQ* dirs) {
   int step_length = outline->pathlength();
-  ICOORD step = outline->step(start_index % step_length);
   // Prev_normed is the start point of this collection and will be set on the
   // first iteration, and on later iterations used to determine the length
   // that has been collected.
@@ -285,16 +338,13 @@ static int GatherPoints(const C_OUTLINE* outline, double feature_length,
   dirs->clear();
   int num_points = 0;
   int index;
-  for (index = start_index; index <= end_index; ++index, *pos += step) {
-    step = outline->step(index % step_length);
+  for (index = start_index; index <= end_index; ++index) {
     int edge_weight = outline->edge_strength_at_index(index % step_length);
     if (edge_weight == 0) {
       // This point has conflicting gradient and step direction, so ignore it.
       continue;
     }
-    // Get the sub-pixel precise location and normalize.
-    FCOORD f_pos = outline->sub_pixel_pos_at_index(*pos, index % step_length);
-    denorm.NormTransform(root_denorm, f_pos, pos_normed);
+    *pos_normed = normed_pts[index - run_start];
     if (num_points == 0) {
       // The start of this segment.
       prev_normed = *pos_normed;
@@ -308,9 +358,8 @@ static int GatherPoints(const C_OUTLINE* outline, double feature_length,
       }
     }
     points->add(pos_normed->x(), pos_normed->y(), edge_weight);
-    int direction = outline->direction_at_index(index % step_length);
+    int direction = normed_dirs[index - run_start];
     if (direction >= 0) {
-      direction = NormalizeDirection(direction, f_pos, denorm, root_denorm);
       // Use both the direction and direction +128 so we are not trying to
       // take the mean of something straddling the wrap-around point.
       dirs->add(direction, Modulo(direction + 128, 256));
@@ -348,15 +397,18 @@ static void ExtractFeaturesFromRun(
     int end_index = lastpt->start_step + lastpt->step_count;
     if (end_index <= start_index)
       end_index += step_length;
+    GenericVector<FCOORD> normed_pts;
+    GenericVector<int> normed_dirs;
+    NormalizeRun(outline, denorm, root_denorm, pos, start_index, end_index,
+                 &normed_pts, &normed_dirs);
     LLSQ prev_points;
     LLSQ prev_dirs;
-    FCOORD prev_normed_pos = outline->sub_pixel_pos_at_index(pos, start_index);
-    denorm.NormTransform(root_denorm, prev_normed_pos, &prev_normed_pos);
+    FCOORD prev_normed_pos = normed_pts[0];
     LLSQ points;
     LLSQ dirs;
     FCOORD normed_pos;
-    int index = GatherPoints(outline, feature_length, denorm, root_denorm,
-                             start_index, end_index, &pos, &normed_pos,
+    int index = GatherPoints(outline, feature_length, normed_pts, normed_dirs,
+                             start_index, start_index, end_index, &normed_pos,
                              &points, &dirs);
     while (index <= end_index) {
       // At each iteration we nominally have 3 accumulated sets of points and
@@ -367,8 +419,8 @@ static void ExtractFeaturesFromRun(
       LLSQ next_points;
       LLSQ next_dirs;
       FCOORD next_normed_pos;
-      index = GatherPoints(outline, feature_length, denorm, root_denorm,
-                           index, end_index, &pos, &next_normed_pos,
+      index = GatherPoints(outline, feature_length, normed_pts, normed_dirs,
+                           start_index, index, end_index, &next_normed_pos,
                            &next_points, &next_dirs);
       LLSQ sum_points(prev_points);
       // TODO(rays) find out why it is better to use just dirs and next_dirs
@@ -486,6 +538,123 @@ void Classify::ExtractFeatures(const TBLOB& blob,
   results->Width = blob.bounding_box().width();
 }
 
+// Helper appends the bytes of value to key.
+template <typename T>
+static void AppendToKey(const T& value, GenericVector<char>* key) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  for (size_t i = 0; i < sizeof(value); ++i) key->push_back(bytes[i]);
+}
+
+// Sets the maximum number of cached blobs, clearing the cache if it
+// changes. A size of 0 disables the cache.
+void IntFeatureCache::set_max_size(int max_size) {
+  if (max_size == max_size_) return;
+  Clear();
+  max_size_ = MAX(max_size, 0);
+}
+
+// Removes all the entries.
+void IntFeatureCache::Clear() {
+  entries_.clear();
+  index_.clear();
+  next_entry_ = 0;
+}
+
+// As Classify::ExtractFeatures, without outline_cn_counts, but appends
+// the cached features if the same blob has been seen before.
+void IntFeatureCache::ExtractFeatures(
+    const TBLOB& blob, bool nonlinear_norm,
+    GenericVector<INT_FEATURE_STRUCT>* bl_features,
+    GenericVector<INT_FEATURE_STRUCT>* cn_features,
+    INT_FX_RESULT_STRUCT* results) {
+  if (max_size_ == 0) {
+    Classify::ExtractFeatures(blob, nonlinear_norm, bl_features, cn_features,
+                              results, NULL);
+    return;
+  }
+  uinT64 hash = ComputeKey(blob, nonlinear_norm);
+  const Entry* entry = NULL;
+  std::unordered_map<uinT64, int>::const_iterator it = index_.find(hash);
+  if (it != index_.end()) {
+    const Entry& found = entries_[it->second];
+    if (found.key.size() == key_.size() &&
+        memcmp(&found.key[0], &key_[0], key_.size()) == 0) {
+      ++hits_;
+      entry = &found;
+    }
+  }
+  if (entry == NULL) {
+    ++misses_;
+    if (entries_.size() < max_size_) {
+      entries_.push_back(Entry());
+    } else {
+      // Evict the oldest entry, unless its hash has since been reused.
+      it = index_.find(entries_[next_entry_].hash);
+      if (it != index_.end() && it->second == next_entry_) index_.erase(it);
+    }
+    Entry& new_entry = entries_[next_entry_];
+    new_entry.key = key_;
+    new_entry.bl_features.truncate(0);
+    new_entry.cn_features.truncate(0);
+    Classify::ExtractFeatures(blob, nonlinear_norm, &new_entry.bl_features,
+                              &new_entry.cn_features, &new_entry.results,
+                              NULL);
+    new_entry.hash = hash;
+    index_[hash] = next_entry_;
+    next_entry_ = (next_entry_ + 1) % max_size_;
+    entry = &new_entry;
+  }
+  // Like Classify::ExtractFeatures, appends to the features already given,
+  // and counts them all in the results.
+  *bl_features += entry->bl_features;
+  *cn_features += entry->cn_features;
+  *results = entry->results;
+  results->NumBL = bl_features->size();
+  results->NumCN = cn_features->size();
+}
+
+// Builds in key_ a byte string uniquely identifying the features that
+// would be extracted from the blob, and returns its hash.
+uinT64 IntFeatureCache::ComputeKey(const TBLOB& blob, bool nonlinear_norm) {
+  key_.truncate(0);
+  AppendToKey(nonlinear_norm, &key_);
+  blob.denorm().AppendTransformKey(&key_);
+  for (const TESSLINE* ol = blob.outlines; ol != NULL; ol = ol->next) {
+    // Each outline and each point is tagged so that differing structures
+    // cannot produce the same key.
+    key_.push_back('o');
+    AppendToKey(ol->topleft, &key_);
+    AppendToKey(ol->botright, &key_);
+    const EDGEPT* pt = ol->loop;
+    if (pt == NULL) continue;
+    const C_OUTLINE* prev_outline = NULL;
+    do {
+      key_.push_back('p');
+      AppendToKey(pt->pos, &key_);
+      AppendToKey(pt->vec, &key_);
+      AppendToKey(pt->flags, &key_);
+      AppendToKey(pt->src_outline, &key_);
+      AppendToKey(pt->start_step, &key_);
+      AppendToKey(pt->step_count, &key_);
+      if (pt->src_outline != NULL && pt->src_outline != prev_outline) {
+        // Guard against a new outline reusing the address of a deleted one.
+        key_.push_back('c');
+        AppendToKey(pt->src_outline->start_pos(), &key_);
+        AppendToKey(pt->src_outline->pathlength(), &key_);
+        AppendToKey(pt->src_outline->bounding_box(), &key_);
+      }
+      prev_outline = pt->src_outline;
+    } while ((pt = pt->next) != ol->loop);
+  }
+  // 64 bit FNV-1a hash of the key.
+  uinT64 hash = 14695981039346656037ULL;
+  for (int i = 0; i < key_.size(); ++i) {
+    hash ^= static_cast<unsigned char>(key_[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
 }  // namespace tesseract
 
 
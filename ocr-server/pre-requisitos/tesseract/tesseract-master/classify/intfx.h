@@ -25,6 +25,7 @@
 #include "intproto.h"
 #include "normalis.h"
 #include <math.h>
+#include <unordered_map>
 
 class DENORM;
 
@@ -55,14 +56,70 @@ void InitIntegerFX();
 FCOORD FeatureDirection(uinT8 theta);
 
 namespace tesseract {
+  // Bounded cache of the features extracted from recently seen blobs, keyed
+  // by the full content of the blob polygon, its source outlines and its
+  // normalization, so the same blob classified again (eg by the adaptive
+  // classifier, ambiguity checking, or another pass) reuses its features
+  // instead of extracting them again. Entries are replaced in FIFO order.
+  // Pointers to the source outlines are part of the key, so the cache must be
+  // cleared whenever the outlines may be deleted, eg at the end of a page.
+  class IntFeatureCache {
+   public:
+    IntFeatureCache() : max_size_(0), next_entry_(0), hits_(0), misses_(0) {}
+
+    // Sets the maximum number of cached blobs, clearing the cache if it
+    // changes. A size of 0 disables the cache.
+    void set_max_size(int max_size);
+    int max_size() const { return max_size_; }
+    int hits() const { return hits_; }
+    int misses() const { return misses_; }
+
+    // Removes all the entries.
+    void Clear();
+
+    // As Classify::ExtractFeatures, without outline_cn_counts, but appends
+    // the cached features if the same blob has been seen before.
+    void ExtractFeatures(const TBLOB& blob, bool nonlinear_norm,
+                         GenericVector<INT_FEATURE_STRUCT>* bl_features,
+                         GenericVector<INT_FEATURE_STRUCT>* cn_features,
+                         INT_FX_RESULT_STRUCT* results);
+
+   private:
+    struct Entry {
+      GenericVector<char> key;
+      GenericVector<INT_FEATURE_STRUCT> bl_features;
+      GenericVector<INT_FEATURE_STRUCT> cn_features;
+      INT_FX_RESULT_STRUCT results;
+      uinT64 hash;
+    };
+
+    // Builds in key_ a byte string uniquely identifying the features that
+    // would be extracted from the blob, and returns its hash.
+    uinT64 ComputeKey(const TBLOB& blob, bool nonlinear_norm);
+
+    int max_size_;
+    // Circular buffer of entries, of which next_entry_ is the next to reuse.
+    GenericVector<Entry> entries_;
+    int next_entry_;
+    // Map from key hash to index in entries_.
+    std::unordered_map<uinT64, int> index_;
+    // Scratch key, kept to avoid reallocation.
+    GenericVector<char> key_;
+    int hits_;
+    int misses_;
+  };
+
   // Generates a TrainingSample from a TBLOB. Extracts features and sets
   // the bounding box, so classifiers that operate on the image can work.
+  // If cache is not NULL, it is used to avoid extracting the features of
+  // the same blob twice.
   // TODO(rays) BlobToTrainingSample must remain a global function until
   // the FlexFx and FeatureDescription code can be removed and LearnBlob
   // made a member of Classify.
   TrainingSample* BlobToTrainingSample(
       const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-      GenericVector<INT_FEATURE_STRUCT>* bl_features);
+      GenericVector<INT_FEATURE_STRUCT>* bl_features,
+      IntFeatureCache* cache = NULL);
 }
 
 // Deprecated! Prefer tesseract::Classify::ExtractFeatures instead.
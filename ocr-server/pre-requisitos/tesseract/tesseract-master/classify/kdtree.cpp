@@ -36,6 +36,9 @@
 #define MINSEARCH -MAX_FLOAT32
 #define MAXSEARCH MAX_FLOAT32
 
+// Number of nodes allocated at once by MakeKDNode.
+const int kNodesPerBlock = 256;
+
 // Helper function to find the next essential dimension in a cycle.
 static int NextLevel(KDTREE *tree, int level) {
   do {
@@ -127,7 +130,7 @@ class KDTreeSearch {
   void Search(int *result_count, FLOAT32 *distances, void **results);
 
  private:
-  void SearchRec(int Level, KDNODE *SubTree);
+  void SearchRec(KDNODE *SubTree);
   bool BoxIntersectsSearch(FLOAT32 *lower, FLOAT32 *upper);
 
   KDTREE *tree_;
@@ -160,7 +163,7 @@ void KDTreeSearch::Search(int *result_count,
       sb_min_[i] = tree_->KeyDesc[i].Min;
       sb_max_[i] = tree_->KeyDesc[i].Max;
     }
-    SearchRec(0, tree_->Root.Left);
+    SearchRec(tree_->Root.Left);
     int count = results_.elements_count();
     *result_count = count;
     for (int j = 0; j < count; j++) {
@@ -198,31 +201,24 @@ KDTREE *MakeKDTree(inT16 KeySize, const PARAM_DESC KeyDesc[]) {
   KDTree->KeySize = KeySize;
   KDTree->Root.Left = NULL;
   KDTree->Root.Right = NULL;
+  KDTree->NodeBlocks = NULL;
+  KDTree->FreeNodes = NULL;
+  KDTree->NumBlockNodes = 0;
   return KDTree;
 }
 
 
 /**
- * This routine stores Data in the K-D tree specified by Tree
- * using Key as an access key.
- *
- * @param Tree    K-D tree in which data is to be stored
- * @param Key    ptr to key by which data can be retrieved
- * @param Data    ptr to data to be stored in the tree
- *
- * @note Exceptions: none
- * @note History:  3/10/89, DSJ, Created.
- *      7/13/89, DSJ, Changed return to void.
+ * Links NewNode into the subtree at *PtrToNode, whose root branches on Level,
+ * in the same way as KDStore does from the root of the tree, and sets up
+ * NewNode for the level at which it lands.
  */
-void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
-  int Level;
-  KDNODE *Node;
-  KDNODE **PtrToNode;
-
-  PtrToNode = &(Tree->Root.Left);
-  Node = *PtrToNode;
-  Level = NextLevel(Tree, -1);
+static void LinkKDNode(KDTREE *Tree, KDNODE **PtrToNode, int Level,
+                       KDNODE *NewNode) {
+  const FLOAT32 *Key = NewNode->Key;
+  KDNODE *Node = *PtrToNode;
   while (Node != NULL) {
+    Level = Node->Level;
     if (Key[Level] < Node->BranchPoint) {
       PtrToNode = &(Node->Left);
       if (Key[Level] > Node->LeftBranch)
@@ -233,11 +229,34 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
       if (Key[Level] < Node->RightBranch)
         Node->RightBranch = Key[Level];
     }
-    Level = NextLevel(Tree, Level);
     Node = *PtrToNode;
+    if (Node == NULL)
+      Level = NextLevel(Tree, Level);
   }
+  NewNode->Level = Level;
+  NewNode->BranchPoint = Key[Level];
+  NewNode->LeftBranch = Tree->KeyDesc[Level].Min;
+  NewNode->RightBranch = Tree->KeyDesc[Level].Max;
+  NewNode->Left = NULL;
+  NewNode->Right = NULL;
+  *PtrToNode = NewNode;
+}
 
-  *PtrToNode = MakeKDNode(Tree, Key, (void *) Data, Level);
+/**
+ * This routine stores Data in the K-D tree specified by Tree
+ * using Key as an access key.
+ *
+ * @param Tree    K-D tree in which data is to be stored
+ * @param Key    ptr to key by which data can be retrieved
+ * @param Data    ptr to data to be stored in the tree
+ *
+ * @note Exceptions: none
+ * @note History:  3/10/89, DSJ, Created.
+ *      7/13/89, DSJ, Changed return to void.
+ */
+void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
+  KDNODE *NewNode = MakeKDNode(Tree, Key, (void *) Data, 0);
+  LinkKDNode(Tree, &(Tree->Root.Left), NextLevel(Tree, -1), NewNode);
 }                                /* KDStore */
 
 /**
@@ -261,27 +280,30 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
  */
 void
 KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
-  int Level;
   KDNODE *Current;
   KDNODE *Father;
+  KDNODE **PtrToCurrent;
+  KDNODE **PtrToFather;
 
   /* initialize search at root of tree */
   Father = &(Tree->Root);
-  Current = Father->Left;
-  Level = NextLevel(Tree, -1);
+  PtrToFather = NULL;
+  PtrToCurrent = &(Tree->Root.Left);
+  Current = *PtrToCurrent;
 
   /* search tree for node to be deleted */
   while ((Current != NULL) && (!NodeFound (Current, Key, Data))) {
+    PtrToFather = PtrToCurrent;
     Father = Current;
-    if (Key[Level] < Current->BranchPoint)
-      Current = Current->Left;
+    if (Key[Current->Level] < Current->BranchPoint)
+      PtrToCurrent = &(Current->Left);
     else
-      Current = Current->Right;
-
-    Level = NextLevel(Tree, Level);
+      PtrToCurrent = &(Current->Right);
+    Current = *PtrToCurrent;
   }
 
   if (Current != NULL) {         /* if node to be deleted was found */
+    int Level = Current->Level;
     if (Current == Father->Left) {
       Father->Left = NULL;
       Father->LeftBranch = Tree->KeyDesc[Level].Min;
@@ -290,9 +312,14 @@ KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
       Father->RightBranch = Tree->KeyDesc[Level].Max;
     }
 
-    InsertNodes(Tree, Current->Left);
-    InsertNodes(Tree, Current->Right);
-    FreeSubTree(Current);
+    /* Every key below Current came in through Father, and left the branch
+       bounds of all the nodes above Father covering it, so re-inserting
+       from Father, rather than from the root, builds the same tree. */
+    if (PtrToFather == NULL)
+      PtrToFather = &(Tree->Root.Left);
+    InsertNodes(Tree, PtrToFather, Level, Current->Left);
+    InsertNodes(Tree, PtrToFather, Level, Current->Right);
+    FreeKDNode(Tree, Current);
   }
 }                                /* KDDelete */
 
@@ -328,7 +355,7 @@ void KDNearestNeighborSearch(
 /** Walk a given Tree with action. */
 void KDWalk(KDTREE *Tree, void_proc action, void *context) {
   if (Tree->Root.Left != NULL)
-    Walk(Tree, action, context, Tree->Root.Left, NextLevel(Tree, -1));
+    Walk(Tree, action, context, Tree->Root.Left);
 }
 
 
@@ -346,7 +373,11 @@ void KDWalk(KDTREE *Tree, void_proc action, void *context) {
  * @note History: 5/26/89, DSJ, Created.
  */
 void FreeKDTree(KDTREE *Tree) {
-  FreeSubTree(Tree->Root.Left);
+  while (Tree->NodeBlocks != NULL) {
+    KDNODE *Block = Tree->NodeBlocks;
+    Tree->NodeBlocks = Block[0].Left;
+    free(Block);
+  }
   free(Tree);
 }                                /* FreeKDTree */
 
@@ -359,7 +390,9 @@ void FreeKDTree(KDTREE *Tree) {
  * This routine allocates memory for a new K-D tree node
  * and places the specified Key and Data into it.  The
  * left and right subtree pointers for the node are
- * initialized to empty subtrees.
+ * initialized to empty subtrees.  Nodes come from blocks
+ * owned by the tree, so that the tree stays compact in
+ * memory, and nodes released by KDDelete are reused.
  * @param tree  The tree to create the node for
  * @param Key  Access key for new node in KD tree
  * @param Data  ptr to data to be stored in new node
@@ -371,7 +404,20 @@ void FreeKDTree(KDTREE *Tree) {
 KDNODE *MakeKDNode(KDTREE *tree, FLOAT32 Key[], void *Data, int Index) {
   KDNODE *NewNode;
 
-  NewNode = (KDNODE *) Emalloc (sizeof (KDNODE));
+  if (tree->FreeNodes != NULL) {
+    NewNode = tree->FreeNodes;
+    tree->FreeNodes = NewNode->Left;
+  } else {
+    if (tree->NumBlockNodes == 0) {
+      /* node 0 of each block links the blocks together */
+      KDNODE *Block = (KDNODE *) Emalloc(
+          (kNodesPerBlock + 1) * sizeof(KDNODE));
+      Block[0].Left = tree->NodeBlocks;
+      tree->NodeBlocks = Block;
+      tree->NumBlockNodes = kNodesPerBlock;
+    }
+    NewNode = tree->NodeBlocks + tree->NumBlockNodes--;
+  }
 
   NewNode->Key = Key;
   NewNode->Data = Data;
@@ -380,23 +426,25 @@ KDNODE *MakeKDNode(KDTREE *tree, FLOAT32 Key[], void *Data, int Index) {
   NewNode->RightBranch = tree->KeyDesc[Index].Max;
   NewNode->Left = NULL;
   NewNode->Right = NULL;
+  NewNode->Level = Index;
 
   return NewNode;
 }                                /* MakeKDNode */
 
 
 /*---------------------------------------------------------------------------*/
-void FreeKDNode(KDNODE *Node) { free(Node); }
+void FreeKDNode(KDTREE *tree, KDNODE *Node) {
+  Node->Left = tree->FreeNodes;
+  tree->FreeNodes = Node;
+}
 
 /*---------------------------------------------------------------------------*/
 /**
  * Recursively accumulate the k_closest points to query_point_ into results_.
- * @param Level  level in tree of sub-tree to be searched
  * @param SubTree  sub-tree to be searched
  */
-void KDTreeSearch::SearchRec(int level, KDNODE *sub_tree) {
-  if (level >= tree_->KeySize)
-    level = 0;
+void KDTreeSearch::SearchRec(KDNODE *sub_tree) {
+  int level = sub_tree->Level;
 
   if (!BoxIntersectsSearch(sb_min_, sb_max_))
     return;
@@ -409,26 +457,26 @@ void KDTreeSearch::SearchRec(int level, KDNODE *sub_tree) {
     if (sub_tree->Left != NULL) {
       FLOAT32 tmp = sb_max_[level];
       sb_max_[level] = sub_tree->LeftBranch;
-      SearchRec(NextLevel(tree_, level), sub_tree->Left);
+      SearchRec(sub_tree->Left);
       sb_max_[level] = tmp;
     }
     if (sub_tree->Right != NULL) {
       FLOAT32 tmp = sb_min_[level];
       sb_min_[level] = sub_tree->RightBranch;
-      SearchRec(NextLevel(tree_, level), sub_tree->Right);
+      SearchRec(sub_tree->Right);
       sb_min_[level] = tmp;
     }
   } else {
     if (sub_tree->Right != NULL) {
       FLOAT32 tmp = sb_min_[level];
       sb_min_[level] = sub_tree->RightBranch;
-      SearchRec(NextLevel(tree_, level), sub_tree->Right);
+      SearchRec(sub_tree->Right);
       sb_min_[level] = tmp;
     }
     if (sub_tree->Left != NULL) {
       FLOAT32 tmp = sb_max_[level];
       sb_max_[level] = sub_tree->LeftBranch;
-      SearchRec(NextLevel(tree_, level), sub_tree->Left);
+      SearchRec(sub_tree->Left);
       sb_max_[level] = tmp;
     }
   }
@@ -525,32 +573,27 @@ bool KDTreeSearch::BoxIntersectsSearch(FLOAT32 *lower, FLOAT32 *upper) {
  * @param action  action to be performed at every node
  * @param context  action's context
  * @param sub_tree  ptr to root of subtree to be walked
- * @param level  current level in the tree for this node
  */
-void Walk(KDTREE *tree, void_proc action, void *context,
-          KDNODE *sub_tree, inT32 level) {
-  (*action)(context, sub_tree->Data, level);
+void Walk(KDTREE *tree, void_proc action, void *context, KDNODE *sub_tree) {
+  (*action)(context, sub_tree->Data, sub_tree->Level);
   if (sub_tree->Left != NULL)
-    Walk(tree, action, context, sub_tree->Left, NextLevel(tree, level));
+    Walk(tree, action, context, sub_tree->Left);
   if (sub_tree->Right != NULL)
-    Walk(tree, action, context, sub_tree->Right, NextLevel(tree, level));
+    Walk(tree, action, context, sub_tree->Right);
 }
 
-/** Given a subtree nodes, insert all of its elements into tree. */
-void InsertNodes(KDTREE *tree, KDNODE *nodes) {
+/**
+ * Given a detached subtree nodes, insert all of its elements in pre-order
+ * into the subtree at *PtrToNode, whose root branches on Level, reusing the
+ * nodes themselves.
+ */
+void InsertNodes(KDTREE *tree, KDNODE **PtrToNode, int Level, KDNODE *nodes) {
   if (nodes == NULL)
     return;
 
-  KDStore(tree, nodes->Key, nodes->Data);
-  InsertNodes(tree, nodes->Left);
-  InsertNodes(tree, nodes->Right);
-}
-
-/** Free all of the nodes of a sub tree. */
-void FreeSubTree(KDNODE *sub_tree) {
-  if (sub_tree != NULL) {
-    FreeSubTree(sub_tree->Left);
-    FreeSubTree(sub_tree->Right);
-    free(sub_tree);
-  }
+  KDNODE *Left = nodes->Left;
+  KDNODE *Right = nodes->Right;
+  LinkKDNode(tree, PtrToNode, Level, nodes);
+  InsertNodes(tree, PtrToNode, Level, Left);
+  InsertNodes(tree, PtrToNode, Level, Right);
 }
@@ -44,11 +44,15 @@ struct KDNODE {
   FLOAT32 RightBranch;           /**< used to optimize search pruning */
   struct KDNODE *Left;           /**< ptrs for KD tree structure */
   struct KDNODE *Right;
+  int Level;                     /**< index of Key this node branches on */
 };
 
 struct KDTREE {
   inT16 KeySize;                 /* number of dimensions in the tree */
   KDNODE Root;                   /* Root.Left points to actual root node */
+  KDNODE *NodeBlocks;            /* blocks of nodes, linked by [0].Left */
+  KDNODE *FreeNodes;             /* released nodes, linked by Left */
+  int NumBlockNodes;             /* unused nodes left in NodeBlocks */
   PARAM_DESC KeyDesc[1];         /* description of each dimension */
 };
 
@@ -79,7 +83,7 @@ void FreeKDTree(KDTREE *Tree);
 -----------------------------------------------------------------------------*/
 KDNODE *MakeKDNode(KDTREE *tree, FLOAT32 Key[], void *Data, int Index);
 
-void FreeKDNode(KDNODE *Node);
+void FreeKDNode(KDTREE *tree, KDNODE *Node);
 
 FLOAT32 DistanceSquared(int k, PARAM_DESC *dim, FLOAT32 p1[], FLOAT32 p2[]);
 
@@ -87,10 +91,7 @@ FLOAT32 ComputeDistance(int k, PARAM_DESC *dim, FLOAT32 p1[], FLOAT32 p2[]);
 
 int QueryInSearch(KDTREE *tree);
 
-void Walk(KDTREE *tree, void_proc action, void *context,
-          KDNODE *SubTree, inT32 Level);
+void Walk(KDTREE *tree, void_proc action, void *context, KDNODE *SubTree);
 
-void InsertNodes(KDTREE *tree, KDNODE *nodes);
-
-void FreeSubTree(KDNODE *SubTree);
+void InsertNodes(KDTREE *tree, KDNODE **PtrToNode, int Level, KDNODE *nodes);
 #endif
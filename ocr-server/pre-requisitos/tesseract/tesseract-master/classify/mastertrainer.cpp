@@ -909,13 +909,25 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
   int min_s2 = 0;
   tprintf("Computing shape distances...");
   for (int s1 = 0; s1 < num_shapes; ++s1) {
-    for (int s2 = s1 + 1; s2 < num_shapes; ++s2) {
-      ShapeDist dist(s1, s2, ShapeDistance(*shapes, s1, s2));
-      shape_dists[s1].push_back(dist);
-      if (dist.distance < min_dist) {
-        min_dist = dist.distance;
+    for (int s2 = s1 + 1; s2 < num_shapes; ++s2)
+      shape_dists[s1].push_back(ShapeDist(s1, s2, kInfiniteDist));
+  }
+  // The distances are independent of each other, so they are computed in
+  // parallel. The rows get shorter as s1 increases, hence the dynamic
+  // schedule. The minimum is then found serially in the original order.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int s1 = 0; s1 < num_shapes; ++s1) {
+    for (int s2 = s1 + 1; s2 < num_shapes; ++s2)
+      shape_dists[s1][s2 - s1 - 1].distance = ShapeDistance(*shapes, s1, s2);
+  }
+  for (int s1 = 0; s1 < num_shapes; ++s1) {
+    for (int i = 0; i < shape_dists[s1].size(); ++i) {
+      if (shape_dists[s1][i].distance < min_dist) {
+        min_dist = shape_dists[s1][i].distance;
         min_s1 = s1;
-        min_s2 = s2;
+        min_s2 = s1 + 1 + i;
       }
     }
     tprintf(" %d", s1);
@@ -934,6 +946,9 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
       shape_dists[min_s2].clear();
       ++num_merged;
 
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
       for (int s = 0; s < min_s1; ++s) {
         if (!shape_dists[s].empty()) {
           shape_dists[s][min_s1 - s - 1].distance =
@@ -941,6 +956,9 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
           shape_dists[s][min_s2 - s -1].distance = kInfiniteDist;
         }
       }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
       for (int s2 = min_s1 + 1; s2 < num_shapes; ++s2) {
         if (shape_dists[min_s1][s2 - min_s1 - 1].distance < kInfiniteDist)
           shape_dists[min_s1][s2 - min_s1 - 1].distance =
@@ -301,66 +301,96 @@ float TrainingSampleSet::ClusterDistance(int font_id1, int class_id1,
   int font_index2 = font_id_map_.SparseToCompact(font_id2);
   if (font_index1 < 0 || font_index2 < 0)
     return 0.0f;
-  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
-  if (font_id1 == font_id2) {
+  float result;
+  {
+    SVAutoLock lock(&distance_cache_mutex_);
+    if (LookupClusterDistance(font_index1, class_id1,
+                              font_index2, font_id2, class_id2, &result))
+      return result;
+  }
+  // Distance has to be calculated. The computation only reads the canonical
+  // and cloud features, so it is done without holding the lock. If another
+  // thread gets there first, it computes the same value.
+  result = ComputeClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                                  feature_map);
+  SVAutoLock lock(&distance_cache_mutex_);
+  StoreClusterDistance(font_index1, font_id1, class_id1,
+                       font_index2, font_id2, class_id2, result);
+  return result;
+}
+
+// Looks up the distance between the given pair of font/class pairs in the
+// caches, returning false if it has not been computed yet.
+bool TrainingSampleSet::LookupClusterDistance(int font_index1, int class_id1,
+                                              int font_index2, int font_id2,
+                                              int class_id2, float* distance) {
+  const FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  if (font_index1 == font_index2) {
     // Special case cache for speed.
+    if (fc_info.unichar_distance_cache.size() == 0 ||
+        fc_info.unichar_distance_cache[class_id2] < 0)
+      return false;
+    *distance = fc_info.unichar_distance_cache[class_id2];
+    return true;
+  } else if (class_id1 == class_id2) {
+    // Another special-case cache for equal class-id.
+    if (fc_info.font_distance_cache.size() == 0 ||
+        fc_info.font_distance_cache[font_index2] < 0)
+      return false;
+    *distance = fc_info.font_distance_cache[font_index2];
+    return true;
+  }
+  // Both font and class are different. Linear search for class_id2/font_id2
+  // in what is a hopefully short list of distances.
+  for (int i = 0; i < fc_info.distance_cache.size(); ++i) {
+    if (fc_info.distance_cache[i].unichar_id == class_id2 &&
+        fc_info.distance_cache[i].font_id == font_id2) {
+      *distance = fc_info.distance_cache[i].distance;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Stores the given distance between the given pair of font/class pairs in
+// the caches, along with the symmetric entry.
+void TrainingSampleSet::StoreClusterDistance(int font_index1, int font_id1,
+                                             int class_id1, int font_index2,
+                                             int font_id2, int class_id2,
+                                             float distance) {
+  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
+  if (font_index1 == font_index2) {
     if (fc_info.unichar_distance_cache.size() == 0)
       fc_info.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-    if (fc_info.unichar_distance_cache[class_id2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.unichar_distance_cache[class_id2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.unichar_distance_cache.size() == 0)
-        fc_info2.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-      fc_info2.unichar_distance_cache[class_id1] = result;
-    }
-    return fc_info.unichar_distance_cache[class_id2];
+    fc_info.unichar_distance_cache[class_id2] = distance;
+    // Copy to the symmetric cache entry.
+    if (fc_info2.unichar_distance_cache.size() == 0)
+      fc_info2.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
+    fc_info2.unichar_distance_cache[class_id1] = distance;
   } else if (class_id1 == class_id2) {
-    // Another special-case cache for equal class-id.
     if (fc_info.font_distance_cache.size() == 0)
       fc_info.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
                                                -1.0f);
-    if (fc_info.font_distance_cache[font_index2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.font_distance_cache[font_index2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.font_distance_cache.size() == 0)
-        fc_info2.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
-                                                  -1.0f);
-      fc_info2.font_distance_cache[font_index1] = result;
-    }
-    return fc_info.font_distance_cache[font_index2];
-  }
-  // Both font and class are different. Linear search for class_id2/font_id2
-  // in what is a hopefully short list of distances.
-  int cache_index = 0;
-  while (cache_index < fc_info.distance_cache.size() &&
-         (fc_info.distance_cache[cache_index].unichar_id != class_id2 ||
-          fc_info.distance_cache[cache_index].font_id != font_id2))
-    ++cache_index;
-  if (cache_index == fc_info.distance_cache.size()) {
-    // Distance has to be calculated.
-    float result = ComputeClusterDistance(font_id1, class_id1,
-                                          font_id2, class_id2,
-                                          feature_map);
-    FontClassDistance fc_dist = { class_id2, font_id2, result };
+    fc_info.font_distance_cache[font_index2] = distance;
+    // Copy to the symmetric cache entry.
+    if (fc_info2.font_distance_cache.size() == 0)
+      fc_info2.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
+                                                -1.0f);
+    fc_info2.font_distance_cache[font_index1] = distance;
+  } else {
+    // Another thread may have stored it since the lookup. As we always copy
+    // to the symmetric entry, checking one list is enough.
+    float cached;
+    if (LookupClusterDistance(font_index1, class_id1,
+                              font_index2, font_id2, class_id2, &cached))
+      return;
+    FontClassDistance fc_dist = { class_id2, font_id2, distance };
     fc_info.distance_cache.push_back(fc_dist);
-    // Copy to the symmetric cache entry. We know it isn't there already, as
-    // we always copy to the symmetric entry.
-    FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
     fc_dist.unichar_id = class_id1;
     fc_dist.font_id = font_id1;
     fc_info2.distance_cache.push_back(fc_dist);
   }
-  return fc_info.distance_cache[cache_index].distance;
 }
 
 // Computes the distance between the given pair of font/class pairs.
@@ -21,6 +21,7 @@
 #include "indexmapbidi.h"
 #include "matrix.h"
 #include "shapetable.h"
+#include "svutil.h"
 #include "trainingsample.h"
 
 class UNICHARSET;
@@ -121,6 +122,8 @@ class TrainingSampleSet {
   // Returns the distance between the given pair of font/class pairs.
   // Finds in cache or computes and caches.
   // OrganizeByFontAndClass must have been already called.
+  // Thread-safe: may be called concurrently once the canonical and cloud
+  // features have been computed.
   float ClusterDistance(int font_id1, int class_id1,
                         int font_id2, int class_id2,
                         const IntFeatureMap& feature_map);
@@ -221,6 +224,16 @@ class TrainingSampleSet {
                                  ScrollView* window) const;
 
  private:
+  // Helpers for ClusterDistance. Look up / store the distance between the
+  // given font/class pairs in the caches. Must be called with
+  // distance_cache_mutex_ held.
+  bool LookupClusterDistance(int font_index1, int class_id1,
+                             int font_index2, int font_id2, int class_id2,
+                             float* distance);
+  void StoreClusterDistance(int font_index1, int font_id1, int class_id1,
+                            int font_index2, int font_id2, int class_id2,
+                            float distance);
+
   // Struct to store a triplet of unichar, font, distance in the distance cache.
   struct FontClassDistance {
     int unichar_id;
@@ -277,6 +290,9 @@ class TrainingSampleSet {
   // A 2-d array of FontClassInfo holding information related to each
   // (font_id, class_id) pair.
   GENERIC_2D_ARRAY<FontClassInfo>* font_class_array_;
+  // Guards the distance caches in font_class_array_, so that shape distances
+  // may be computed in parallel.
+  SVMutex distance_cache_mutex_;
 
   // Reference to the fontinfo_table_ in MasterTrainer. Provides names
   // for font_ids in the samples. Not serialized!
@@ -17,6 +17,7 @@
 ///////////////////////////////////////////////////////////////////////
 #include "ctc.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "genericvector.h"
@@ -38,6 +39,9 @@ const double CTC::kMaxExpArg_ = 80.0;
 const double CTC::kMinTotalTimeProb_ = 1e-8;
 // Minimum probability for total prob in final normalization.
 const double CTC::kMinTotalFinalProb_ = 1e-6;
+// exp(-37) < 2^-53, so terms further below the max than this are lost in the
+// rounding of ln(1 + sum).
+const double CTC::kMaxLogSumExpDiff_ = 37.0;
 
 // Builds a target using CTC. Slightly improved as follows:
 // Includes normalizations and clipping for stability.
@@ -66,6 +70,7 @@ bool CTC::ComputeCTCTargets(const GenericVector<int>& labels, int null_char,
   simple_targets *= bias_fraction;
   ctc->outputs_ += simple_targets;
   NormalizeProbs(&ctc->outputs_);
+  ctc->ComputeLogLabelProbs();
   // Run regular CTC on the biased outputs.
   // Run forward and backward
   GENERIC_2D_ARRAY<double> log_alphas, log_betas;
@@ -255,41 +260,65 @@ float CTC::CalculateBiasFraction() {
   return exp(MAX(true_pos - false_pos, 1) * log(kMinProb_) / total_labels);
 }
 
-// Given ln(x) and ln(y), returns ln(x + y), using:
-// ln(x + y) = ln(y) + ln(1 + exp(ln(y) - ln(x)), ensuring that ln(x) is the
-// bigger number to maximize precision.
-static double LogSumExp(double ln_x, double ln_y) {
-  if (ln_x >= ln_y) {
-    return ln_x + log1p(exp(ln_y - ln_x));
-  } else {
-    return ln_y + log1p(exp(ln_x - ln_y));
+// Given ln(x), ln(y) and ln(z), returns ln(x + y + z), using:
+// ln(x + y + z) = ln(x) + ln(1 + exp(ln(y) - ln(x)) + exp(ln(z) - ln(x))),
+// ensuring that ln(x) is the biggest to maximize precision. Terms that are too
+// small to change the result are skipped without calling exp(), so the result
+// is within rounding of the exact sum. Impossible paths (-MAX_FLOAT32) stay
+// impossible.
+static inline double LogSumExp(double ln_x, double ln_y, double ln_z,
+                               double max_diff) {
+  if (ln_y > ln_x) std::swap(ln_x, ln_y);
+  if (ln_z > ln_x) std::swap(ln_x, ln_z);
+  double sum = 0.0;
+  if (ln_y - ln_x > -max_diff) sum += exp(ln_y - ln_x);
+  if (ln_z - ln_x > -max_diff) sum += exp(ln_z - ln_x);
+  return sum > 0.0 ? ln_x + log1p(sum) : ln_x;
+}
+
+// Computes log_label_probs_ and can_skip_to_ from the (final) outputs_ and
+// labels_, for use by Forward and Backward. Taking the logs once here, over
+// just the reachable labels of each timestep, replaces the 1 log per cell in
+// Forward and 3 per cell in Backward.
+void CTC::ComputeLogLabelProbs() {
+  can_skip_to_.init_to_size(num_labels_, false);
+  for (int u = 2; u < num_labels_; ++u) {
+    can_skip_to_[u] =
+        labels_[u - 1] == null_char_ && labels_[u] != labels_[u - 2];
+  }
+  log_label_probs_.Resize(num_timesteps_, num_labels_, 0.0);
+  for (int t = 0; t < num_timesteps_; ++t) {
+    // Forward needs the labels of t itself (and 0, 1 at t = 0), and Backward
+    // at t - 1 needs up to 2 labels beyond those of t - 1.
+    int min_u = t > 0 ? min_labels_[t - 1] : 0;
+    int max_u = MIN(MAX(max_labels_[t], 1) + 2, num_labels_ - 1);
+    const float* outputs_t = outputs_[t];
+    double* log_probs_t = log_label_probs_[t];
+    for (int u = min_u; u <= max_u; ++u)
+      log_probs_t[u] = log(static_cast<double>(outputs_t[labels_[u]]));
   }
 }
 
 // Runs the forward CTC pass, filling in log_probs.
+// Each timestep depends only on the previous one, so each row is computed in
+// a single pass over contiguous memory.
 void CTC::Forward(GENERIC_2D_ARRAY<double>* log_probs) const {
   log_probs->Resize(num_timesteps_, num_labels_, -MAX_FLOAT32);
-  log_probs->put(0, 0, log(outputs_(0, labels_[0])));
+  log_probs->put(0, 0, log_label_probs_(0, 0));
   if (labels_[0] == null_char_)
-    log_probs->put(0, 1, log(outputs_(0, labels_[1])));
+    log_probs->put(0, 1, log_label_probs_(0, 1));
   for (int t = 1; t < num_timesteps_; ++t) {
-    const float* outputs_t = outputs_[t];
+    const double* prev = (*log_probs)[t - 1];
+    double* curr = (*log_probs)[t];
+    const double* log_label_probs_t = log_label_probs_[t];
     for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
-      // Continuing the same label.
-      double log_sum = log_probs->get(t - 1, u);
-      // Change from previous label.
-      if (u > 0) {
-        log_sum = LogSumExp(log_sum, log_probs->get(t - 1, u - 1));
-      }
-      // Skip the null if allowed.
-      if (u >= 2 && labels_[u - 1] == null_char_ &&
-          labels_[u] != labels_[u - 2]) {
-        log_sum = LogSumExp(log_sum, log_probs->get(t - 1, u - 2));
-      }
+      // Continuing the same label, changing from the previous label, or
+      // skipping the null if allowed.
+      double ln_change = u > 0 ? prev[u - 1] : -MAX_FLOAT32;
+      double ln_skip = can_skip_to_[u] ? prev[u - 2] : -MAX_FLOAT32;
       // Add in the log prob of the current label.
-      double label_prob = outputs_t[labels_[u]];
-      log_sum += log(label_prob);
-      log_probs->put(t, u, log_sum);
+      curr[u] = LogSumExp(prev[u], ln_change, ln_skip, kMaxLogSumExpDiff_) +
+                log_label_probs_t[u];
     }
   }
 }
@@ -301,24 +330,21 @@ void CTC::Backward(GENERIC_2D_ARRAY<double>* log_probs) const {
   if (labels_[num_labels_ - 1] == null_char_)
     log_probs->put(num_timesteps_ - 1, num_labels_ - 2, 0.0);
   for (int t = num_timesteps_ - 2; t >= 0; --t) {
-    const float* outputs_tp1 = outputs_[t + 1];
+    const double* next = (*log_probs)[t + 1];
+    double* curr = (*log_probs)[t];
+    const double* log_label_probs_tp1 = log_label_probs_[t + 1];
     for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
       // Continuing the same label.
-      double log_sum = log_probs->get(t + 1, u) + log(outputs_tp1[labels_[u]]);
+      double ln_stay = next[u] + log_label_probs_tp1[u];
       // Change from previous label.
-      if (u + 1 < num_labels_) {
-        double prev_prob = outputs_tp1[labels_[u + 1]];
-        log_sum =
-            LogSumExp(log_sum, log_probs->get(t + 1, u + 1) + log(prev_prob));
-      }
+      double ln_change = u + 1 < num_labels_
+                             ? next[u + 1] + log_label_probs_tp1[u + 1]
+                             : -MAX_FLOAT32;
       // Skip the null if allowed.
-      if (u + 2 < num_labels_ && labels_[u + 1] == null_char_ &&
-          labels_[u] != labels_[u + 2]) {
-        double skip_prob = outputs_tp1[labels_[u + 2]];
-        log_sum =
-            LogSumExp(log_sum, log_probs->get(t + 1, u + 2) + log(skip_prob));
-      }
-      log_probs->put(t, u, log_sum);
+      double ln_skip = u + 2 < num_labels_ && can_skip_to_[u + 2]
+                           ? next[u + 2] + log_label_probs_tp1[u + 2]
+                           : -MAX_FLOAT32;
+      curr[u] = LogSumExp(ln_stay, ln_change, ln_skip, kMaxLogSumExpDiff_);
     }
   }
 }
@@ -326,24 +352,32 @@ void CTC::Backward(GENERIC_2D_ARRAY<double>* log_probs) const {
 // Normalizes and brings probs out of log space with a softmax over time.
 void CTC::NormalizeSequence(GENERIC_2D_ARRAY<double>* probs) const {
   double max_logprob = probs->Max();
-  for (int u = 0; u < num_labels_; ++u) {
-    double total = 0.0;
-    for (int t = 0; t < num_timesteps_; ++t) {
+  // Works a timestep (row) at a time for memory locality, accumulating the
+  // totals for all labels together.
+  GenericVector<double> totals;
+  totals.init_to_size(num_labels_, 0.0);
+  for (int t = 0; t < num_timesteps_; ++t) {
+    double* probs_t = (*probs)[t];
+    for (int u = 0; u < num_labels_; ++u) {
       // Separate impossible path from unlikely probs.
-      double prob = probs->get(t, u);
+      double prob = probs_t[u];
       if (prob > -MAX_FLOAT32)
         prob = ClippedExp(prob - max_logprob);
       else
         prob = 0.0;
-      total += prob;
-      probs->put(t, u, prob);
+      totals[u] += prob;
+      probs_t[u] = prob;
     }
-    // Note that although this is a probability distribution over time and
-    // therefore should sum to 1, it is important to allow some labels to be
-    // all zero, (or at least tiny) as it is necessary to skip some blanks.
-    if (total < kMinTotalTimeProb_) total = kMinTotalTimeProb_;
-    for (int t = 0; t < num_timesteps_; ++t)
-      probs->put(t, u, probs->get(t, u) / total);
+  }
+  // Note that although this is a probability distribution over time and
+  // therefore should sum to 1, it is important to allow some labels to be
+  // all zero, (or at least tiny) as it is necessary to skip some blanks.
+  for (int u = 0; u < num_labels_; ++u) {
+    if (totals[u] < kMinTotalTimeProb_) totals[u] = kMinTotalTimeProb_;
+  }
+  for (int t = 0; t < num_timesteps_; ++t) {
+    double* probs_t = (*probs)[t];
+    for (int u = 0; u < num_labels_; ++u) probs_t[u] /= totals[u];
   }
 }
 
@@ -389,15 +423,19 @@ void CTC::NormalizeProbs(GENERIC_2D_ARRAY<float>* probs) {
     for (int c = 0; c < num_classes; ++c) total += probs_t[c];
     if (total < kMinTotalFinalProb_) total = kMinTotalFinalProb_;
     // Compute the increased total as a result of clipping.
+    // Multiplying by the reciprocal is within an ulp of dividing, and much
+    // cheaper.
+    double scale = 1.0 / total;
     double increment = 0.0;
     for (int c = 0; c < num_classes; ++c) {
-      double prob = probs_t[c] / total;
+      double prob = probs_t[c] * scale;
       if (prob < kMinProb_) increment += kMinProb_ - prob;
     }
     // Now normalize with clipping. Any additional clipping is negligible.
     total += increment;
+    scale = 1.0 / total;
     for (int c = 0; c < num_classes; ++c) {
-      float prob = probs_t[c] / total;
+      float prob = probs_t[c] * scale;
       probs_t[c] = MAX(prob, kMinProb_);
     }
   }
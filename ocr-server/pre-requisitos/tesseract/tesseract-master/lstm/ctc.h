@@ -73,6 +73,9 @@ class CTC {
   // Calculates and returns a suitable fraction of the simple targets to add
   // to the network outputs.
   float CalculateBiasFraction();
+  // Computes log_label_probs_ and can_skip_to_ from the (final) outputs_ and
+  // labels_, for use by Forward and Backward.
+  void ComputeLogLabelProbs();
   // Runs the forward CTC pass, filling in log_probs.
   void Forward(GENERIC_2D_ARRAY<double>* log_probs) const;
   // Runs the backward CTC pass, filling in log_probs.
@@ -107,6 +110,9 @@ class CTC {
   static const double kMinTotalTimeProb_;
   // Minimum probability for total prob in final normalization.
   static const double kMinTotalFinalProb_;
+  // Largest difference of log probs for which the smaller still affects
+  // their log sum in double precision.
+  static const double kMaxLogSumExpDiff_;
 
   // The truth label indices that are to be matched to outputs_.
   const GenericVector<int>& labels_;
@@ -123,6 +129,12 @@ class CTC {
   // Min and max valid label indices for each timestep.
   GenericVector<int> min_labels_;
   GenericVector<int> max_labels_;
+  // ln(outputs_(t, labels_[u])), indexed by [t][u]. Only the range of labels
+  // that Forward and Backward can reach at each timestep is computed.
+  GENERIC_2D_ARRAY<double> log_label_probs_;
+  // True for label indices u that may be reached directly from u - 2 by
+  // skipping a null.
+  GenericVector<bool> can_skip_to_;
 };
 
 }  // namespace tesseract
@@ -308,4 +308,30 @@ void FullyConnected::CountAlternators(const Network& other, double* same,
   weights_.CountAlternators(fc->weights_, same, changed);
 }
 
+// Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+void FullyConnected::ClearDeltas() {
+  weights_.ClearDeltas();
+}
+
+// Adds the weight deltas computed by the last Backward of other, which must
+// have an identical structure, to the deltas in *this.
+void FullyConnected::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const FullyConnected* fc = static_cast<const FullyConnected*>(&other);
+  weights_.AddDeltas(fc->weights_);
+}
+
+// Multiplies the weight deltas by factor, to average summed deltas.
+void FullyConnected::ScaleDeltas(double factor) {
+  weights_.ScaleDeltas(factor);
+}
+
+// Copies the weights from other, which must have an identical structure,
+// leaving the deltas and updates in *this untouched.
+void FullyConnected::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const FullyConnected* fc = static_cast<const FullyConnected*>(&other);
+  weights_.CopyWeights(fc->weights_);
+}
+
 }  // namespace tesseract.
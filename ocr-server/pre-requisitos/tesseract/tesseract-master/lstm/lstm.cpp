@@ -61,6 +61,14 @@
 
 namespace tesseract {
 
+// Number of blocks of rows the stacked gate weights are split into, to be
+// multiplied in parallel with OpenMP, or all at once without it.
+#ifdef _OPENMP
+const int kNumFusedBlocks = kMaxFusedBlocks;
+#else
+const int kNumFusedBlocks = 1;
+#endif
+
 // Max absolute value of state_. It is reasonably high to enable the state
 // to count things.
 const double kStateClip = 100.0;
@@ -74,6 +82,7 @@ LSTM::LSTM(const STRING& name, int ni, int ns, int no, bool two_dimensional,
       ns_(ns),
       nf_(0),
       is_2d_(two_dimensional),
+      num_fused_blocks_(0),
       softmax_(NULL),
       input_width_(0) {
   if (two_dimensional) na_ += ns_;
@@ -106,6 +115,7 @@ StaticShape LSTM::OutputShape(const StaticShape& input_shape) const {
 // Suspends/Enables training by setting the training_ flag. Serialize and
 // DeSerialize only operate on the run-time data if state is false.
 void LSTM::SetEnableTraining(TrainingState state) {
+  UnfuseWeights();
   if (state == TS_RE_ENABLE) {
     // Enable only from temp disabled.
     if (training_ == TS_TEMP_DISABLE) training_ = TS_ENABLED;
@@ -128,6 +138,7 @@ void LSTM::SetEnableTraining(TrainingState state) {
 // scale `range` picked according to the random number generator `randomizer`.
 int LSTM::InitWeights(float range, TRand* randomizer) {
   Network::SetRandomizer(randomizer);
+  UnfuseWeights();
   num_weights_ = 0;
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -152,6 +163,7 @@ int LSTM::RemapOutputs(int old_no, const std::vector<int>& code_map) {
 
 // Converts a float network to an int network.
 void LSTM::ConvertToInt() {
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     gate_weights_[w].ConvertToInt();
@@ -163,6 +175,7 @@ void LSTM::ConvertToInt() {
 
 // Sets up the network for training using the given weight_range.
 void LSTM::DebugWeights() {
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     STRING msg = name_;
@@ -178,6 +191,7 @@ void LSTM::DebugWeights() {
 bool LSTM::Serialize(TFile* fp) const {
   if (!Network::Serialize(fp)) return false;
   if (fp->FWrite(&na_, sizeof(na_), 1) != 1) return false;
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     if (!gate_weights_[w].Serialize(IsTraining(), fp)) return false;
@@ -197,6 +211,7 @@ bool LSTM::DeSerialize(TFile* fp) {
   } else {
     nf_ = 0;
   }
+  UnfuseWeights();
   is_2d_ = false;
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -229,10 +244,23 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
     output->ResizeXTo1(input, no_);
   else
     output->Resize(input, no_);
+  // When not training, all the gates are computed with a single matrix
+  // product into gate_line, and the state and output with a single pass.
+  bool fused = !IsTraining();
+  if (fused)
+    FuseWeights();
+  else
+    UnfuseWeights();
   ResizeForward(input);
+  NetworkScratch::FloatVec gate_line;
   // Temporary storage of forward computation for each gate.
   NetworkScratch::FloatVec temp_lines[WT_COUNT];
-  for (int i = 0; i < WT_COUNT; ++i) temp_lines[i].Init(ns_, scratch);
+  int num_gate_rows = (Is2D() ? WT_COUNT : GFS) * ns_;
+  if (fused) {
+    gate_line.Init(WT_COUNT * ns_, scratch);
+  } else {
+    for (int i = 0; i < WT_COUNT; ++i) temp_lines[i].Init(ns_, scratch);
+  }
   // Single timestep buffers for the current/recurrent output and state.
   NetworkScratch::FloatVec curr_state, curr_output;
   curr_state.Init(ns_, scratch);
@@ -260,7 +288,7 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
   if (softmax_ != NULL) {
     softmax_output.Init(no_, scratch);
     ZeroVector<double>(no_, softmax_output);
-    int rounded_softmax_inputs = gate_weights_[CI].RoundInputs(ns_);
+    int rounded_softmax_inputs = RoundInputs(ns_);
     if (input.int_mode())
       int_output.Resize2d(true, 1, rounded_softmax_inputs, scratch);
     softmax_->SetupForward(input, NULL);
@@ -289,81 +317,99 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
     if (Is2D())
       source_.WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
     if (!source_.int_mode()) source_.ReadTimeStep(t, curr_input);
-    // Matrix multiply the inputs with the source.
-    PARALLEL_IF_OPENMP(GFS)
-    // It looks inefficient to create the threads on each t iteration, but the
-    // alternative of putting the parallel outside the t loop, a single around
-    // the t-loop and then tasks in place of the sections is a *lot* slower.
-    // Cell inputs.
-    if (source_.int_mode())
-      gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
-    else
-      gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
-    FuncInplace<GFunc>(ns_, temp_lines[CI]);
-
-    SECTION_IF_OPENMP
-    // Input Gates.
-    if (source_.int_mode())
-      gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
-    else
-      gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
-    FuncInplace<FFunc>(ns_, temp_lines[GI]);
+    if (fused) {
+      // Each block of the stacked weights writes its rows of gate_line.
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(kNumFusedBlocks)
+#endif
+      for (int b = 0; b < num_fused_blocks_; ++b) {
+        double* gates = gate_line + b * num_gate_rows / num_fused_blocks_;
+        if (source_.int_mode())
+          fused_weights_[b].MatrixDotVector(source_.i(t), gates);
+        else
+          fused_weights_[b].MatrixDotVector(curr_input, gates);
+      }
+      const double* stepped_state = NULL;
+      if (valid_2d) stepped_state = states[mod_t];
+      FusedTimeStep(gate_line, stepped_state, curr_state, curr_output);
+    } else {
+      // Matrix multiply the inputs with the source.
+      PARALLEL_IF_OPENMP(GFS)
+      // It looks inefficient to create the threads on each t iteration, but
+      // the alternative of putting the parallel outside the t loop, a single
+      // around the t-loop and then tasks in place of the sections is a *lot*
+      // slower.
+      // Cell inputs.
+      if (source_.int_mode())
+        gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
+      else
+        gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
+      FuncInplace<GFunc>(ns_, temp_lines[CI]);
 
-    SECTION_IF_OPENMP
-    // 1-D forget gates.
-    if (source_.int_mode())
-      gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
-    else
-      gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
-    FuncInplace<FFunc>(ns_, temp_lines[GF1]);
-
-    // 2-D forget gates.
-    if (Is2D()) {
+      SECTION_IF_OPENMP
+      // Input Gates.
       if (source_.int_mode())
-        gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
+        gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
       else
-        gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
-      FuncInplace<FFunc>(ns_, temp_lines[GFS]);
-    }
+        gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
+      FuncInplace<FFunc>(ns_, temp_lines[GI]);
 
-    SECTION_IF_OPENMP
-    // Output gates.
-    if (source_.int_mode())
-      gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
-    else
-      gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
-    FuncInplace<FFunc>(ns_, temp_lines[GO]);
-    END_PARALLEL_IF_OPENMP
+      SECTION_IF_OPENMP
+      // 1-D forget gates.
+      if (source_.int_mode())
+        gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
+      else
+        gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
+      FuncInplace<FFunc>(ns_, temp_lines[GF1]);
+
+      // 2-D forget gates.
+      if (Is2D()) {
+        if (source_.int_mode())
+          gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
+        else
+          gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
+        FuncInplace<FFunc>(ns_, temp_lines[GFS]);
+      }
 
-    // Apply forget gate to state.
-    MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
-    if (Is2D()) {
-      // Max-pool the forget gates (in 2-d) instead of blindly adding.
-      inT8* which_fg_col = which_fg_[t];
-      memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
-      if (valid_2d) {
-        const double* stepped_state = states[mod_t];
-        for (int i = 0; i < ns_; ++i) {
-          if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
-            curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
-            which_fg_col[i] = 2;
+      SECTION_IF_OPENMP
+      // Output gates.
+      if (source_.int_mode())
+        gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
+      else
+        gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
+      FuncInplace<FFunc>(ns_, temp_lines[GO]);
+      END_PARALLEL_IF_OPENMP
+
+      // Apply forget gate to state.
+      MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
+      if (Is2D()) {
+        // Max-pool the forget gates (in 2-d) instead of blindly adding.
+        inT8* which_fg_col = which_fg_[t];
+        memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
+        if (valid_2d) {
+          const double* stepped_state = states[mod_t];
+          for (int i = 0; i < ns_; ++i) {
+            if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
+              curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
+              which_fg_col[i] = 2;
+            }
           }
         }
       }
+      MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
+      // Clip curr_state to a sane range.
+      ClipVector<double>(ns_, -kStateClip, kStateClip, curr_state);
+      if (IsTraining()) {
+        // Save the gate node values.
+        node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
+        node_values_[GI].WriteTimeStep(t, temp_lines[GI]);
+        node_values_[GF1].WriteTimeStep(t, temp_lines[GF1]);
+        node_values_[GO].WriteTimeStep(t, temp_lines[GO]);
+        if (Is2D()) node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
+      }
+      FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
+      if (IsTraining()) state_.WriteTimeStep(t, curr_state);
     }
-    MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
-    // Clip curr_state to a sane range.
-    ClipVector<double>(ns_, -kStateClip, kStateClip, curr_state);
-    if (IsTraining()) {
-      // Save the gate node values.
-      node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
-      node_values_[GI].WriteTimeStep(t, temp_lines[GI]);
-      node_values_[GF1].WriteTimeStep(t, temp_lines[GF1]);
-      node_values_[GO].WriteTimeStep(t, temp_lines[GO]);
-      if (Is2D()) node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
-    }
-    FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
-    if (IsTraining()) state_.WriteTimeStep(t, curr_state);
     if (softmax_ != NULL) {
       if (input.int_mode()) {
         int_output->WriteTimeStepPart(0, 0, ns_, curr_output);
@@ -407,12 +453,82 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
   if (debug) DisplayForward(*output);
 }
 
+// Moves the gate weights into fused_weights_, stacked in WeightType order,
+// so that Forward can compute all the gates with a single product. The stack
+// is split into kNumFusedBlocks blocks of rows to run in parallel. The gate
+// matrices give up their weights, so only one copy is kept.
+void LSTM::FuseWeights() {
+  if (num_fused_blocks_ > 0) return;
+  int num_gates = Is2D() ? WT_COUNT : GFS;
+  int num_rows = num_gates * ns_;
+  for (int b = 0; b < kNumFusedBlocks; ++b) {
+    int first_row = b * num_rows / kNumFusedBlocks;
+    int end_row = (b + 1) * num_rows / kNumFusedBlocks;
+    fused_weights_[b].InitFromStack(gate_weights_, num_gates, first_row,
+                                    end_row - first_row);
+  }
+  for (int w = 0; w < num_gates; ++w) gate_weights_[w].ReleaseWeights();
+  num_fused_blocks_ = kNumFusedBlocks;
+}
+
+// Moves the weights back from fused_weights_ to gate_weights_. Must be
+// called before anything other than the inference Forward uses them.
+void LSTM::UnfuseWeights() const {
+  if (num_fused_blocks_ == 0) return;
+  int num_gates = Is2D() ? WT_COUNT : GFS;
+  for (int w = 0; w < num_gates; ++w) {
+    gate_weights_[w].InitFromStack(fused_weights_, num_fused_blocks_, w * ns_,
+                                   ns_);
+  }
+  for (int b = 0; b < num_fused_blocks_; ++b)
+    fused_weights_[b].ReleaseWeights();
+  num_fused_blocks_ = 0;
+}
+
+// Returns the size rounded up to the input factor of the gate weights.
+int LSTM::RoundInputs(int size) const {
+  if (num_fused_blocks_ > 0) return fused_weights_[0].RoundInputs(size);
+  return gate_weights_[CI].RoundInputs(size);
+}
+
+// Computes the state and output of one inference timestep from gates, the
+// weighted inputs to all the gates, ns_ each, in WeightType order.
+// stepped_state is the state at the previous timestep in the 2nd dimension,
+// or NULL if there is none. Performs the same arithmetic as the separate
+// passes over the gate vectors in the training path, so the results are
+// identical, but keeps each element in registers from start to finish.
+void LSTM::FusedTimeStep(const double* gates, const double* stepped_state,
+                         double* curr_state, double* curr_output) const {
+  const double* ci = gates + CI * ns_;
+  const double* gi = gates + GI * ns_;
+  const double* gf1 = gates + GF1 * ns_;
+  const double* go = gates + GO * ns_;
+  const double* gfs = gates + GFS * ns_;
+  GFunc g_func;
+  FFunc f_func;
+  HFunc h_func;
+  for (int i = 0; i < ns_; ++i) {
+    double forget = f_func(gf1[i]);
+    double state = curr_state[i] * forget;
+    if (stepped_state != NULL) {
+      // Max-pool the forget gates.
+      double forget_2d = f_func(gfs[i]);
+      if (forget < forget_2d) state = forget_2d * stepped_state[i];
+    }
+    state += g_func(ci[i]) * f_func(gi[i]);
+    state = ClipToRange(state, -kStateClip, kStateClip);
+    curr_state[i] = state;
+    curr_output[i] = h_func(state) * f_func(go[i]);
+  }
+}
+
 // Runs backward propagation of errors on the deltas line.
 // See NetworkCpp for a detailed discussion of the arguments.
 bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
                     NetworkScratch* scratch,
                     NetworkIO* back_deltas) {
   if (debug) DisplayBackward(fwd_deltas);
+  UnfuseWeights();
   back_deltas->ResizeToMap(fwd_deltas.int_mode(), input_map_, ni_);
   // ======Scratch space.======
   // Output errors from deltas with recurrence from sourceerr.
@@ -640,6 +756,7 @@ void LSTM::Update(float learning_rate, float momentum, float adam_beta,
 #if DEBUG_DETAIL > 3
   PrintW();
 #endif
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     gate_weights_[w].Update(learning_rate, momentum, adam_beta, num_samples);
@@ -659,6 +776,8 @@ void LSTM::CountAlternators(const Network& other, double* same,
                             double* changed) const {
   ASSERT_HOST(other.type() == type_);
   const LSTM* lstm = static_cast<const LSTM*>(&other);
+  UnfuseWeights();
+  lstm->UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     gate_weights_[w].CountAlternators(lstm->gate_weights_[w], same, changed);
@@ -668,9 +787,62 @@ void LSTM::CountAlternators(const Network& other, double* same,
   }
 }
 
+// Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+void LSTM::ClearDeltas() {
+  UnfuseWeights();
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].ClearDeltas();
+  }
+  if (softmax_ != NULL) softmax_->ClearDeltas();
+}
+
+// Adds the weight deltas computed by the last Backward of other, which must
+// have an identical structure, to the deltas in *this.
+void LSTM::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM* lstm = static_cast<const LSTM*>(&other);
+  UnfuseWeights();
+  lstm->UnfuseWeights();
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].AddDeltas(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != NULL) {
+    softmax_->AddDeltas(*lstm->softmax_);
+  }
+}
+
+// Multiplies the weight deltas by factor, to average summed deltas.
+void LSTM::ScaleDeltas(double factor) {
+  UnfuseWeights();
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].ScaleDeltas(factor);
+  }
+  if (softmax_ != NULL) softmax_->ScaleDeltas(factor);
+}
+
+// Copies the weights from other, which must have an identical structure,
+// leaving the deltas and updates in *this untouched.
+void LSTM::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM* lstm = static_cast<const LSTM*>(&other);
+  UnfuseWeights();
+  lstm->UnfuseWeights();
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].CopyWeights(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != NULL) {
+    softmax_->CopyWeights(*lstm->softmax_);
+  }
+}
+
 // Prints the weights for debug purposes.
 void LSTM::PrintW() {
   tprintf("Weight state:%s\n", name_.string());
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     tprintf("Gate %d, inputs\n", w);
@@ -697,6 +869,7 @@ void LSTM::PrintW() {
 // Prints the weight deltas for debug purposes.
 void LSTM::PrintDW() {
   tprintf("Delta state:%s\n", name_.string());
+  UnfuseWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     tprintf("Gate %d, inputs\n", w);
@@ -722,7 +895,7 @@ void LSTM::PrintDW() {
 
 // Resizes forward data to cope with an input image of the given width.
 void LSTM::ResizeForward(const NetworkIO& input) {
-  int rounded_inputs = gate_weights_[CI].RoundInputs(na_);
+  int rounded_inputs = RoundInputs(na_);
   source_.Resize(input, rounded_inputs);
   which_fg_.ResizeNoInit(input.Width(), ns_);
   if (IsTraining()) {
@@ -24,6 +24,10 @@
 
 namespace tesseract {
 
+// Max number of blocks of rows that the stacked gate weights are split into
+// for inference, so that the blocks can be multiplied in parallel.
+const int kMaxFusedBlocks = 4;
+
 // C++ Implementation of the LSTM class from lstm.py.
 class LSTM : public Network {
  public:
@@ -111,6 +115,16 @@ class LSTM : public Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const;
+  // Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+  void ClearDeltas() override;
+  // Adds the weight deltas computed by the last Backward of other, which must
+  // have an identical structure, to the deltas in *this.
+  void AddDeltas(const Network& other) override;
+  // Multiplies the weight deltas by factor, to average summed deltas.
+  void ScaleDeltas(double factor) override;
+  // Copies the weights from other, which must have an identical structure,
+  // leaving the deltas and updates in *this untouched.
+  void CopyWeights(const Network& other) override;
   // Prints the weights for debug purposes.
   void PrintW();
   // Prints the weight deltas for debug purposes.
@@ -124,6 +138,20 @@ class LSTM : public Network {
  private:
   // Resizes forward data to cope with an input image of the given width.
   void ResizeForward(const NetworkIO& input);
+  // Returns the size rounded up to the input factor of the gate weights.
+  int RoundInputs(int size) const;
+  // Moves the gate weights into fused_weights_, stacked in WeightType order,
+  // so that Forward can compute all the gates with a single product.
+  void FuseWeights();
+  // Moves the weights back from fused_weights_ to gate_weights_. Must be
+  // called before anything other than the inference Forward uses them.
+  void UnfuseWeights() const;
+  // Computes the state and output of one inference timestep from gates, the
+  // weighted inputs to all the gates, ns_ each, in WeightType order.
+  // stepped_state is the state at the previous timestep in the 2nd dimension,
+  // or NULL if there is none.
+  void FusedTimeStep(const double* gates, const double* stepped_state,
+                     double* curr_state, double* curr_output) const;
 
  private:
   // Size of padded input to weight matrices = ni_ + no_ for 1-D operation
@@ -140,8 +168,15 @@ class LSTM : public Network {
   // Flag indicating 2-D operation.
   bool is_2d_;
 
-  // Gate weight arrays of size [na + 1, no].
-  WeightMatrix gate_weights_[WT_COUNT];
+  // Gate weight arrays of size [na + 1, no]. Empty while the weights are
+  // fused. Mutable, along with the fused weights, so that const readers can
+  // unfuse them.
+  mutable WeightMatrix gate_weights_[WT_COUNT];
+  // For inference, the gate weights stacked into one matrix and split into
+  // num_fused_blocks_ blocks of consecutive rows. num_fused_blocks_ is 0 if
+  // the weights are not fused. Not serialized.
+  mutable WeightMatrix fused_weights_[kMaxFusedBlocks];
+  mutable int num_fused_blocks_;
   // Used only if this is a softmax LSTM.
   FullyConnected* softmax_;
   // Input padded with previous output of size [width, na].
@@ -68,6 +68,14 @@ LSTMRecognizer::~LSTMRecognizer() {
   delete search_;
 }
 
+// Returns the number of bytes held by the recoder tables and the beam
+// search lattice, which is retained between lines. Excludes the network.
+int LSTMRecognizer::MemoryUsed() const {
+  int total = recoder_.MemoryUsed();
+  if (search_ != NULL) total += search_->MemoryUsed();
+  return total;
+}
+
 // Loads a model from mgr, including the dictionary only if lang is not null.
 bool LSTMRecognizer::Load(const char* lang, TessdataManager* mgr) {
   TFile fp;
@@ -152,6 +152,9 @@ class LSTMRecognizer {
     return network_->NumInputs();
   }
   int null_char() const { return null_char_; }
+  // Returns the number of bytes held by the recoder tables and the beam
+  // search lattice, which is retained between lines. Excludes the network.
+  int MemoryUsed() const;
 
   // Loads a model from mgr, including the dictionary only if lang is not null.
   bool Load(const char* lang, TessdataManager* mgr);
@@ -481,6 +481,8 @@ bool LSTMTrainer::Serialize(SerializeAmount serialize_amount,
 // Reads from the given file. Returns false in case of error.
 // NOTE: It is assumed that the trainer is never read cross-endian.
 bool LSTMTrainer::DeSerialize(const TessdataManager* mgr, TFile* fp) {
+  // Any workers have the old network, so will be rebuilt when next needed.
+  workers_.clear();
   if (!LSTMRecognizer::DeSerialize(mgr, fp)) return false;
   if (fp->FRead(&learning_iteration_, sizeof(learning_iteration_), 1) != 1) {
     // Special case. If we successfully decoded the recognizer, but fail here
@@ -589,7 +591,11 @@ SubTrainerResult LSTMTrainer::UpdateSubtrainer(STRING* log_msg) {
       int target_iteration =
           sub_trainer_->training_iteration() + kNumPagesPerBatch;
       while (sub_trainer_->training_iteration() < target_iteration) {
-        sub_trainer_->TrainOnLine(this, false);
+        // Train it the same way as *this is being trained.
+        if (batch_threads_ > 1)
+          sub_trainer_->TrainOnBatch(this, batch_threads_);
+        else
+          sub_trainer_->TrainOnLine(this, false);
       }
       STRING batch_log = "Sub:";
       sub_trainer_->PrepareLogMsg(&batch_log);
@@ -823,6 +829,88 @@ Trainability LSTMTrainer::TrainOnLine(const ImageData* trainingdata,
   return trainable;
 }
 
+// Performs forward-backward on the next num_threads samples in parallel,
+// each on its own copy of the network, then averages their weight deltas
+// into *this in sample order and applies a single update, so the result
+// does not depend on thread timing. Error rates and iterations are accounted
+// exactly as num_threads calls to TrainOnLine would. samples_trainer could
+// be this or an alternative trainer that holds the training samples.
+// Returns the number of samples that were usable.
+int LSTMTrainer::TrainOnBatch(LSTMTrainer* samples_trainer, int num_threads) {
+  PrepareWorkers(num_threads);
+  // The samples are copied, as getting the later ones may un-cache the
+  // document that holds an earlier one.
+  PointerVector<ImageData> samples;
+  for (int w = 0; w < num_threads; ++w) {
+    const ImageData* image =
+        samples_trainer->training_data_.GetPageBySerial(sample_iteration_ + w);
+    samples.push_back(image != NULL ? new ImageData(*image) : NULL);
+  }
+  // Give each worker the iterations that TrainOnLine would be at, counting
+  // only the earlier samples whose truth can be encoded as consumed. A sample
+  // that fails later, in recognition or targets, still offsets the training
+  // iteration of those after it, which only affects the choice of debug
+  // output.
+  GenericVector<int> training_iterations;
+  int next_iteration = training_iteration_;
+  for (int w = 0; w < num_threads; ++w) {
+    training_iterations.push_back(next_iteration);
+    if (samples[w] != NULL && CanEncode(*samples[w])) ++next_iteration;
+  }
+  batch_threads_ = num_threads;
+  GenericVector<Trainability> results;
+  results.init_to_size(num_threads, UNENCODABLE);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int w = 0; w < num_threads; ++w) {
+    if (samples[w] == NULL) continue;
+    LSTMTrainer* worker = workers_[w];
+    // Keep any random elements the same as they would be in TrainOnLine.
+    worker->sample_iteration_ = sample_iteration_ + w;
+    worker->training_iteration_ = training_iterations[w];
+    results[w] = worker->ComputeDeltas(samples[w]);
+  }
+  // Account for the samples in order, exactly as TrainOnLine does, summing
+  // the deltas of those that are to be used into *this.
+  int num_usable = 0;
+  int num_deltas = 0;
+  for (int w = 0; w < num_threads; ++w) {
+    Trainability trainable = results[w];
+    if (samples[w] == NULL || trainable == UNENCODABLE ||
+        trainable == NOT_BOXED) {
+      ++sample_iteration_;
+      continue;
+    }
+    ++num_usable;
+    const LSTMTrainer* worker = workers_[w];
+    UpdateErrorBuffer(worker->NewSingleError(ET_RMS), ET_RMS);
+    UpdateErrorBuffer(worker->NewSingleError(ET_DELTA), ET_DELTA);
+    UpdateErrorBuffer(worker->NewSingleError(ET_WORD_RECERR), ET_WORD_RECERR);
+    UpdateErrorBuffer(worker->NewSingleError(ET_CHAR_ERROR), ET_CHAR_ERROR);
+    UpdateErrorBuffer(sample_iteration_ - prev_sample_iteration_,
+                      ET_SKIP_RATIO);
+    ++sample_iteration_;
+    if (network_->IsTraining() &&
+        (trainable != PERFECT ||
+         training_iteration() >
+             last_perfect_training_iteration_ + perfect_delay_)) {
+      if (num_deltas == 0) network_->ClearDeltas();
+      network_->AddDeltas(*worker->network_);
+      ++num_deltas;
+    }
+    RollErrorBuffers();
+  }
+  if (num_deltas > 0) {
+    // Average the deltas, so the learning rate means the same per update as
+    // it does for a single sample.
+    if (num_deltas > 1) network_->ScaleDeltas(1.0 / num_deltas);
+    network_->Update(learning_rate_, momentum_, adam_beta_,
+                     training_iteration_);
+  }
+  return num_usable;
+}
+
 // Prepares the ground truth, runs forward, and prepares the targets.
 // Returns a Trainability enum to indicate the suitability of the sample.
 Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
@@ -923,6 +1011,33 @@ Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
   return TRAINABLE;
 }
 
+// Runs forward and backward on the trainingdata, leaving the weight deltas
+// in the network without applying them. Used by the workers of
+// TrainOnBatch. Returns a Trainability enum as PrepareForBackward.
+Trainability LSTMTrainer::ComputeDeltas(const ImageData* trainingdata) {
+  NetworkIO fwd_outputs, targets;
+  Trainability trainable =
+      PrepareForBackward(trainingdata, &fwd_outputs, &targets);
+  if (trainable != UNENCODABLE && trainable != NOT_BOXED &&
+      network_->IsTraining()) {
+    NetworkIO bp_deltas;
+    network_->Backward(false, targets, &scratch_space_, &bp_deltas);
+  }
+  return trainable;
+}
+
+// Returns true if the transcription of trainingdata encodes to labels that
+// are not all space or null, as PrepareForBackward requires.
+bool LSTMTrainer::CanEncode(const ImageData& trainingdata) const {
+  GenericVector<int> truth_labels;
+  if (!EncodeString(trainingdata.transcription(), &truth_labels)) return false;
+  for (int c = 0; c < truth_labels.size(); ++c) {
+    if (truth_labels[c] != UNICHAR_SPACE && truth_labels[c] != null_char_)
+      return true;
+  }
+  return false;
+}
+
 // Writes the trainer to memory, so that the current training state can be
 // restored.  *this must always be the master trainer that retains the only
 // copy of the training data and language model. trainer is the model that is
@@ -1047,11 +1162,32 @@ void LSTMTrainer::EmptyConstructor() {
   ctc_win_ = NULL;
   recon_win_ = NULL;
   checkpoint_iteration_ = 0;
+  batch_threads_ = 1;
   training_stage_ = 0;
   num_training_stages_ = 2;
   InitIterations();
 }
 
+// Makes sure that workers_ holds num_workers copies of *this for
+// TrainOnBatch, each with the current weights of *this.
+void LSTMTrainer::PrepareWorkers(int num_workers) {
+  if (workers_.size() == num_workers &&
+      workers_[0]->network_->num_weights() == network_->num_weights()) {
+    for (int w = 0; w < num_workers; ++w)
+      workers_[w]->network_->CopyWeights(*network_);
+    return;
+  }
+  workers_.clear();
+  GenericVector<char> trainer_data;
+  SaveTrainingDump(LIGHT, this, &trainer_data);
+  for (int w = 0; w < num_workers; ++w) {
+    LSTMTrainer* worker = new LSTMTrainer;
+    ASSERT_HOST(ReadTrainingDump(trainer_data, worker));
+    worker->randomly_rotate_ = randomly_rotate_;
+    workers_.push_back(worker);
+  }
+}
+
 // Outputs the string and periodically displays the given network inputs
 // as an image in the given window, and the corresponding labels at the
 // corresponding x_starts.
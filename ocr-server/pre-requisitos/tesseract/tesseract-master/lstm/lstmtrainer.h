@@ -271,11 +271,26 @@ class LSTMTrainer : public LSTMRecognizer {
     return image;
   }
   Trainability TrainOnLine(const ImageData* trainingdata, bool batch);
+  // Performs forward-backward on the next num_threads samples in parallel,
+  // each on its own copy of the network, then averages their weight deltas
+  // into *this in sample order and applies a single update, so the result
+  // does not depend on thread timing. Error rates and iterations are accounted
+  // exactly as num_threads calls to TrainOnLine would. samples_trainer could
+  // be this or an alternative trainer that holds the training samples.
+  // Returns the number of samples that were usable.
+  int TrainOnBatch(LSTMTrainer* samples_trainer, int num_threads);
 
   // Prepares the ground truth, runs forward, and prepares the targets.
   // Returns a Trainability enum to indicate the suitability of the sample.
   Trainability PrepareForBackward(const ImageData* trainingdata,
                                   NetworkIO* fwd_outputs, NetworkIO* targets);
+  // Runs forward and backward on the trainingdata, leaving the weight deltas
+  // in the network without applying them. Used by the workers of
+  // TrainOnBatch. Returns a Trainability enum as PrepareForBackward.
+  Trainability ComputeDeltas(const ImageData* trainingdata);
+  // Returns true if the transcription of trainingdata encodes to labels that
+  // are not all space or null, as PrepareForBackward requires.
+  bool CanEncode(const ImageData& trainingdata) const;
 
   // Writes the trainer to memory, so that the current training state can be
   // restored.  *this must always be the master trainer that retains the only
@@ -331,6 +346,10 @@ class LSTMTrainer : public LSTMRecognizer {
   // Factored sub-constructor sets up reasonable default values.
   void EmptyConstructor();
 
+  // Makes sure that workers_ holds num_workers copies of *this for
+  // TrainOnBatch, each with the current weights of *this.
+  void PrepareWorkers(int num_workers);
+
   // Outputs the string and periodically displays the given network inputs
   // as an image in the given window, and the corresponding labels at the
   // corresponding x_starts.
@@ -448,6 +467,12 @@ class LSTMTrainer : public LSTMRecognizer {
   // A subsidiary trainer running with a different learning rate until either
   // *this or sub_trainer_ hits a new best.
   LSTMTrainer* sub_trainer_;
+  // Copies of *this that compute deltas in parallel for TrainOnBatch.
+  // Not serialized, and rebuilt whenever the network may have changed.
+  PointerVector<LSTMTrainer> workers_;
+  // Number of samples per update of the last TrainOnBatch, or 1 if it has
+  // not been used. Used to train the sub_trainer_ the same way.
+  int batch_threads_;
   // Error rate at which last best model was dumped.
   float error_rate_of_last_saved_best_;
   // Current stage of training.
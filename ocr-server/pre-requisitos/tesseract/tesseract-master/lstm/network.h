@@ -235,6 +235,16 @@ class Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const {}
+  // Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+  virtual void ClearDeltas() {}
+  // Adds the weight deltas computed by the last Backward of other, which must
+  // have an identical structure, to the deltas in *this.
+  virtual void AddDeltas(const Network& other) {}
+  // Multiplies the weight deltas by factor, to average summed deltas.
+  virtual void ScaleDeltas(double factor) {}
+  // Copies the weights from other, which must have an identical structure,
+  // leaving the deltas and updates in *this untouched.
+  virtual void CopyWeights(const Network& other) {}
 
   // Reads from the given file. Returns NULL in case of error.
   // Determines the type of the serialized class and calls its DeSerialize
@@ -967,9 +967,7 @@ void NetworkIO::CopyUnpacking(const NetworkIO& src, int feature_offset,
 
 // Transposes the float part of *this into dest.
 void NetworkIO::Transpose(TransposedArray* dest) const {
-  int width = Width();
-  dest->ResizeNoInit(NumFeatures(), width);
-  for (int t = 0; t < width; ++t) dest->WriteStrided(t, f_[t]);
+  dest->Transpose(f_);
 }
 
 // Clips the content of a single time-step to +/-range.
@@ -243,5 +243,35 @@ void Plumbing::CountAlternators(const Network& other, double* same,
     stack_[i]->CountAlternators(*plumbing->stack_[i], same, changed);
 }
 
+// Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+void Plumbing::ClearDeltas() {
+  for (int i = 0; i < stack_.size(); ++i) stack_[i]->ClearDeltas();
+}
+
+// Adds the weight deltas computed by the last Backward of other, which must
+// have an identical structure, to the deltas in *this.
+void Plumbing::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const Plumbing* plumbing = static_cast<const Plumbing*>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->AddDeltas(*plumbing->stack_[i]);
+}
+
+// Multiplies the weight deltas by factor, to average summed deltas.
+void Plumbing::ScaleDeltas(double factor) {
+  for (int i = 0; i < stack_.size(); ++i) stack_[i]->ScaleDeltas(factor);
+}
+
+// Copies the weights from other, which must have an identical structure,
+// leaving the deltas and updates in *this untouched.
+void Plumbing::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const Plumbing* plumbing = static_cast<const Plumbing*>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->CopyWeights(*plumbing->stack_[i]);
+}
+
 }  // namespace tesseract.
 
@@ -130,6 +130,16 @@ class Plumbing : public Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const;
+  // Sets the weight deltas to zero, ready to sum deltas with AddDeltas.
+  void ClearDeltas() override;
+  // Adds the weight deltas computed by the last Backward of other, which must
+  // have an identical structure, to the deltas in *this.
+  void AddDeltas(const Network& other) override;
+  // Multiplies the weight deltas by factor, to average summed deltas.
+  void ScaleDeltas(double factor) override;
+  // Copies the weights from other, which must have an identical structure,
+  // leaving the deltas and updates in *this untouched.
+  void CopyWeights(const Network& other) override;
 
  protected:
   // The networks.
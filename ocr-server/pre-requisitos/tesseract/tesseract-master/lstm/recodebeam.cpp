@@ -96,6 +96,20 @@ void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float>& output,
   }
 }
 
+// Returns the number of bytes held by the beam lattice and top-n workspace,
+// which persist between calls to Decode.
+int RecodeBeamSearch::MemoryUsed() const {
+  int total = top_n_flags_.size_reserved() * sizeof(TopNState) +
+              top_heap_.size_reserved() * sizeof(TopPair);
+  for (int t = 0; t < beam_.size(); ++t) {
+    total += sizeof(RecodeBeam);
+    for (int i = 0; i < kNumBeams; ++i) {
+      total += beam_[t]->beams_[i].size_reserved() * sizeof(RecodePair);
+    }
+  }
+  return total;
+}
+
 // Returns the best path as labels/scores/xcoords similar to simple CTC.
 void RecodeBeamSearch::ExtractBestPathAsLabels(
     GenericVector<int>* labels, GenericVector<int>* xcoords) const {
@@ -500,10 +514,11 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
                               NC_ANYTHING, prev, step);
     }
   }
-  const GenericVector<int>* final_codes = recoder_.GetFinalCodes(prefix);
+  int num_final_codes;
+  const int* final_codes = recoder_.GetFinalCodes(prefix, &num_final_codes);
   if (final_codes != NULL) {
-    for (int i = 0; i < final_codes->size(); ++i) {
-      int code = (*final_codes)[i];
+    for (int i = 0; i < num_final_codes; ++i) {
+      int code = final_codes[i];
       if (top_n_flags_[code] != top_n_flag) continue;
       if (prev != nullptr && prev->code == code && !is_simple_text_) continue;
       float cert = NetworkIO::ProbToCertainty(outputs[code]) + cert_offset;
@@ -528,10 +543,11 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
       }
     }
   }
-  const GenericVector<int>* next_codes = recoder_.GetNextCodes(prefix);
+  int num_next_codes;
+  const int* next_codes = recoder_.GetNextCodes(prefix, &num_next_codes);
   if (next_codes != NULL) {
-    for (int i = 0; i < next_codes->size(); ++i) {
-      int code = (*next_codes)[i];
+    for (int i = 0; i < num_next_codes; ++i) {
+      int code = next_codes[i];
       if (top_n_flags_[code] != top_n_flag) continue;
       if (prev != nullptr && prev->code == code && !is_simple_text_) continue;
       float cert = NetworkIO::ProbToCertainty(outputs[code]) + cert_offset;
@@ -206,6 +206,10 @@ class RecodeBeamSearch {
   // Generates debug output of the content of the beams after a Decode.
   void DebugBeams(const UNICHARSET& unicharset) const;
 
+  // Returns the number of bytes held by the beam lattice and top-n workspace,
+  // which persist between calls to Decode.
+  int MemoryUsed() const;
+
   // Clipping value for certainty inside Tesseract. Reflects the minimum value
   // of certainty that will be returned by ExtractBestPathAsUnicharIds.
   // Supposedly on a uniform scale that can be compared across languages and
@@ -234,6 +238,15 @@ class RecodeBeamSearch {
   // a single time-step position of the output. Use a PointerVector<RecodeBeam>
   // to hold all the timesteps and prevent reallocation of the individual heaps.
   struct RecodeBeam {
+    // Releases the default reservation of each heap, as most of the kNumBeams
+    // combinations are never used for a given model, and a line may have
+    // thousands of timesteps. Heaps that are used grow on demand and keep
+    // their memory when the beam is reused for later lines.
+    RecodeBeam() {
+      for (int i = 0; i < kNumBeams; ++i) {
+        beams_[i].heap()->clear();
+      }
+    }
     // Resets to the initial state without deleting all the memory.
     void Clear() {
       for (int i = 0; i < kNumBeams; ++i) {
@@ -32,12 +32,38 @@ const int kAdamCorrectionIterations = 200000;
 // Epsilon in Adam to prevent division by zero.
 const double kAdamEpsilon = 1e-8;
 
-// Copies the whole input transposed, converted to double, into *this.
-void TransposedArray::Transpose(const GENERIC_2D_ARRAY<double>& input) {
+// Number of rows of u that SumOuterTransposed processes together, sharing
+// each load of a row of v.
+const int kNumOuterRows = 4;
+// Size of the square blocks used by the transposes.
+const int kTransposeBlockSize = 8;
+
+// Copies input transposed, converted to double, into *result. Works in square
+// blocks, so both the reads and the strided writes stay in cache.
+template <typename T>
+static void TransposeBlocked(const GENERIC_2D_ARRAY<T>& input,
+                             GENERIC_2D_ARRAY<double>* result) {
   int width = input.dim1();
   int num_features = input.dim2();
-  ResizeNoInit(num_features, width);
-  for (int t = 0; t < width; ++t) WriteStrided(t, input[t]);
+  result->ResizeNoInit(num_features, width);
+  for (int t0 = 0; t0 < width; t0 += kTransposeBlockSize) {
+    int t_end = MIN(t0 + kTransposeBlockSize, width);
+    for (int i0 = 0; i0 < num_features; i0 += kTransposeBlockSize) {
+      int i_end = MIN(i0 + kTransposeBlockSize, num_features);
+      for (int t = t0; t < t_end; ++t) {
+        const T* input_t = input[t];
+        for (int i = i0; i < i_end; ++i) (*result)(i, t) = input_t[i];
+      }
+    }
+  }
+}
+
+// Copies the whole input transposed, converted to double, into *this.
+void TransposedArray::Transpose(const GENERIC_2D_ARRAY<double>& input) {
+  TransposeBlocked(input, this);
+}
+void TransposedArray::Transpose(const GENERIC_2D_ARRAY<float>& input) {
+  TransposeBlocked(input, this);
 }
 
 // Sets up the network for training. Initializes weights using weights of
@@ -116,6 +142,60 @@ void WeightMatrix::ConvertToInt() {
   if (multiplier_ != nullptr) multiplier_->Init(wi_);
 }
 
+// Sets the weights of *this to num_rows rows of the stack of the num_parts
+// matrices in parts, taken in turn, starting at first_row of the stack, so
+// that MatrixDotVector computes those outputs of all the parts in the same
+// order with identical results. The rows and int8 scales are copied as they
+// are, so the dot product of each row is unchanged.
+void WeightMatrix::InitFromStack(const WeightMatrix* parts, int num_parts,
+                                 int first_row, int num_rows) {
+  int_mode_ = parts[0].int_mode_;
+  int dim2 = int_mode_ ? parts[0].wi_.dim2() : parts[0].wf_.dim2();
+  if (int_mode_) {
+    wi_.ResizeNoInit(num_rows, dim2);
+    scales_.init_to_size(num_rows, 0.0);
+  } else {
+    wf_.ResizeNoInit(num_rows, dim2);
+  }
+  int row = 0;
+  for (int p = 0; p < num_parts && row < num_rows; ++p) {
+    const WeightMatrix& part = parts[p];
+    ASSERT_HOST(part.int_mode_ == int_mode_);
+    int part_rows = part.NumOutputs();
+    // Skip the parts that lie wholly before first_row.
+    int part_row = first_row;
+    if (part_row >= part_rows) {
+      first_row -= part_rows;
+      continue;
+    }
+    first_row = 0;
+    for (; part_row < part_rows && row < num_rows; ++part_row, ++row) {
+      if (int_mode_) {
+        ASSERT_HOST(part.wi_.dim2() == dim2);
+        memcpy(wi_[row], part.wi_[part_row], dim2 * sizeof(wi_[row][0]));
+        scales_[row] = part.scales_[part_row];
+      } else {
+        ASSERT_HOST(part.wf_.dim2() == dim2);
+        memcpy(wf_[row], part.wf_[part_row], dim2 * sizeof(wf_[row][0]));
+      }
+    }
+  }
+  ASSERT_HOST(row == num_rows);
+  if (int_mode_) {
+    multiplier_.reset(IntSimdMatrix::GetFastestMultiplier());
+    if (multiplier_ != nullptr) multiplier_->Init(wi_);
+  }
+}
+
+// Frees the weights, keeping the mode and deltas, while InitFromStack has
+// put them in another matrix.
+void WeightMatrix::ReleaseWeights() {
+  wf_ = GENERIC_2D_ARRAY<double>();
+  wi_ = GENERIC_2D_ARRAY<inT8>();
+  scales_.clear();
+  multiplier_.reset();
+}
+
 // Allocates any needed memory for running Backward, and zeroes the deltas,
 // thus eliminating any existing momentum.
 void WeightMatrix::InitBackward() {
@@ -255,19 +335,33 @@ void WeightMatrix::SumOuterTransposed(const TransposedArray& u,
   int num_samples = u.dim2();
   // v is missing the last element in dim1.
   ASSERT_HOST(v.dim1() == num_inputs);
+  // Works on tiles of kNumOuterRows rows of u, so each row of v is loaded
+  // once per tile instead of once per row of u, while the tile stays in
+  // cache. The result of each dot product is unchanged.
+  bool use_avx = SIMDDetect::IsAVXAvailable();
 #ifdef _OPENMP
 #pragma omp parallel for num_threads(4) if (in_parallel)
 #endif
-  for (int i = 0; i < num_outputs; ++i) {
-    double* dwi = dw_[i];
-    const double* ui = u[i];
+  for (int i0 = 0; i0 < num_outputs; i0 += kNumOuterRows) {
+    int num_rows = MIN(kNumOuterRows, num_outputs - i0);
+    const double* u_rows[kNumOuterRows];
+    for (int r = 0; r < num_rows; ++r) u_rows[r] = u[i0 + r];
+    double results[kNumOuterRows];
     for (int j = 0; j < num_inputs; ++j) {
-      dwi[j] = DotProduct(ui, v[j], num_samples);
+      if (use_avx && num_rows == kNumOuterRows) {
+        DotProduct4AVX(u_rows, v[j], num_samples, results);
+      } else {
+        for (int r = 0; r < num_rows; ++r)
+          results[r] = DotProduct(u_rows[r], v[j], num_samples);
+      }
+      for (int r = 0; r < num_rows; ++r) dw_[i0 + r][j] = results[r];
     }
     // The last element of v is missing, presumed 1.0f.
-    double total = 0.0;
-    for (int k = 0; k < num_samples; ++k) total += ui[k];
-    dwi[num_inputs] = total;
+    for (int r = 0; r < num_rows; ++r) {
+      double total = 0.0;
+      for (int k = 0; k < num_samples; ++k) total += u_rows[r][k];
+      dw_[i0 + r][num_inputs] = total;
+    }
   }
 }
 
@@ -303,6 +397,16 @@ void WeightMatrix::AddDeltas(const WeightMatrix& other) {
   dw_ += other.dw_;
 }
 
+// Copies just the float weights (and their transpose) from other, which
+// must be the same shape, leaving deltas and updates untouched.
+void WeightMatrix::CopyWeights(const WeightMatrix& other) {
+  ASSERT_HOST(!int_mode_ && !other.int_mode_);
+  ASSERT_HOST(wf_.dim1() == other.wf_.dim1());
+  ASSERT_HOST(wf_.dim2() == other.wf_.dim2());
+  wf_ = other.wf_;
+  wf_t_ = other.wf_t_;
+}
+
 // Sums the products of weight updates in *this and other, splitting into
 // positive (same direction) in *same and negative (different direction) in
 // *changed.
@@ -34,6 +34,7 @@ class TransposedArray : public GENERIC_2D_ARRAY<double> {
  public:
   // Copies the whole input transposed, converted to double, into *this.
   void Transpose(const GENERIC_2D_ARRAY<double>& input);
+  void Transpose(const GENERIC_2D_ARRAY<float>& input);
   // Writes a vector of data representing a timestep (gradients or sources).
   // The data is assumed to be of size1 in size (the strided dimension).
   void WriteStrided(int t, const float* data) {
@@ -87,6 +88,16 @@ class WeightMatrix {
   // Store a multiplicative scale factor (as a float) that will reproduce
   //   the original value, subject to rounding errors.
   void ConvertToInt();
+  // Sets the weights of *this to num_rows rows of the stack of the num_parts
+  // matrices in parts, taken in turn, starting at first_row of the stack, so
+  // that MatrixDotVector computes those outputs of all the parts in the same
+  // order with identical results. The parts must all have the same mode and
+  // number of inputs. Only the weights are set: the deltas are untouched.
+  void InitFromStack(const WeightMatrix* parts, int num_parts, int first_row,
+                     int num_rows);
+  // Frees the weights, keeping the mode and deltas, while InitFromStack has
+  // put them in another matrix.
+  void ReleaseWeights();
   // Returns the size rounded up to an internal factor used by the SIMD
   // implementation for its input.
   int RoundInputs(int size) const {
@@ -143,6 +154,13 @@ class WeightMatrix {
               int num_samples);
   // Adds the dw_ in other to the dw_ is *this.
   void AddDeltas(const WeightMatrix& other);
+  // Sets all of dw_ to zero, ready to sum deltas with AddDeltas.
+  void ClearDeltas() { dw_.Clear(); }
+  // Multiplies all of dw_ by factor, to average summed deltas.
+  void ScaleDeltas(double factor) { dw_ *= factor; }
+  // Copies just the float weights (and their transpose) from other, which
+  // must be the same shape, leaving deltas and updates untouched.
+  void CopyWeights(const WeightMatrix& other);
   // Sums the products of weight updates in *this and other, splitting into
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
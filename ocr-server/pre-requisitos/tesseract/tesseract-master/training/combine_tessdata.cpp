@@ -151,6 +151,33 @@ int main(int argc, char **argv) {
       tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
       exit(1);
     }
+  } else if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+    if (!tm.Init(argv[2])) {
+      tprintf("Failed to read %s\n", argv[2]);
+      exit(1);
+    }
+    // Rewrite the unicharsets in the faster-loading binary format.
+    const tesseract::TessdataType kUnicharsets[] = {
+        tesseract::TESSDATA_UNICHARSET, tesseract::TESSDATA_LSTM_UNICHARSET};
+    for (int u = 0; u < 2; ++u) {
+      tesseract::TFile fp;
+      if (!tm.GetComponent(kUnicharsets[u], &fp)) continue;
+      UNICHARSET unicharset;
+      if (!unicharset.load_from_file(&fp, false)) {
+        tprintf("Failed to read unicharset %d in %s!\n", kUnicharsets[u],
+                argv[2]);
+        exit(1);
+      }
+      GenericVector<char> unicharset_data;
+      fp.OpenWrite(&unicharset_data);
+      ASSERT_HOST(unicharset.save_binary(&fp));
+      tm.OverwriteEntry(kUnicharsets[u], &unicharset_data[0],
+                        unicharset_data.size());
+    }
+    if (!tm.SaveFile(argv[2], nullptr)) {
+      tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
+      exit(1);
+    }
   } else if (argc == 3 && strcmp(argv[1], "-d") == 0) {
     // Initialize TessdataManager with the data in the given traineddata file.
     tm.Init(argv[2]);
@@ -177,6 +204,11 @@ int main(int argc, char **argv) {
         "Usage for compacting LSTM component to int:\n"
         "  %s -c traineddata_file\n",
         argv[0]);
+    printf(
+        "Usage for converting unicharset components to the binary format,\n"
+        "which loads faster, but only with this or later versions:\n"
+        "  %s -b traineddata_file\n",
+        argv[0]);
     return 1;
   }
   tm.Directory();
@@ -15,9 +15,8 @@ namespace tesseract {
 bool IntFlagExists(const char* flag_name, inT32* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<IntParam*> empty;
   IntParam *p = ParamUtils::FindParam<IntParam>(
-      full_flag_name.string(), GlobalParams()->int_params, empty);
+      full_flag_name.string(), GlobalParams()->int_index, nullptr);
   if (p == nullptr) return false;
   *value = (inT32)(*p);
   return true;
@@ -26,9 +25,8 @@ bool IntFlagExists(const char* flag_name, inT32* value) {
 bool DoubleFlagExists(const char* flag_name, double* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<DoubleParam*> empty;
   DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      full_flag_name.string(), GlobalParams()->double_params, empty);
+      full_flag_name.string(), GlobalParams()->double_index, nullptr);
   if (p == nullptr) return false;
   *value = static_cast<double>(*p);
   return true;
@@ -37,9 +35,8 @@ bool DoubleFlagExists(const char* flag_name, double* value) {
 bool BoolFlagExists(const char* flag_name, bool* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<BoolParam*> empty;
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      full_flag_name.string(), GlobalParams()->bool_params, empty);
+      full_flag_name.string(), GlobalParams()->bool_index, nullptr);
   if (p == nullptr) return false;
   *value = (BOOL8)(*p);
   return true;
@@ -48,9 +45,8 @@ bool BoolFlagExists(const char* flag_name, bool* value) {
 bool StringFlagExists(const char* flag_name, const char** value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<StringParam*> empty;
   StringParam *p = ParamUtils::FindParam<StringParam>(
-      full_flag_name.string(), GlobalParams()->string_params, empty);
+      full_flag_name.string(), GlobalParams()->string_index, nullptr);
   *value = (p != nullptr) ? p->string() : nullptr;
   return p != nullptr;
 }
@@ -59,9 +55,8 @@ bool StringFlagExists(const char* flag_name, const char** value) {
 void SetIntFlagValue(const char* flag_name, const inT32 new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<IntParam*> empty;
   IntParam *p = ParamUtils::FindParam<IntParam>(
-      full_flag_name.string(), GlobalParams()->int_params, empty);
+      full_flag_name.string(), GlobalParams()->int_index, nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -69,9 +64,8 @@ void SetIntFlagValue(const char* flag_name, const inT32 new_val) {
 void SetDoubleFlagValue(const char* flag_name, const double new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<DoubleParam*> empty;
   DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      full_flag_name.string(), GlobalParams()->double_params, empty);
+      full_flag_name.string(), GlobalParams()->double_index, nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -79,9 +73,8 @@ void SetDoubleFlagValue(const char* flag_name, const double new_val) {
 void SetBoolFlagValue(const char* flag_name, const bool new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<BoolParam*> empty;
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      full_flag_name.string(), GlobalParams()->bool_params, empty);
+      full_flag_name.string(), GlobalParams()->bool_index, nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -89,9 +82,8 @@ void SetBoolFlagValue(const char* flag_name, const bool new_val) {
 void SetStringFlagValue(const char* flag_name, const char* new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<StringParam*> empty;
   StringParam *p = ParamUtils::FindParam<StringParam>(
-      full_flag_name.string(), GlobalParams()->string_params, empty);
+      full_flag_name.string(), GlobalParams()->string_index, nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(STRING(new_val));
 }
@@ -62,6 +62,8 @@ STRING_PARAM_FLAG(old_traineddata, "",
                   " character set that is to be replaced");
 BOOL_PARAM_FLAG(randomly_rotate, false,
                 "Train OSD and randomly turn training samples upside-down");
+INT_PARAM_FLAG(train_threads, 1, "Number of samples to train on in parallel,"
+               " each with its own thread, averaging their weight deltas");
 
 // Number of training images to train between calls to MaintainCheckpoints.
 const int kNumPagesPerBatch = 100;
@@ -177,6 +179,10 @@ int main(int argc, char **argv) {
     tprintf("Load of images failed!!\n");
     return 1;
   }
+  if (FLAGS_train_threads > 1) {
+    // Keep the next couple of batches loading in the background.
+    trainer.mutable_training_data()->set_read_ahead(2 * FLAGS_train_threads);
+  }
 
   tesseract::LSTMTester tester(static_cast<inT64>(FLAGS_max_image_MB) *
                                1048576);
@@ -196,7 +202,10 @@ int main(int argc, char **argv) {
     for (int target_iteration = iteration + kNumPagesPerBatch;
          iteration < target_iteration;
          iteration = trainer.training_iteration()) {
-      trainer.TrainOnLine(&trainer, false);
+      if (FLAGS_train_threads > 1)
+        trainer.TrainOnBatch(&trainer, FLAGS_train_threads);
+      else
+        trainer.TrainOnLine(&trainer, false);
     }
     STRING log_str;
     trainer.MaintainCheckpoints(tester_callback, &log_str);
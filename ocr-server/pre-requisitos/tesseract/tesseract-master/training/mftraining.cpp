@@ -76,6 +76,9 @@ const int kMaxShapeLabelLength = 10;
 
 DECLARE_STRING_PARAM_FLAG(test_ch);
 
+INT_PARAM_FLAG(threads, 1,
+               "Number of threads to cluster the configs with (needs OpenMP)");
+
 /*----------------------------------------------------------------------------
           Public Function Prototypes
 ----------------------------------------------------------------------------*/
@@ -122,8 +125,9 @@ static void DisplayProtoList(const char* ch, LIST protolist) {
 
 // Helper to run clustering on a single config.
 // Mostly copied from the old mftraining, but with renamed variables.
+// Returns the list of significant protos, to be merged into mf_classes by
+// MergeOneConfig. Safe to run on several configs in parallel.
 static LIST ClusterOneConfig(int shape_id, const char* class_label,
-                             LIST mf_classes,
                              const ShapeTable& shape_table,
                              MasterTrainer* trainer) {
   int num_samples;
@@ -131,13 +135,15 @@ static LIST ClusterOneConfig(int shape_id, const char* class_label,
                                                       feature_defs,
                                                       shape_id,
                                                       &num_samples);
-  Config.MagicSamples = num_samples;
-  LIST proto_list = ClusterSamples(clusterer, &Config);
+  // Local copy of the global Config, as MagicSamples varies with the config.
+  CLUSTERCONFIG config = Config;
+  config.MagicSamples = num_samples;
+  LIST proto_list = ClusterSamples(clusterer, &config);
   CleanUpUnusedData(proto_list);
 
   // Merge protos where reasonable to make more of them significant by
   // representing almost all samples of the class/font.
-  MergeInsignificantProtos(proto_list, class_label, clusterer, &Config);
+  MergeInsignificantProtos(proto_list, class_label, clusterer, &config);
   #ifndef GRAPHICS_DISABLED
   if (strcmp(FLAGS_test_ch.c_str(), class_label) == 0)
     DisplayProtoList(FLAGS_test_ch.c_str(), proto_list);
@@ -147,6 +153,15 @@ static LIST ClusterOneConfig(int shape_id, const char* class_label,
                                          false,
                                          clusterer->SampleSize);
   FreeClusterer(clusterer);
+  return proto_list;
+}
+
+// Helper to merge the protos of a single config, as produced by
+// ClusterOneConfig, into its class in mf_classes. Deletes proto_list.
+// Must be called in config order, as the protos are merged with those
+// of the previous configs of the same class.
+static LIST MergeOneConfig(int shape_id, const char* class_label,
+                           LIST proto_list, LIST mf_classes) {
   MERGE_CLASS merge_class = FindClass(mf_classes, class_label);
   if (merge_class == nullptr) {
     merge_class = NewLabeledClass(class_label);
@@ -275,9 +290,17 @@ int main (int argc, char **argv) {
     }
   }
 
-  // Now train each config separately.
+  // Now train each config separately. The clustering of each config is
+  // independent, so it can run in parallel, but the merging into mf_classes
+  // is done in config order, so the output does not depend on the threads.
   int num_configs = shape_table->NumShapes();
   LIST mf_classes = NIL_LIST;
+#ifdef _OPENMP
+  // The debug display is not thread-safe.
+  int num_threads = FLAGS_test_ch.empty() ? FLAGS_threads : 1;
+  if (num_threads < 1) num_threads = 1;
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(num_threads)
+#endif
   for (int s = 0; s < num_configs; ++s) {
     int unichar_id, font_id;
     if (unicharset == &shape_set) {
@@ -288,8 +311,11 @@ int main (int argc, char **argv) {
       shape_table->GetFirstUnicharAndFont(s, &unichar_id, &font_id);
     }
     const char* class_label = unicharset->id_to_unichar(unichar_id);
-    mf_classes = ClusterOneConfig(s, class_label, mf_classes, *shape_table,
-                                  trainer);
+    LIST proto_list = ClusterOneConfig(s, class_label, *shape_table, trainer);
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+    mf_classes = MergeOneConfig(s, class_label, proto_list, mf_classes);
   }
   STRING inttemp_file = file_prefix;
   inttemp_file += "inttemp";
@@ -340,6 +340,12 @@ void StringRenderer::ClearBoxes() {
   boxaDestroy(&page_boxes_);
 }
 
+void StringRenderer::TransferBoxes(std::vector<BoxChar*>* boxes) {
+  boxes->insert(boxes->end(), boxchars_.begin(), boxchars_.end());
+  boxchars_.clear();
+  boxaDestroy(&page_boxes_);
+}
+
 string StringRenderer::GetBoxesStr() {
   BoxChar::PrepareToWrite(&boxchars_);
   return BoxChar::GetTesseractBoxStr(page_height_, boxchars_);
@@ -810,6 +816,24 @@ int StringRenderer::RenderToImage(const char* text, int text_length,
   return page_offset;
 }
 
+void StringRenderer::FindPageStarts(const char* text, int text_length,
+                                    int max_pages,
+                                    std::vector<int>* page_starts) {
+  page_starts->clear();
+  int offset = 0;
+  while (offset < text_length &&
+         (max_pages == 0 ||
+          static_cast<int>(page_starts->size()) < max_pages)) {
+    InitPangoCairo();
+    const int page_offset =
+        FindFirstPageBreakOffset(text + offset, text_length - offset);
+    FreePangoCairo();
+    if (!page_offset) break;
+    page_starts->push_back(offset);
+    offset += page_offset;
+  }
+}
+
 // Render a string to an image, returning it as an 8 bit pix.  Behaves as
 // RenderString, except that it ignores the font set at construction and works
 // through all the fonts, returning 0 until they are exhausted, at which point
@@ -62,6 +62,12 @@ class StringRenderer {
   // a font be able to render all the text.
   int RenderAllFontsToImage(double min_coverage, const char* text,
                             int text_length, string* font_used, Pix** pix);
+  // Lays out the text without rendering it, and returns in page_starts the
+  // byte offset of each page that successive calls to RenderToImage would
+  // produce, up to max_pages pages (0 for no limit). Since each page depends
+  // only on its start offset, the pages may then be rendered independently.
+  void FindPageStarts(const char* text, int text_length, int max_pages,
+                      std::vector<int>* page_starts);
 
   bool set_font(const string& desc);
   // Char spacing is in PIXELS!!!!.
@@ -143,6 +149,8 @@ class StringRenderer {
   void RotatePageBoxes(float rotation);
   // Delete all boxes.
   void ClearBoxes();
+  // Moves all boxes to the end of *boxes, which takes ownership of them.
+  void TransferBoxes(std::vector<BoxChar*>* boxes);
   // Returns the boxes in a boxfile string.
   string GetBoxesStr();
   // Writes the boxes to a boxfile.
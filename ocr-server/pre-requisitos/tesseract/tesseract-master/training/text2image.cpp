@@ -44,7 +44,10 @@
 #include "errcode.h"
 #include "fileio.h"
 #include "helpers.h"
+#include "imagedata.h"
+#include "ligature_table.h"
 #include "normstrngs.h"
+#include "rect.h"
 #include "stringrenderer.h"
 #include "tlog.h"
 #include "unicharset.h"
@@ -167,6 +170,16 @@ INT_PARAM_FLAG(glyph_resized_size, 0,
 INT_PARAM_FLAG(glyph_num_border_pixels_to_pad, 0,
                "Final_size=glyph_resized_size+2*glyph_num_border_pixels_to_pad");
 
+// Pages are laid out first, then rendered and degraded independently.
+INT_PARAM_FLAG(threads, 1,
+               "Number of threads to render pages with (needs OpenMP)");
+
+// Writes the text lines directly as LSTM training data, instead of running
+// tesseract with the lstm.train config on the output tif/box pair.
+BOOL_PARAM_FLAG(output_lstmf, false,
+                "Also write the rendered text lines to outputbase.lstmf for "
+                "lstmtraining. Horizontal text only.");
+
 namespace tesseract {
 
 struct SpacingProperties {
@@ -402,9 +415,163 @@ bool MakeIndividualGlyphs(Pix* pix,
     return true;
   }
 }
+
+// Sets up the renderer according to the flags. Returns false if the
+// --writing_mode is invalid.
+bool SetRendererFlags(StringRenderer* render) {
+  render->set_add_ligatures(FLAGS_ligatures);
+  render->set_leading(FLAGS_leading);
+  render->set_resolution(FLAGS_resolution);
+  render->set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
+  render->set_h_margin(FLAGS_margin);
+  render->set_v_margin(FLAGS_margin);
+  render->set_output_word_boxes(FLAGS_output_word_boxes);
+  render->set_box_padding(FLAGS_box_padding);
+  render->set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
+  render->set_underline_start_prob(FLAGS_underline_start_prob);
+  render->set_underline_continuation_prob(FLAGS_underline_continuation_prob);
+
+  // Set text rendering orientation and their forms.
+  if (FLAGS_writing_mode == "horizontal") {
+    // Render regular horizontal text (default).
+    render->set_vertical_text(false);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical") {
+    // Render vertical text. Glyph orientation is selected by Pango.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical-upright") {
+    // Render vertical text. Glyph orientation is set to be upright.
+    // Also Basic Latin characters are converted to their fullwidth forms
+    // on rendering, since fullwidth Latin characters are well designed to fit
+    // vertical text lines, while .box files store halfwidth Basic Latin
+    // unichars.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(true);
+    render->set_render_fullwidth_latin(true);
+  } else {
+    tprintf("Invalid writing mode: %s\n", FLAGS_writing_mode.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Degrades (if required) and binarizes the page image just rendered by
+// render, taking ownership of pix, and rotates the boxes of the page to
+// match. If *rotation is 0, a random rotation may be chosen and is returned
+// in *rotation.
+Pix* MakeBinaryPage(Pix* pix, TRand* randomizer, float* rotation,
+                    StringRenderer* render) {
+  if (FLAGS_degrade_image) {
+    pix = DegradeImage(pix, FLAGS_exposure, randomizer,
+                       FLAGS_rotate_image ? rotation : nullptr);
+  }
+  render->RotatePageBoxes(*rotation);
+
+  Pix* gray_pix = pixConvertTo8(pix, false);
+  pixDestroy(&pix);
+  Pix* binary = pixThresholdToBinary(gray_pix, 128);
+  pixDestroy(&gray_pix);
+  return binary;
+}
+
+// Returns the ImageData of the text line made of boxes [start, end), which
+// are all on the same page, cut out of that page with its boxes and text in
+// the same way as tesseract does for the lstm.train config. Returns nullptr
+// if the line is not on the page.
+static ImageData* GetTextLineData(const std::vector<BoxChar*>& boxes,
+                                  int start, int end,
+                                  const std::vector<Pix*>& pages) {
+  const int page = boxes[start]->page();
+  Pix* page_pix = pages[page];
+  if (page_pix == nullptr) return nullptr;
+  const int height = pixGetHeight(page_pix);
+  GenericVector<TBOX> line_boxes;
+  GenericVector<STRING> line_texts;
+  TBOX line_box;
+  for (int b = start; b < end; ++b) {
+    const Box* box = boxes[b]->box();
+    if (box == nullptr) continue;
+    // Tesseract coordinates, as written to the box file.
+    TBOX char_box(box->x, height - box->y - box->h, box->x + box->w,
+                  height - box->y);
+    if (line_boxes.empty())
+      line_box = char_box;
+    else
+      line_box += char_box;
+    line_boxes.push_back(char_box);
+    line_texts.push_back(STRING(boxes[b]->ch().c_str()));
+  }
+  if (line_boxes.empty()) return nullptr;
+  line_box.pad(kImagePadding, kImagePadding);
+  line_box &= TBOX(0, 0, pixGetWidth(page_pix), height);
+  if (line_box.null_box()) return nullptr;
+  Box* clip_box = boxCreate(line_box.left(), height - line_box.top(),
+                            line_box.width(), line_box.height());
+  Pix* line_pix = pixClipRectangle(page_pix, clip_box, nullptr);
+  boxDestroy(&clip_box);
+  if (line_pix == nullptr) return nullptr;
+  Pix* grey = pixConvertTo8(line_pix, false);
+  pixDestroy(&line_pix);
+  ImageData* image_data = new ImageData(false, grey);
+  image_data->set_page_number(page);
+  // Shift the boxes so they are relative to the line image.
+  ICOORD shift = -line_box.botleft();
+  for (int i = 0; i < line_boxes.size(); ++i) line_boxes[i].move(shift);
+  GenericVector<int> page_numbers;
+  page_numbers.init_to_size(line_boxes.size(), page);
+  image_data->AddBoxes(line_boxes, line_texts, page_numbers);
+  return image_data;
+}
+
+// Adds each text line of the given boxes, which must have been through
+// BoxChar::PrepareToWrite, to the document, using pages, indexed by box page
+// number, for the images. Returns the number of lines added.
+int AddTextLinesToDocument(const std::vector<BoxChar*>& boxes,
+                           const std::vector<Pix*>& pages,
+                           DocumentData* document) {
+  // Find the [start, end) range of boxes of each line. Lines end at the tab
+  // boxes inserted by PrepareToWrite, and at page boundaries.
+  std::vector<std::pair<int, int> > lines;
+  const int num_boxes = boxes.size();
+  int end = 0;
+  while (end < num_boxes) {
+    int start = end;
+    while (start < num_boxes && boxes[start]->ch() == "\t") ++start;
+    if (start == num_boxes) break;
+    end = start + 1;
+    while (end < num_boxes && boxes[end]->ch() != "\t" &&
+           boxes[end]->page() == boxes[start]->page()) {
+      ++end;
+    }
+    lines.push_back(std::make_pair(start, end));
+  }
+  // Encoding the line images is the expensive part, so do it in parallel and
+  // add the results in order.
+  const int num_lines = lines.size();
+  std::vector<ImageData*> line_data(num_lines, nullptr);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(static_cast<int>(FLAGS_threads)) \
+    schedule(dynamic, 1)
+#endif
+  for (int l = 0; l < num_lines; ++l) {
+    line_data[l] =
+        GetTextLineData(boxes, lines[l].first, lines[l].second, pages);
+  }
+  int num_added = 0;
+  for (int l = 0; l < num_lines; ++l) {
+    if (line_data[l] == nullptr) continue;
+    document->AddPageToDocument(line_data[l]);
+    ++num_added;
+  }
+  return num_added;
+}
 }  // namespace tesseract
 
-using tesseract::DegradeImage;
+using tesseract::BoxChar;
+using tesseract::DocumentData;
 using tesseract::ExtractFontProperties;
 using tesseract::File;
 using tesseract::FontUtils;
@@ -436,6 +603,15 @@ int Main() {
     tprintf("Use '--unicharset_file' only if '--render_ngrams' is set.\n");
     exit(1);
   }
+  if (FLAGS_threads < 1) {
+    tprintf("'--threads' must be at least 1.\n");
+    exit(1);
+  }
+  if (FLAGS_output_lstmf &&
+      (FLAGS_find_fonts || !(FLAGS_writing_mode == "horizontal"))) {
+    tprintf("'--output_lstmf' needs horizontal text and no '--find_fonts'.\n");
+    exit(1);
+  }
 
   if (!FLAGS_find_fonts && !FontUtils::IsAvailableFont(FLAGS_font.c_str())) {
     string pango_name;
@@ -456,42 +632,7 @@ int Main() {
   snprintf(font_desc_name, 1024, "%s %d", FLAGS_font.c_str(),
            static_cast<int>(FLAGS_ptsize));
   StringRenderer render(font_desc_name, FLAGS_xsize, FLAGS_ysize);
-  render.set_add_ligatures(FLAGS_ligatures);
-  render.set_leading(FLAGS_leading);
-  render.set_resolution(FLAGS_resolution);
-  render.set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
-  render.set_h_margin(FLAGS_margin);
-  render.set_v_margin(FLAGS_margin);
-  render.set_output_word_boxes(FLAGS_output_word_boxes);
-  render.set_box_padding(FLAGS_box_padding);
-  render.set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
-  render.set_underline_start_prob(FLAGS_underline_start_prob);
-  render.set_underline_continuation_prob(FLAGS_underline_continuation_prob);
-
-  // Set text rendering orientation and their forms.
-  if (FLAGS_writing_mode == "horizontal") {
-    // Render regular horizontal text (default).
-    render.set_vertical_text(false);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical") {
-    // Render vertical text. Glyph orientation is selected by Pango.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical-upright") {
-    // Render vertical text. Glyph orientation is set to be upright.
-    // Also Basic Latin characters are converted to their fullwidth forms
-    // on rendering, since fullwidth Latin characters are well designed to fit
-    // vertical text lines, while .box files store halfwidth Basic Latin
-    // unichars.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(true);
-    render.set_render_fullwidth_latin(true);
-  } else {
-    tprintf("Invalid writing mode: %s\n", FLAGS_writing_mode.c_str());
-    exit(1);
-  }
+  if (!tesseract::SetRendererFlags(&render)) exit(1);
 
   string src_utf8;
   // This c_str is NOT redundant!
@@ -568,61 +709,48 @@ int Main() {
     return 0;
   }
 
-  int im = 0;
-  std::vector<float> page_rotation;
   const char* to_render_utf8 = src_utf8.c_str();
+  const int text_length = strlen(to_render_utf8);
 
-  tesseract::TRand randomizer;
-  randomizer.set_seed(kRandomSeed);
-  std::vector<string> font_names;
   // We use a two pass mechanism to rotate images in both direction.
   // The first pass(0) will rotate the images in random directions and
   // the second pass(1) will mirror those rotations.
   int num_pass = FLAGS_bidirectional_rotation ? 2 : 1;
-  for (int pass = 0; pass < num_pass; ++pass) {
-    int page_num = 0;
-    string font_used;
-    for (size_t offset = 0;
-         offset < strlen(to_render_utf8) &&
-         (FLAGS_max_pages == 0 || page_num < FLAGS_max_pages);
-         ++im, ++page_num) {
-      tlog(1, "Starting page %d\n", im);
-      Pix* pix = nullptr;
-      if (FLAGS_find_fonts) {
+  tesseract::TRand randomizer;
+  if (FLAGS_find_fonts) {
+    int im = 0;
+    std::vector<float> page_rotation;
+    std::vector<string> font_names;
+    for (int pass = 0; pass < num_pass; ++pass) {
+      int page_num = 0;
+      string font_used;
+      for (size_t offset = 0;
+           offset < strlen(to_render_utf8) &&
+           (FLAGS_max_pages == 0 || page_num < FLAGS_max_pages);
+           ++im, ++page_num) {
+        tlog(1, "Starting page %d\n", im);
+        Pix* pix = nullptr;
         offset += render.RenderAllFontsToImage(FLAGS_min_coverage,
                                                to_render_utf8 + offset,
                                                strlen(to_render_utf8 + offset),
                                                &font_used, &pix);
-      } else {
-        offset += render.RenderToImage(to_render_utf8 + offset,
-                                       strlen(to_render_utf8 + offset), &pix);
-      }
-      if (pix != nullptr) {
-        float rotation = 0;
-        if (pass == 1) {
-          // Pass 2, do mirror rotation.
-          rotation = -1 * page_rotation[page_num];
-        }
-        if (FLAGS_degrade_image) {
-          pix = DegradeImage(pix, FLAGS_exposure, &randomizer,
-                             FLAGS_rotate_image ? &rotation : nullptr);
-        }
-        render.RotatePageBoxes(rotation);
-
-        if (pass == 0) {
-          // Pass 1, rotate randomly and store the rotation..
-          page_rotation.push_back(rotation);
-        }
-
-        Pix* gray_pix = pixConvertTo8(pix, false);
-        pixDestroy(&pix);
-        Pix* binary = pixThresholdToBinary(gray_pix, 128);
-        pixDestroy(&gray_pix);
-        char tiff_name[1024];
-        if (FLAGS_find_fonts) {
+        if (pix != nullptr) {
+          float rotation = 0;
+          if (pass == 1) {
+            // Pass 2, do mirror rotation.
+            rotation = -1 * page_rotation[page_num];
+          }
+          randomizer.set_seed(kRandomSeed + im);
+          Pix* binary =
+              tesseract::MakeBinaryPage(pix, &randomizer, &rotation, &render);
+          if (pass == 0) {
+            // Pass 1, rotate randomly and store the rotation..
+            page_rotation.push_back(rotation);
+          }
           if (FLAGS_render_per_font) {
             string fontname_for_file = tesseract::StringReplace(
                 font_used, " ", "_");
+            char tiff_name[1024];
             snprintf(tiff_name, 1024, "%s.%s.tif", FLAGS_outputbase.c_str(),
                      fontname_for_file.c_str());
             pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, "w");
@@ -630,43 +758,128 @@ int Main() {
           } else {
             font_names.push_back(font_used);
           }
-        } else {
-          snprintf(tiff_name, 1024, "%s.tif", FLAGS_outputbase.c_str());
-          pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
-          tprintf("Rendered page %d to file %s\n", im, tiff_name);
-        }
-        // Make individual glyphs
-        if (FLAGS_output_individual_glyph_images) {
-          if (!MakeIndividualGlyphs(binary, render.GetBoxes(), im)) {
-            tprintf("ERROR: Individual glyphs not saved\n");
+          // Make individual glyphs
+          if (FLAGS_output_individual_glyph_images) {
+            if (!MakeIndividualGlyphs(binary, render.GetBoxes(), im)) {
+              tprintf("ERROR: Individual glyphs not saved\n");
+            }
           }
+          pixDestroy(&binary);
+        }
+        if (offset != 0) {
+          // We just want a list of names, or some sample images so we don't
+          // need to render more than the first page of the text.
+          break;
         }
-        pixDestroy(&binary);
       }
-      if (FLAGS_find_fonts && offset != 0) {
-        // We just want a list of names, or some sample images so we don't need
-        // to render more than the first page of the text.
-        break;
+    }
+    if (!FLAGS_render_per_font && !font_names.empty()) {
+      string filename = FLAGS_outputbase.c_str();
+      filename += ".fontlist.txt";
+      FILE* fp = fopen(filename.c_str(), "wb");
+      if (fp == nullptr) {
+        tprintf("Failed to create output font list %s\n", filename.c_str());
+      } else {
+        for (size_t i = 0; i < font_names.size(); ++i) {
+          fprintf(fp, "%s\n", font_names[i].c_str());
+        }
+        fclose(fp);
       }
     }
+    return 0;
   }
-  if (!FLAGS_find_fonts) {
-    string box_name = FLAGS_outputbase.c_str();
-    box_name += ".box";
-    render.WriteAllBoxes(box_name);
-  } else if (!FLAGS_render_per_font && !font_names.empty()) {
-    string filename = FLAGS_outputbase.c_str();
-    filename += ".fontlist.txt";
-    FILE* fp = fopen(filename.c_str(), "wb");
-    if (fp == nullptr) {
-      tprintf("Failed to create output font list %s\n", filename.c_str());
-    } else {
-      for (size_t i = 0; i < font_names.size(); ++i) {
-        fprintf(fp, "%s\n", font_names[i].c_str());
+
+  // Each page depends only on where it starts in the text, so find the page
+  // starts with a layout-only pass, then render, degrade and binarize the
+  // pages in parallel, each thread with its own renderer and Pango context.
+  // Pages and their boxes are written in page order, and the noise of each
+  // page is seeded by its page number, so the output is the same for any
+  // number of threads.
+  if (FLAGS_ligatures) tesseract::LigatureTable::Get();  // Not thread-safe.
+  std::vector<int> page_starts;
+  render.FindPageStarts(to_render_utf8, text_length, FLAGS_max_pages,
+                        &page_starts);
+  const int num_pages = page_starts.size();
+  std::vector<float> page_rotation(num_pages, 0.0f);
+  std::vector<BoxChar*> boxes;
+  // Binary pages indexed by page number, kept for --output_lstmf.
+  std::vector<Pix*> binary_pages;
+  char tiff_name[1024];
+  snprintf(tiff_name, 1024, "%s.tif", FLAGS_outputbase.c_str());
+  for (int pass = 0; pass < num_pass; ++pass) {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(static_cast<int>(FLAGS_threads)) \
+    firstprivate(randomizer)
+#endif
+    {
+      StringRenderer page_render(font_desc_name, FLAGS_xsize, FLAGS_ysize);
+      tesseract::SetRendererFlags(&page_render);
+#ifdef _OPENMP
+#pragma omp for ordered schedule(dynamic, 1)
+#endif
+      for (int p = 0; p < num_pages; ++p) {
+        const int im = pass * num_pages + p;
+        tlog(1, "Starting page %d\n", im);
+        const int offset = page_starts[p];
+        Pix* pix = nullptr;
+        page_render.set_page(im);
+        page_render.RenderToImage(to_render_utf8 + offset,
+                                  text_length - offset, &pix);
+        Pix* binary = nullptr;
+        if (pix != nullptr) {
+          // Pass 2 mirrors the random rotation of pass 1.
+          float rotation = pass == 1 ? -page_rotation[p] : 0.0f;
+          randomizer.set_seed(kRandomSeed + im);
+          binary = tesseract::MakeBinaryPage(pix, &randomizer, &rotation,
+                                             &page_render);
+          if (pass == 0) page_rotation[p] = rotation;
+        }
+        std::vector<BoxChar*> page_boxes;
+        page_render.TransferBoxes(&page_boxes);
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+        {
+          if (binary != nullptr) {
+            pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
+            tprintf("Rendered page %d to file %s\n", im, tiff_name);
+            // Make individual glyphs
+            if (FLAGS_output_individual_glyph_images &&
+                !MakeIndividualGlyphs(binary, page_boxes, 0)) {
+              tprintf("ERROR: Individual glyphs not saved\n");
+            }
+          }
+          boxes.insert(boxes.end(), page_boxes.begin(), page_boxes.end());
+          if (FLAGS_output_lstmf)
+            binary_pages.push_back(binary);
+          else
+            pixDestroy(&binary);
+        }
       }
-      fclose(fp);
     }
   }
+  BoxChar::PrepareToWrite(&boxes);
+  string box_name = FLAGS_outputbase.c_str();
+  box_name += ".box";
+  BoxChar::WriteTesseractBoxFile(box_name, FLAGS_ysize, boxes);
+
+  if (FLAGS_output_lstmf) {
+    STRING lstmf_name = FLAGS_outputbase.c_str();
+    lstmf_name += ".lstmf";
+    DocumentData document(lstmf_name);
+    int num_lines =
+        tesseract::AddTextLinesToDocument(boxes, binary_pages, &document);
+    // Shuffle the lines, as tesseract does for the lstm.train config.
+    document.Shuffle();
+    if (!document.SaveDocument(lstmf_name.string(), nullptr)) {
+      tprintf("Failed to write training data to %s!\n", lstmf_name.string());
+      exit(1);
+    }
+    tprintf("Wrote %d text lines to %s\n", num_lines, lstmf_name.string());
+    for (size_t i = 0; i < binary_pages.size(); ++i)
+      pixDestroy(&binary_pages[i]);
+  }
+  for (size_t i = 0; i < boxes.size(); ++i) delete boxes[i];
 
   return 0;
 }
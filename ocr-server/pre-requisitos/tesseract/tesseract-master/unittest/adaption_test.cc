@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// File:        adaption_test.cc
+// Description: Tests that adaption deferred by classify_defer_adaption
+//              uses the same features as immediate adaption.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include "allheaders.h"
+#include "blobs.h"
+#include "classify.h"
+#include "edgblob.h"
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "intproto.h"
+#include "normalis.h"
+#include "ocrblock.h"
+#include "stepblob.h"
+
+namespace {
+
+const int kWidth = 200;
+const int kHeight = 120;
+
+// Returns an image of a ring and a slanted bar, whose features from their
+// outlines differ from those of their polygonal approximation.
+Pix* MakeShapes() {
+  Pix* pix = pixCreate(kWidth, kHeight, 1);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      int dx = x - 60;
+      int dy = y - 60;
+      int d2 = dx * dx + dy * dy;
+      bool ring = d2 > 25 * 25 && d2 < 45 * 45;
+      bool bar = x >= 120 && x < 190 && abs(y - 10 - (x - 120) * 10 / 7) < 8;
+      if (ring || bar) pixSetPixel(pix, x, y, 1);
+    }
+  }
+  return pix;
+}
+
+// Returns the baseline-normalized TBLOB of c_blob, with points that refer to
+// the outlines of c_blob, like the blobs of the words that LearnPieces adapts
+// to.
+TBLOB* NormalizedBlob(C_BLOB* c_blob) {
+  TBLOB* blob = TBLOB::PolygonalCopy(true, c_blob);
+  TBOX box = blob->bounding_box();
+  float scale = static_cast<float>(kBlnXHeight) / box.height();
+  blob->Normalize(NULL, NULL, NULL, (box.left() + box.right()) / 2.0f,
+                  box.bottom(), scale, scale, 0.0f, kBlnBaselineOffset, false,
+                  NULL);
+  return blob;
+}
+
+// Returns the number of outlines of c_blob, including holes.
+int NumOutlines(C_BLOB* c_blob) {
+  int count = 0;
+  C_OUTLINE_IT ol_it(c_blob->out_list());
+  for (ol_it.mark_cycle_pt(); !ol_it.cycled_list(); ol_it.forward())
+    count += 1 + ol_it.data()->child()->length();
+  return count;
+}
+
+// Extracts the baseline and character normalized features of blob.
+void ExtractFeatures(const TBLOB& blob,
+                     GenericVector<INT_FEATURE_STRUCT>* bl_features,
+                     GenericVector<INT_FEATURE_STRUCT>* cn_features) {
+  INT_FX_RESULT_STRUCT fx_info;
+  tesseract::Classify::ExtractFeatures(blob, false, bl_features, cn_features,
+                                       &fx_info, NULL);
+}
+
+bool SameFeatures(const GenericVector<INT_FEATURE_STRUCT>& a,
+                  const GenericVector<INT_FEATURE_STRUCT>& b) {
+  if (a.size() != b.size()) return false;
+  for (int i = 0; i < a.size(); ++i) {
+    if (a[i].X != b[i].X || a[i].Y != b[i].Y || a[i].Theta != b[i].Theta)
+      return false;
+  }
+  return true;
+}
+
+// The blob of an AdaptionEvent gives the features of the blob it was made
+// from, after that blob and its outlines have been deleted, as they may be by
+// the time the adaption is applied.
+TEST(AdaptionTest, DeferredBlobKeepsFeatures) {
+  Pix* pix = MakeShapes();
+  BLOCK block("", TRUE, 0, 0, 0, 0, kWidth, kHeight);
+  extract_edges(pix, &block);
+  pixDestroy(&pix);
+  C_BLOB_IT b_it(block.blob_list());
+  ASSERT_EQ(2, b_it.length());
+  int num_polygonal_differ = 0;
+  for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward()) {
+    C_BLOB* c_blob = b_it.extract();
+    TBLOB* blob = NormalizedBlob(c_blob);
+    GenericVector<INT_FEATURE_STRUCT> bl_features, cn_features;
+    ExtractFeatures(*blob, &bl_features, &cn_features);
+    ASSERT_GT(bl_features.size(), 0);
+    tesseract::AdaptionEvent event(*blob, 0, 0, 0.0f);
+    EXPECT_EQ(NumOutlines(c_blob), event.outlines.length());
+    delete blob;
+    delete c_blob;
+    GenericVector<INT_FEATURE_STRUCT> event_bl_features, event_cn_features;
+    ExtractFeatures(*event.blob, &event_bl_features, &event_cn_features);
+    EXPECT_TRUE(SameFeatures(bl_features, event_bl_features));
+    EXPECT_TRUE(SameFeatures(cn_features, event_cn_features));
+    // Without the outlines, only the polygonal approximation is left.
+    TBLOB polygonal(*event.blob);
+    for (TESSLINE* ol = polygonal.outlines; ol != NULL; ol = ol->next) {
+      EDGEPT* pt = ol->loop;
+      do {
+        pt->src_outline = NULL;
+        pt = pt->next;
+      } while (pt != ol->loop);
+    }
+    GenericVector<INT_FEATURE_STRUCT> poly_bl_features, poly_cn_features;
+    ExtractFeatures(polygonal, &poly_bl_features, &poly_cn_features);
+    if (!SameFeatures(bl_features, poly_bl_features)) ++num_polygonal_differ;
+  }
+  EXPECT_EQ(2, num_polygonal_differ);
+}
+
+}  // namespace
@@ -0,0 +1,190 @@
+///////////////////////////////////////////////////////////////////////
+// File:        batchapi_test.cc
+// Description: Tests the submit/wait/destroy life cycle of TessBatchAPI.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "batchapi.h"
+#include "include_gunit.h"
+#include "strngs.h"
+#include "svutil.h"
+#include "tessdatamanager.h"
+
+namespace {
+
+const int kNumEngines = 4;
+const int kNumImages = 16;
+
+// Blocks the batch callbacks until released, so a test can hold images
+// pending for as long as it likes.
+SVSemaphore* callback_gate = NULL;
+int callbacks_run = 0;
+SVMutex callbacks_mutex;
+
+void CountingCallback(TessBatchImage* image) {
+  if (callback_gate != NULL) {
+    callback_gate->Wait();
+    callback_gate->Signal();
+  }
+  SVAutoLock lock(&callbacks_mutex);
+  ++callbacks_run;
+}
+
+int CallbacksRun() {
+  SVAutoLock lock(&callbacks_mutex);
+  return callbacks_run;
+}
+
+// The batch that WaitingCallback waits on.
+tesseract::TessBatchAPI* waiting_batch = NULL;
+
+// Waits for the whole batch from inside a callback, then counts the image.
+void WaitingCallback(TessBatchImage* image) {
+  waiting_batch->Wait();
+  EXPECT_TRUE(waiting_batch->IsDone(image));
+  CountingCallback(image);
+}
+
+class BatchAPITest : public ::testing::Test {
+ protected:
+  // Writes a traineddata that holds only a config telling Init to stop after
+  // reading it. Such engines initialize instantly and need no language data,
+  // which is all the life cycle tests need: images without pixels fail
+  // before they reach recognition.
+  void SetUp() override {
+    const char* tmpdir = getenv("TMPDIR");
+    datapath_ = tmpdir != NULL ? tmpdir : "/tmp";
+    datapath_ += "/";
+    STRING filename = datapath_ + kLanguage + ".traineddata";
+    const char kConfig[] = "tessedit_init_config_only 1\n";
+    tesseract::TessdataManager mgr;
+    mgr.OverwriteEntry(tesseract::TESSDATA_LANG_CONFIG, kConfig,
+                       strlen(kConfig));
+    ASSERT_TRUE(mgr.SaveFile(filename, NULL));
+    callbacks_run = 0;
+    callback_gate = NULL;
+    memset(images_, 0, sizeof(images_));
+    for (int i = 0; i < kNumImages; ++i) {
+      images_[i].page_seg_mode = -1;
+      images_[i].text_arena = arenas_[i];
+      images_[i].text_arena_size = sizeof(arenas_[i]);
+    }
+  }
+
+  bool Init(tesseract::TessBatchAPI* batch) {
+    return batch->Init(datapath_.string(), kLanguage,
+                       tesseract::OEM_TESSERACT_ONLY, kNumEngines);
+  }
+
+  static const char* kLanguage;
+  STRING datapath_;
+  TessBatchImage images_[kNumImages];
+  char arenas_[kNumImages][16];
+};
+
+const char* BatchAPITest::kLanguage = "batchapi_test";
+
+// Nothing is queued without engines.
+TEST_F(BatchAPITest, SubmitBeforeInit) {
+  tesseract::TessBatchAPI batch;
+  EXPECT_FALSE(batch.Submit(images_, kNumImages, CountingCallback));
+  EXPECT_EQ(0, images_[0].status);
+  batch.Wait();
+  EXPECT_FALSE(batch.Init(datapath_.string(), "no_such_language",
+                          tesseract::OEM_TESSERACT_ONLY, kNumEngines));
+  EXPECT_EQ(0, batch.num_engines());
+  EXPECT_FALSE(batch.Submit(images_, kNumImages, CountingCallback));
+}
+
+// Destroying the batch while its workers are still starting up must wait for
+// all of them, not just for those that have already taken their engine.
+TEST_F(BatchAPITest, DestroyRightAfterInit) {
+  for (int i = 0; i < 50; ++i) {
+    tesseract::TessBatchAPI* batch = new tesseract::TessBatchAPI;
+    ASSERT_TRUE(Init(batch));
+    EXPECT_EQ(kNumEngines, batch->num_engines());
+    delete batch;
+  }
+}
+
+// Every submitted image is done after Wait, and its callback has run by the
+// time the batch is destroyed.
+TEST_F(BatchAPITest, SubmitWait) {
+  {
+    tesseract::TessBatchAPI batch;
+    ASSERT_TRUE(Init(&batch));
+    EXPECT_TRUE(batch.Submit(images_, kNumImages / 2, CountingCallback));
+    EXPECT_TRUE(batch.Submit(images_ + kNumImages / 2, kNumImages / 2,
+                             CountingCallback));
+    batch.Wait();
+    for (int i = 0; i < kNumImages; ++i) {
+      EXPECT_TRUE(batch.IsDone(&images_[i]));
+      EXPECT_EQ(TESS_BATCH_FAILED, images_[i].status);
+      EXPECT_EQ(0, images_[i].text_length);
+      EXPECT_STREQ("", images_[i].text_arena);
+    }
+  }
+  EXPECT_EQ(kNumImages, CallbacksRun());
+}
+
+// A callback can Wait for the batch, as its own image is already done.
+TEST_F(BatchAPITest, WaitInCallback) {
+  {
+    tesseract::TessBatchAPI batch;
+    ASSERT_TRUE(Init(&batch));
+    waiting_batch = &batch;
+    // No more images than engines, so there is always a free engine to
+    // finish the images that the waiting callbacks depend on.
+    EXPECT_TRUE(batch.Submit(images_, kNumEngines, WaitingCallback));
+    batch.Wait();
+    for (int i = 0; i < kNumEngines; ++i)
+      EXPECT_EQ(TESS_BATCH_FAILED, images_[i].status);
+  }
+  waiting_batch = NULL;
+  EXPECT_EQ(kNumEngines, CallbacksRun());
+}
+
+// A second Init fails, leaving the batch as it was.
+TEST_F(BatchAPITest, InitTwice) {
+  tesseract::TessBatchAPI batch;
+  ASSERT_TRUE(Init(&batch));
+  EXPECT_FALSE(batch.Init(datapath_.string(), kLanguage,
+                          tesseract::OEM_TESSERACT_ONLY, 2 * kNumEngines));
+  EXPECT_EQ(kNumEngines, batch.num_engines());
+  EXPECT_TRUE(batch.Submit(images_, kNumImages, CountingCallback));
+  batch.Wait();
+  for (int i = 0; i < kNumImages; ++i)
+    EXPECT_EQ(TESS_BATCH_FAILED, images_[i].status);
+}
+
+// Variables can't change under pending images, and the destructor waits for
+// them.
+TEST_F(BatchAPITest, SetVariableWhilePendingAndDestroy) {
+  SVSemaphore gate;
+  callback_gate = &gate;
+  tesseract::TessBatchAPI* batch = new tesseract::TessBatchAPI;
+  ASSERT_TRUE(Init(batch));
+  EXPECT_TRUE(batch->SetVariable("tessedit_pageseg_mode", "6"));
+  EXPECT_TRUE(batch->Submit(images_, kNumImages, CountingCallback));
+  EXPECT_FALSE(batch->SetVariable("tessedit_pageseg_mode", "3"));
+  EXPECT_EQ(0, CallbacksRun());
+  gate.Signal();
+  delete batch;
+  callback_gate = NULL;
+  EXPECT_EQ(kNumImages, CallbacksRun());
+  for (int i = 0; i < kNumImages; ++i)
+    EXPECT_EQ(TESS_BATCH_FAILED, images_[i].status);
+}
+
+}  // namespace
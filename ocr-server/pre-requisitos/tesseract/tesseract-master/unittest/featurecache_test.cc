@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////
+// File:        featurecache_test.cc
+// Description: Tests that IntFeatureCache returns the features that would
+//              be extracted afresh, and misses when the blob or its
+//              normalization changes.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include "allheaders.h"
+#include "blobs.h"
+#include "classify.h"
+#include "edgblob.h"
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "intfx.h"
+#include "normalis.h"
+#include "ocrblock.h"
+#include "stepblob.h"
+
+namespace {
+
+using tesseract::IntFeatureCache;
+
+const int kWidth = 200;
+const int kHeight = 120;
+
+// Returns an image of a ring and a slanted bar.
+Pix* MakeShapes() {
+  Pix* pix = pixCreate(kWidth, kHeight, 1);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      int dx = x - 60;
+      int dy = y - 60;
+      int d2 = dx * dx + dy * dy;
+      bool ring = d2 > 25 * 25 && d2 < 45 * 45;
+      bool bar = x >= 120 && x < 190 && abs(y - 10 - (x - 120) * 10 / 7) < 8;
+      if (ring || bar) pixSetPixel(pix, x, y, 1);
+    }
+  }
+  return pix;
+}
+
+// The features and fx info of a blob.
+struct Features {
+  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  GenericVector<INT_FEATURE_STRUCT> cn_features;
+  INT_FX_RESULT_STRUCT results;
+};
+
+bool SameFeatures(const GenericVector<INT_FEATURE_STRUCT>& a,
+                  const GenericVector<INT_FEATURE_STRUCT>& b) {
+  if (a.size() != b.size()) return false;
+  for (int i = 0; i < a.size(); ++i) {
+    if (a[i].X != b[i].X || a[i].Y != b[i].Y || a[i].Theta != b[i].Theta ||
+        a[i].CP_misses != b[i].CP_misses)
+      return false;
+  }
+  return true;
+}
+
+bool SameResults(const INT_FX_RESULT_STRUCT& a,
+                 const INT_FX_RESULT_STRUCT& b) {
+  return a.Length == b.Length && a.Xmean == b.Xmean && a.Ymean == b.Ymean &&
+         a.Rx == b.Rx && a.Ry == b.Ry && a.NumBL == b.NumBL &&
+         a.NumCN == b.NumCN && a.Width == b.Width && a.YBottom == b.YBottom &&
+         a.YTop == b.YTop;
+}
+
+bool Same(const Features& a, const Features& b) {
+  return SameFeatures(a.bl_features, b.bl_features) &&
+         SameFeatures(a.cn_features, b.cn_features) &&
+         SameResults(a.results, b.results);
+}
+
+class FeatureCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Pix* pix = MakeShapes();
+    BLOCK block("", TRUE, 0, 0, 0, 0, kWidth, kHeight);
+    extract_edges(pix, &block);
+    pixDestroy(&pix);
+    C_BLOB_IT b_it(&c_blobs_);
+    b_it.add_list_after(block.blob_list());
+    cache_.set_max_size(16);
+  }
+
+  // Returns the baseline-normalized TBLOB of the index-th shape, scaled by
+  // scale relative to the x-height, and after the given predecessor
+  // normalization, if any.
+  TBLOB* NormalizedBlob(int index, float scale, const DENORM* predecessor) {
+    C_BLOB_IT b_it(&c_blobs_);
+    for (int i = 0; i < index; ++i) b_it.forward();
+    TBLOB* blob = TBLOB::PolygonalCopy(true, b_it.data());
+    TBOX box = blob->bounding_box();
+    scale *= static_cast<float>(kBlnXHeight) / box.height();
+    blob->Normalize(NULL, NULL, predecessor,
+                    (box.left() + box.right()) / 2.0f, box.bottom(), scale,
+                    scale, 0.0f, kBlnBaselineOffset, false, NULL);
+    return blob;
+  }
+
+  // Extracts the features of blob without the cache.
+  static void ExtractFresh(const TBLOB& blob, bool nonlinear_norm,
+                           Features* features) {
+    tesseract::Classify::ExtractFeatures(
+        blob, nonlinear_norm, &features->bl_features,
+        &features->cn_features, &features->results, NULL);
+  }
+
+  // Extracts the features of blob through the cache.
+  void ExtractCached(const TBLOB& blob, bool nonlinear_norm,
+                     Features* features) {
+    cache_.ExtractFeatures(blob, nonlinear_norm, &features->bl_features,
+                           &features->cn_features, &features->results);
+  }
+
+  // Checks that blob misses the cache, then hits it, and that both times the
+  // features are those extracted afresh.
+  void ExpectMissThenHit(const TBLOB& blob, bool nonlinear_norm) {
+    Features fresh, missed, hit;
+    ExtractFresh(blob, nonlinear_norm, &fresh);
+    ASSERT_GT(fresh.cn_features.size(), 0);
+    int misses = cache_.misses();
+    int hits = cache_.hits();
+    ExtractCached(blob, nonlinear_norm, &missed);
+    EXPECT_EQ(misses + 1, cache_.misses());
+    EXPECT_EQ(hits, cache_.hits());
+    EXPECT_TRUE(Same(fresh, missed));
+    ExtractCached(blob, nonlinear_norm, &hit);
+    EXPECT_EQ(misses + 1, cache_.misses());
+    EXPECT_EQ(hits + 1, cache_.hits());
+    EXPECT_TRUE(Same(fresh, hit));
+  }
+
+  C_BLOB_LIST c_blobs_;
+  IntFeatureCache cache_;
+};
+
+// Cached features are identical to fresh ones, for both normalizations, and
+// a copy of a blob shares its entry.
+TEST_F(FeatureCacheTest, CachedMatchesFresh) {
+  C_BLOB_IT b_it(&c_blobs_);
+  ASSERT_EQ(2, b_it.length());
+  for (int i = 0; i < 2; ++i) {
+    TBLOB* blob = NormalizedBlob(i, 1.0f, NULL);
+    ExpectMissThenHit(*blob, false);
+    ExpectMissThenHit(*blob, true);
+    TBLOB copy(*blob);
+    Features fresh, cached;
+    ExtractFresh(copy, false, &fresh);
+    int hits = cache_.hits();
+    ExtractCached(copy, false, &cached);
+    EXPECT_EQ(hits + 1, cache_.hits());
+    EXPECT_TRUE(Same(fresh, cached));
+    delete blob;
+  }
+}
+
+// A changed polygon, or the loss of the outlines it refers to, misses.
+TEST_F(FeatureCacheTest, BlobChangeMisses) {
+  TBLOB* blob = NormalizedBlob(0, 1.0f, NULL);
+  ExpectMissThenHit(*blob, false);
+  TBLOB moved(*blob);
+  moved.outlines->loop->pos.x += 3;
+  moved.ComputeBoundingBoxes();
+  ExpectMissThenHit(moved, false);
+  TBLOB polygonal(*blob);
+  for (TESSLINE* ol = polygonal.outlines; ol != NULL; ol = ol->next) {
+    EDGEPT* pt = ol->loop;
+    do {
+      pt->src_outline = NULL;
+      pt = pt->next;
+    } while (pt != ol->loop);
+  }
+  ExpectMissThenHit(polygonal, false);
+  // The original is still cached.
+  Features fresh, cached;
+  ExtractFresh(*blob, false, &fresh);
+  int hits = cache_.hits();
+  ExtractCached(*blob, false, &cached);
+  EXPECT_EQ(hits + 1, cache_.hits());
+  EXPECT_TRUE(Same(fresh, cached));
+  delete blob;
+}
+
+// A change of normalization misses, whether it moves the points, or only
+// changes an earlier step of the DENORM chain that leaves the polygon as it
+// was.
+TEST_F(FeatureCacheTest, NormalizationChangeMisses) {
+  TBLOB* blob = NormalizedBlob(1, 1.0f, NULL);
+  ExpectMissThenHit(*blob, false);
+  TBLOB* scaled = NormalizedBlob(1, 0.5f, NULL);
+  ExpectMissThenHit(*scaled, false);
+  DENORM predecessor;
+  predecessor.SetupNormalization(NULL, NULL, NULL, 0.0f, 0.0f, 2.0f, 2.0f,
+                                 0.0f, 0.0f);
+  TBLOB* chained = NormalizedBlob(1, 1.0f, &predecessor);
+  ExpectMissThenHit(*chained, false);
+  delete chained;
+  delete scaled;
+  delete blob;
+}
+
+// Old entries are replaced once the cache is full, and a size of 0 or a
+// Clear leaves nothing cached.
+TEST_F(FeatureCacheTest, EvictsAndClears) {
+  cache_.set_max_size(1);
+  TBLOB* blob0 = NormalizedBlob(0, 1.0f, NULL);
+  TBLOB* blob1 = NormalizedBlob(1, 1.0f, NULL);
+  ExpectMissThenHit(*blob0, false);
+  ExpectMissThenHit(*blob1, false);
+  ExpectMissThenHit(*blob0, false);
+  cache_.Clear();
+  ExpectMissThenHit(*blob0, false);
+  cache_.set_max_size(0);
+  Features fresh, uncached, uncached_again;
+  ExtractFresh(*blob0, false, &fresh);
+  int hits = cache_.hits();
+  ExtractCached(*blob0, false, &uncached);
+  ExtractCached(*blob0, false, &uncached_again);
+  EXPECT_EQ(hits, cache_.hits());
+  EXPECT_TRUE(Same(fresh, uncached));
+  EXPECT_TRUE(Same(fresh, uncached_again));
+  delete blob1;
+  delete blob0;
+}
+
+// Like Classify::ExtractFeatures, a miss or a hit appends to the features
+// already given, and the cached entry holds only those of the blob.
+TEST_F(FeatureCacheTest, AppendsLikeExtractFeatures) {
+  TBLOB* blob0 = NormalizedBlob(0, 1.0f, NULL);
+  TBLOB* blob1 = NormalizedBlob(1, 1.0f, NULL);
+  Features fresh, missed, hit;
+  ExtractFresh(*blob1, false, &fresh);
+  ExtractFresh(*blob0, false, &fresh);
+  ExtractFresh(*blob1, false, &missed);
+  ExtractCached(*blob0, false, &missed);
+  EXPECT_TRUE(Same(fresh, missed));
+  ExtractFresh(*blob1, false, &hit);
+  ExtractCached(*blob0, false, &hit);
+  EXPECT_EQ(1, cache_.hits());
+  EXPECT_TRUE(Same(fresh, hit));
+  Features alone;
+  ExtractCached(*blob0, false, &alone);
+  Features fresh_alone;
+  ExtractFresh(*blob0, false, &fresh_alone);
+  EXPECT_TRUE(Same(fresh_alone, alone));
+  delete blob1;
+  delete blob0;
+}
+
+}  // namespace
@@ -0,0 +1,527 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gradient_test.cc
+// Description: Tests that the CTC targets and the weight gradients match
+//              the plain implementations that their faster versions
+//              replaced.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <float.h>
+#include <math.h>
+#include "ctc.h"
+#include "genericvector.h"
+#include "helpers.h"
+#include "include_gunit.h"
+#include "matrix.h"
+#include "networkio.h"
+#include "weightmatrix.h"
+
+namespace {
+
+using tesseract::CTC;
+using tesseract::NetworkIO;
+using tesseract::TRand;
+using tesseract::TransposedArray;
+using tesseract::WeightMatrix;
+
+// The CTC target computation as it was before the log label probs were
+// cached and the log-sum-exp merged, kept as the reference for CTC.
+class ReferenceCTC {
+ public:
+  static bool ComputeCTCTargets(const GenericVector<int>& labels,
+                                int null_char,
+                                const GENERIC_2D_ARRAY<float>& outputs,
+                                NetworkIO* targets) {
+    ReferenceCTC ctc(labels, null_char, outputs);
+    if (!ctc.ComputeLabelLimits()) return false;
+    GENERIC_2D_ARRAY<float> simple_targets;
+    ctc.ComputeSimpleTargets(&simple_targets);
+    float bias_fraction = ctc.CalculateBiasFraction();
+    simple_targets *= bias_fraction;
+    ctc.outputs_ += simple_targets;
+    NormalizeProbs(&ctc.outputs_);
+    GENERIC_2D_ARRAY<double> log_alphas, log_betas;
+    ctc.Forward(&log_alphas);
+    ctc.Backward(&log_betas);
+    log_alphas += log_betas;
+    ctc.NormalizeSequence(&log_alphas);
+    ctc.LabelsToClasses(log_alphas, targets);
+    NormalizeProbs(targets->mutable_float_array());
+    return true;
+  }
+
+  static void NormalizeProbs(GENERIC_2D_ARRAY<float>* probs) {
+    int num_timesteps = probs->dim1();
+    int num_classes = probs->dim2();
+    for (int t = 0; t < num_timesteps; ++t) {
+      float* probs_t = (*probs)[t];
+      double total = 0.0;
+      for (int c = 0; c < num_classes; ++c) total += probs_t[c];
+      if (total < kMinTotalFinalProb) total = kMinTotalFinalProb;
+      double increment = 0.0;
+      for (int c = 0; c < num_classes; ++c) {
+        double prob = probs_t[c] / total;
+        if (prob < kMinProb) increment += kMinProb - prob;
+      }
+      total += increment;
+      for (int c = 0; c < num_classes; ++c) {
+        float prob = probs_t[c] / total;
+        probs_t[c] = MAX(prob, kMinProb);
+      }
+    }
+  }
+
+ private:
+  ReferenceCTC(const GenericVector<int>& labels, int null_char,
+               const GENERIC_2D_ARRAY<float>& outputs)
+      : labels_(labels), outputs_(outputs), null_char_(null_char) {
+    num_timesteps_ = outputs.dim1();
+    num_classes_ = outputs.dim2();
+    num_labels_ = labels_.size();
+  }
+
+  bool ComputeLabelLimits() {
+    min_labels_.init_to_size(num_timesteps_, 0);
+    max_labels_.init_to_size(num_timesteps_, 0);
+    int min_u = num_labels_ - 1;
+    if (labels_[min_u] == null_char_) --min_u;
+    for (int t = num_timesteps_ - 1; t >= 0; --t) {
+      min_labels_[t] = min_u;
+      if (min_u > 0) {
+        --min_u;
+        if (labels_[min_u] == null_char_ && min_u > 0 &&
+            labels_[min_u + 1] != labels_[min_u - 1]) {
+          --min_u;
+        }
+      }
+    }
+    int max_u = labels_[0] == null_char_;
+    for (int t = 0; t < num_timesteps_; ++t) {
+      max_labels_[t] = max_u;
+      if (max_labels_[t] < min_labels_[t]) return false;
+      if (max_u + 1 < num_labels_) {
+        ++max_u;
+        if (labels_[max_u] == null_char_ && max_u + 1 < num_labels_ &&
+            labels_[max_u + 1] != labels_[max_u - 1]) {
+          ++max_u;
+        }
+      }
+    }
+    return true;
+  }
+
+  void ComputeSimpleTargets(GENERIC_2D_ARRAY<float>* targets) const {
+    targets->Resize(num_timesteps_, num_classes_, 0.0f);
+    GenericVector<float> half_widths;
+    GenericVector<int> means;
+    ComputeWidthsAndMeans(&half_widths, &means);
+    for (int l = 0; l < num_labels_; ++l) {
+      int label = labels_[l];
+      float left_half_width = half_widths[l];
+      float right_half_width = left_half_width;
+      int mean = means[l];
+      if (label == null_char_) {
+        if (!NeededNull(l)) {
+          if ((l > 0 && mean == means[l - 1]) ||
+              (l + 1 < num_labels_ && mean == means[l + 1])) {
+            continue;
+          }
+        }
+        if (l > 0) left_half_width = mean - means[l - 1];
+        if (l + 1 < num_labels_) right_half_width = means[l + 1] - mean;
+      }
+      if (mean >= 0 && mean < num_timesteps_) targets->put(mean, label, 1.0f);
+      for (int offset = 1; offset < left_half_width && mean >= offset;
+           ++offset) {
+        float prob = 1.0f - offset / left_half_width;
+        if (mean - offset < num_timesteps_ &&
+            prob > targets->get(mean - offset, label)) {
+          targets->put(mean - offset, label, prob);
+        }
+      }
+      for (int offset = 1;
+           offset < right_half_width && mean + offset < num_timesteps_;
+           ++offset) {
+        float prob = 1.0f - offset / right_half_width;
+        if (mean + offset >= 0 && prob > targets->get(mean + offset, label)) {
+          targets->put(mean + offset, label, prob);
+        }
+      }
+    }
+  }
+
+  void ComputeWidthsAndMeans(GenericVector<float>* half_widths,
+                             GenericVector<int>* means) const {
+    int num_plus = 0, num_star = 0;
+    for (int i = 0; i < num_labels_; ++i) {
+      if (labels_[i] != null_char_ || NeededNull(i))
+        ++num_plus;
+      else
+        ++num_star;
+    }
+    float plus_size = 1.0f, star_size = 0.0f;
+    float total_floating = num_plus + num_star;
+    if (total_floating <= num_timesteps_) {
+      plus_size = star_size = num_timesteps_ / total_floating;
+    } else if (num_star > 0) {
+      star_size = static_cast<float>(num_timesteps_ - num_plus) / num_star;
+    }
+    float mean_pos = 0.0f;
+    for (int i = 0; i < num_labels_; ++i) {
+      float half_width;
+      if (labels_[i] != null_char_ || NeededNull(i)) {
+        half_width = plus_size / 2.0f;
+      } else {
+        half_width = star_size / 2.0f;
+      }
+      mean_pos += half_width;
+      means->push_back(static_cast<int>(mean_pos));
+      mean_pos += half_width;
+      half_widths->push_back(half_width);
+    }
+  }
+
+  int BestLabel(int t) const {
+    int result = 0;
+    const float* outputs_t = outputs_[t];
+    for (int c = 1; c < num_classes_; ++c) {
+      if (outputs_t[c] > outputs_t[result]) result = c;
+    }
+    return result;
+  }
+
+  float CalculateBiasFraction() {
+    GenericVector<int> output_labels;
+    for (int t = 0; t < num_timesteps_; ++t) {
+      int label = BestLabel(t);
+      while (t + 1 < num_timesteps_ && BestLabel(t + 1) == label) ++t;
+      if (label != null_char_) output_labels.push_back(label);
+    }
+    GenericVector<int> truth_counts(num_classes_, 0);
+    GenericVector<int> output_counts(num_classes_, 0);
+    for (int l = 0; l < num_labels_; ++l) ++truth_counts[labels_[l]];
+    for (int l = 0; l < output_labels.size(); ++l)
+      ++output_counts[output_labels[l]];
+    int true_pos = 0, false_pos = 0, total_labels = 0;
+    for (int c = 0; c < num_classes_; ++c) {
+      if (c == null_char_) continue;
+      int truth_count = truth_counts[c];
+      int ocr_count = output_counts[c];
+      if (truth_count > 0) {
+        total_labels += truth_count;
+        if (ocr_count > truth_count) {
+          true_pos += truth_count;
+          false_pos += ocr_count - truth_count;
+        } else {
+          true_pos += ocr_count;
+        }
+      }
+    }
+    if (total_labels == 0) return 0.0f;
+    return exp(MAX(true_pos - false_pos, 1) * log(kMinProb) / total_labels);
+  }
+
+  static double LogSumExp(double ln_x, double ln_y) {
+    if (ln_x >= ln_y) {
+      return ln_x + log1p(exp(ln_y - ln_x));
+    } else {
+      return ln_y + log1p(exp(ln_x - ln_y));
+    }
+  }
+
+  void Forward(GENERIC_2D_ARRAY<double>* log_probs) const {
+    log_probs->Resize(num_timesteps_, num_labels_, -MAX_FLOAT32);
+    log_probs->put(0, 0, log(outputs_(0, labels_[0])));
+    if (labels_[0] == null_char_)
+      log_probs->put(0, 1, log(outputs_(0, labels_[1])));
+    for (int t = 1; t < num_timesteps_; ++t) {
+      const float* outputs_t = outputs_[t];
+      for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
+        double log_sum = log_probs->get(t - 1, u);
+        if (u > 0) {
+          log_sum = LogSumExp(log_sum, log_probs->get(t - 1, u - 1));
+        }
+        if (u >= 2 && labels_[u - 1] == null_char_ &&
+            labels_[u] != labels_[u - 2]) {
+          log_sum = LogSumExp(log_sum, log_probs->get(t - 1, u - 2));
+        }
+        double label_prob = outputs_t[labels_[u]];
+        log_sum += log(label_prob);
+        log_probs->put(t, u, log_sum);
+      }
+    }
+  }
+
+  void Backward(GENERIC_2D_ARRAY<double>* log_probs) const {
+    log_probs->Resize(num_timesteps_, num_labels_, -MAX_FLOAT32);
+    log_probs->put(num_timesteps_ - 1, num_labels_ - 1, 0.0);
+    if (labels_[num_labels_ - 1] == null_char_)
+      log_probs->put(num_timesteps_ - 1, num_labels_ - 2, 0.0);
+    for (int t = num_timesteps_ - 2; t >= 0; --t) {
+      const float* outputs_tp1 = outputs_[t + 1];
+      for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
+        double log_sum =
+            log_probs->get(t + 1, u) + log(outputs_tp1[labels_[u]]);
+        if (u + 1 < num_labels_) {
+          double prev_prob = outputs_tp1[labels_[u + 1]];
+          log_sum = LogSumExp(log_sum,
+                              log_probs->get(t + 1, u + 1) + log(prev_prob));
+        }
+        if (u + 2 < num_labels_ && labels_[u + 1] == null_char_ &&
+            labels_[u] != labels_[u + 2]) {
+          double skip_prob = outputs_tp1[labels_[u + 2]];
+          log_sum = LogSumExp(log_sum,
+                              log_probs->get(t + 1, u + 2) + log(skip_prob));
+        }
+        log_probs->put(t, u, log_sum);
+      }
+    }
+  }
+
+  static double ClippedExp(double x) {
+    if (x < -kMaxExpArg) return exp(-kMaxExpArg);
+    if (x > kMaxExpArg) return exp(kMaxExpArg);
+    return exp(x);
+  }
+
+  void NormalizeSequence(GENERIC_2D_ARRAY<double>* probs) const {
+    double max_logprob = probs->Max();
+    for (int u = 0; u < num_labels_; ++u) {
+      double total = 0.0;
+      for (int t = 0; t < num_timesteps_; ++t) {
+        double prob = probs->get(t, u);
+        if (prob > -MAX_FLOAT32)
+          prob = ClippedExp(prob - max_logprob);
+        else
+          prob = 0.0;
+        total += prob;
+        probs->put(t, u, prob);
+      }
+      if (total < kMinTotalTimeProb) total = kMinTotalTimeProb;
+      for (int t = 0; t < num_timesteps_; ++t)
+        probs->put(t, u, probs->get(t, u) / total);
+    }
+  }
+
+  void LabelsToClasses(const GENERIC_2D_ARRAY<double>& probs,
+                       NetworkIO* targets) const {
+    GenericVector<double> class_probs;
+    for (int t = 0; t < num_timesteps_; ++t) {
+      float* targets_t = targets->f(t);
+      class_probs.init_to_size(num_classes_, 0.0);
+      for (int u = 0; u < num_labels_; ++u) {
+        double prob = probs(t, u);
+        if (prob > class_probs[labels_[u]]) class_probs[labels_[u]] = prob;
+      }
+      for (int c = 0; c < num_classes_; ++c) targets_t[c] = class_probs[c];
+    }
+  }
+
+  bool NeededNull(int index) const {
+    return labels_[index] == null_char_ && index > 0 &&
+           index + 1 < num_labels_ && labels_[index + 1] == labels_[index - 1];
+  }
+
+  static const float kMinProb;
+  static const double kMaxExpArg;
+  static const double kMinTotalTimeProb;
+  static const double kMinTotalFinalProb;
+
+  const GenericVector<int>& labels_;
+  GENERIC_2D_ARRAY<float> outputs_;
+  int null_char_;
+  int num_timesteps_;
+  int num_classes_;
+  int num_labels_;
+  GenericVector<int> min_labels_;
+  GenericVector<int> max_labels_;
+};
+
+const float ReferenceCTC::kMinProb = 1e-12;
+const double ReferenceCTC::kMaxExpArg = 80.0;
+const double ReferenceCTC::kMinTotalTimeProb = 1e-8;
+const double ReferenceCTC::kMinTotalFinalProb = 1e-6;
+
+// The CTC targets may differ from the reference by rounding in the float
+// results, ie an ulp or so of the largest target.
+const float kCTCTolerance = 1e-6f;
+// Relative tolerance on the weight gradients against a plain dot product,
+// which sums in a different order.
+const double kGradientTolerance = 1e-12;
+
+class GradientTest : public ::testing::Test {
+ protected:
+  // Makes num_timesteps of softmax outputs over num_classes, with random
+  // logits scaled by sharpness, so a large sharpness makes peaky outputs.
+  void MakeOutputs(int num_timesteps, int num_classes, double sharpness,
+                   NetworkIO* outputs) {
+    outputs->Resize2d(false, num_timesteps, num_classes);
+    for (int t = 0; t < num_timesteps; ++t) {
+      float* outputs_t = outputs->f(t);
+      double total = 0.0;
+      for (int c = 0; c < num_classes; ++c) {
+        double value = exp(random_.SignedRand(sharpness));
+        outputs_t[c] = value;
+        total += value;
+      }
+      for (int c = 0; c < num_classes; ++c) outputs_t[c] /= total;
+    }
+  }
+
+  // Makes num_chars random labels in [1, num_classes), with a null (0)
+  // before each and after the last. Every fourth label repeats the one
+  // before, to need the null between them.
+  void MakeLabels(int num_chars, int num_classes, GenericVector<int>* labels) {
+    labels->clear();
+    int prev = 0;
+    for (int i = 0; i < num_chars; ++i) {
+      int label = i % 4 == 3 ? prev : 1 + random_.IntRand() % (num_classes - 1);
+      labels->push_back(0);
+      labels->push_back(label);
+      prev = label;
+    }
+    labels->push_back(0);
+  }
+
+  // Runs CTC and the reference on the same labels and outputs, clipped as by
+  // the trainer, and checks that they agree.
+  void ExpectCTCMatches(const GenericVector<int>& labels,
+                        NetworkIO* outputs) {
+    CTC::NormalizeProbs(outputs);
+    int num_timesteps = outputs->Width();
+    int num_classes = outputs->NumFeatures();
+    NetworkIO targets, expected;
+    targets.Resize2d(false, num_timesteps, num_classes);
+    expected.Resize2d(false, num_timesteps, num_classes);
+    bool ok = CTC::ComputeCTCTargets(labels, 0, outputs->float_array(),
+                                     &targets);
+    EXPECT_EQ(ReferenceCTC::ComputeCTCTargets(labels, 0,
+                                              outputs->float_array(),
+                                              &expected),
+              ok);
+    if (!ok) return;
+    float max_diff = 0.0f;
+    for (int t = 0; t < num_timesteps; ++t) {
+      for (int c = 0; c < num_classes; ++c) {
+        float diff = fabs(targets.f(t)[c] - expected.f(t)[c]);
+        if (diff > max_diff) max_diff = diff;
+      }
+    }
+    EXPECT_LE(max_diff, kCTCTolerance);
+  }
+
+  // Fills array with random values in [-1, 1].
+  void Randomize(int dim1, int dim2, TransposedArray* array) {
+    array->ResizeNoInit(dim1, dim2);
+    for (int i = 0; i < dim1; ++i) {
+      for (int j = 0; j < dim2; ++j) (*array)(i, j) = random_.SignedRand(1.0);
+    }
+  }
+
+  TRand random_;
+};
+
+// The normalized probs match the reference to within an ulp.
+TEST_F(GradientTest, NormalizeProbsMatches) {
+  NetworkIO outputs;
+  MakeOutputs(50, 40, 30.0, &outputs);
+  GENERIC_2D_ARRAY<float> expected = outputs.float_array();
+  CTC::NormalizeProbs(&outputs);
+  ReferenceCTC::NormalizeProbs(&expected);
+  for (int t = 0; t < expected.dim1(); ++t) {
+    for (int c = 0; c < expected.dim2(); ++c) {
+      EXPECT_NEAR(expected(t, c), outputs.f(t)[c],
+                  expected(t, c) * 2 * FLT_EPSILON);
+    }
+  }
+}
+
+// The CTC targets match the reference over a range of line lengths, with
+// both flat and peaky outputs, where the skipped small terms of the
+// log-sum-exp are most common.
+TEST_F(GradientTest, CTCTargetsMatch) {
+  const int kNumClasses = 30;
+  const double kSharpnesses[] = {1.0, 8.0, 60.0};
+  for (double sharpness : kSharpnesses) {
+    for (int num_chars = 1; num_chars <= 40; num_chars += 13) {
+      GenericVector<int> labels;
+      MakeLabels(num_chars, kNumClasses, &labels);
+      NetworkIO outputs;
+      MakeOutputs(num_chars * 3 + 5, kNumClasses, sharpness, &outputs);
+      ExpectCTCMatches(labels, &outputs);
+    }
+  }
+}
+
+// Both agree when there is only just enough time for the labels, and when
+// there is too little.
+TEST_F(GradientTest, CTCTargetsMatchWhenShort) {
+  const int kNumClasses = 10;
+  const int kNumChars = 12;
+  GenericVector<int> labels;
+  MakeLabels(kNumChars, kNumClasses, &labels);
+  for (int num_timesteps = kNumChars - 1; num_timesteps <= kNumChars * 2;
+       ++num_timesteps) {
+    NetworkIO outputs;
+    MakeOutputs(num_timesteps, kNumClasses, 4.0, &outputs);
+    ExpectCTCMatches(labels, &outputs);
+  }
+}
+
+// The blocked transpose is an exact copy of the strided one.
+TEST_F(GradientTest, TransposeMatches) {
+  TransposedArray input;
+  Randomize(37, 21, &input);
+  TransposedArray result, expected;
+  result.Transpose(input);
+  expected.ResizeNoInit(input.dim2(), input.dim1());
+  for (int t = 0; t < input.dim1(); ++t) expected.WriteStrided(t, input[t]);
+  ASSERT_EQ(expected.dim1(), result.dim1());
+  ASSERT_EQ(expected.dim2(), result.dim2());
+  for (int i = 0; i < expected.dim1(); ++i) {
+    for (int t = 0; t < expected.dim2(); ++t)
+      EXPECT_EQ(expected(i, t), result(i, t));
+  }
+}
+
+// The tiled SumOuterTransposed gives each delta bit-identical to the
+// per-element WeightMatrix::DotProduct that it replaced, and within rounding
+// of a plain sum, for sizes that do and don't fill the last tile.
+TEST_F(GradientTest, SumOuterTransposedMatches) {
+  const int kNumSamples = 53;
+  const int kNumInputs = 19;
+  for (int num_outputs = 1; num_outputs <= 11; num_outputs += 5) {
+    WeightMatrix w;
+    w.InitWeightsFloat(num_outputs, kNumInputs + 1, false, 0.1f, &random_);
+    w.InitBackward();
+    TransposedArray u, v;
+    Randomize(num_outputs, kNumSamples, &u);
+    Randomize(kNumInputs, kNumSamples, &v);
+    w.SumOuterTransposed(u, v, false);
+    for (int i = 0; i < num_outputs; ++i) {
+      for (int j = 0; j < kNumInputs; ++j) {
+        EXPECT_EQ(WeightMatrix::DotProduct(u[i], v[j], kNumSamples),
+                  w.GetDW(i, j));
+        double total = 0.0;
+        for (int k = 0; k < kNumSamples; ++k) total += u(i, k) * v(j, k);
+        EXPECT_NEAR(total, w.GetDW(i, j), kGradientTolerance * kNumSamples);
+      }
+      // The missing last element of v is 1.
+      double total = 0.0;
+      for (int k = 0; k < kNumSamples; ++k) total += u(i, k);
+      EXPECT_NEAR(total, w.GetDW(i, kNumInputs),
+                  kGradientTolerance * kNumSamples);
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////
+// File:        langgate_test.cc
+// Description: Tests the certainty gate and block routing that let
+//              multilang_gated_routing skip the other languages.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "ocrblock.h"
+#include "pageres.h"
+#include "ratngs.h"
+#include "tesseractclass.h"
+#include "unicharset.h"
+
+namespace {
+
+using tesseract::PointerVector;
+
+class LangGateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tess_.multilang_gated_routing.set_value(true);
+    tess_.multilang_gate_certainty.set_value(-3.0);
+    tess_.multilang_block_route_words.set_value(3);
+  }
+
+  // Adds to words a result with the given certainty and permuter.
+  void AddWord(float certainty, PermuterType permuter,
+               PointerVector<WERD_RES>* words) {
+    WERD_RES* word = new WERD_RES;
+    WERD_CHOICE* choice = new WERD_CHOICE(&unicharset_);
+    choice->set_certainty(certainty);
+    choice->set_permuter(permuter);
+    WERD_CHOICE_IT it(&word->best_choices);
+    it.add_to_end(choice);
+    word->best_choice = choice;
+    words->push_back(word);
+  }
+
+  // Returns true if a single word with the given certainty and permuter
+  // passes the gate.
+  bool WordPasses(float certainty, PermuterType permuter) {
+    PointerVector<WERD_RES> words;
+    AddWord(certainty, permuter, &words);
+    return tess_.WordsPassLangGate(words);
+  }
+
+  UNICHARSET unicharset_;
+  tesseract::Tesseract tess_;
+  tesseract::Tesseract other_lang_;
+};
+
+// Only confident dictionary or number words pass, and only when gated
+// routing is on.
+TEST_F(LangGateTest, CertaintyGate) {
+  EXPECT_TRUE(WordPasses(-1.0f, SYSTEM_DAWG_PERM));
+  EXPECT_TRUE(WordPasses(-3.0f, NUMBER_PERM));
+  EXPECT_FALSE(WordPasses(-3.5f, SYSTEM_DAWG_PERM));
+  EXPECT_FALSE(WordPasses(-1.0f, TOP_CHOICE_PERM));
+  tess_.multilang_gated_routing.set_value(false);
+  EXPECT_FALSE(WordPasses(-1.0f, SYSTEM_DAWG_PERM));
+}
+
+// A result of several words passes only if they all do, and a failed word
+// never passes.
+TEST_F(LangGateTest, AllWordsMustPass) {
+  PointerVector<WERD_RES> words;
+  AddWord(-1.0f, SYSTEM_DAWG_PERM, &words);
+  AddWord(-2.0f, FREQ_DAWG_PERM, &words);
+  EXPECT_TRUE(tess_.WordsPassLangGate(words));
+  AddWord(-5.0f, SYSTEM_DAWG_PERM, &words);
+  EXPECT_FALSE(tess_.WordsPassLangGate(words));
+  words.truncate(1);
+  words[0]->tess_failed = true;
+  EXPECT_FALSE(tess_.WordsPassLangGate(words));
+}
+
+// A block is routed to a language after multilang_block_route_words
+// consecutive gated words in it, and only that block and language.
+TEST_F(LangGateTest, BlockRouting) {
+  BLOCK block, next_block;
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  EXPECT_FALSE(tess_.IsBlockRouted(&block, &tess_));
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  EXPECT_TRUE(tess_.IsBlockRouted(&block, &tess_));
+  EXPECT_FALSE(tess_.IsBlockRouted(&block, &other_lang_));
+  EXPECT_FALSE(tess_.IsBlockRouted(&next_block, &tess_));
+  // Ungated words don't undo the route once it is made.
+  tess_.UpdateLangRoute(&block, &tess_, false);
+  EXPECT_TRUE(tess_.IsBlockRouted(&block, &tess_));
+  // A new block starts again.
+  tess_.UpdateLangRoute(&next_block, &tess_, true);
+  EXPECT_FALSE(tess_.IsBlockRouted(&block, &tess_));
+  EXPECT_FALSE(tess_.IsBlockRouted(&next_block, &tess_));
+  tess_.multilang_block_route_words.set_value(0);
+  tess_.UpdateLangRoute(&next_block, &tess_, true);
+  EXPECT_FALSE(tess_.IsBlockRouted(&next_block, &tess_));
+}
+
+// An ungated word, or a gated word in another language, breaks the streak
+// before the block is routed.
+TEST_F(LangGateTest, StreakBroken) {
+  BLOCK block;
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  tess_.UpdateLangRoute(&block, &tess_, false);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  EXPECT_FALSE(tess_.IsBlockRouted(&block, &tess_));
+  tess_.UpdateLangRoute(&block, &other_lang_, true);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  EXPECT_FALSE(tess_.IsBlockRouted(&block, &tess_));
+  tess_.UpdateLangRoute(&block, &tess_, true);
+  EXPECT_TRUE(tess_.IsBlockRouted(&block, &tess_));
+}
+
+}  // namespace
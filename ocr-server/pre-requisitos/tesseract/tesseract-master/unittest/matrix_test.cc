@@ -14,6 +14,7 @@
 // limitations under the License.
 ///////////////////////////////////////////////////////////////////////
 
+#include <stdint.h>
 #include "matrix.h"
 #include "include_gunit.h"
 #include "genericvector.h"
@@ -132,4 +133,34 @@ TEST_F(MatrixTest, RotatingTranspose_0_2) {
   EXPECT_EQ(6, m(15, 0));
 }
 
+// Tests that ResizeWithCopy keeps the data, both when it fits in the
+// existing allocation and when it doesn't, and that the storage is aligned.
+TEST_F(MatrixTest, ResizeWithCopy) {
+  GENERIC_2D_ARRAY<int> m(src_);
+  m.ResizeNoInit(10, 12);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(m[0]) % kMatrixAlignment);
+  // Fewer, longer rows, in place.
+  m.ResizeWithCopy(8, 15);
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 15; ++j) {
+      EXPECT_EQ(j < 12 ? i * 12 + j : 0, m(i, j));
+    }
+  }
+  // More, shorter rows, in place.
+  m.ResizeWithCopy(12, 10);
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      EXPECT_EQ(i < 8 ? i * 12 + j : 0, m(i, j));
+    }
+  }
+  // Bigger than the allocation.
+  m.ResizeWithCopy(20, 20);
+  for (int i = 0; i < 20; ++i) {
+    for (int j = 0; j < 20; ++j) {
+      EXPECT_EQ(i < 8 && j < 10 ? i * 12 + j : 0, m(i, j));
+    }
+  }
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(m[0]) % kMatrixAlignment);
+}
+
 }  // namespace
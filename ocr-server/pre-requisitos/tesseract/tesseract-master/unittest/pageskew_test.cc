@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageskew_test.cc
+// Description: Tests FindPageSkew and the mapping of layout results of a
+//              deskewed page back to the input image.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include "allheaders.h"
+#include "baseapi.h"
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "pageskew.h"
+#include "points.h"
+
+namespace {
+
+// A full page of text, without any skew of its own.
+const char kTestImage[] = "../testing/hebrew-nikud-genesis-1-2.png";
+
+// Returns pix rotated clockwise by the given degrees about its centre, as
+// TessBaseAPI rotates the images it deskews.
+Pix* Rotate(Pix* pix, double degrees) {
+  return pixRotateShearCenter(
+      pix, static_cast<l_float32>(degrees * M_PI / 180), L_BRING_IN_WHITE);
+}
+
+class PageSkewTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Pix* pix = pixRead(kTestImage);
+    ASSERT_TRUE(pix != NULL) << "Failed to read " << kTestImage;
+    // Pad the page so no text is rotated out of the image.
+    Pix* grey = pixConvertTo8(pix, false);
+    grey_ = pixAddBorder(grey, 150, 255);
+    binary_ = pixConvertTo1(grey_, 128);
+    pixDestroy(&grey);
+    pixDestroy(&pix);
+  }
+  void TearDown() override {
+    pixDestroy(&grey_);
+    pixDestroy(&binary_);
+  }
+
+  // Returns the centres of the text lines that layout analysis finds in pix,
+  // in image coordinates, deskewing pix first if deskew is true.
+  void FindLineCentres(Pix* pix, bool deskew, GenericVector<FCOORD>* centres) {
+    tesseract::TessBaseAPI api;
+    api.InitForAnalysePage();
+    api.SetVariable("tessedit_deskew_image", deskew ? "1" : "0");
+    api.SetPageSegMode(tesseract::PSM_AUTO_ONLY);
+    api.SetImage(pix);
+    tesseract::PageIterator* it = api.AnalyseLayout();
+    ASSERT_TRUE(it != NULL);
+    do {
+      int left, top, right, bottom;
+      if (it->BoundingBox(tesseract::RIL_TEXTLINE, &left, &top, &right,
+                          &bottom)) {
+        centres->push_back(FCOORD((left + right) / 2.0f,
+                                  (top + bottom) / 2.0f));
+      }
+    } while (it->Next(tesseract::RIL_TEXTLINE));
+    delete it;
+    // The layout must have been found on a straight page.
+    Pix* thresholded = api.GetThresholdedImage();
+    double angle, confidence;
+    tesseract::FindPageSkew(thresholded, 5.0, &angle, &confidence);
+    EXPECT_NEAR(0.0, angle * 180 / M_PI, 0.1);
+    pixDestroy(&thresholded);
+  }
+
+  Pix* grey_;
+  Pix* binary_;
+};
+
+// The skew of a rotated page is found to within 0.05 degrees, as the
+// rotation that undoes it.
+TEST_F(PageSkewTest, FindsKnownAngle) {
+  const double kAngles[] = {-3.0, -1.1, -0.4, 0.0, 0.3, 1.7, 4.2};
+  const int kNumAngles = sizeof(kAngles) / sizeof(kAngles[0]);
+  for (int a = 0; a < kNumAngles; ++a) {
+    Pix* skewed = Rotate(binary_, kAngles[a]);
+    double angle, confidence;
+    EXPECT_TRUE(tesseract::FindPageSkew(skewed, 5.0, &angle, &confidence))
+        << "at " << kAngles[a];
+    EXPECT_NEAR(-kAngles[a], angle * 180 / M_PI, 0.05) << "at " << kAngles[a];
+    pixDestroy(&skewed);
+  }
+}
+
+// A page without text has no skew.
+TEST_F(PageSkewTest, BlankPage) {
+  Pix* blank = pixCreate(pixGetWidth(binary_), pixGetHeight(binary_), 1);
+  double angle, confidence;
+  EXPECT_FALSE(tesseract::FindPageSkew(blank, 5.0, &angle, &confidence));
+  EXPECT_EQ(0.0, angle);
+  pixDestroy(&blank);
+}
+
+// With tessedit_deskew_image, the layout of a skewed page is found on the
+// deskewed image, but reported in the coordinates of the skewed input: each
+// text line of the straight page, rotated like the input, has a line there.
+TEST_F(PageSkewTest, BoxesMapToInputImage) {
+  const double kDegrees = 2.5;
+  GenericVector<FCOORD> straight, skewed;
+  FindLineCentres(grey_, false, &straight);
+  ASSERT_GT(straight.size(), 10);
+  Pix* input = Rotate(grey_, kDegrees);
+  FindLineCentres(input, true, &skewed);
+  // The centre of rotation in image coordinates.
+  FCOORD centre(pixGetWidth(input) / 2, pixGetHeight(input) / 2);
+  pixDestroy(&input);
+  EXPECT_EQ(straight.size(), skewed.size());
+  double sin_a = sin(kDegrees * M_PI / 180);
+  double cos_a = cos(kDegrees * M_PI / 180);
+  for (int i = 0; i < straight.size(); ++i) {
+    // Clockwise in image coordinates, where y points down.
+    FCOORD d = straight[i] - centre;
+    FCOORD expected(centre.x() + d.x() * cos_a - d.y() * sin_a,
+                    centre.y() + d.x() * sin_a + d.y() * cos_a);
+    double best = -1.0;
+    for (int j = 0; j < skewed.size(); ++j) {
+      double dist = (skewed[j] - expected).length();
+      if (best < 0.0 || dist < best) best = dist;
+    }
+    EXPECT_LT(best, 4.0) << "line " << i << " at " << expected.x() << ","
+                         << expected.y();
+  }
+}
+
+}  // namespace
@@ -0,0 +1,726 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagesnapshot_test.cc
+// Description: Tests the serialized form of PageSnapshot, and that the
+//              TSV, hOCR and PDF text rendered from it match the
+//              ResultIterator walks they replaced.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+#include "allheaders.h"
+#include "baseapi.h"
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "mutableiterator.h"
+#include "pageres.h"
+#include "pagesnapshot.h"
+#include "renderer.h"
+#include "resultiterator.h"
+#include "serialis.h"
+#include "strngs.h"
+#include "tesseractclass.h"
+#include "unichar.h"
+
+// Helpers of pdfrenderer.cpp, unchanged by the move to PageSnapshot.
+namespace tesseract {
+double prec(double x);
+void GetWordBaseline(int writing_direction, int ppi, int height,
+                     int word_x1, int word_y1, int word_x2, int word_y2,
+                     int line_x1, int line_y1, int line_x2, int line_y2,
+                     double* x0, double* y0, double* length);
+void AffineMatrix(int writing_direction,
+                  int line_x1, int line_y1, int line_x2, int line_y2,
+                  double* a, double* b, double* c, double* d);
+void ClipBaseline(int ppi, int x1, int y1, int x2, int y2,
+                  int* line_x1, int* line_y1, int* line_x2, int* line_y2);
+bool CodepointToUtf16be(int code, char utf16[20]);
+}  // namespace tesseract
+
+namespace {
+
+using tesseract::PageIterator;
+using tesseract::PageIteratorLevel;
+using tesseract::PageSnapshot;
+using tesseract::ResultIterator;
+using tesseract::TFile;
+
+const char* kTestImages[] = {
+    "../testing/hebrew-nikud-genesis-1-2.png", "../testing/hebrew.png",
+    "../testing/hebtypo.jpg", "../testing/DuTillet1004Pg2LG.jpg"};
+const int kNumTestImages = sizeof(kTestImages) / sizeof(kTestImages[0]);
+
+// Gives the api a page of results to render without language data: the
+// layout of pix is analysed as usual, and each word is given a made up best
+// choice, with varying text and certainty. Two words in three have the
+// language of the api.
+bool LayoutWithFakeText(Pix* pix, tesseract::TessBaseAPI* api) {
+  api->InitForAnalysePage();
+  api->SetImage(pix);
+  delete api->AnalyseLayout();
+  std::unique_ptr<tesseract::MutableIterator> mutable_it(
+      api->GetMutableIterator());
+  if (mutable_it == nullptr) return false;
+  const UNICHARSET& unicharset = api->tesseract()->unicharset;
+  PAGE_RES_IT it(mutable_it->PageResIt()->page_res);
+  int n = 0;
+  for (it.restart_page(); it.word() != NULL; it.forward(), ++n) {
+    it.word()->SetupFake(unicharset);
+    WERD_CHOICE* choice = it.word()->best_choice;
+    for (int i = 0; i < choice->length(); ++i)
+      choice->set_unichar_id(1 + (n + i) % (unicharset.size() - 1), i);
+    choice->set_certainty(-(n % 17));
+    it.word()->tesseract = n % 3 != 0 ? api->tesseract() : NULL;
+  }
+  return n > 0;
+}
+
+void AddTSVRowStart(int level, int page_num, int block_num, int par_num,
+                    int line_num, int word_num, STRING* tsv_str) {
+  tsv_str->add_str_int("", level);
+  tsv_str->add_str_int("\t", page_num);
+  tsv_str->add_str_int("\t", block_num);
+  tsv_str->add_str_int("\t", par_num);
+  tsv_str->add_str_int("\t", line_num);
+  tsv_str->add_str_int("\t", word_num);
+}
+
+void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
+                 STRING* tsv_str) {
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  tsv_str->add_str_int("\t", left);
+  tsv_str->add_str_int("\t", top);
+  tsv_str->add_str_int("\t", right - left);
+  tsv_str->add_str_int("\t", bottom - top);
+}
+
+// The GetTSVText of before PageSnapshot, which walked the ResultIterator,
+// for a page of the given size without a rectangle set.
+STRING IteratorTSVText(tesseract::TessBaseAPI* api, int page_number,
+                       int width, int height) {
+  int page_num = page_number + 1, block_num = 0, par_num = 0, line_num = 0,
+      word_num = 0;
+  STRING tsv_str("");
+  AddTSVRowStart(1, page_num, block_num, par_num, line_num, word_num,
+                 &tsv_str);
+  tsv_str.add_str_int("\t", 0);
+  tsv_str.add_str_int("\t", 0);
+  tsv_str.add_str_int("\t", width);
+  tsv_str.add_str_int("\t", height);
+  tsv_str += "\t-1\t\n";
+  ResultIterator* res_it = api->GetIterator();
+  while (!res_it->Empty(tesseract::RIL_BLOCK)) {
+    if (res_it->Empty(tesseract::RIL_WORD)) {
+      res_it->Next(tesseract::RIL_WORD);
+      continue;
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_BLOCK)) {
+      block_num++, par_num = 0, line_num = 0, word_num = 0;
+      AddTSVRowStart(2, page_num, block_num, par_num, line_num, word_num,
+                     &tsv_str);
+      AddBoxToTSV(res_it, tesseract::RIL_BLOCK, &tsv_str);
+      tsv_str += "\t-1\t\n";
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_PARA)) {
+      par_num++, line_num = 0, word_num = 0;
+      AddTSVRowStart(3, page_num, block_num, par_num, line_num, word_num,
+                     &tsv_str);
+      AddBoxToTSV(res_it, tesseract::RIL_PARA, &tsv_str);
+      tsv_str += "\t-1\t\n";
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+      line_num++, word_num = 0;
+      AddTSVRowStart(4, page_num, block_num, par_num, line_num, word_num,
+                     &tsv_str);
+      AddBoxToTSV(res_it, tesseract::RIL_TEXTLINE, &tsv_str);
+      tsv_str += "\t-1\t\n";
+    }
+    word_num++;
+    AddTSVRowStart(5, page_num, block_num, par_num, line_num, word_num,
+                   &tsv_str);
+    AddBoxToTSV(res_it, tesseract::RIL_WORD, &tsv_str);
+    tsv_str.add_str_int("\t", res_it->Confidence(tesseract::RIL_WORD));
+    tsv_str += "\t";
+    do {
+      tsv_str += std::unique_ptr<const char[]>(
+                     res_it->GetUTF8Text(tesseract::RIL_SYMBOL)).get();
+      res_it->Next(tesseract::RIL_SYMBOL);
+    } while (!res_it->Empty(tesseract::RIL_BLOCK) &&
+             !res_it->IsAtBeginningOf(tesseract::RIL_WORD));
+    tsv_str += "\n";
+  }
+  delete res_it;
+  return tsv_str;
+}
+
+// The AddBaselineCoordsTohOCR of before PageSnapshot.
+void IteratorBaselineTohOCR(const PageIterator* it, PageIteratorLevel level,
+                            STRING* hocr_str) {
+  tesseract::Orientation orientation;
+  tesseract::WritingDirection writing_direction;
+  tesseract::TextlineOrder textline_order;
+  float deskew_angle;
+  it->Orientation(&orientation, &writing_direction, &textline_order,
+                  &deskew_angle);
+  if (orientation != tesseract::ORIENTATION_PAGE_UP) {
+    hocr_str->add_str_int("; textangle ", 360 - orientation * 90);
+    return;
+  }
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  int x1, y1, x2, y2;
+  if (!it->Baseline(level, &x1, &y1, &x2, &y2)) return;
+  x1 -= left;
+  x2 -= left;
+  y1 -= bottom;
+  y2 -= bottom;
+  if (x1 == x2) return;
+  double p1 = (y2 - y1) / static_cast<double>(x2 - x1);
+  double p0 = y1 - static_cast<double>(p1 * x1);
+  hocr_str->add_str_double("; baseline ", round(p1 * 1000.0) / 1000.0);
+  hocr_str->add_str_double(" ", round(p0 * 1000.0) / 1000.0);
+}
+
+// The AddIdTohOCR of before PageSnapshot.
+void IteratorIdTohOCR(STRING* hocr_str, const char* base, int num1,
+                      int num2) {
+  char id_buffer[64];
+  if (num2 >= 0)
+    snprintf(id_buffer, sizeof(id_buffer), "%s_%d_%d", base, num1, num2);
+  else
+    snprintf(id_buffer, sizeof(id_buffer), "%s_%d", base, num1);
+  *hocr_str += " id='";
+  *hocr_str += id_buffer;
+  *hocr_str += "'";
+}
+
+// The AddBoxTohOCR of before PageSnapshot.
+void IteratorBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
+                       STRING* hocr_str) {
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  hocr_str->add_str_int(" title=\"bbox ", left);
+  hocr_str->add_str_int(" ", top);
+  hocr_str->add_str_int(" ", right);
+  hocr_str->add_str_int(" ", bottom);
+  if (level == tesseract::RIL_TEXTLINE) {
+    IteratorBaselineTohOCR(it, level, hocr_str);
+    float row_height, descenders, ascenders;
+    it->RowAttributes(&row_height, &descenders, &ascenders);
+    hocr_str->add_str_double("; x_size ", row_height);
+    hocr_str->add_str_double("; x_descenders ", descenders * -1);
+    hocr_str->add_str_double("; x_ascenders ", ascenders);
+  }
+  *hocr_str += "\">";
+}
+
+// The GetHOCRText of before PageSnapshot, which walked the ResultIterator,
+// for a page of the given size and input name without a rectangle set.
+STRING IteratorHOCRText(tesseract::TessBaseAPI* api, int page_number,
+                        const char* input_name, int width, int height,
+                        bool font_info) {
+  int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
+  int page_id = page_number + 1;
+  bool para_is_ltr = true;
+  const char* paragraph_lang = NULL;
+  STRING hocr_str("");
+  hocr_str += "  <div class='ocr_page'";
+  IteratorIdTohOCR(&hocr_str, "page", page_id, -1);
+  hocr_str += " title='image \"";
+  hocr_str += tesseract::HOcrEscape(input_name);
+  hocr_str.add_str_int("\"; bbox ", 0);
+  hocr_str.add_str_int(" ", 0);
+  hocr_str.add_str_int(" ", width);
+  hocr_str.add_str_int(" ", height);
+  hocr_str.add_str_int("; ppageno ", page_number);
+  hocr_str += "'>\n";
+  ResultIterator* res_it = api->GetIterator();
+  while (!res_it->Empty(tesseract::RIL_BLOCK)) {
+    if (res_it->Empty(tesseract::RIL_WORD)) {
+      res_it->Next(tesseract::RIL_WORD);
+      continue;
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_BLOCK)) {
+      para_is_ltr = true;
+      hocr_str += "   <div class='ocr_carea'";
+      IteratorIdTohOCR(&hocr_str, "block", page_id, bcnt);
+      IteratorBoxTohOCR(res_it, tesseract::RIL_BLOCK, &hocr_str);
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_PARA)) {
+      hocr_str += "\n    <p class='ocr_par'";
+      para_is_ltr = res_it->ParagraphIsLtr();
+      if (!para_is_ltr) hocr_str += " dir='rtl'";
+      IteratorIdTohOCR(&hocr_str, "par", page_id, pcnt);
+      paragraph_lang = res_it->WordRecognitionLanguage();
+      if (paragraph_lang) {
+        hocr_str += " lang='";
+        hocr_str += paragraph_lang;
+        hocr_str += "'";
+      }
+      IteratorBoxTohOCR(res_it, tesseract::RIL_PARA, &hocr_str);
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+      hocr_str += "\n     <span class='ocr_line'";
+      IteratorIdTohOCR(&hocr_str, "line", page_id, lcnt);
+      IteratorBoxTohOCR(res_it, tesseract::RIL_TEXTLINE, &hocr_str);
+    }
+    hocr_str += "<span class='ocrx_word'";
+    IteratorIdTohOCR(&hocr_str, "word", page_id, wcnt);
+    int left, top, right, bottom;
+    bool bold, italic, underlined, monospace, serif, smallcaps;
+    int pointsize, font_id;
+    res_it->BoundingBox(tesseract::RIL_WORD, &left, &top, &right, &bottom);
+    const char* font_name = res_it->WordFontAttributes(
+        &bold, &italic, &underlined, &monospace, &serif, &smallcaps,
+        &pointsize, &font_id);
+    hocr_str.add_str_int(" title='bbox ", left);
+    hocr_str.add_str_int(" ", top);
+    hocr_str.add_str_int(" ", right);
+    hocr_str.add_str_int(" ", bottom);
+    hocr_str.add_str_int("; x_wconf ",
+                         res_it->Confidence(tesseract::RIL_WORD));
+    if (font_info) {
+      if (font_name) {
+        hocr_str += "; x_font ";
+        hocr_str += tesseract::HOcrEscape(font_name);
+      }
+      hocr_str.add_str_int("; x_fsize ", pointsize);
+    }
+    hocr_str += "'";
+    const char* lang = res_it->WordRecognitionLanguage();
+    if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
+      hocr_str += " lang='";
+      hocr_str += lang;
+      hocr_str += "'";
+    }
+    switch (res_it->WordDirection()) {
+      case DIR_LEFT_TO_RIGHT:
+        if (!para_is_ltr) hocr_str += " dir='ltr'";
+        break;
+      case DIR_RIGHT_TO_LEFT:
+        if (para_is_ltr) hocr_str += " dir='rtl'";
+        break;
+      default:
+        break;
+    }
+    hocr_str += ">";
+    bool last_word_in_line =
+        res_it->IsAtFinalElement(tesseract::RIL_TEXTLINE, tesseract::RIL_WORD);
+    bool last_word_in_para =
+        res_it->IsAtFinalElement(tesseract::RIL_PARA, tesseract::RIL_WORD);
+    bool last_word_in_block =
+        res_it->IsAtFinalElement(tesseract::RIL_BLOCK, tesseract::RIL_WORD);
+    if (bold) hocr_str += "<strong>";
+    if (italic) hocr_str += "<em>";
+    do {
+      const std::unique_ptr<const char[]> grapheme(
+          res_it->GetUTF8Text(tesseract::RIL_SYMBOL));
+      if (grapheme && grapheme[0] != 0)
+        hocr_str += tesseract::HOcrEscape(grapheme.get());
+      res_it->Next(tesseract::RIL_SYMBOL);
+    } while (!res_it->Empty(tesseract::RIL_BLOCK) &&
+             !res_it->IsAtBeginningOf(tesseract::RIL_WORD));
+    if (italic) hocr_str += "</em>";
+    if (bold) hocr_str += "</strong>";
+    hocr_str += "</span> ";
+    wcnt++;
+    if (last_word_in_line) {
+      hocr_str += "\n     </span>";
+      lcnt++;
+    }
+    if (last_word_in_para) {
+      hocr_str += "\n    </p>\n";
+      pcnt++;
+      para_is_ltr = true;
+    }
+    if (last_word_in_block) {
+      hocr_str += "   </div>\n";
+      bcnt++;
+    }
+  }
+  hocr_str += "  </div>\n";
+  delete res_it;
+  return hocr_str;
+}
+
+// The GetPDFTextObjects of before PageSnapshot, which walked the
+// ResultIterator, for a page of the given size in points, without the image.
+STRING IteratorPDFText(tesseract::TessBaseAPI* api, double width,
+                       double height) {
+  using tesseract::prec;
+  const int kCharWidth = 2;
+  const int kMaxBytesPerCodepoint = 20;
+  STRING pdf_str("");
+  double ppi = api->GetSourceYResolution();
+  double old_x = 0.0, old_y = 0.0;
+  int old_fontsize = 0;
+  tesseract::WritingDirection old_writing_direction =
+      tesseract::WRITING_DIRECTION_LEFT_TO_RIGHT;
+  bool new_block = true;
+  int fontsize = 0;
+  double a = 1, b = 0, c = 0, d = 1;
+  pdf_str += "q ";
+  pdf_str.add_str_double("", prec(width));
+  pdf_str += " 0 0 ";
+  pdf_str.add_str_double("", prec(height));
+  pdf_str += " 0 0 cm";
+  pdf_str += " Q\n";
+  int line_x1 = 0, line_y1 = 0, line_x2 = 0, line_y2 = 0;
+  ResultIterator* res_it = api->GetIterator();
+  while (!res_it->Empty(tesseract::RIL_BLOCK)) {
+    if (res_it->IsAtBeginningOf(tesseract::RIL_BLOCK)) {
+      pdf_str += "BT\n3 Tr";
+      old_fontsize = 0;
+      new_block = true;
+    }
+    if (res_it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+      int x1, y1, x2, y2;
+      res_it->Baseline(tesseract::RIL_TEXTLINE, &x1, &y1, &x2, &y2);
+      tesseract::ClipBaseline(ppi, x1, y1, x2, y2, &line_x1, &line_y1,
+                              &line_x2, &line_y2);
+    }
+    if (res_it->Empty(tesseract::RIL_WORD)) {
+      res_it->Next(tesseract::RIL_WORD);
+      continue;
+    }
+    tesseract::WritingDirection writing_direction;
+    {
+      tesseract::Orientation orientation;
+      tesseract::TextlineOrder textline_order;
+      float deskew_angle;
+      res_it->Orientation(&orientation, &writing_direction, &textline_order,
+                          &deskew_angle);
+      if (writing_direction != tesseract::WRITING_DIRECTION_TOP_TO_BOTTOM) {
+        switch (res_it->WordDirection()) {
+          case DIR_LEFT_TO_RIGHT:
+            writing_direction = tesseract::WRITING_DIRECTION_LEFT_TO_RIGHT;
+            break;
+          case DIR_RIGHT_TO_LEFT:
+            writing_direction = tesseract::WRITING_DIRECTION_RIGHT_TO_LEFT;
+            break;
+          default:
+            writing_direction = old_writing_direction;
+        }
+      }
+    }
+    double x, y, word_length;
+    {
+      int word_x1, word_y1, word_x2, word_y2;
+      res_it->Baseline(tesseract::RIL_WORD, &word_x1, &word_y1, &word_x2,
+                       &word_y2);
+      tesseract::GetWordBaseline(writing_direction, ppi, height, word_x1,
+                                 word_y1, word_x2, word_y2, line_x1, line_y1,
+                                 line_x2, line_y2, &x, &y, &word_length);
+    }
+    if (writing_direction != old_writing_direction || new_block) {
+      tesseract::AffineMatrix(writing_direction, line_x1, line_y1, line_x2,
+                              line_y2, &a, &b, &c, &d);
+      pdf_str.add_str_double(" ", prec(a));
+      pdf_str.add_str_double(" ", prec(b));
+      pdf_str.add_str_double(" ", prec(c));
+      pdf_str.add_str_double(" ", prec(d));
+      pdf_str.add_str_double(" ", prec(x));
+      pdf_str.add_str_double(" ", prec(y));
+      pdf_str += (" Tm ");
+      new_block = false;
+    } else {
+      double dx = x - old_x;
+      double dy = y - old_y;
+      pdf_str.add_str_double(" ", prec(dx * a + dy * b));
+      pdf_str.add_str_double(" ", prec(dx * c + dy * d));
+      pdf_str += (" Td ");
+    }
+    old_x = x;
+    old_y = y;
+    old_writing_direction = writing_direction;
+    {
+      bool bold, italic, underlined, monospace, serif, smallcaps;
+      int font_id;
+      res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
+                                 &serif, &smallcaps, &fontsize, &font_id);
+      const int kDefaultFontsize = 8;
+      if (fontsize <= 0) fontsize = kDefaultFontsize;
+      if (fontsize != old_fontsize) {
+        char textfont[20];
+        snprintf(textfont, sizeof(textfont), "/f-0-0 %d Tf ", fontsize);
+        pdf_str += textfont;
+        old_fontsize = fontsize;
+      }
+    }
+    bool last_word_in_line =
+        res_it->IsAtFinalElement(tesseract::RIL_TEXTLINE, tesseract::RIL_WORD);
+    bool last_word_in_block =
+        res_it->IsAtFinalElement(tesseract::RIL_BLOCK, tesseract::RIL_WORD);
+    STRING pdf_word("");
+    int pdf_word_len = 0;
+    do {
+      const std::unique_ptr<const char[]> grapheme(
+          res_it->GetUTF8Text(tesseract::RIL_SYMBOL));
+      if (grapheme && grapheme[0] != '\0') {
+        std::vector<tesseract::char32> unicodes =
+            tesseract::UNICHAR::UTF8ToUTF32(grapheme.get());
+        char utf16[kMaxBytesPerCodepoint];
+        for (tesseract::char32 code : unicodes) {
+          if (tesseract::CodepointToUtf16be(code, utf16)) {
+            pdf_word += utf16;
+            pdf_word_len++;
+          }
+        }
+      }
+      res_it->Next(tesseract::RIL_SYMBOL);
+    } while (!res_it->Empty(tesseract::RIL_BLOCK) &&
+             !res_it->IsAtBeginningOf(tesseract::RIL_WORD));
+    if (word_length > 0 && pdf_word_len > 0 && fontsize > 0) {
+      double h_stretch =
+          kCharWidth * prec(100.0 * word_length / (fontsize * pdf_word_len));
+      pdf_str.add_str_double("", h_stretch);
+      pdf_str += " Tz";
+      pdf_str += " [ <";
+      pdf_str += pdf_word;
+      pdf_str += "> ] TJ";
+    }
+    if (last_word_in_line) pdf_str += " \n";
+    if (last_word_in_block) pdf_str += "ET\n";
+  }
+  delete res_it;
+  return pdf_str;
+}
+
+// Gives the tests access to the PDF text of a page.
+class TestPDFRenderer : public tesseract::TessPDFRenderer {
+ public:
+  TestPDFRenderer() : tesseract::TessPDFRenderer("-", "", true) {}
+  using tesseract::TessPDFRenderer::GetPDFTextObjects;
+};
+
+class PageSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Pix* pix = pixRead(kTestImages[0]);
+    ASSERT_TRUE(pix != NULL) << "Failed to read " << kTestImages[0];
+    ASSERT_TRUE(LayoutWithFakeText(pix, &api_));
+    pixDestroy(&pix);
+    snapshot_.reset(api_.GetPageSnapshot());
+    ASSERT_TRUE(snapshot_ != nullptr);
+    ASSERT_GT(snapshot_->num_words(), 10);
+    TFile fp;
+    fp.OpenWrite(&serialized_);
+    ASSERT_TRUE(snapshot_->Serialize(&fp));
+    ASSERT_EQ(snapshot_->size(), serialized_.size());
+  }
+
+  // Returns a 4-byte aligned copy of the serialized snapshot, to modify.
+  GenericVector<inT32> AlignedCopy() const {
+    GenericVector<inT32> copy;
+    copy.init_to_size(serialized_.size() / sizeof(inT32), 0);
+    memcpy(&copy[0], &serialized_[0], serialized_.size());
+    return copy;
+  }
+
+  // Returns true if SetFromBuffer accepts the given buffer. If not, checks
+  // that the snapshot is left valid and empty.
+  static bool Accepts(const GenericVector<inT32>& buffer) {
+    PageSnapshot snapshot;
+    if (snapshot.SetFromBuffer(reinterpret_cast<const char*>(&buffer[0]),
+                               buffer.size() * sizeof(inT32)))
+      return true;
+    EXPECT_EQ(0, snapshot.num_words());
+    EXPECT_STREQ("", snapshot.text());
+    return false;
+  }
+
+  tesseract::TessBaseAPI api_;
+  std::unique_ptr<PageSnapshot> snapshot_;
+  GenericVector<char> serialized_;
+};
+
+// A snapshot reads back identically, and leaves the file just past itself.
+TEST_F(PageSnapshotTest, SerializeRoundTrip) {
+  GenericVector<char> data;
+  TFile out;
+  out.OpenWrite(&data);
+  ASSERT_TRUE(snapshot_->Serialize(&out));
+  ASSERT_TRUE(snapshot_->Serialize(&out));
+  TFile in;
+  ASSERT_TRUE(in.Open(&data[0], data.size()));
+  for (int i = 0; i < 2; ++i) {
+    PageSnapshot copy;
+    ASSERT_TRUE(copy.DeSerialize(&in));
+    EXPECT_EQ(snapshot_->num_blocks(), copy.num_blocks());
+    EXPECT_EQ(snapshot_->num_words(), copy.num_words());
+    EXPECT_EQ(snapshot_->num_symbols(), copy.num_symbols());
+    EXPECT_STREQ(snapshot_->text(), copy.text());
+    ASSERT_EQ(snapshot_->size(), copy.size());
+    EXPECT_EQ(0, memcmp(snapshot_->data(), copy.data(), copy.size()));
+  }
+  EXPECT_EQ(0, in.remaining());
+  // Used in place, the buffer is not copied.
+  GenericVector<inT32> aligned = AlignedCopy();
+  PageSnapshot view;
+  ASSERT_TRUE(view.SetFromBuffer(reinterpret_cast<const char*>(&aligned[0]),
+                                 serialized_.size()));
+  EXPECT_EQ(reinterpret_cast<const char*>(&aligned[0]), view.data());
+  EXPECT_EQ(snapshot_->num_words(), view.num_words());
+}
+
+// Every truncation of a snapshot is rejected, by both DeSerialize and
+// SetFromBuffer.
+TEST_F(PageSnapshotTest, RejectsTruncated) {
+  GenericVector<inT32> aligned = AlignedCopy();
+  const char* data = reinterpret_cast<const char*>(&aligned[0]);
+  for (int size = 0; size < serialized_.size(); size += sizeof(inT32)) {
+    PageSnapshot snapshot;
+    EXPECT_FALSE(snapshot.SetFromBuffer(data, size)) << "at " << size;
+    if (size == 0) continue;  // TFile can't open an empty buffer.
+    TFile fp;
+    fp.Open(&serialized_[0], size);
+    EXPECT_FALSE(snapshot.DeSerialize(&fp)) << "at " << size;
+    EXPECT_EQ(0, snapshot.num_words());
+  }
+}
+
+// A header that claims more data than the file holds is rejected before
+// anything is allocated for it.
+TEST_F(PageSnapshotTest, RejectsSizeBeyondFile) {
+  GenericVector<inT32> aligned = AlignedCopy();
+  const int kSizeIndex = 3;  // magic, byte_order, version, size.
+  ASSERT_EQ(snapshot_->size(), aligned[kSizeIndex]);
+  aligned[kSizeIndex] = 0x7ffffff0;
+  TFile fp;
+  fp.Open(reinterpret_cast<const char*>(&aligned[0]), serialized_.size());
+  PageSnapshot snapshot;
+  EXPECT_FALSE(snapshot.DeSerialize(&fp));
+  EXPECT_EQ(0, snapshot.num_words());
+  EXPECT_FALSE(Accepts(aligned));
+}
+
+// Any header field or element range that points outside the buffer, and
+// any mismatch of format, is rejected.
+TEST_F(PageSnapshotTest, RejectsCorrupted) {
+  GenericVector<inT32> original = AlignedCopy();
+  ASSERT_TRUE(Accepts(original));
+  // All the header fields after the magic, except the size, which is
+  // covered by RejectsSizeBeyondFile.
+  const int kNumHeaderInts = 18;
+  const int kBadValues[] = {-1, 1 << 30};
+  for (int i = 1; i < kNumHeaderInts; ++i) {
+    if (i == 3) continue;
+    for (int v = 0; v < sizeof(kBadValues) / sizeof(kBadValues[0]); ++v) {
+      GenericVector<inT32> corrupt = original;
+      corrupt[i] = kBadValues[v];
+      EXPECT_FALSE(Accepts(corrupt)) << "header " << i << " = "
+                                     << kBadValues[v];
+    }
+  }
+  GenericVector<inT32> corrupt = original;
+  reinterpret_cast<char*>(&corrupt[0])[0] = 'X';
+  EXPECT_FALSE(Accepts(corrupt)) << "magic";
+  // An array that is not 4-byte aligned.
+  const int kWordsOffsetIndex = 12;
+  corrupt = original;
+  corrupt[kWordsOffsetIndex] += 2;
+  EXPECT_FALSE(Accepts(corrupt)) << "words alignment";
+  // The ranges of elements into the arrays and text.
+  const char* base = snapshot_->data();
+  int last_word = snapshot_->num_words() - 1;
+  const tesseract::SnapshotWord& word = snapshot_->word(last_word);
+  int word_index = (reinterpret_cast<const char*>(&word) - base) /
+                   sizeof(inT32);
+  int first_symbol_index =
+      word_index + (reinterpret_cast<const char*>(&word.first_symbol) -
+                    reinterpret_cast<const char*>(&word)) / sizeof(inT32);
+  corrupt = original;
+  ++corrupt[first_symbol_index];
+  EXPECT_FALSE(Accepts(corrupt)) << "symbol range";
+  int text_length_index =
+      word_index + (reinterpret_cast<const char*>(&word.text_length) -
+                    reinterpret_cast<const char*>(&word)) / sizeof(inT32);
+  corrupt = original;
+  corrupt[text_length_index] += 1 << 20;
+  EXPECT_FALSE(Accepts(corrupt)) << "text range";
+  // The text must be null-terminated.
+  int text_end = snapshot_->text() - base + snapshot_->text_length();
+  corrupt = original;
+  reinterpret_cast<char*>(&corrupt[0])[text_end] = 'x';
+  EXPECT_FALSE(Accepts(corrupt)) << "text terminator";
+  // A buffer that is not 4-byte aligned can't be used in place.
+  GenericVector<inT32> shifted;
+  shifted.init_to_size(original.size() + 1, 0);
+  char* misaligned = reinterpret_cast<char*>(&shifted[0]) + 1;
+  memcpy(misaligned, &serialized_[0], serialized_.size());
+  PageSnapshot snapshot;
+  EXPECT_FALSE(snapshot.SetFromBuffer(misaligned, serialized_.size()));
+}
+
+// GetTSVText, rendered from the snapshot, is byte-identical to the
+// ResultIterator walk it replaced.
+TEST(PageSnapshotTSVTest, MatchesIteratorWalk) {
+  for (int i = 0; i < kNumTestImages; ++i) {
+    Pix* pix = pixRead(kTestImages[i]);
+    ASSERT_TRUE(pix != NULL) << "Failed to read " << kTestImages[i];
+    tesseract::TessBaseAPI api;
+    ASSERT_TRUE(LayoutWithFakeText(pix, &api)) << kTestImages[i];
+    STRING expected = IteratorTSVText(&api, i, pixGetWidth(pix),
+                                      pixGetHeight(pix));
+    std::unique_ptr<char[]> tsv(api.GetTSVText(i));
+    ASSERT_TRUE(tsv != nullptr);
+    EXPECT_STREQ(expected.string(), tsv.get()) << kTestImages[i];
+    pixDestroy(&pix);
+  }
+}
+
+// GetHOCRText, rendered from the snapshot, is byte-identical to the
+// ResultIterator walk it replaced, with and without the font info.
+TEST(PageSnapshotHOCRTest, MatchesIteratorWalk) {
+  for (int i = 0; i < kNumTestImages; ++i) {
+    Pix* pix = pixRead(kTestImages[i]);
+    ASSERT_TRUE(pix != NULL) << "Failed to read " << kTestImages[i];
+    tesseract::TessBaseAPI api;
+    ASSERT_TRUE(LayoutWithFakeText(pix, &api)) << kTestImages[i];
+    api.SetInputName(kTestImages[i]);
+    bool font_info = i % 2 != 0;
+    api.SetVariable("hocr_font_info", font_info ? "1" : "0");
+    STRING expected = IteratorHOCRText(&api, i, kTestImages[i],
+                                       pixGetWidth(pix), pixGetHeight(pix),
+                                       font_info);
+    std::unique_ptr<char[]> hocr(api.GetHOCRText(i));
+    ASSERT_TRUE(hocr != nullptr);
+    EXPECT_STREQ(expected.string(), hocr.get()) << kTestImages[i];
+    pixDestroy(&pix);
+  }
+}
+
+// The PDF text objects, rendered from the snapshot, are byte-identical to
+// the ResultIterator walk they replaced.
+TEST(PageSnapshotPDFTest, MatchesIteratorWalk) {
+  for (int i = 0; i < kNumTestImages; ++i) {
+    Pix* pix = pixRead(kTestImages[i]);
+    ASSERT_TRUE(pix != NULL) << "Failed to read " << kTestImages[i];
+    tesseract::TessBaseAPI api;
+    ASSERT_TRUE(LayoutWithFakeText(pix, &api)) << kTestImages[i];
+    double ppi = api.GetSourceYResolution();
+    double width = pixGetWidth(pix) * 72.0 / ppi;
+    double height = pixGetHeight(pix) * 72.0 / ppi;
+    STRING expected = IteratorPDFText(&api, width, height);
+    TestPDFRenderer renderer;
+    std::unique_ptr<char[]> pdf(
+        renderer.GetPDFTextObjects(&api, width, height));
+    ASSERT_TRUE(pdf != nullptr);
+    EXPECT_STREQ(expected.string(), pdf.get()) << kTestImages[i];
+    pixDestroy(&pix);
+  }
+}
+
+}  // namespace
@@ -134,20 +134,22 @@ class UnicharcompressTest : public ::testing::Test {
                            const std::vector<RecodedCharID>& times_seen) {
     RecodedCharID extended = code;
     int length = code.length();
-    const GenericVector<int>* final_codes = compressed_.GetFinalCodes(code);
+    int num_final_codes;
+    const int* final_codes = compressed_.GetFinalCodes(code, &num_final_codes);
     if (final_codes != NULL) {
-      for (int i = 0; i < final_codes->size(); ++i) {
-        int ending = (*final_codes)[i];
+      for (int i = 0; i < num_final_codes; ++i) {
+        int ending = final_codes[i];
         EXPECT_GT(times_seen[ending](length), 0);
         extended.Set(length, ending);
         int unichar_id = compressed_.DecodeUnichar(extended);
         EXPECT_NE(INVALID_UNICHAR_ID, unichar_id);
       }
     }
-    const GenericVector<int>* next_codes = compressed_.GetNextCodes(code);
+    int num_next_codes;
+    const int* next_codes = compressed_.GetNextCodes(code, &num_next_codes);
     if (next_codes != NULL) {
-      for (int i = 0; i < next_codes->size(); ++i) {
-        int extension = (*next_codes)[i];
+      for (int i = 0; i < num_next_codes; ++i) {
+        int extension = next_codes[i];
         EXPECT_GT(times_seen[extension](length), 0);
         extended.Set(length, extension);
         CheckCodeExtensions(extended, times_seen);
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////
+// File:        unicharset_test.cc
+// Description: Tests the text and binary formats of UNICHARSET, from
+//              files, FILE streams and memory.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "serialis.h"
+#include "strngs.h"
+#include "unicharset.h"
+
+namespace {
+
+const char kTestUnicharset[] = "../testdata/por.unicharset";
+// Written after a unicharset, to check that the reader stops at its end.
+const inT32 kTrailer = 0x54524c52;
+
+class UnicharsetTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(text_unicharset_.load_from_file(kTestUnicharset));
+    ASSERT_GT(text_unicharset_.size(), 100);
+    ASSERT_TRUE(text_unicharset_.save_to_string(&text_));
+    tesseract::TFile fp;
+    fp.OpenWrite(&binary_);
+    ASSERT_TRUE(text_unicharset_.save_binary(&fp));
+  }
+
+  // Returns the text form of the given unicharset.
+  static STRING AsText(const UNICHARSET& unicharset) {
+    STRING text;
+    EXPECT_TRUE(unicharset.save_to_string(&text));
+    return text;
+  }
+
+  UNICHARSET text_unicharset_;
+  // The text and binary forms of text_unicharset_.
+  STRING text_;
+  GenericVector<char> binary_;
+};
+
+// The binary format holds everything in the text format: text loaded,
+// saved as binary and loaded again, and saved as text and loaded again,
+// gives the same text.
+TEST_F(UnicharsetTest, TextBinaryRoundTrip) {
+  ASSERT_NE(0, strncmp(text_.string(), &binary_[0], 8));
+  tesseract::TFile fp;
+  ASSERT_TRUE(fp.Open(&binary_[0], binary_.size()));
+  UNICHARSET from_binary;
+  ASSERT_TRUE(from_binary.load_from_file(&fp, false));
+  EXPECT_EQ(0, fp.remaining());
+  EXPECT_EQ(text_unicharset_.size(), from_binary.size());
+  STRING text = AsText(from_binary);
+  EXPECT_STREQ(text_.string(), text.string());
+  UNICHARSET from_text;
+  ASSERT_TRUE(from_text.load_from_inmemory_file(text.string(),
+                                                text.length()));
+  EXPECT_STREQ(text_.string(), AsText(from_text).string());
+  for (int id = 0; id < from_binary.size(); ++id) {
+    EXPECT_EQ(text_unicharset_.get_script(id), from_binary.get_script(id));
+    EXPECT_EQ(text_unicharset_.get_other_case(id),
+              from_binary.get_other_case(id));
+    EXPECT_STREQ(text_unicharset_.get_normed_unichar(id),
+                 from_binary.get_normed_unichar(id));
+  }
+}
+
+// Both formats are recognized in memory, as held in a traineddata.
+TEST_F(UnicharsetTest, LoadsBothFormatsFromMemory) {
+  UNICHARSET unicharset;
+  ASSERT_TRUE(unicharset.load_from_inmemory_file(&binary_[0],
+                                                 binary_.size()));
+  EXPECT_STREQ(text_.string(), AsText(unicharset).string());
+  ASSERT_TRUE(unicharset.load_from_inmemory_file(text_.string(),
+                                                 text_.length()));
+  EXPECT_STREQ(text_.string(), AsText(unicharset).string());
+}
+
+// Readers of a FILE, such as TrainingSampleSet::DeSerialize, find the data
+// that follows a unicharset of either format just after it.
+TEST_F(UnicharsetTest, LeavesFileAfterUnicharset) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(binary_.size(), fwrite(&binary_[0], 1, binary_.size(), fp));
+  ASSERT_EQ(1, fwrite(&kTrailer, sizeof(kTrailer), 1, fp));
+  ASSERT_EQ(1, fwrite(text_.string(), text_.length(), 1, fp));
+  ASSERT_EQ(1, fwrite(&kTrailer, sizeof(kTrailer), 1, fp));
+  rewind(fp);
+  for (int i = 0; i < 2; ++i) {
+    UNICHARSET unicharset;
+    ASSERT_TRUE(unicharset.load_from_file(fp)) << "unicharset " << i;
+    EXPECT_STREQ(text_.string(), AsText(unicharset).string());
+    inT32 trailer = 0;
+    ASSERT_EQ(1, fread(&trailer, sizeof(trailer), 1, fp));
+    EXPECT_EQ(kTrailer, trailer) << "after unicharset " << i;
+  }
+  fclose(fp);
+}
+
+// Likewise for a TFile, as in LSTMRecognizer::DeSerialize.
+TEST_F(UnicharsetTest, LeavesTFileAfterUnicharset) {
+  GenericVector<char> data;
+  tesseract::TFile out;
+  out.OpenWrite(&data);
+  out.FWrite(&binary_[0], 1, binary_.size());
+  out.FWrite(&binary_[0], 1, binary_.size());
+  out.FWrite(&kTrailer, sizeof(kTrailer), 1);
+  tesseract::TFile fp;
+  ASSERT_TRUE(fp.Open(&data[0], data.size()));
+  UNICHARSET unicharset;
+  ASSERT_TRUE(unicharset.load_from_file(&fp, false));
+  ASSERT_TRUE(unicharset.load_from_file(&fp, false));
+  inT32 trailer = 0;
+  ASSERT_EQ(1, fp.FRead(&trailer, sizeof(trailer), 1));
+  EXPECT_EQ(kTrailer, trailer);
+}
+
+// A binary unicharset that is cut short, or whose size doesn't match its
+// content, is rejected.
+TEST_F(UnicharsetTest, RejectsBadBinarySize) {
+  UNICHARSET unicharset;
+  EXPECT_FALSE(unicharset.load_from_inmemory_file(&binary_[0],
+                                                  binary_.size() - 1));
+  // The size follows the magic line and version.
+  int size_offset = strchr(&binary_[0], '\n') + 1 - &binary_[0] +
+                    sizeof(inT32);
+  GenericVector<char> bad(binary_);
+  inT32 size;
+  memcpy(&size, &bad[size_offset], sizeof(size));
+  EXPECT_EQ(binary_.size() - size_offset - static_cast<int>(sizeof(size)),
+            size);
+  --size;
+  memcpy(&bad[size_offset], &size, sizeof(size));
+  EXPECT_FALSE(unicharset.load_from_inmemory_file(&bad[0], bad.size()));
+  size += 1 << 20;
+  memcpy(&bad[size_offset], &size, sizeof(size));
+  EXPECT_FALSE(unicharset.load_from_inmemory_file(&bad[0], bad.size()));
+}
+
+}  // namespace